@@ -5,15 +5,37 @@ import re
 from PIL import Image
 
 if len(sys.argv) != 3:
-    print("Use:", sys.argv[0], "<px_file> <png_file>")
+    print("Use:", sys.argv[0], "<px_or_px2_file> <png_file>")
     sys.exit(1)
 else:
     pxfile=sys.argv[1]
     pngfile=sys.argv[2]
 
 px = open(pxfile, "rb")
-width = int.from_bytes(px.read(2), byteorder='little')
-height = int.from_bytes(px.read(2), byteorder='little')
+magic = px.read(4)
+pixels = []
+if magic == b"PX2\x00":
+    # Compressed: palette + RLE (see convert_to_file.py)
+    width = int.from_bytes(px.read(2), byteorder='little')
+    height = int.from_bytes(px.read(2), byteorder='little')
+    ncolors = px.read(1)[0] + 1
+    palette = [int.from_bytes(px.read(2), byteorder='little')
+               for i in range(0, ncolors)]
+    data = px.read()
+    i = 0
+    while i < len(data) and len(pixels) < width * height:
+        n = (data[i] & 0x7f) + 1
+        if data[i] & 0x80:
+            pixels.extend([palette[data[i + 1]]] * n)
+            i += 2
+        else:
+            pixels.extend(palette[c] for c in data[i + 1:i + 1 + n])
+            i += 1 + n
+else:
+    width = int.from_bytes(magic[0:2], byteorder='little')
+    height = int.from_bytes(magic[2:4], byteorder='little')
+    for i in range(0, width * height):
+        pixels.append(int.from_bytes(px.read(2), byteorder='little'))
 
 img = Image.new('RGB', (width, height))
 pixmap = img.load()
@@ -23,7 +45,7 @@ print("height: ", height)
 
 for y in range(0,height):
     for x in range(0,width):
-        pixel = int.from_bytes(px.read(2), byteorder='little')
+        pixel = pixels[y * width + x]
         R5 = (pixel >> 11) & 0x1f;
         G6 = (pixel >> 5) & 0x3f;
         B5 = pixel & 0x1f;
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+
+import os,sys
+import re
+
+if len(sys.argv) != 4:
+    print("Use:", sys.argv[0], "<pixmap_directory> <ETheme.h> <bundle_file>")
+    sys.exit(1)
+else:
+    pxdir=sys.argv[1]
+    theme=sys.argv[2]
+    bundle=sys.argv[3]
+
+# Bundle layout (little endian, see EIconBundle.h):
+#   header:  "WSIB", version (16 bits), number of entries (16 bits)
+#   entries: width (16 bits), height (16 bits), offset (32 bits), one for
+#            each ETheme::pixmap_t and size: entry = pixmap * 2 + size
+#   data:    RGB565 pixels of each image, 4 bytes aligned
+MAGIC   = b"WSIB"
+VERSION = 0
+ALIGN   = 4
+
+# Read a .px or .px2 file (see convert_to_file.py)
+def read_pixmap(path):
+    px = open(path, "rb")
+    magic = px.read(4)
+    pixels = []
+    if magic == b"PX2\x00":
+        width = int.from_bytes(px.read(2), byteorder='little')
+        height = int.from_bytes(px.read(2), byteorder='little')
+        ncolors = px.read(1)[0] + 1
+        palette = [int.from_bytes(px.read(2), byteorder='little')
+                   for i in range(0, ncolors)]
+        data = px.read()
+        i = 0
+        while i < len(data) and len(pixels) < width * height:
+            n = (data[i] & 0x7f) + 1
+            if data[i] & 0x80:
+                pixels.extend([palette[data[i + 1]]] * n)
+                i += 2
+            else:
+                pixels.extend(palette[c] for c in data[i + 1:i + 1 + n])
+                i += 1 + n
+    else:
+        width = int.from_bytes(magic[0:2], byteorder='little')
+        height = int.from_bytes(magic[2:4], byteorder='little')
+        data = px.read(width * height * 2)
+        pixels = [int.from_bytes(data[i:i + 2], byteorder='little')
+                  for i in range(0, len(data), 2)]
+    px.close()
+    if len(pixels) != width * height:
+        print("%s: truncated pixmap" % path)
+        sys.exit(1)
+    return (width, height, pixels)
+
+# Pixmap types (in enum order) and their files, taken from ETheme.h
+src = open(theme).read()
+enum = re.search(r'enum _pixmap \{(.*?)\}', src, re.S)
+if enum == None:
+    print("%s: pixmap_t not found" % theme)
+    sys.exit(1)
+pixmaps = re.findall(r'^\s*(FIG_\w+)', enum.group(1), re.M)
+files = {}
+for (table, fig, fname) in re.findall(
+        r'(icons|iconsHalf)\[(FIG_\w+)\]\s*=\s*"/([^"]+)"', src):
+    files[(fig, table == "iconsHalf")] = fname.rsplit(".", 1)[0]
+
+entries = []
+images  = {}
+data    = bytearray()
+offset  = len(MAGIC) + 4 + len(pixmaps) * 2 * 8
+for fig in pixmaps:
+    for half in (False, True):
+        name = files.get((fig, half))
+        if name == None:
+            entries.append((0, 0, 0))
+            continue
+        if name not in images:
+            path = os.path.join(pxdir, name + ".px2")
+            if not os.path.exists(path):
+                path = os.path.join(pxdir, name + ".px")
+            print("Adding %s" % os.path.basename(path))
+            width, height, pixels = read_pixmap(path)
+            images[name] = (width, height, offset + len(data))
+            for pixel in pixels:
+                data.extend(pixel.to_bytes(2, byteorder='little'))
+            while len(data) % ALIGN:
+                data.append(0)
+        entries.append(images[name])
+
+out = open(bundle, "wb")
+out.write(MAGIC)
+out.write(VERSION.to_bytes(2, byteorder='little'))
+out.write(len(entries).to_bytes(2, byteorder='little'))
+for (width, height, off) in entries:
+    out.write(width.to_bytes(2, byteorder='little'))
+    out.write(height.to_bytes(2, byteorder='little'))
+    out.write(off.to_bytes(4, byteorder='little'))
+out.write(data)
+out.close()
+print("%s: %d entries, %d bytes" % (bundle, len(entries), offset + len(data)))
@@ -4,12 +4,86 @@ import os,sys
 import re
 from PIL import Image
 
-if len(sys.argv) != 3:
-    print("Use:", sys.argv[0], "<png_directory> <output_directory>")
+args = sys.argv[1:]
+fmt  = "px"
+if len(args) >= 2 and args[0] == "-f":
+    fmt  = args[1]
+    args = args[2:]
+
+if len(args) < 2 or fmt not in ("px", "px2"):
+    print("Use:", sys.argv[0], "[-f px|px2] <png_directory> <output_directory> [half_size_icon ...]")
+    print("  -f  Output format: px (raw RGB565, default) or px2 (palette + RLE)")
     sys.exit(1)
 else:
-    pngdir=sys.argv[1]
-    outdir=sys.argv[2]
+    pngdir=args[0]
+    outdir=args[1]
+    # Icons that also get a half size version (<icon>_half.px)
+    halflist=args[2:]
+
+# Normalize 32 bits RGB to RGB565
+def rgb565(r, g, b):
+    return ((r & 0xf8) << 8) | ((g & 0xfc) << 3) | ((b & 0xf8) >> 3)
+
+# Write a .px file: width, height and RGB565 pixels (little endian)
+def write_px(path, width, height, pixels):
+    cout = open(path, 'wb')
+    cout.write(width.to_bytes(2, byteorder='little'))
+    cout.write(height.to_bytes(2, byteorder='little'))
+    for pixel in pixels:
+        cout.write(pixel.to_bytes(2, byteorder='little'))
+    cout.close()
+
+# Write a .px2 file: "PX2", version, width, height, palette and packets of
+# palette indexes (run: 1nnnnnnn index, literal: 0nnnnnnn index ...), where
+# n + 1 is the number of pixels (up to 128). See EPixmapReader.h
+def write_px2(path, width, height, pixels):
+    palette = sorted(set(pixels))
+    if len(palette) > 256:
+        return False
+    index = dict((c, i) for i, c in enumerate(palette))
+
+    data = bytearray()
+    i = 0
+    while i < len(pixels):
+        run = 1
+        while (i + run < len(pixels) and run < 128 and
+               pixels[i + run] == pixels[i]):
+            run += 1
+        if run > 1:
+            data.append(0x80 | (run - 1))
+            data.append(index[pixels[i]])
+            i += run
+            continue
+        # Literal: until the next run of two pixels
+        j = i
+        while (j < len(pixels) and j - i < 128 and
+               (j + 1 >= len(pixels) or pixels[j + 1] != pixels[j])):
+            j += 1
+        if j == i:
+            j = i + 1
+        data.append(j - i - 1)
+        data.extend(index[p] for p in pixels[i:j])
+        i = j
+
+    cout = open(path, 'wb')
+    cout.write(b"PX2\x00")
+    cout.write(width.to_bytes(2, byteorder='little'))
+    cout.write(height.to_bytes(2, byteorder='little'))
+    cout.write((len(palette) - 1).to_bytes(1, byteorder='little'))
+    for color in palette:
+        cout.write(color.to_bytes(2, byteorder='little'))
+    cout.write(data)
+    cout.close()
+    return True
+
+# Write a pixmap in the selected format (raw when it cannot be compressed)
+def write_pixmap(name, width, height, pixels):
+    if fmt == "px2":
+        if write_px2(os.path.join(outdir, name + ".px2"), width, height,
+                     pixels):
+            return
+        print("  %s: more than 256 colors, using .px" % name)
+    write_px(os.path.join(outdir, name + ".px"), width, height, pixels)
 
 flist = []
 for fname in os.listdir(pngdir):
@@ -23,27 +97,35 @@ for fname in os.listdir(pngdir):
 for img in flist:
     png    = Image.open(img)
     bitmap = png.load()
-    ncols  = 12
-    nc     = 0
 
     fname = os.path.basename(img)
     vname = fname.rsplit(".", 1)[0]
-    cfile = vname + ".px" 
 
     width, height = png.size
 
     print("Converting %s" % fname)
 
-    cout = open(os.path.join(outdir, cfile), 'wb')
-    cout.write(width.to_bytes(2, byteorder='little'))
-    cout.write(height.to_bytes(2, byteorder='little'))
-
+    pixels = []
     for y in range(0,height):
         for x in range(0,width):
-            # Normalize 32 bits RGB to RGB565
             r, g, b, a = bitmap[x,y]
-            pixel = ((r & 0xf8) << 8) | ((g & 0xfc) << 3) | ((b & 0xf8) >> 3)
-            cout.write(pixel.to_bytes(2, byteorder='little'))
-    cout.close
-    png.close()
+            pixels.append(rgb565(r, g, b))
+    write_pixmap(vname, width, height, pixels)
 
+    if vname in halflist:
+        # Half size: average of each 2x2 block (last odd row/column is
+        # dropped, same as the firmware does when scaling at run time)
+        hwidth  = width // 2
+        hheight = height // 2
+        pixels  = []
+        for y in range(0,hheight):
+            for x in range(0,hwidth):
+                block = [bitmap[2*x, 2*y], bitmap[2*x+1, 2*y],
+                         bitmap[2*x, 2*y+1], bitmap[2*x+1, 2*y+1]]
+                r = (sum(p[0] for p in block) + 2) // 4
+                g = (sum(p[1] for p in block) + 2) // 4
+                b = (sum(p[2] for p in block) + 2) // 4
+                pixels.append(rgb565(r, g, b))
+        write_pixmap(vname + "_half", hwidth, hheight, pixels)
+
+    png.close()
@@ -0,0 +1,140 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file ECanvas.cpp
+ * @class ECanvas
+ * Off-screen canvases used to compose screen regions before sending them to
+ * the TFT module in a single burst
+ */
+#include <ECanvas.h>
+
+/**
+ * Constructor
+ * @param [in] capacity Maximum number of pixels
+ */
+ECanvas::ECanvas(uint32_t capacity) :
+	GFXcanvas16(capacity, 1), capacity(capacity), busy(false)
+{
+	setTextWrap(false);
+}
+
+/**
+ * Reshape the canvas
+ * @param [in] w Width
+ * @param [in] h Height
+ * @return bool true if the new size fits on the canvas
+ */
+bool ECanvas::reshape(uint16_t w, uint16_t h)
+{
+	if (!getBuffer() || w == 0 || h == 0 || ((uint32_t)w * h) > capacity)
+		return false;
+
+	WIDTH   = w;
+	HEIGHT  = h;
+	_width  = w;
+	_height = h;
+	rotation = 0;
+	return true;
+}
+
+/**
+ * Send the canvas to the screen
+ * @param [in] tft TFT module
+ * @param [in] x Screen position (X axis)
+ * @param [in] y Screen position (Y axis)
+ */
+void ECanvas::push(Adafruit_SPITFT *tft, int16_t x, int16_t y)
+{
+	// One address window, one pixel burst (with DMA, pixels are copied and
+	// the canvas can be reused while they are sent). The driver clips it
+	// and, with a shadow of the screen, only sends the pixels that change.
+	tft->drawRGBBitmap(x, y, getBuffer(), WIDTH, HEIGHT);
+}
+
+/**
+ * Constructor
+ */
+ECanvasPool::ECanvasPool()
+{
+	int i;
+
+	for (i = 0; i < CANVAS_POOL_SIZE; i++) {
+		canvas[i] = new ECanvas(CANVAS_POOL_PIXELS);
+		if (canvas[i] && !canvas[i]->getBuffer()) {
+			log_e("Cannot allocate canvas %d", i);
+			delete canvas[i];
+			canvas[i] = NULL;
+		}
+	}
+}
+
+/**
+ * Destructor
+ */
+ECanvasPool::~ECanvasPool()
+{
+	int i;
+
+	for (i = 0; i < CANVAS_POOL_SIZE; i++) {
+		if (canvas[i])
+			delete canvas[i];
+	}
+}
+
+/**
+ * Get a free canvas
+ * @param [in] w Width
+ * @param [in] h Height
+ * @return ECanvas* Canvas reshaped to w x h or NULL when there is no free
+ * canvas large enough
+ */
+ECanvas *ECanvasPool::acquire(uint16_t w, uint16_t h)
+{
+	int i;
+
+	for (i = 0; i < CANVAS_POOL_SIZE; i++) {
+		if (canvas[i] && !canvas[i]->busy && canvas[i]->reshape(w, h)) {
+			canvas[i]->busy = true;
+			return canvas[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Give back a canvas to the pool
+ * @param [in] c Canvas
+ */
+void ECanvasPool::release(ECanvas *c)
+{
+	if (c)
+		c->busy = false;
+}
@@ -0,0 +1,152 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EFontMetrics.cpp
+ * @class EFontMetrics
+ * Text metrics of a GFX font
+ */
+#include <EFontMetrics.h>
+
+/**
+ * Constructor
+ * @param [in] font Font
+ */
+EFontMetrics::EFontMetrics(const GFXfont *font) :
+	font(font), table(NULL)
+{
+	const GFXglyph *glyph;
+	metrics_t *m;
+	int i, count;
+
+	first    = pgm_read_byte(&font->first);
+	last     = pgm_read_byte(&font->last);
+	yAdvance = pgm_read_byte(&font->yAdvance);
+	count    = last - first + 1;
+
+	table = new metrics_t[count];
+	if (!table) {
+		log_e("Cannot allocate metrics of %d characters", count);
+		return;
+	}
+
+	for (i = 0; i < count; i++) {
+		glyph = &font->glyph[i];
+		m = &table[i];
+		m->advance = pgm_read_byte(&glyph->xAdvance);
+		m->left    = (int8_t)pgm_read_byte(&glyph->xOffset);
+		m->top     = (int8_t)pgm_read_byte(&glyph->yOffset);
+		m->right   = m->left + pgm_read_byte(&glyph->width) - 1;
+		m->bottom  = m->top + pgm_read_byte(&glyph->height) - 1;
+	}
+}
+
+/**
+ * Destructor
+ */
+EFontMetrics::~EFontMetrics()
+{
+	if (table)
+		delete[] table;
+}
+
+/**
+ * Get the font
+ * @return const GFXfont* Font
+ */
+const GFXfont *EFontMetrics::getFont()
+{
+	return font;
+}
+
+/**
+ * Get the bounds of a string (same as Adafruit_GFX::getTextBounds, text size
+ * 1, on a screen of the given size)
+ * @param [in] str String
+ * @param [in] x Cursor position (X axis)
+ * @param [in] y Cursor position (Y axis)
+ * @param [in] width Screen width
+ * @param [in] height Screen height
+ * @param [out] x1 Top left corner (X axis)
+ * @param [out] y1 Top left corner (Y axis)
+ * @param [out] w Width
+ * @param [out] h Height
+ * @return bool false if the text would wrap at the right edge of the screen
+ * (bounds are not computed)
+ */
+bool EFontMetrics::getTextBounds(const char *str, int16_t x, int16_t y,
+		int16_t width, int16_t height, int16_t *x1, int16_t *y1,
+		uint16_t *w, uint16_t *h)
+{
+	int16_t minx = width, miny = height, maxx = -1, maxy = -1;
+	const metrics_t *m;
+	uint8_t c;
+
+	if (!table)
+		return false;
+
+	*x1 = x;
+	*y1 = y;
+	*w  = 0;
+	*h  = 0;
+
+	while ((c = *str++)) {
+		if (c == '\n') {
+			x = 0;
+			y += yAdvance;
+			continue;
+		}
+		if (c < first || c > last)
+			continue;
+
+		m = &table[c - first];
+		if ((x + m->right) >= width)
+			return false;
+		if ((x + m->left) < minx)
+			minx = x + m->left;
+		if ((y + m->top) < miny)
+			miny = y + m->top;
+		if ((x + m->right) > maxx)
+			maxx = x + m->right;
+		if ((y + m->bottom) > maxy)
+			maxy = y + m->bottom;
+		x += m->advance;
+	}
+
+	if (maxx >= minx) {
+		*x1 = minx;
+		*w  = maxx - minx + 1;
+	}
+	if (maxy >= miny) {
+		*y1 = miny;
+		*h  = maxy - miny + 1;
+	}
+	return true;
+}
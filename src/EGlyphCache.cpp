@@ -0,0 +1,279 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EGlyphCache.cpp
+ * @class EGlyphCache
+ * Cache of pre-rendered font characters
+ */
+#include <EGlyphCache.h>
+#include <Adafruit_GFX_RGB565.h>
+
+/**
+ * Constructor
+ * @param [in] font Font
+ * @param [in] chars Characters to cache (up to GLYPH_CACHE_MAX)
+ */
+EGlyphCache::EGlyphCache(const GFXfont *font, const char *chars) :
+	font(font), count(0), height(0), top(0), buffer(NULL), size(0),
+	fg(0), bg(0), valid(false)
+{
+	uint8_t first, last;
+	const GFXglyph *glyph;
+	tile_t *t;
+	int16_t bottom = 0;
+
+	first = pgm_read_byte(&font->first);
+	last  = pgm_read_byte(&font->last);
+
+	for (; *chars && count < GLYPH_CACHE_MAX; chars++) {
+		if ((uint8_t)*chars < first || (uint8_t)*chars > last)
+			continue;
+
+		glyph = &font->glyph[(uint8_t)*chars - first];
+		t = &tiles[count];
+		t->c       = *chars;
+		t->advance = pgm_read_byte(&glyph->xAdvance);
+		t->xo      = pgm_read_byte(&glyph->xOffset);
+		t->yo      = pgm_read_byte(&glyph->yOffset);
+		t->w       = pgm_read_byte(&glyph->width);
+		t->h       = pgm_read_byte(&glyph->height);
+
+		if (count == 0 || t->yo < top)
+			top = t->yo;
+		if (count == 0 || (t->yo + t->h) > bottom)
+			bottom = t->yo + t->h;
+		count++;
+	}
+	height = bottom - top;
+
+	for (t = tiles; t < &tiles[count]; t++) {
+		t->offset = size;
+		size += t->advance * height;
+	}
+}
+
+/**
+ * Destructor
+ */
+EGlyphCache::~EGlyphCache()
+{
+	if (buffer)
+		free(buffer);
+}
+
+/**
+ * Get the font
+ * @return const GFXfont*
+ */
+const GFXfont *EGlyphCache::getFont()
+{
+	return font;
+}
+
+/**
+ * Render the tiles for the given colors (when needed)
+ * @param [in] fg Foreground color
+ * @param [in] bg Background color
+ * @return bool true if the tiles are ready to use
+ */
+bool EGlyphCache::build(color_t fg, color_t bg)
+{
+	const uint8_t *bitmap;
+	const GFXglyph *glyph;
+	uint16_t *pixels;
+	uint16_t bo;
+	uint8_t bits, bit, xx, yy;
+	tile_t *t;
+
+	if (valid && this->fg == fg && this->bg == bg)
+		return true;
+
+	if (size == 0)
+		return false;
+
+	if (!buffer) {
+		buffer = (uint16_t*)malloc(size * sizeof(uint16_t));
+		if (!buffer) {
+			log_e("Cannot allocate glyph cache (%u bytes)",
+					(unsigned int)(size * sizeof(uint16_t)));
+			return false;
+		}
+	}
+
+	rgb565Fill(buffer, bg, size);
+
+	bitmap = font->bitmap;
+	for (t = tiles; t < &tiles[count]; t++) {
+		glyph  = &font->glyph[(uint8_t)t->c - pgm_read_byte(&font->first)];
+		bo     = pgm_read_word(&glyph->bitmapOffset);
+		pixels = &buffer[t->offset];
+		bits   = 0;
+		bit    = 0;
+		for (yy = 0; yy < t->h; yy++) {
+			for (xx = 0; xx < t->w; xx++) {
+				if (!(bit++ & 7))
+					bits = pgm_read_byte(&bitmap[bo++]);
+				if ((bits & 0x80) && (t->xo + xx) >= 0 &&
+						(t->xo + xx) < t->advance) {
+					pixels[(t->yo - top + yy) * t->advance + t->xo + xx] = fg;
+				}
+				bits <<= 1;
+			}
+		}
+	}
+
+	this->fg = fg;
+	this->bg = bg;
+	valid = true;
+	return true;
+}
+
+/**
+ * Drop the rendered tiles
+ */
+void EGlyphCache::invalidate()
+{
+	valid = false;
+}
+
+/**
+ * Get the bounds of a string (same as Adafruit_GFX::getTextBounds)
+ * @param [in] str String
+ * @param [in] x Cursor position (X axis)
+ * @param [in] y Cursor position (Y axis)
+ * @param [out] x1 Top left corner (X axis)
+ * @param [out] y1 Top left corner (Y axis)
+ * @param [out] w Width
+ * @param [out] h Height
+ * @return bool false if the string has characters that are not cached
+ */
+bool EGlyphCache::getTextBounds(const char *str, int16_t x, int16_t y,
+		int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h)
+{
+	int16_t minx = 0x7fff, miny = 0x7fff, maxx = -1, maxy = -1;
+	const tile_t *t;
+
+	*x1 = x;
+	*y1 = y;
+	*w  = 0;
+	*h  = 0;
+
+	for (; *str; str++) {
+		if (!(t = getTile(*str)))
+			return false;
+		if ((x + t->xo) < minx)
+			minx = x + t->xo;
+		if ((y + t->yo) < miny)
+			miny = y + t->yo;
+		if ((x + t->xo + t->w - 1) > maxx)
+			maxx = x + t->xo + t->w - 1;
+		if ((y + t->yo + t->h - 1) > maxy)
+			maxy = y + t->yo + t->h - 1;
+		x += t->advance;
+	}
+
+	if (maxx >= minx) {
+		*x1 = minx;
+		*w  = maxx - minx + 1;
+	}
+	if (maxy >= miny) {
+		*y1 = miny;
+		*h  = maxy - miny + 1;
+	}
+	return true;
+}
+
+/**
+ * Copy the tiles of a string into a pixel buffer
+ * @param [in] dst Pixel buffer
+ * @param [in] dw Buffer width
+ * @param [in] dh Buffer height
+ * @param [in] x Cursor position (X axis)
+ * @param [in] y Cursor position (Y axis, baseline)
+ * @param [in] str String
+ * @return bool false if the tiles are not built or the string has characters
+ * that are not cached
+ */
+bool EGlyphCache::draw(uint16_t *dst, int16_t dw, int16_t dh,
+		int16_t x, int16_t y, const char *str)
+{
+	const char *s;
+	const tile_t *t;
+	int16_t row, col, cw;
+	uint16_t *src;
+
+	if (!valid)
+		return false;
+	for (s = str; *s; s++) {
+		if (!getTile(*s))
+			return false;
+	}
+
+	for (; *str; str++) {
+		t = getTile(*str);
+
+		// Clip the tile to the buffer
+		col = 0;
+		cw  = t->advance;
+		if (x < 0)
+			col = -x;
+		if ((x + cw) > dw)
+			cw = dw - x;
+
+		for (row = 0; row < height && col < cw; row++) {
+			if ((y + top + row) < 0 || (y + top + row) >= dh)
+				continue;
+			src = &buffer[t->offset + row * t->advance];
+			memcpy(&dst[(y + top + row) * dw + x + col], &src[col],
+					(cw - col) * sizeof(uint16_t));
+		}
+		x += t->advance;
+	}
+	return true;
+}
+
+/* ======================= PRIVATE ======================= */
+
+/**
+ * Find the tile of a character
+ * @param [in] c Character
+ * @return const tile_t* Tile or NULL when the character is not cached
+ */
+const EGlyphCache::tile_t *EGlyphCache::getTile(char c)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (tiles[i].c == c)
+			return &tiles[i];
+	}
+	return NULL;
+}
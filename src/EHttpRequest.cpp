@@ -0,0 +1,408 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EHttpRequest.cpp
+ * @class EHttpRequest
+ * HTTP/1.1 GET request on a kept-alive connection
+ */
+#include <EHttpRequest.h>
+
+/**
+ * Constructor
+ * @param [in] net Network layer
+ */
+EHttpRequest::EHttpRequest(ENetwork *net) :
+	net(net), client(NULL), nheaders(0), length(-1), left(0),
+	chunked(false), done(true), keep(false), peeked(-1)
+{
+}
+
+/**
+ * Destructor
+ */
+EHttpRequest::~EHttpRequest()
+{
+	end();
+}
+
+/**
+ * Add a request header
+ * @param [in] name Name
+ * @param [in] value Value
+ */
+void EHttpRequest::addHeader(const char *name, const char *value)
+{
+	reqHeaders += name;
+	reqHeaders += ": ";
+	reqHeaders += value;
+	reqHeaders += "\r\n";
+}
+
+/**
+ * Keep response headers
+ * @param [in] names Header names (kept by the caller)
+ * @param [in] count Number of names (up to HTTP_HEADERS_MAX)
+ */
+void EHttpRequest::collectHeaders(const char *const names[], int count)
+{
+	int i;
+
+	nheaders = count < HTTP_HEADERS_MAX ? count : HTTP_HEADERS_MAX;
+	for (i = 0; i < nheaders; i++) {
+		this->names[i] = names[i];
+		values[i] = "";
+	}
+}
+
+/**
+ * Send a GET request
+ * @param [in] url URL (http://host[:port]/path)
+ * @return int HTTP status code, negative number (HTTP_ERROR_*) on error
+ */
+int EHttpRequest::GET(const char *url)
+{
+	char host[NET_HOST_MAX], req[HTTP_REQUEST_MAX];
+	const char *p, *path;
+	uint32_t ttfb;
+	uint16_t port = 80;
+	bool reused;
+	int n, res, attempt;
+	size_t len;
+
+	end();
+	if (!net) {
+		log_e("No network for %s", url);
+		return HTTP_ERROR_CONNECT;
+	}
+	if (strncmp(url, "http://", 7)) {
+		log_e("Unsupported URL: %s", url);
+		return HTTP_ERROR_URL;
+	}
+	p    = url + 7;
+	len  = strcspn(p, ":/?");
+	path = p + len;
+	if (len == 0 || len >= NET_HOST_MAX) {
+		log_e("Malformed URL: %s", url);
+		return HTTP_ERROR_URL;
+	}
+	memcpy(host, p, len);
+	host[len] = '\0';
+	if (*path == ':') {
+		port = strtoul(path + 1, (char **)&path, 10);
+		path = path + strcspn(path, "/?");
+	}
+
+	n = snprintf(req, sizeof(req), "GET %s%s HTTP/1.1\r\nHost: %s\r\n"
+			"User-Agent: WStation\r\nConnection: %s\r\n%s\r\n",
+			*path == '/' ? "" : "/", path, host,
+			net->keepAlive ? "keep-alive" : "close", reqHeaders.c_str());
+	if (n < 0 || n >= (int)sizeof(req)) {
+		log_e("URL too long: %s", url);
+		return HTTP_ERROR_URL;
+	}
+
+	// Once more on a new connection when the kept-alive one was closed
+	res = HTTP_ERROR_CONNECT;
+	for (attempt = 0; attempt < 2; attempt++) {
+		client = net->acquire(host, port, attempt > 0, &reused);
+		if (!client)
+			return HTTP_ERROR_CONNECT;
+
+		ttfb = micros();
+		if (client->write((const uint8_t *)req, n) == (size_t)n) {
+			res = readHeaders(&ttfb);
+			if (res > 0) {
+				net->countRequest(reused, attempt > 0, ttfb);
+				return res;
+			}
+		} else {
+			res = HTTP_ERROR_SEND;
+		}
+
+		net->release(client, false);
+		client = NULL;
+		done   = true;
+		if (!reused)
+			break;
+	}
+
+	log_e("GET %s failed: %d", url, res);
+	return res;
+}
+
+/**
+ * Value of a response header kept
+ * @param [in] name Name, as given to collectHeaders()
+ * @return const String& Value (empty when the server did not send it)
+ */
+const String& EHttpRequest::header(const char *name)
+{
+	static const String none;
+	int i;
+
+	for (i = 0; i < nheaders; i++) {
+		if (!strcasecmp(names[i], name))
+			return values[i];
+	}
+	return none;
+}
+
+/**
+ * Size of the response body
+ * @return long Bytes (Content-Length), -1 when unknown
+ */
+long EHttpRequest::getSize()
+{
+	return length;
+}
+
+/**
+ * Response body
+ * @return Stream& Body (the request itself)
+ */
+Stream& EHttpRequest::getStream()
+{
+	return *this;
+}
+
+/**
+ * End the request
+ *
+ * A short rest of the body is read, so that the connection can be kept.
+ */
+void EHttpRequest::end()
+{
+	size_t n = 0;
+
+	if (!client)
+		return;
+	if (!chunked && left > HTTP_DRAIN_MAX)
+		keep = false;
+	while (keep && !done && n++ < HTTP_DRAIN_MAX && readBody() >= 0)
+		;
+	net->release(client, keep && done);
+	client = NULL;
+	done   = true;
+	peeked = -1;
+}
+
+int EHttpRequest::available()
+{
+	int n;
+
+	if (done || !client)
+		return peeked >= 0 ? 1 : 0;
+	n = client->available();
+	if (!chunked && left >= 0 && n > left)
+		n = left;
+	return n + (peeked >= 0 ? 1 : 0);
+}
+
+int EHttpRequest::read()
+{
+	int c = peeked;
+
+	if (c >= 0) {
+		peeked = -1;
+		return c;
+	}
+	return readBody();
+}
+
+int EHttpRequest::peek()
+{
+	if (peeked < 0)
+		peeked = readBody();
+	return peeked;
+}
+
+size_t EHttpRequest::write(uint8_t c)
+{
+	return 0;
+}
+
+/* ======================= PRIVATE ======================= */
+
+/**
+ * Read a line of the response (waits up to the connection timeout)
+ * @param [out] buf Line, without CR LF (cut to the buffer size)
+ * @param [in] size Buffer size
+ * @return int Line length, -1 when the connection ended before the line
+ */
+int EHttpRequest::readLine(char *buf, size_t size)
+{
+	size_t n = 0;
+	char c;
+
+	while (client->readBytes(&c, 1) == 1) {
+		if (c == '\n') {
+			if (n && buf[n - 1] == '\r')
+				n--;
+			buf[n] = '\0';
+			return n;
+		}
+		if (n < size - 1)
+			buf[n++] = c;
+	}
+	buf[n] = '\0';
+	return -1;
+}
+
+/**
+ * Read the status line and the headers
+ * @param [in,out] ttfbUs Time the request was sent (micros()), then the
+ *                        time to the first line of the response (us)
+ * @return int HTTP status code, HTTP_ERROR_RESPONSE on error
+ */
+int EHttpRequest::readHeaders(uint32_t *ttfbUs)
+{
+	char line[HTTP_LINE_MAX], *value;
+	int n, i, code;
+
+	length = -1;
+	left   = 0;
+	peeked = -1;
+	chunked = false;
+	for (i = 0; i < nheaders; i++)
+		values[i] = "";
+
+	n = readLine(line, sizeof(line));
+	*ttfbUs = micros() - *ttfbUs;
+	if (n < 12 || strncmp(line, "HTTP/1.", 7))
+		return HTTP_ERROR_RESPONSE;
+	// HTTP/1.0 closes the connection unless it says otherwise
+	keep = line[7] != '0';
+	code = atoi(line + 9);
+
+	while ((n = readLine(line, sizeof(line))) > 0) {
+		value = strchr(line, ':');
+		if (!value)
+			continue;
+		*value++ = '\0';
+		while (*value == ' ' || *value == '\t')
+			value++;
+
+		if (!strcasecmp(line, "Content-Length"))
+			length = atol(value);
+		else if (!strcasecmp(line, "Transfer-Encoding"))
+			chunked = !strcasecmp(value, "chunked");
+		else if (!strcasecmp(line, "Connection") && !strcasecmp(value, "close"))
+			keep = false;
+		else if (!strcasecmp(line, "Connection") &&
+				!strcasecmp(value, "keep-alive"))
+			keep = true;
+
+		for (i = 0; i < nheaders; i++) {
+			if (!strcasecmp(names[i], line))
+				values[i] = value;
+		}
+	}
+	if (n < 0)
+		return HTTP_ERROR_RESPONSE;
+
+	if (code < 200 || code == 204 || code == 304) {
+		// No body
+		done = true;
+	} else if (chunked) {
+		done = false;
+	} else if (length >= 0) {
+		left = length;
+		done = (length == 0);
+	} else {
+		// Body up to the end of the connection
+		left = -1;
+		done = false;
+		keep = false;
+	}
+	return code;
+}
+
+/**
+ * Start the next chunk
+ * @return bool false at the end of the body
+ */
+bool EHttpRequest::nextChunk()
+{
+	char line[32];
+	int n;
+
+	if (readLine(line, sizeof(line)) < 0) {
+		done = true;
+		keep = false;
+		return false;
+	}
+	left = strtol(line, NULL, 16);
+	if (left > 0)
+		return true;
+
+	// Last chunk, then the trailer
+	while ((n = readLine(line, sizeof(line))) > 0)
+		;
+	done = true;
+	if (n < 0)
+		keep = false;
+	return false;
+}
+
+/**
+ * Read a byte of the body (waits up to the connection timeout)
+ * @return int Byte, -1 at the end of the body
+ */
+int EHttpRequest::readBody()
+{
+	char line[8];
+	int c;
+
+	if (done || !client)
+		return -1;
+	if (chunked && left == 0 && !nextChunk())
+		return -1;
+
+	c = client->read();
+	if (c < 0) {
+		char b;
+		if (client->readBytes(&b, 1) != 1) {
+			// End of the connection (or timeout)
+			done = true;
+			keep = false;
+			return -1;
+		}
+		c = (uint8_t)b;
+	}
+
+	if (left > 0 && --left == 0) {
+		if (chunked)
+			readLine(line, sizeof(line));
+		else
+			done = true;
+	}
+	return c;
+}
@@ -0,0 +1,150 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EIconBundle.cpp
+ * @class EIconBundle
+ * Draw icons straight from a memory mapped flash partition, without opening
+ * files or copying pixels to RAM
+ */
+#include <EIconBundle.h>
+
+/** Header size (magic, version and number of entries) */
+#define ICON_BUNDLE_HEADER 8
+
+/**
+ * Constructor
+ */
+EIconBundle::EIconBundle() :
+	base(NULL), size(0), entries(NULL), count(0), handle(0)
+{
+}
+
+/**
+ * Destructor
+ */
+EIconBundle::~EIconBundle()
+{
+	end();
+}
+
+/**
+ * Map the icon bundle partition
+ * @return bool true if the partition was found and holds a valid bundle
+ */
+bool EIconBundle::begin()
+{
+	const esp_partition_t *part;
+	const void *ptr;
+	uint16_t version = 0;
+
+	if (base)
+		return true;
+
+	part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+			(esp_partition_subtype_t)ICON_BUNDLE_SUBTYPE, ICON_BUNDLE_LABEL);
+	if (!part) {
+		log_i("No icon bundle partition, using the file system");
+		return false;
+	}
+
+	if (esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA,
+				&ptr, &handle) != ESP_OK) {
+		log_e("Cannot map icon bundle partition");
+		return false;
+	}
+
+	base = (const uint8_t*)ptr;
+	size = part->size;
+	if (size >= ICON_BUNDLE_HEADER) {
+		version = base[4] | (base[5] << 8);
+		count   = base[6] | (base[7] << 8);
+	}
+	if (size < ICON_BUNDLE_HEADER ||
+			memcmp(base, ICON_BUNDLE_MAGIC, 4) != 0 ||
+			version != ICON_BUNDLE_VERSION ||
+			ICON_BUNDLE_HEADER + count * sizeof(entry_t) > size) {
+		log_e("Invalid icon bundle");
+		end();
+		return false;
+	}
+	entries = (const entry_t*)(base + ICON_BUNDLE_HEADER);
+	return true;
+}
+
+/**
+ * Unmap the icon bundle partition
+ */
+void EIconBundle::end()
+{
+	if (base)
+		spi_flash_munmap(handle);
+	base    = NULL;
+	size    = 0;
+	entries = NULL;
+	count   = 0;
+	handle  = 0;
+}
+
+/**
+ * Check if the bundle is mapped
+ * @return bool true if icons can be read from the bundle
+ */
+bool EIconBundle::isAvailable()
+{
+	return (entries != NULL);
+}
+
+/**
+ * Get an icon
+ * @param [in] pixmap Pixmap
+ * @param [in] half Half size pixmap
+ * @param [out] w Width
+ * @param [out] h Height
+ * @return const uint16_t* Pixels (in flash) or NULL if not available
+ */
+const uint16_t *EIconBundle::get(ETheme::pixmap_t pixmap, bool half,
+		uint16_t *w, uint16_t *h)
+{
+	const entry_t *e;
+	uint32_t i = pixmap * 2 + (half ? 1 : 0);
+
+	if (!entries || i >= count)
+		return NULL;
+
+	e = &entries[i];
+	if (e->offset == 0 || (e->offset & 1) ||
+			e->offset + (uint32_t)e->w * e->h * 2 > size)
+		return NULL;
+
+	*w = e->w;
+	*h = e->h;
+	return (const uint16_t*)(base + e->offset);
+}
@@ -35,13 +35,12 @@
  */
 #include <EInterface.h>
 #include <SPI.h>
+#include <Adafruit_GFX_RGB565.h>
 #include <Fonts/FreeSansBold12pt7b.h>
 #include <Fonts/FreeSansBold18pt7b.h>
 #include <Fonts/FreeSans9pt7b.h>
 #include <Fonts/FreeMono9pt7b.h>
-#ifdef DEBUG_SCREENSHOT
-#include <esp_task_wdt.h>
-#endif
+#include <layouts.h>
 
 /** Default weather */
 #define DEF_WEATHER  UNKNOWN_WEATHER
@@ -50,6 +49,40 @@
 /** Default time format */
 #define DEF_TIME_FORMAT TIME_FORMAT_24H
 
+#if GUI_PROFILE
+/** Measure the rest of the block as a profiled section */
+#define PROFILE_SCOPE(section) EProfiler::Scope profileScope(profiler, section)
+/** Measure the rest of the block as a redraw of a widget */
+#define PROFILE_REDRAW(w) EProfiler::Scope profileScope(profiler, w, true)
+/** Count a value set on a widget */
+#define PROFILE_CALL(w) profiler->call(w)
+
+/** Names of the profiled sections: widgets, then drawing functions */
+static const char *const profileNames[] = {
+	"hours", "period", "minutes", "seconds", "date", "city", "ip", "wifi",
+	"radio", "weather", "label_indoor", "label_outdoor", "temp1",
+	"humidity1", "channel", "temp2", "humidity2", "battery1", "battery2",
+	"forecast_weather0", "forecast_weather1", "forecast_weather2",
+	"forecast_label0", "forecast_label1", "forecast_label2",
+	"forecast_temp2_0", "forecast_temp2_1", "forecast_temp2_2",
+	"forecast_temp1_0", "forecast_temp1_1", "forecast_temp1_2",
+	"update", "clearAll", "showAll", "drawClockText", "drawText",
+	"drawTextRight", "drawLabel", "drawLine", "drawIcon", "drawTemp",
+	"drawHumidity", "drawPixmap", "drawPixmapHalf", "showLogo",
+	"showVersion"
+};
+static_assert(sizeof(profileNames) / sizeof(profileNames[0]) == PROFILE_MAX,
+		"One name per profiled section");
+#else
+#define PROFILE_SCOPE(section)
+#define PROFILE_REDRAW(w)
+#define PROFILE_CALL(w)
+#endif
+
+/** Firmware version: background area (relative to the cursor) */
+static constexpr EFontMetrics::bounds_t versionArea =
+	EFontMetrics::textBounds(FreeMono9pt7b, WSTATION_VERSION);
+
 /**
  * Constructor
  * @param [in] cs TFT module CS pin
@@ -64,7 +97,11 @@ EInterface::EInterface(int8_t cs, int8_t dc,
 		fs::FS *pfs) :
 	state(false), tftCS(cs), tftDC(dc), tftLED(led),
 	backlight(backlight),theme(theme), pfs(pfs),
-	tft(NULL), hours(-1), minutes(-1), seconds(-1),
+	tft(NULL), canvasPool(NULL), clockDigits(NULL),
+	clockSeconds(NULL), clockPeriod(NULL),
+	layout(&layouts[GUI_LAYOUT]), pixmapCache(NULL),
+	iconBundle(NULL), strip(NULL), dmaQueue(NULL), shadow(NULL),
+	shadowPool(NULL), hours(-1), minutes(-1), seconds(-1),
 	temp1(GUI_INV_TEMP), temp2(GUI_INV_TEMP), tempScale(DEF_SCALE),
 	city(""), date(""), weather(DEF_WEATHER), period(0),
 	radio(false), wifi(false), battery1(false), battery2(false),
@@ -73,9 +110,37 @@ EInterface::EInterface(int8_t cs, int8_t dc,
 	forecastTemp1({GUI_INV_TEMP, GUI_INV_TEMP, GUI_INV_TEMP}),
 	forecastTemp2({GUI_INV_TEMP, GUI_INV_TEMP, GUI_INV_TEMP}),
 	forecastWeather({DEF_WEATHER, DEF_WEATHER, DEF_WEATHER}),
-	timeFormat(DEF_TIME_FORMAT)
+	timeFormat(DEF_TIME_FORMAT), redraws(0), skipped(0)
 {
+	int i;
+	char str[WIDGET_VALUE_MAX];
+
 	this->tft = new Adafruit_ILI9341(tftCS, tftDC);
+	this->canvasPool = new ECanvasPool();
+	this->clockDigits  = new EGlyphCache(&FreeSansBold18pt7b, "0123456789:");
+	this->clockSeconds = new EGlyphCache(&FreeSansBold12pt7b, "0123456789");
+	this->clockPeriod  = new EGlyphCache(&FreeSans9pt7b, "apm");
+	this->metrics[0]   = new EFontMetrics(&FreeSans9pt7b);
+	this->metrics[1]   = new EFontMetrics(&FreeSansBold12pt7b);
+	this->metrics[2]   = new EFontMetrics(&FreeSansBold18pt7b);
+	this->metrics[3]   = new EFontMetrics(&FreeMono9pt7b);
+	this->pixmapCache  = new EPixmapCache();
+	this->iconBundle   = new EIconBundle();
+	this->strip        = new uint16_t[PIXMAP_STRIP_PIXELS];
+#if GUI_PROFILE
+	this->profiler     = new EProfiler(profileNames, PROFILE_MAX, tft);
+#endif
+#if GUI_PIN_STATUS_ICONS
+	pixmapCache->setPinned(ETheme::FIG_RADIO, true);
+	pixmapCache->setPinned(ETheme::FIG_WIFI, true);
+	pixmapCache->setPinned(ETheme::FIG_BATTERY, true);
+#endif
+
+	setPalette();
+
+	// Nothing is shown until the widgets are set or invalidated
+	for (i = 0; i < WIDGET_MAX; i++)
+		widgets[i].reset(formatWidget(i, str, sizeof(str)));
 }
 
 /**
@@ -83,18 +148,68 @@ EInterface::EInterface(int8_t cs, int8_t dc,
  */
 EInterface::~EInterface()
 {
+	int i;
+
+	if (this->dmaQueue) {
+		tft->setDMAQueue(NULL);
+		delete this->dmaQueue;
+	}
+	setShadow(0);
+#if GUI_PROFILE
+	delete this->profiler;
+#endif
 	if (this->tft)
 		delete this->tft;
+	if (this->canvasPool)
+		delete this->canvasPool;
+	if (this->clockDigits)
+		delete this->clockDigits;
+	if (this->clockSeconds)
+		delete this->clockSeconds;
+	if (this->clockPeriod)
+		delete this->clockPeriod;
+	for (i = 0; i < GUI_FONTS; i++) {
+		if (this->metrics[i])
+			delete this->metrics[i];
+	}
+	if (this->pixmapCache)
+		delete this->pixmapCache;
+	if (this->iconBundle)
+		delete this->iconBundle;
+	if (this->strip)
+		delete[] this->strip;
 }
 
 /**
  * Initialize interface
+ * @param [in] dma DMA bus of the TFT module (NULL: blocking transfers)
  */
-void EInterface::initialize()
+void EInterface::initialize(SPITFT_DMABus *dma)
 {
 	// Initialize TFT module
-	tft->begin();
-	tft->setRotation(2);
+	tft->begin(TFT_SPI_FREQ);
+#if GUI_SPI_DMA
+	if (dma && !dmaQueue) {
+		dmaQueue = new SPITFT_DMAQueue(dma);
+		if (dmaQueue->begin()) {
+			tft->setDMAQueue(dmaQueue);
+		} else {
+			log_e("Cannot initialize DMA, using blocking transfers");
+			delete dmaQueue;
+			dmaQueue = NULL;
+		}
+	}
+#endif
+#if GUI_SHADOW
+	if (!shadow) {
+#ifdef BOARD_HAS_PSRAM
+		setShadow(psramFound() ? -1 : GUI_SHADOW_TILES);
+#else
+		setShadow(GUI_SHADOW_TILES);
+#endif
+	}
+#endif
+	tft->setRotation(layout->rotation);
 	tft->fillScreen(theme.getBackground());
 
 	// Initialize backlight PWM
@@ -103,9 +218,42 @@ void EInterface::initialize()
 	ledcAttachPin(tftLED, 0);
 	ledcWrite(0, backlight);
 
+	// Icons from flash, when the bundle partition is available
+	iconBundle->begin();
+
 	state = true;
 }
 
+/**
+ * Draw the widgets that changed since they were last drawn
+ */
+void EInterface::update()
+{
+	int i;
+
+	if (!state)
+		return;
+
+	PROFILE_SCOPE(PROFILE_UPDATE);
+	for (i = 0; i < WIDGET_MAX; i++) {
+		if (!widgets[i].isDirty())
+			continue;
+		drawWidget(i);
+		widgets[i].drawDone();
+		redraws++;
+	}
+}
+
+/**
+ * Draw the widgets that changed and wait until all drawing has been sent to
+ * the TFT module
+ */
+void EInterface::flush()
+{
+	update();
+	tft->dmaWait();
+}
+
 /**
  * Set backlight level
  * @param [in] level Level
@@ -116,6 +264,40 @@ void EInterface::setBacklight(int level)
 	ledcWrite(0, level);
 }
 
+/**
+ * Set color theme
+ * @param [in] theme Color theme
+ */
+void EInterface::setTheme(ETheme theme)
+{
+	this->theme = theme;
+	setPalette();
+	clockDigits->invalidate();
+	clockSeconds->invalidate();
+	clockPeriod->invalidate();
+	if (state) {
+		clearAll();
+		showAll();
+	}
+}
+
+/**
+ * Set screen layout
+ * @param [in] id Layout
+ */
+void EInterface::setLayout(gui_layout_t id)
+{
+	if (id < 0 || id >= LAYOUT_MAX || layout == &layouts[id])
+		return;
+
+	layout = &layouts[id];
+	if (state) {
+		tft->setRotation(layout->rotation);
+		clearAll();
+		showAll();
+	}
+}
+
 /**
  * Set temperature scale
  * @param [in] scale Scale
@@ -124,14 +306,13 @@ void EInterface::setBacklight(int level)
 void EInterface::setTempScale(temp_scale_t scale)
 {
 	int i;
+
 	tempScale = scale;
-	showTemp1(temp1);
-	showTemp2(temp2);
-	for (i = 0; i < 3; i++) {
-		showForecastWeather(i, forecastWeather[i]);
-		showForecastLabel(i, forecastLabels[i]);
-		showForecastTemp1(i, forecastTemp1[i]);
-		showForecastTemp2(i, forecastTemp2[i]);
+	setWidget(WIDGET_TEMP1);
+	setWidget(WIDGET_TEMP2);
+	for (i = 0; i < GUI_FORECASTS; i++) {
+		setWidget(WIDGET_FORECAST_TEMP1 + i);
+		setWidget(WIDGET_FORECAST_TEMP2 + i);
 	}
 }
 
@@ -142,7 +323,8 @@ void EInterface::setTempScale(temp_scale_t scale)
 void EInterface::setTimeFormat(time_format_t timeFormat)
 {
 	this->timeFormat = timeFormat;
-	showClock(CLOCK_HOURS);
+	setWidget(WIDGET_HOURS);
+	setWidget(WIDGET_PERIOD);
 }
 
 /**
@@ -152,7 +334,7 @@ void EInterface::setTimeFormat(time_format_t timeFormat)
 void EInterface::setCity(const String& city)
 {
 	this->city = city;
-	showCity();
+	setWidget(WIDGET_CITY);
 }
 
 /**
@@ -162,7 +344,7 @@ void EInterface::setCity(const String& city)
 void EInterface::setDate(const String& date)
 {
 	this->date = date;
-	showDate();
+	setWidget(WIDGET_DATE);
 }
 
 /**
@@ -171,9 +353,10 @@ void EInterface::setDate(const String& date)
  */
 void EInterface::setHours(int hours)
 {
-	if (this->hours != hours) {
+	if (hours >= 0 && hours <= 23) {
 		this->hours = hours;
-		showClock(CLOCK_HOURS);
+		setWidget(WIDGET_HOURS);
+		setWidget(WIDGET_PERIOD);
 	}
 }
 
@@ -183,9 +366,9 @@ void EInterface::setHours(int hours)
  */
 void EInterface::setMinutes(int minutes)
 {
-	if (this->minutes != minutes) {
+	if (minutes >= 0 && minutes <= 59) {
 		this->minutes = minutes;
-		showClock(CLOCK_MINUTES);
+		setWidget(WIDGET_MINUTES);
 	}
 }
 
@@ -195,94 +378,9 @@ void EInterface::setMinutes(int minutes)
  */
 void EInterface::setSeconds(int seconds)
 {
-	if (this->seconds != seconds) {
+	if (seconds >= 0 && seconds <= 59) {
 		this->seconds = seconds;
-		showClock(CLOCK_SECONDS);
-	}
-}
-
-/**
- * Show clock
- * @param [in] elements Clock elements to show
- */
-void EInterface::showClock(clock_el_t elements)
-{
-	int16_t x1, y1;
-	uint16_t w, h;
-	int hrs;
-	char str[4];
-
-	// Hours
-	if (elements == CLOCK_ALL || elements == CLOCK_HOURS) {
-		if (this->hours >= 0 && this->hours <= 23) {
-			tft->setTextColor(theme.getClock());
-
-			if (this->timeFormat == TIME_FORMAT_12H) {
-				if (this->hours >= 12) {
-					// PM
-					if (this->hours == 12) {
-						hrs = 12;
-					} else {
-						hrs = this->hours - 12;
-					}
-					strcpy(str, "pm");
-				} else {
-					// AM
-					if (this-> hours == 0) {
-						hrs = 12;
-					} else {
-						hrs = this->hours;
-					}
-					strcpy(str, "am");
-				}
-			} else {
-				hrs = this->hours;
-				strcpy(str, "");
-			}
-			// Print am/pm
-			tft->setFont(&FreeSans9pt7b);
-			tft->setCursor(190, 95);
-			tft->getTextBounds("pm", 190, 95, &x1, &y1, &w, &h);
-			tft->fillRect(x1 - 2, y1 - 2, w + 2, h + 2, theme.getBackground());
-			tft->print(str);
-
-			// Print hours
-			tft->setFont(&FreeSansBold18pt7b);
-			tft->setCursor(60, 95);
-			snprintf(str, sizeof(str), "%02d:", hrs);
-
-			tft->getTextBounds(str, 60, 95, &x1, &y1, &w, &h);
-			tft->fillRect(x1 - 2, y1 - 2, w + 2, h + 2, theme.getBackground());
-			tft->print(str);
-		}
-	}
-
-	// Minutes
-	if (elements == CLOCK_ALL || elements == CLOCK_MINUTES) {
-		if (this->minutes >= 0 && this->minutes <= 59) {
-			tft->setFont(&FreeSansBold18pt7b);
-			tft->setTextColor(theme.getClock());
-			tft->setCursor(110, 95);
-			snprintf(str, sizeof(str), "%02d", this->minutes);
-
-			tft->getTextBounds(str, 110, 95, &x1, &y1, &w, &h);
-			tft->fillRect(x1 - 2, y1 - 2, w + 8, h + 2, theme.getBackground());
-			tft->print(str);
-		}
-	}
-
-	// Seconds
-	if (elements == CLOCK_ALL || elements == CLOCK_SECONDS) {
-		if (this->seconds >= 0 && this->seconds <= 59) {
-			tft->setFont(&FreeSansBold12pt7b);
-			tft->setTextColor(theme.getClock());
-			tft->setCursor(155, 95);
-			snprintf(str, sizeof(str), "%02d", this->seconds);
-
-			tft->getTextBounds(str, 155, 95, &x1, &y1, &w, &h);
-			tft->fillRect(x1 - 2, y1 - 2, w + 5, h + 2, theme.getBackground());
-			tft->print(str);
-		}
+		setWidget(WIDGET_SECONDS);
 	}
 }
 
@@ -293,23 +391,24 @@ void EInterface::showClock(clock_el_t elements)
 void EInterface::setIP(const String& ip)
 {
 	this->ip = ip;
-	showIP();
+	setWidget(WIDGET_IP);
 }
 
 /**
  * Show weather icon
  * @param [in] weather Weather
  * @param [in] Period: 0 = Day, 1 = Night
+ * \note Forecast icons also depend on the period.
  */
 void EInterface::showWeather(weather_t weather, char period)
 {
-	ETheme::pixmap_t icon;
+	int i;
 
 	this->weather = weather;
 	this->period  = period;
-	icon = getWeatherIcon(weather, period);
-	tft->fillRect(0, 18, 60, 60, theme.getBackground());
-	drawPixmap(0, 18, theme.getPixmapFile(icon));
+	setWidget(WIDGET_WEATHER);
+	for (i = 0; i < GUI_FORECASTS; i++)
+		setWidget(WIDGET_FORECAST_WEATHER + i);
 }
 
 /**
@@ -317,17 +416,7 @@ void EInterface::showWeather(weather_t weather, char period)
  */
 void EInterface::showCity()
 {
-	int16_t x1, y1;
-	uint16_t w, h;
-
-	tft->setFont(&FreeSansBold12pt7b);
-	tft->setCursor(70,40);
-	tft->setTextColor(theme.getCity());
-	tft->setTextSize(1);
-
-	tft->getTextBounds(city, 70, 40, &x1, &y1, &w, &h);
-	tft->fillRect(x1, y1, w, h + 1, theme.getBackground());
-	tft->print(city);
+	widgets[WIDGET_CITY].invalidate();
 }
 
 /**
@@ -335,21 +424,7 @@ void EInterface::showCity()
  */
 void EInterface::showIP()
 {
-	int16_t x1, y1;
-	uint16_t w, h;
-
-	tft->setFont(&FreeMono9pt7b);
-	tft->setCursor(50, 10);
-	tft->setTextColor(theme.getIP());
-
-	// Clear text area (maximum size)
-	tft->getTextBounds("000.000.000.000", 50, 10, &x1, &y1, &w, &h);
-	tft->fillRect(x1, y1, w, h + 1, theme.getBackground());
-
-	// Right justified
-	tft->getTextBounds(ip, 50, 10, &x1, &y1, &w, &h);
-	tft->setCursor(210 - w, 10);
-	tft->print(ip);
+	widgets[WIDGET_IP].invalidate();
 }
 
 /**
@@ -357,16 +432,7 @@ void EInterface::showIP()
  */
 void EInterface::showDate()
 {
-	int16_t x1, y1;
-	uint16_t w, h;
-
-	tft->setFont(&FreeSans9pt7b);
-	tft->setCursor(70,55);
-	tft->setTextColor(theme.getDate());
-
-	tft->getTextBounds("Ap", 70, 55, &x1, &y1, &w, &h);
-	tft->fillRect(x1, y1, (320 - x1), h + 1, theme.getBackground());
-	tft->print(date);
+	widgets[WIDGET_DATE].invalidate();
 }
 
 /**
@@ -374,13 +440,8 @@ void EInterface::showDate()
  */
 void EInterface::showTempLabels()
 {
-	tft->setFont(&FreeSans9pt7b);
-	tft->setTextColor(theme.getTempLabel());
-
-	tft->setCursor(5, 120);
-	tft->print("Indoor:");
-	tft->setCursor(5, 185);
-	tft->print("Outdoor:");
+	widgets[WIDGET_LABEL_INDOOR].invalidate();
+	widgets[WIDGET_LABEL_OUTDOOR].invalidate();
 }
 
 /**
@@ -390,7 +451,7 @@ void EInterface::showTempLabels()
 void EInterface::showTemp1(float temp)
 {
 	temp1 = temp;
-	drawTemp(convCelsius(temp1), 5, 160);
+	setWidget(WIDGET_TEMP1);
 }
 
 /**
@@ -400,7 +461,7 @@ void EInterface::showTemp1(float temp)
 void EInterface::showTemp2(float temp)
 {
 	temp2 = temp;
-	drawTemp(convCelsius(temp2), 5, 225);
+	setWidget(WIDGET_TEMP2);
 }
 
 /**
@@ -410,7 +471,7 @@ void EInterface::showTemp2(float temp)
 void EInterface::showHumidity1(int humidity)
 {
 	humidity1 = humidity;
-	drawHumidity(humidity1, 150, 160);
+	setWidget(WIDGET_HUMIDITY1);
 }
 
 /**
@@ -420,7 +481,7 @@ void EInterface::showHumidity1(int humidity)
 void EInterface::showHumidity2(int humidity)
 {
 	humidity2 = humidity;
-	drawHumidity(humidity2, 150, 225);
+	setWidget(WIDGET_HUMIDITY2);
 }
 
 /**
@@ -429,24 +490,8 @@ void EInterface::showHumidity2(int humidity)
  */
 void EInterface::showChannel(int channel)
 {
-	int16_t x1, y1;
-	uint16_t w, h;
-	char str[4];
-
-	tft->setFont(&FreeSans9pt7b);
-	tft->setTextColor(theme.getTempLabel());
-	tft->setCursor(80, 185);
-
-	tft->getTextBounds("000", 80, 185, &x1, &y1, &w, &h);
-	tft->fillRect(x1, y1, w, h + 1, theme.getBackground());
-
-	if (channel != GUI_INV_CHANNEL) {
-		this->channel = channel;
-		snprintf(str, sizeof(str), "%3d", channel);
-		tft->print(str);
-	} else {
-		tft->print("   ");
-	}
+	this->channel = channel;
+	setWidget(WIDGET_CHANNEL);
 }
 
 /**
@@ -456,32 +501,11 @@ void EInterface::showChannel(int channel)
  */
 void EInterface::showForecastWeather(int i, weather_t weather)
 {
-	int x, y;
-	ETheme::pixmap_t icon;
-
-	if (i < 0 || i > 3)
+	if (i < 0 || i >= GUI_FORECASTS)
 		return;
 
-	y = 240;
-	switch(i) {
-		case 0:
-			x = 5;
-			break;
-
-		case 1:
-			x = 90;
-			break;
-
-		case 2:
-			x = 168;
-			break;
-	}
-
-	this->forecastWeather[i] = weather;
-	icon = getWeatherIcon(weather, period);
-
-	tft->fillRect(x, y, 30, 30, theme.getBackground());
-	drawPixmapHalf(x, y, theme.getPixmapFile(icon));
+	forecastWeather[i] = weather;
+	setWidget(WIDGET_FORECAST_WEATHER + i);
 }
 
 /**
@@ -491,36 +515,11 @@ void EInterface::showForecastWeather(int i, weather_t weather)
  */
 void EInterface::showForecastLabel(int i, const String& label)
 {
-	int16_t x1, y1;
-	uint16_t w, h;
-	int x, y;
-
-	if (i < 0 || i > 3)
+	if (i < 0 || i >= GUI_FORECASTS)
 		return;
 
-	y = 260;
-	switch(i) {
-		case 0:
-			x = 40;
-			break;
-
-		case 1:
-			x = 125;
-			break;
-
-		case 2:
-			x = 203;
-			break;
-	}
-
 	forecastLabels[i] = label;
-	tft->setFont(&FreeSans9pt7b);
-	tft->setTextColor(theme.getWeekDay());
-	tft->setCursor(x, y);
-
-	tft->getTextBounds("AAA", x, y, &x1, &y1, &w, &h);
-	tft->fillRect(x1, y1, w, h + 1, theme.getBackground());
-	tft->print(forecastLabels[i]);
+	setWidget(WIDGET_FORECAST_LABEL + i);
 }
 
 /**
@@ -530,32 +529,11 @@ void EInterface::showForecastLabel(int i, const String& label)
  */
 void EInterface::showForecastTemp1(int i, float temp)
 {
-	int x, y;
-
-	if (i < 0 || i > 3)
+	if (i < 0 || i >= GUI_FORECASTS)
 		return;
 
-	y = 305;
-	switch(i) {
-		case 0:
-			x = 5;
-			break;
-
-		case 1:
-			x = 90;
-			break;
-
-		case 2:
-			x = 168;
-			break;
-
-		default:
-			x = 5;
-			break;
-	}
-
 	forecastTemp1[i] = temp;
-	drawForecastTemp(convCelsius(temp), x, y, theme.getWeekTemp1());
+	setWidget(WIDGET_FORECAST_TEMP1 + i);
 }
 
 /**
@@ -565,28 +543,11 @@ void EInterface::showForecastTemp1(int i, float temp)
  */
 void EInterface::showForecastTemp2(int i, float temp)
 {
-	int x, y;
-
-	if (i < 0 || i > 3)
+	if (i < 0 || i >= GUI_FORECASTS)
 		return;
 
-	y = 285;
-	switch(i) {
-		case 0:
-			x = 5;
-			break;
-
-		case 1:
-			x = 90;
-			break;
-
-		case 2:
-			x = 168;
-			break;
-	}
-
 	forecastTemp2[i] = temp;
-	drawForecastTemp(convCelsius(temp), x, y, theme.getWeekTemp2());
+	setWidget(WIDGET_FORECAST_TEMP2 + i);
 }
 
 /**
@@ -596,11 +557,7 @@ void EInterface::showForecastTemp2(int i, float temp)
 void EInterface::showRadio(bool show)
 {
 	this->radio = show;
-	if (show) {
-		drawPixmap(180, 170, theme.getPixmapFile(ETheme::FIG_RADIO));
-	} else  {
-		tft->fillRect(180, 170, 14, 24, theme.getBackground());
-	}
+	setWidget(WIDGET_RADIO);
 }
 
 /**
@@ -610,11 +567,7 @@ void EInterface::showRadio(bool show)
 void EInterface::showWiFi(bool show)
 {
 	this->wifi = show;
-	if (show) {
-		drawPixmap(216, 0, theme.getPixmapFile(ETheme::FIG_WIFI));
-	} else  {
-		tft->fillRect(216, 0, 24, 24, theme.getBackground());
-	}
+	setWidget(WIDGET_WIFI);
 }
 
 /**
@@ -624,11 +577,7 @@ void EInterface::showWiFi(bool show)
 void EInterface::showBattery1(bool show)
 {
 	this->battery1 = show;
-	if (show) {
-		drawPixmap(200, 107, theme.getPixmapFile(ETheme::FIG_BATTERY));
-	} else  {
-		tft->fillRect(200, 107, 32, 15, theme.getBackground());
-	}
+	setWidget(WIDGET_BATTERY1);
 }
 
 /**
@@ -638,11 +587,7 @@ void EInterface::showBattery1(bool show)
 void EInterface::showBattery2(bool show)
 {
 	this->battery2 = show;
-	if (show) {
-		drawPixmap(200, 172, theme.getPixmapFile(ETheme::FIG_BATTERY));
-	} else  {
-		tft->fillRect(200, 172, 32, 15, theme.getBackground());
-	}
+	setWidget(WIDGET_BATTERY2);
 }
 
 /**
@@ -663,12 +608,13 @@ void EInterface::showLogo(int x, int y)
 	int x1 = x;
 	int y1 = y;
 
+	PROFILE_SCOPE(PROFILE_LOGO);
 	if (x < 0)
-		x1 = 10;
+		x1 = layout->logoX;
 	if (y < 0)
-		y1 = 124;
+		y1 = layout->logoY;
 
-	drawPixmap(x1, y1, theme.getPixmapFile(ETheme::FIG_LOGO));
+	drawPixmap(x1, y1, ETheme::FIG_LOGO);
 }
 
 /**
@@ -681,12 +627,13 @@ void EInterface::showVersion(int x, int y)
 	int16_t x1, y1;
 	uint16_t w, h;
 
+	PROFILE_SCOPE(PROFILE_VERSION);
 	tft->setFont(&FreeMono9pt7b);
 	tft->setCursor(x, y);
 	tft->setTextColor(theme.getTempLabel());
 
 	// Clear text area (maximum size)
-	tft->getTextBounds(WSTATION_VERSION, x, y, &x1, &y1, &w, &h);
+	EFontMetrics::place(versionArea, x, y, &x1, &y1, &w, &h);
 	tft->fillRect(x1, y1, w, h + 1, theme.getBackground());
 
 	// Print version
@@ -695,36 +642,17 @@ void EInterface::showVersion(int x, int y)
 }
 
 /**
- * Draw all graphical elements in the screen
+ * Redraw all graphical elements in the screen
+ *
+ * All widgets are invalidated, they are drawn on the next update().
  */
 void EInterface::showAll()
 {
 	int i;
 
-	if (!state)
-		return;
-
-	showCity();
-	showWeather(weather, period);
-	showTempLabels();
-	showTemp1(temp1);
-	showTemp2(temp2);
-	showChannel(channel);
-	showHumidity1(humidity1);
-	showHumidity2(humidity2);
-	showRadio(radio);
-	showIP();
-	showWiFi(wifi);
-	showBattery1(battery1);
-	showBattery2(battery2);
-	showClock(CLOCK_ALL);
-
-	for (i = 0; i < 3; i++) {
-		showForecastWeather(i, forecastWeather[i]);
-		showForecastLabel(i, forecastLabels[i]);
-		showForecastTemp1(i, forecastTemp1[i]);
-		showForecastTemp2(i, forecastTemp2[i]);
-	}
+	PROFILE_SCOPE(PROFILE_SHOW_ALL);
+	for (i = 0; i < WIDGET_MAX; i++)
+		widgets[i].invalidate();
 }
 
 /**
@@ -745,11 +673,103 @@ time_format_t EInterface::getTimeFormat()
 	return timeFormat;
 }
 
+/**
+ * Keep a copy of the screen: fills and canvases that don't change any pixel
+ * are not sent and the screen is read back from memory. Without PSRAM a few
+ * tiles are enough to keep the redrawn areas.
+ * The copy starts empty: the screen must be redrawn to fill it.
+ * @param [in] tiles Number of 16x16 tiles kept (-1: whole screen, 0: none)
+ * @return bool false if the memory cannot be allocated
+ */
+bool EInterface::setShadow(int tiles)
+{
+	int total = SPITFT_Shadow::tileCount(tft->width(), tft->height());
+	size_t size;
+
+	if (this->shadow) {
+		tft->setShadow(NULL);
+		delete this->shadow;
+		this->shadow = NULL;
+	}
+	if (this->shadowPool) {
+		free(this->shadowPool);
+		this->shadowPool = NULL;
+	}
+	if (tiles == 0)
+		return true;
+	if (tiles < 0 || tiles > total)
+		tiles = total;
+
+	size = tiles * SPITFT_SHADOW_TILE_PIXELS * sizeof(uint16_t);
+#ifdef BOARD_HAS_PSRAM
+	if (psramFound())
+		shadowPool = (uint16_t*)ps_malloc(size);
+#endif
+	if (!shadowPool)
+		shadowPool = (uint16_t*)malloc(size);
+	if (!shadowPool) {
+		log_e("Cannot allocate screen copy (%u bytes)", (unsigned int)size);
+		return false;
+	}
+
+	shadow = new SPITFT_Shadow(tft->width(), tft->height(), shadowPool,
+			tiles);
+	tft->setShadow(shadow);
+	return true;
+}
+
+/**
+ * Get the copy of the screen
+ * @return SPITFT_Shadow* NULL if disabled
+ */
+SPITFT_Shadow *EInterface::getShadow()
+{
+	return shadow;
+}
+
+/**
+ * Get pixmap cache
+ * @return EPixmapCache*
+ */
+EPixmapCache *EInterface::getPixmapCache()
+{
+	return pixmapCache;
+}
+
+/**
+ * Get icon bundle
+ * @return EIconBundle*
+ */
+EIconBundle *EInterface::getIconBundle()
+{
+	return iconBundle;
+}
+
+/**
+ * Get the number of widgets drawn
+ * @return unsigned int
+ */
+unsigned int EInterface::getRedraws()
+{
+	return redraws;
+}
+
+/**
+ * Get the number of widget updates skipped because the value on the screen
+ * did not change
+ * @return unsigned int
+ */
+unsigned int EInterface::getSkippedRedraws()
+{
+	return skipped;
+}
+
 /**
  * Clear the whole screen
  */
 void EInterface::clearAll()
 {
+	PROFILE_SCOPE(PROFILE_CLEAR_ALL);
 	tft->fillScreen(theme.getBackground());
 }
 
@@ -812,110 +832,376 @@ void EInterface::print(int x, int y, int16_t color, int16_t bgcolor, const Strin
 
 	/* Clear background area (when needed) */
 	if (bgcolor >= 0) {
-		tft->getTextBounds(text, x, y, &x1, &y1, &w, &h);
+		getTextBounds(&FreeSans9pt7b, text.c_str(), x, y, &x1, &y1, &w, &h);
 		tft->fillRect(x, y - h, w, h + 1, bgcolor);
 	}
 
 	tft->print(text);
 }
 
-#ifdef DEBUG_SCREENSHOT
 /**
- * Take a screenshot of the screen
- * @param file File name
+ * Read pixels of the screen, from the copy of the screen when it holds them
+ * (otherwise from the TFT module)
+ * @param [in] x Left
+ * @param [in] y Top
+ * @param [in] w Width
+ * @param [in] h Height
+ * @param [out] buf Pixels (RGB565), w * h
+ * @return bool false if the area is not on screen
  */
-void EInterface::takeScreenshot(String file)
+bool EInterface::readScreen(int16_t x, int16_t y, int16_t w, int16_t h,
+		uint16_t *buf)
 {
-	int16_t x, y, w, h;
-	int pos;
-	int imgsize;
-	uint16_t *tft_buffer;
-	uint16_t buffer[960]; // 240x4 tile
-	File pic = pfs->open(file, "w");
-
-	if (!pic)
-		return;
+	if (x < 0 || y < 0 || w <= 0 || h <= 0 ||
+			(x + w) > tft->width() || (y + h) > tft->height())
+		return false;
+
+	if (shadow && shadow->readPixels(x, y, w, h, buf))
+		return true;
+	tft->readPixels16(x, y, w, h, buf);
+	return true;
+}
 
-	w = tft->width(); // 240
-	h = tft->height(); // 320
+/**
+ * Get the screen width (current layout)
+ * @return int16_t Pixels
+ */
+int16_t EInterface::getWidth()
+{
+	return tft->width();
+}
 
-	log_i("Taking screenshot %d x %d", w, h);
-	pic.write((uint8_t*)&w, sizeof(w));
-	pic.write((uint8_t*)&h, sizeof(h));
+/**
+ * Get the screen height (current layout)
+ * @return int16_t Pixels
+ */
+int16_t EInterface::getHeight()
+{
+	return tft->height();
+}
 
-	// Take screenshot of the entire screen by 240x4 tiles (due to memory
-	// limitation)
-	for (y = 0; y < h; y+=4) {
-		/* This loop takes longer, we need to refresh the watchdog */
-		esp_task_wdt_reset();
-		tft->readPixels16(0, y, w, 4, buffer);
-		pic.write((uint8_t*)buffer, sizeof(buffer));
-	}
+/**
+ * Record the areas of the screen written from now on
+ * @param [in] damage List of areas (the caller takes and clears them), NULL
+ *                    to stop
+ */
+void EInterface::setDamage(SPITFT_Damage *damage)
+{
+	tft->setDamage(damage);
+}
 
-	// Close file
-	pic.close();
+#if GUI_PROFILE
+/**
+ * Get the render profiler
+ * @return EProfiler*
+ */
+EProfiler *EInterface::getProfiler()
+{
+	return profiler;
 }
 #endif
 
 /* ======================= PRIVATE ======================= */
 
 /**
- * Print a temperature value with degree symbol
- * @param [in] temp Temperature
- * @param [in] x X position
- * @param [in] y Y position
+ * Format the value of a widget from the current state
+ * @param [in] w Widget
+ * @param [out] str Buffer
+ * @param [in] size Buffer size
+ * @return const char* Formatted value (str or a string owned by the interface)
  */
-void EInterface::drawTemp(float temp, int x, int y)
+const char *EInterface::formatWidget(int w, char *str, size_t size)
 {
-	char sc;
-	char tempVal[12];
-	int16_t x1, y1, dx, dy;
-	uint16_t w, h;
-
-	if (tempScale == CELSIUS) {
-		sc = 'C';
-	} else {
-		sc = 'F';
+	int i, hrs;
+
+	str[0] = '\0';
+	switch (w) {
+		case WIDGET_HOURS:
+		case WIDGET_PERIOD:
+			if (hours < 0 || hours > 23)
+				break;
+			hrs = hours;
+			if (timeFormat == TIME_FORMAT_12H) {
+				if (hrs > 12)
+					hrs -= 12;
+				else if (hrs == 0)
+					hrs = 12;
+				if (w == WIDGET_PERIOD)
+					return (hours >= 12 ? "pm" : "am");
+			}
+			if (w == WIDGET_HOURS)
+				snprintf(str, size, "%02d:", hrs);
+			break;
+		case WIDGET_MINUTES:
+			if (minutes >= 0 && minutes <= 59)
+				snprintf(str, size, "%02d", minutes);
+			break;
+		case WIDGET_SECONDS:
+			if (seconds >= 0 && seconds <= 59)
+				snprintf(str, size, "%02d", seconds);
+			break;
+		case WIDGET_DATE:
+			return date.c_str();
+		case WIDGET_CITY:
+			return city.c_str();
+		case WIDGET_IP:
+			return ip.c_str();
+		case WIDGET_WIFI:
+			return (wifi ? "1" : "0");
+		case WIDGET_RADIO:
+			return (radio ? "1" : "0");
+		case WIDGET_BATTERY1:
+			return (battery1 ? "1" : "0");
+		case WIDGET_BATTERY2:
+			return (battery2 ? "1" : "0");
+		case WIDGET_WEATHER:
+			snprintf(str, size, "%d", getWeatherIcon(weather, period));
+			break;
+		case WIDGET_LABEL_INDOOR:
+			return "Indoor:";
+		case WIDGET_LABEL_OUTDOOR:
+			return "Outdoor:";
+		case WIDGET_TEMP1:
+			formatTemp(temp1, str, size);
+			break;
+		case WIDGET_TEMP2:
+			formatTemp(temp2, str, size);
+			break;
+		case WIDGET_HUMIDITY1:
+		case WIDGET_HUMIDITY2:
+			i = (w == WIDGET_HUMIDITY1) ? humidity1 : humidity2;
+			if (i == GUI_INV_HUMIDITY)
+				snprintf(str, size, "--%%");
+			else
+				snprintf(str, size, "%d%%", i);
+			break;
+		case WIDGET_CHANNEL:
+			if (channel != GUI_INV_CHANNEL)
+				snprintf(str, size, "%3d", channel);
+			else
+				snprintf(str, size, "   ");
+			break;
+		default:
+			if (w >= WIDGET_FORECAST_TEMP1) {
+				formatTemp(forecastTemp1[w - WIDGET_FORECAST_TEMP1], str, size);
+			} else if (w >= WIDGET_FORECAST_TEMP2) {
+				formatTemp(forecastTemp2[w - WIDGET_FORECAST_TEMP2], str, size);
+			} else if (w >= WIDGET_FORECAST_LABEL) {
+				return forecastLabels[w - WIDGET_FORECAST_LABEL].c_str();
+			} else if (w >= WIDGET_FORECAST_WEATHER) {
+				i = w - WIDGET_FORECAST_WEATHER;
+				snprintf(str, size, "%d",
+						getWeatherIcon(forecastWeather[i], period));
+			}
+			break;
 	}
-	
-	if (temp == GUI_INV_TEMP) {
-		snprintf(tempVal, sizeof(tempVal), "--.-  %c", sc);
-	} else {
-		snprintf(tempVal, sizeof(tempVal), "%.1f  %c", temp, sc);
+	return str;
+}
+
+/**
+ * Update the value of a widget from the current state
+ *
+ * The widget is only drawn (on the next update()) when its formatted value
+ * is different from the one on the screen.
+ *
+ * @param [in] w Widget
+ */
+void EInterface::setWidget(int w)
+{
+	char str[WIDGET_VALUE_MAX];
+
+	PROFILE_CALL(w);
+	if (!widgets[w].set(formatWidget(w, str, sizeof(str))))
+		skipped++;
+}
+
+/**
+ * Draw a widget at its place in the current layout
+ * @param [in] w Widget
+ */
+void EInterface::drawWidget(int w)
+{
+	int i;
+	const ELayout::element_t& el = layout->el[w];
+	const char *value = widgets[w].get();
+
+	PROFILE_REDRAW(w);
+	switch (w) {
+		case WIDGET_HOURS:
+		case WIDGET_PERIOD:
+			if (hours >= 0)
+				drawClockText(w == WIDGET_HOURS ? clockDigits : clockPeriod,
+						el, value);
+			break;
+		case WIDGET_MINUTES:
+			if (minutes >= 0)
+				drawClockText(clockDigits, el, value);
+			break;
+		case WIDGET_SECONDS:
+			if (seconds >= 0)
+				drawClockText(clockSeconds, el, value);
+			break;
+		case WIDGET_DATE:
+			drawLine(el, date.c_str());
+			break;
+		case WIDGET_CITY:
+			drawLabel(el, city.c_str());
+			break;
+		case WIDGET_IP:
+			drawTextRight(el, ip.c_str());
+			break;
+		case WIDGET_WIFI:
+			drawIcon(el, ETheme::FIG_WIFI, wifi);
+			break;
+		case WIDGET_RADIO:
+			drawIcon(el, ETheme::FIG_RADIO, radio);
+			break;
+		case WIDGET_BATTERY1:
+			drawIcon(el, ETheme::FIG_BATTERY, battery1);
+			break;
+		case WIDGET_BATTERY2:
+			drawIcon(el, ETheme::FIG_BATTERY, battery2);
+			break;
+		case WIDGET_WEATHER:
+			tft->fillRect(el.x, el.y, el.w, el.h, theme.getBackground());
+			drawPixmap(el.cx, el.cy, getWeatherIcon(weather, period));
+			break;
+		case WIDGET_LABEL_INDOOR:
+		case WIDGET_LABEL_OUTDOOR:
+			drawLabel(el, value);
+			break;
+		case WIDGET_TEMP1:
+		case WIDGET_TEMP2:
+			drawTemp(el, value, 30, 5);
+			break;
+		case WIDGET_HUMIDITY1:
+			drawHumidity(el, humidity1, value);
+			break;
+		case WIDGET_HUMIDITY2:
+			drawHumidity(el, humidity2, value);
+			break;
+		case WIDGET_CHANNEL:
+			drawText(el, value);
+			break;
+		default:
+			if (w >= WIDGET_FORECAST_TEMP2) {
+				drawTemp(el, value, 15, 3);
+			} else if (w >= WIDGET_FORECAST_LABEL) {
+				i = w - WIDGET_FORECAST_LABEL;
+				drawText(el, forecastLabels[i].c_str());
+			} else if (w >= WIDGET_FORECAST_WEATHER) {
+				i = w - WIDGET_FORECAST_WEATHER;
+				tft->fillRect(el.x, el.y, el.w, el.h, theme.getBackground());
+				drawPixmapHalf(el.cx, el.cy,
+						getWeatherIcon(forecastWeather[i], period));
+			}
+			break;
 	}
+}
 
-	tft->setFont(&FreeSansBold18pt7b);
-	tft->setTextColor(theme.getTemperature());
-	tft->setCursor(x, y);
+/**
+ * Print a text over its background area
+ * @param [in] el Layout element
+ * @param [in] str Text
+ */
+void EInterface::drawText(const ELayout::element_t& el, const char *str)
+{
+	PROFILE_SCOPE(PROFILE_TEXT);
+	tft->setFont(el.font);
+	tft->setTextColor(palette[el.color]);
+	tft->setCursor(el.cx, el.cy);
 
-	/* Clear background area (largest string) */
-	tft->getTextBounds("-000.0 C", x, y, &x1, &y1, &w, &h);
-	tft->fillRect(x, y - h, w, h + 1, theme.getBackground());
+	tft->fillRect(el.x, el.y, el.w, el.h, theme.getBackground());
+	tft->print(str);
+}
 
-	/* Get the bounds of the current text */
-	tft->getTextBounds(tempVal, x, y, &x1, &y1, &w, &h);
-	dx = x + w - 30;
-	dy = y - h + 5;
+/**
+ * Print a text right justified over its background area
+ * @param [in] el Layout element (the cursor is the right end of the text)
+ * @param [in] str Text
+ */
+void EInterface::drawTextRight(const ELayout::element_t& el, const char *str)
+{
+	int16_t x1, y1;
+	uint16_t w, h;
 
-	/* Draw value and degree symbol */
-	tft->print(tempVal);
-	tft->drawCircle(dx, dy, 5, theme.getTemperature());
+	PROFILE_SCOPE(PROFILE_TEXT_RIGHT);
+	tft->setFont(el.font);
+	tft->setTextColor(palette[el.color]);
+	tft->fillRect(el.x, el.y, el.w, el.h, theme.getBackground());
+
+	// Measure at the left side, so the text does not wrap
+	getTextBounds(el.font, str, el.x, el.cy, &x1, &y1, &w, &h);
+	tft->setCursor(el.cx - w, el.cy);
+	tft->print(str);
 }
 
 /**
- * Print a forecast temperature
- * @param [in] temp Temperature
- * @param [in] x X position
- * @param [in] y Y position
- * @param [in] color Color
+ * Print a text clearing only its own bounds
+ * @param [in] el Layout element
+ * @param [in] str Text
  */
-void EInterface::drawForecastTemp(float temp, int x, int y, int16_t color)
+void EInterface::drawLabel(const ELayout::element_t& el, const char *str)
 {
-	char sc;
-	char tempVal[12];
-	int16_t x1, y1, dx, dy;
+	int16_t x1, y1;
 	uint16_t w, h;
 
+	PROFILE_SCOPE(PROFILE_LABEL);
+	tft->setFont(el.font);
+	tft->setCursor(el.cx, el.cy);
+	tft->setTextColor(palette[el.color]);
+	tft->setTextSize(1);
+
+	getTextBounds(el.font, str, el.cx, el.cy, &x1, &y1, &w, &h);
+	tft->fillRect(x1, y1, w, h + 1, theme.getBackground());
+	tft->print(str);
+}
+
+/**
+ * Print a text on a region composed off-screen
+ * @param [in] el Layout element
+ * @param [in] str Text
+ */
+void EInterface::drawLine(const ELayout::element_t& el, const char *str)
+{
+	int16_t ox, oy;
+	Adafruit_GFX *gfx;
+
+	PROFILE_SCOPE(PROFILE_LINE);
+	gfx = beginRegion(el.x, el.y, el.w, el.h, &ox, &oy);
+	gfx->setFont(el.font);
+	gfx->setCursor(el.cx - ox, el.cy - oy);
+	gfx->setTextColor(palette[el.color]);
+	gfx->print(str);
+	endRegion(gfx, ox, oy);
+}
+
+/**
+ * Draw or clear a status icon
+ * @param [in] el Layout element
+ * @param [in] pixmap Icon
+ * @param [in] show Draw the icon (true) or clear its area (false)
+ */
+void EInterface::drawIcon(const ELayout::element_t& el,
+		ETheme::pixmap_t pixmap, bool show)
+{
+	PROFILE_SCOPE(PROFILE_ICON);
+	if (show)
+		drawPixmap(el.cx, el.cy, pixmap);
+	else
+		tft->fillRect(el.x, el.y, el.w, el.h, theme.getBackground());
+}
+
+/**
+ * Format a temperature value with the scale symbol
+ * @param [in] temp Temperature (in Celsius)
+ * @param [out] str Buffer
+ * @param [in] size Buffer size
+ */
+void EInterface::formatTemp(float temp, char *str, size_t size)
+{
+	char sc;
+
 	if (tempScale == CELSIUS) {
 		sc = 'C';
 	} else {
@@ -923,157 +1209,425 @@ void EInterface::drawForecastTemp(float temp, int x, int y, int16_t color)
 	}
 
 	if (temp == GUI_INV_TEMP) {
-		snprintf(tempVal, sizeof(tempVal), "--.-  %c", sc);
+		snprintf(str, size, "--.-  %c", sc);
 	} else {
-		snprintf(tempVal, sizeof(tempVal), "%.1f  %c", temp, sc);
+		snprintf(str, size, "%.1f  %c", convCelsius(temp), sc);
 	}
+}
 
-	tft->setFont(&FreeSans9pt7b);
-	tft->setCursor(x, y);
-	tft->setTextColor(color);
+/**
+ * Print a temperature value with degree symbol
+ * @param [in] el Layout element
+ * @param [in] str Temperature (formatted)
+ * @param [in] dx Position of the degree symbol, from the end of the text
+ * @param [in] r Radius of the degree symbol
+ */
+void EInterface::drawTemp(const ELayout::element_t& el, const char *str,
+		int16_t dx, int16_t r)
+{
+	int16_t x1, y1, ox, oy;
+	uint16_t w, h;
+	Adafruit_GFX *gfx;
 
-	/* Clear background area (largest string) */
-	tft->getTextBounds("-000.0 C", x, y, &x1, &y1, &w, &h);
-	tft->fillRect(x, y - h, w, h + 1, theme.getBackground());
+	PROFILE_SCOPE(PROFILE_TEMP);
+	gfx = beginRegion(el.x, el.y, el.w, el.h, &ox, &oy);
+	gfx->setFont(el.font);
+	gfx->setTextColor(palette[el.color]);
+	gfx->setCursor(el.cx - ox, el.cy - oy);
 
 	/* Get the bounds of the current text */
-	tft->getTextBounds(tempVal, x, y, &x1, &y1, &w, &h);
-	dx = x + w - 15;
-	dy = y - h + 5;
+	getTextBounds(el.font, str, el.cx, el.cy, &x1, &y1, &w, &h);
 
 	/* Draw value and degree symbol */
-	tft->print(tempVal);
-	tft->drawCircle(dx, dy, 3, color);
+	gfx->print(str);
+	gfx->drawCircle(el.cx + w - dx - ox, el.cy - h + 5 - oy, r,
+			palette[el.color]);
+	endRegion(gfx, ox, oy);
 }
 
 /**
  * Print humidity value
+ * @param [in] el Layout element
  * @param [in] humidity Humidity value (0 to 100)
- * @param [in] x X position
- * @param [in] y Y position
+ * @param [in] str Humidity (formatted)
  */
-void EInterface::drawHumidity(int humidity, int x, int y)
+void EInterface::drawHumidity(const ELayout::element_t& el, int humidity,
+		const char *str)
 {
-	char humVal[6];
-	int16_t x1, y1;
-	uint16_t w, h;
-
-	tft->setFont(&FreeSansBold18pt7b);
-	tft->setCursor(x, y);
+	int16_t ox, oy;
+	uint16_t color;
+	Adafruit_GFX *gfx;
 
+	PROFILE_SCOPE(PROFILE_HUMIDITY);
 	if (humidity == GUI_INV_HUMIDITY) {
-		snprintf(humVal, sizeof(humVal), "--%%");
+		color = theme.getTempLabel();
+	} else if (humidity >= HUMIDITY_L2_HIGH) {
+		color = theme.getHumidity(2);
+	} else if (humidity >= HUMIDITY_L1_IDEAL) {
+		color = theme.getHumidity(1);
 	} else {
-		snprintf(humVal, sizeof(humVal), "%d%%", humidity);
+		color = theme.getHumidity(0);
+	}
 
-		if (humidity >= HUMIDITY_L2_HIGH) {
-			tft->setTextColor(theme.getHumidity(2));
-		} else if (humidity >= HUMIDITY_L1_IDEAL) {
-			tft->setTextColor(theme.getHumidity(1));
-		} else {
-			tft->setTextColor(theme.getHumidity(0));
+	gfx = beginRegion(el.x, el.y, el.w, el.h, &ox, &oy);
+	gfx->setFont(el.font);
+	gfx->setTextColor(color);
+	gfx->setCursor(el.cx - ox, el.cy - oy);
+	gfx->print(str);
+	endRegion(gfx, ox, oy);
+}
+
+/**
+ * Get the bounds of a string (same as Adafruit_GFX::getTextBounds)
+ *
+ * The string is measured from the flat metrics table of the font, falling
+ * back to the TFT module when the text would wrap (or the font has no
+ * metrics table).
+ *
+ * @param [in] font Font
+ * @param [in] str String
+ * @param [in] x Cursor position (X axis)
+ * @param [in] y Cursor position (Y axis)
+ * @param [out] x1 Top left corner (X axis)
+ * @param [out] y1 Top left corner (Y axis)
+ * @param [out] w Width
+ * @param [out] h Height
+ */
+void EInterface::getTextBounds(const GFXfont *font, const char *str,
+		int16_t x, int16_t y, int16_t *x1, int16_t *y1,
+		uint16_t *w, uint16_t *h)
+{
+	int i;
+
+	for (i = 0; i < GUI_FONTS; i++) {
+		if (metrics[i]->getFont() == font) {
+			if (metrics[i]->getTextBounds(str, x, y, tft->width(),
+						tft->height(), x1, y1, w, h))
+				return;
+			break;
+		}
+	}
+
+	tft->setFont(font);
+	tft->getTextBounds(str, x, y, x1, y1, w, h);
+}
+
+/**
+ * Print a clock element
+ *
+ * The element is composed from pre-rendered characters, falling back to
+ * print the text with the cache font when they are not available.
+ *
+ * @param [in] cache Characters cache
+ * @param [in] el Layout element
+ * @param [in] str String
+ */
+void EInterface::drawClockText(EGlyphCache *cache,
+		const ELayout::element_t& el, const char *str)
+{
+	int16_t ox, oy;
+	Adafruit_GFX *gfx;
+	ECanvas *canvas;
+
+	PROFILE_SCOPE(PROFILE_CLOCK_TEXT);
+	gfx = beginRegion(el.x, el.y, el.w, el.h, &ox, &oy);
+
+	if (gfx != tft) {
+		canvas = static_cast<ECanvas*>(gfx);
+		if (cache->build(palette[el.color], theme.getBackground()) &&
+				cache->draw(canvas->getBuffer(), canvas->width(),
+					canvas->height(), el.cx - ox, el.cy - oy, str)) {
+			endRegion(gfx, ox, oy);
+			return;
 		}
 	}
 
-	/* Clear background area (consider maximum size) */
-	tft->getTextBounds("000%", x, y, &x1, &y1, &w, &h);
-	tft->fillRect(x, y - h, w + 6, h + 1, theme.getBackground());
+	gfx->setFont(cache->getFont());
+	gfx->setTextColor(palette[el.color]);
+	gfx->setCursor(el.cx - ox, el.cy - oy);
+	gfx->print(str);
+	endRegion(gfx, ox, oy);
+}
+
+/**
+ * Begin drawing a screen region
+ *
+ * The region is composed off-screen on a canvas from the pool, which is
+ * cleared with the background color. When there is no canvas available, the
+ * region is cleared directly on the screen.
+ *
+ * @param [in] x X position
+ * @param [in] y Y position
+ * @param [in] w Width
+ * @param [in] h Height
+ * @param [out] ox Region origin (X axis), to be subtracted from coordinates
+ * @param [out] oy Region origin (Y axis), to be subtracted from coordinates
+ * @return Adafruit_GFX* Where to draw the region
+ */
+Adafruit_GFX *EInterface::beginRegion(int16_t x, int16_t y,
+		int16_t w, int16_t h, int16_t *ox, int16_t *oy)
+{
+	ECanvas *canvas = NULL;
+
+	// Clip region to the screen
+	if (x < 0) {
+		w += x;
+		x  = 0;
+	}
+	if (y < 0) {
+		h += y;
+		y  = 0;
+	}
+	if ((x + w) > tft->width())
+		w = tft->width() - x;
+	if ((y + h) > tft->height())
+		h = tft->height() - y;
+
+	if (w > 0 && h > 0)
+		canvas = canvasPool->acquire(w, h);
+
+	if (canvas) {
+		canvas->fillScreen(theme.getBackground());
+		*ox = x;
+		*oy = y;
+		return canvas;
+	}
 
-	/* Draw value */
-	tft->print(humVal);
+	tft->fillRect(x, y, w, h, theme.getBackground());
+	*ox = 0;
+	*oy = 0;
+	return tft;
 }
 
 /**
- * Read 16 bits number from file
- * @param [in] f File
- * @return uint16_t
+ * Finish drawing a screen region
+ * @param [in] gfx Value returned by beginRegion()
+ * @param [in] ox Region origin (X axis)
+ * @param [in] oy Region origin (Y axis)
  */
-uint16_t EInterface::readInt(File f)
+void EInterface::endRegion(Adafruit_GFX *gfx, int16_t ox, int16_t oy)
 {
-	char num[2];
-	num[0] = f.read();
-	num[1] = f.read();
-	return (((num[1] << 8) & 0xff00) | (num[0] & 0xff));
+	ECanvas *canvas;
+
+	if (gfx == tft)
+		return;
+
+	canvas = static_cast<ECanvas*>(gfx);
+	canvas->push(tft, ox, oy);
+	canvasPool->release(canvas);
 }
 
 /**
  * Draw a pixel map file on the screen
  * @param [in] x Initial position (X axis)
  * @param [in] y Initial position (Y axis)
- * @param file File name
+ * @param [in] pixmap Pixmap
  */
-void EInterface::drawPixmap(int x, int y, String file)
+void EInterface::drawPixmap(int x, int y, ETheme::pixmap_t pixmap)
 {
-	int w, h;
-	int pos;
-	int imgsize;
-	File pic = pfs->open(file, "r");
+	uint16_t w, h;
+	const uint16_t *pixels;
+	EPixmapReader pic;
+
+	PROFILE_SCOPE(PROFILE_PIXMAP);
+	if ((pixels = iconBundle->get(pixmap, false, &w, &h)) ||
+			(pixels = pixmapCache->get(pixmap, false, &w, &h))) {
+		tft->drawRGBBitmap(x, y, (uint16_t*)pixels, w, h);
+		return;
+	}
+
+	if (pic.open(pfs, theme.getPixmapFile(pixmap)))
+		loadPixmap(x, y, pixmap, false, pic, false);
+}
 
-	if (!pic)
+/**
+ * Draw a pixel map file at half size on the screen
+ * @param [in] x Initial position (X axis)
+ * @param [in] y Initial position (Y axis)
+ * @param [in] pixmap Pixmap
+ */
+void EInterface::drawPixmapHalf(int x, int y, ETheme::pixmap_t pixmap)
+{
+	uint16_t wh, hh;
+	const uint16_t *pixels;
+	String file;
+	EPixmapReader pic;
+
+	PROFILE_SCOPE(PROFILE_PIXMAP_HALF);
+	if ((pixels = iconBundle->get(pixmap, true, &wh, &hh)) ||
+			(pixels = pixmapCache->get(pixmap, true, &wh, &hh))) {
+		tft->drawRGBBitmap(x, y, (uint16_t*)pixels, wh, hh);
 		return;
+	}
+
+	file = theme.getPixmapFile(pixmap, ETheme::PIXMAP_HALF);
+	if (file.length() > 0 && pic.open(pfs, file)) {
+		// Half size file from the asset pipeline
+		loadPixmap(x, y, pixmap, true, pic, false);
+	} else if (pic.open(pfs, theme.getPixmapFile(pixmap))) {
+		// Not available (older file system image): scale at run time
+		loadPixmap(x, y, pixmap, true, pic, true);
+	}
+}
 
-	w = readInt(pic);
-	h = readInt(pic);
-	imgsize = w * h;
-	uint16_t *buffer = new uint16_t[imgsize];
+/**
+ * Decode a pixel map file into the cache (when it fits) and draw it
+ * @param [in] x Initial position (X axis)
+ * @param [in] y Initial position (Y axis)
+ * @param [in] pixmap Pixmap
+ * @param [in] half Half size pixmap
+ * @param [in] pic Pixmap file
+ * @param [in] scale Scale the file down to half size
+ */
+void EInterface::loadPixmap(int x, int y, ETheme::pixmap_t pixmap,
+		bool half, EPixmapReader& pic, bool scale)
+{
+	uint16_t w, h;
+	uint16_t *buffer = NULL;
+	int lines;
+
+	w = scale ? (pic.width() / 2) : pic.width();
+	h = scale ? (pic.height() / 2) : pic.height();
+
+	if (!scale || (strip && 2 * pic.width() <= PIXMAP_STRIP_PIXELS))
+		buffer = pixmapCache->put(pixmap, half, w, h);
 
 	if (!buffer) {
-		pic.close();
+		streamPixmap(x, y, pic, scale);
 		return;
 	}
 
-	pos = 0;
-	while(pic.available() && pos < imgsize) {
-		buffer[pos++] = readInt(pic);
+	// Decode into the cache with a single read
+	if (scale)
+		lines = pic.readHalf(buffer, h, strip);
+	else
+		lines = pic.read(buffer, h);
+	if (lines == h) {
+		tft->drawRGBBitmap(x, y, buffer, w, h);
+		return;
 	}
-	pic.close();
 
-	tft->drawRGBBitmap(x, y, buffer, w, h);
-
-	delete buffer;
+	// Truncated file: draw what was decoded, then drop the entry (this
+	// frees the buffer)
+	if (lines > 0)
+		tft->drawRGBBitmap(x, y, buffer, w, lines);
+	pixmapCache->remove(pixmap, half);
 }
 
 /**
- * Draw a pixel map file at half size on the screen
+ * Stream a pixel map to the screen, one strip of lines at a time
  * @param [in] x Initial position (X axis)
  * @param [in] y Initial position (Y axis)
- * @param file File name
+ * @param [in] pic Pixmap file
+ * @param [in] half Draw at half size
  */
-void EInterface::drawPixmapHalf(int x, int y, String file)
+void EInterface::streamPixmap(int x, int y, EPixmapReader& pic, bool half)
 {
-	int w, h, wh, hh;
-	int i, j;
-	int pos;
-	int imgsize;
-	File pic = pfs->open(file, "r");
+	uint16_t *scratch = NULL;
+	int w, h, n, row, lines;
+	int capacity = PIXMAP_STRIP_PIXELS;
+
+	w = half ? (pic.width() / 2) : pic.width();
+	h = half ? (pic.height() / 2) : pic.height();
 
-	if (!pic)
+	// Half size: last part of the strip holds two lines of the file
+	if (half) {
+		capacity -= 2 * pic.width();
+		scratch = strip + capacity;
+	}
+	if (!strip || w == 0 || capacity < w) {
+		log_e("Cannot stream pixmap %d x %d", pic.width(), pic.height());
 		return;
+	}
 
-	w  = readInt(pic);
-	h  = readInt(pic);
-	wh = w / 2;
-	hh = h / 2;
-	imgsize = wh * hh;
-	uint16_t buffer[imgsize];
-
-	pos = 0;
-	for (i = 0; i < h; i++) {
-		for (j = 0; j < w; j+=2) {
-			if ((i % 2) != 0) {
-				// Discard this line
-				readInt(pic);
-				readInt(pic);
-				continue;
-			} else {
-				buffer[pos++] = readInt(pic);
-				readInt(pic);
-			}
+	if (x >= 0 && y >= 0 &&
+			(x + w) <= tft->width() && (y + h) <= tft->height()) {
+		tft->startWrite();
+		tft->setAddrWindow(x, y, w, h);
+		if (half)
+			streamLines(pic, scratch, capacity / w);
+		else
+			streamSpans(pic);
+		tft->endWrite();
+		return;
+	}
+
+	// Partially visible, let the driver clip each strip
+	n = capacity / w;
+	for (row = 0; row < h; row += lines) {
+		if (half)
+			lines = pic.readHalf(strip, n, scratch);
+		else
+			lines = pic.read(strip, n);
+		if (lines <= 0)
+			break;
+		tft->drawRGBBitmap(x, y + row, strip, w, lines);
+	}
+}
+
+/**
+ * Send lines of a pixel map at half size to the current address window
+ * @param [in] pic Pixmap file
+ * @param [in] scratch Buffer for two lines of the file
+ * @param [in] n Lines per strip
+ */
+void EInterface::streamLines(EPixmapReader& pic, uint16_t *scratch, int n)
+{
+	int lines;
+
+	while ((lines = pic.readHalf(strip, n, scratch)) > 0)
+		tft->writePixels(strip, lines * (pic.width() / 2), false);
+}
+
+/**
+ * Send a pixel map to the current address window
+ *
+ * Pixels are gathered on the strip buffer and sent in bursts. Runs of at
+ * least PIXMAP_FILL_MIN pixels (compressed files) are sent as a single fill.
+ *
+ * @param [in] pic Pixmap file
+ */
+void EInterface::streamSpans(EPixmapReader& pic)
+{
+	uint32_t n, pending = 0;
+	bool fill;
+
+	while ((n = pic.readSpan(strip + pending,
+					PIXMAP_STRIP_PIXELS - pending, &fill)) > 0) {
+		if (fill && n >= PIXMAP_FILL_MIN) {
+			if (pending)
+				tft->writePixels(strip, pending, false);
+			tft->writeColor(strip[pending], n);
+			pending = 0;
+			continue;
+		}
+		if (fill)
+			rgb565Fill(strip + pending + 1, strip[pending], n - 1);
+		pending += n;
+		if (pending == PIXMAP_STRIP_PIXELS) {
+			tft->writePixels(strip, pending, false);
+			pending = 0;
 		}
 	}
-	pic.close();
+	if (pending)
+		tft->writePixels(strip, pending, false);
+}
 
-	tft->drawRGBBitmap(x, y, buffer, wh, hh);
+/**
+ * Resolve the colors of the layout elements from the color theme
+ */
+void EInterface::setPalette()
+{
+	palette[ELayout::COLOR_NONE]        = theme.getDefaultText();
+	palette[ELayout::COLOR_CITY]        = theme.getCity();
+	palette[ELayout::COLOR_IP]          = theme.getIP();
+	palette[ELayout::COLOR_DATE]        = theme.getDate();
+	palette[ELayout::COLOR_CLOCK]       = theme.getClock();
+	palette[ELayout::COLOR_TEMP_LABEL]  = theme.getTempLabel();
+	palette[ELayout::COLOR_TEMPERATURE] = theme.getTemperature();
+	palette[ELayout::COLOR_WEEKDAY]     = theme.getWeekDay();
+	palette[ELayout::COLOR_WEEK_TEMP1]  = theme.getWeekTemp1();
+	palette[ELayout::COLOR_WEEK_TEMP2]  = theme.getWeekTemp2();
 }
 
 /**
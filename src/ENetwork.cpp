@@ -0,0 +1,389 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file ENetwork.cpp
+ * @class ENetwork
+ * Connection pool, DNS cache and timing counters of the outbound requests
+ */
+#include <ENetwork.h>
+
+/**
+ * Constructor
+ */
+ENetwork::ENetwork() :
+	dnsTTL(NET_DNS_TTL), keepAlive(true), since(0)
+{
+	int i;
+
+	mux = portMUX_INITIALIZER_UNLOCKED;
+	for (i = 0; i < NET_DNS_ENTRIES; i++)
+		dns[i].host[0] = '\0';
+	for (i = 0; i < NET_POOL_SIZE; i++) {
+		pool[i].host[0] = '\0';
+		pool[i].port    = 0;
+		pool[i].busy    = false;
+		pool[i].lastUse = 0;
+	}
+	resetStats();
+}
+
+/**
+ * Resolve a host name
+ *
+ * Answers are kept for the DNS TTL. The lookup itself is done without the
+ * lock, so other tasks are not held while the DNS server answers.
+ *
+ * @param [in] host Host name (or address)
+ * @param [out] ip Address
+ * @return bool true on success
+ */
+bool ENetwork::resolve(const char *host, IPAddress& ip)
+{
+	unsigned long now = millis();
+	uint32_t us;
+	bool found = false;
+	int i, slot;
+
+	portENTER_CRITICAL(&mux);
+	for (i = 0; i < NET_DNS_ENTRIES; i++) {
+		if (dns[i].host[0] && (long)(dns[i].expires - now) > 0 &&
+				!strcmp(dns[i].host, host)) {
+			ip    = dns[i].ip;
+			found = true;
+			st.dnsHits++;
+			break;
+		}
+	}
+	portEXIT_CRITICAL(&mux);
+	if (found)
+		return true;
+
+	us    = micros();
+	found = WiFi.hostByName(host, ip) == 1;
+	us    = micros() - us;
+
+	portENTER_CRITICAL(&mux);
+	st.dnsLookups++;
+	addTime(&st.dnsUs, &st.dnsMaxUs, us);
+	if (!found) {
+		st.dnsErrors++;
+	} else if (strlen(host) < NET_HOST_MAX) {
+		// Same host, else an unused or expired entry, else the oldest
+		slot = 0;
+		for (i = 0; i < NET_DNS_ENTRIES; i++) {
+			if (!strcmp(dns[i].host, host)) {
+				slot = i;
+				break;
+			}
+			if (!dns[i].host[0] || (long)(dns[i].expires - now) <= 0 ||
+					(long)(dns[i].expires - dns[slot].expires) < 0)
+				slot = i;
+		}
+		strcpy(dns[slot].host, host);
+		dns[slot].ip      = ip;
+		dns[slot].expires = now + dnsTTL;
+	}
+	portEXIT_CRITICAL(&mux);
+
+	if (!found)
+		log_e("Cannot resolve %s", host);
+	return found;
+}
+
+/**
+ * Forget the DNS answers
+ */
+void ENetwork::flushDNS()
+{
+	int i;
+
+	portENTER_CRITICAL(&mux);
+	for (i = 0; i < NET_DNS_ENTRIES; i++)
+		dns[i].host[0] = '\0';
+	portEXIT_CRITICAL(&mux);
+}
+
+/**
+ * Set the time DNS answers are kept
+ * @param [in] ms Time (ms), for the next answers
+ */
+void ENetwork::setDNSTTL(uint32_t ms)
+{
+	dnsTTL = ms;
+}
+
+/**
+ * Keep connections open between requests
+ * @param [in] keepAlive false to close each connection after its request
+ */
+void ENetwork::setKeepAlive(bool keepAlive)
+{
+	this->keepAlive = keepAlive;
+	if (!keepAlive)
+		closeIdle();
+}
+
+/**
+ * Take a connection to a server
+ *
+ * The connection of the pool kept for the server is reused when it is still
+ * open. Otherwise the least recently used idle connection of the pool is
+ * connected to the server, or, when all of them are in use, a connection
+ * that is closed after the request.
+ *
+ * @param [in] host Server
+ * @param [in] port Port
+ * @param [in] fresh Do not reuse a connection
+ * @param [out] reused true when the connection was already open
+ * @return WiFiClient* Connection (give it back with release()), NULL on
+ *                     error
+ */
+WiFiClient *ENetwork::acquire(const char *host, uint16_t port, bool fresh,
+		bool *reused)
+{
+	unsigned long now = millis();
+	connection_t *conn = NULL;
+	WiFiClient *client;
+	int i;
+
+	*reused = false;
+	portENTER_CRITICAL(&mux);
+	for (i = 0; i < NET_POOL_SIZE && keepAlive && !fresh; i++) {
+		connection_t *c = &pool[i];
+		if (!c->busy && c->port == port && !strcmp(c->host, host) &&
+				now - c->lastUse < NET_IDLE_TIMEOUT) {
+			conn    = c;
+			*reused = true;
+			break;
+		}
+	}
+	for (i = 0; i < NET_POOL_SIZE && !*reused; i++) {
+		connection_t *c = &pool[i];
+		if (!c->busy && (!conn || (conn->host[0] && (!c->host[0] ||
+						(long)(c->lastUse - conn->lastUse) < 0))))
+			conn = c;
+	}
+	if (conn) {
+		conn->busy = true;
+		if (!*reused)
+			conn->host[0] = '\0';
+	}
+	portEXIT_CRITICAL(&mux);
+
+	if (!conn) {
+		client = new WiFiClient();
+	} else {
+		client = &conn->client;
+		// Closed by the server while idle
+		if (*reused && !client->connected())
+			*reused = false;
+		if (*reused)
+			return client;
+	}
+
+	if (!connect(client, host, port)) {
+		release(client, false);
+		return NULL;
+	}
+	if (conn && strlen(host) < NET_HOST_MAX) {
+		strcpy(conn->host, host);
+		conn->port = port;
+	}
+	return client;
+}
+
+/**
+ * Give a connection back
+ * @param [in] client Connection from acquire()
+ * @param [in] keep The connection can be reused (the response has been
+ *                  read to the end and the server keeps it open)
+ */
+void ENetwork::release(WiFiClient *client, bool keep)
+{
+	connection_t *conn = NULL;
+	int i;
+
+	for (i = 0; i < NET_POOL_SIZE; i++) {
+		if (client == &pool[i].client)
+			conn = &pool[i];
+	}
+	if (!conn) {
+		client->stop();
+		delete client;
+		return;
+	}
+
+	keep = keep && keepAlive && conn->host[0];
+	if (!keep)
+		client->stop();
+	portENTER_CRITICAL(&mux);
+	if (!keep)
+		conn->host[0] = '\0';
+	conn->lastUse = millis();
+	conn->busy    = false;
+	portEXIT_CRITICAL(&mux);
+}
+
+/**
+ * Close the idle connections
+ */
+void ENetwork::closeIdle()
+{
+	bool idle;
+	int i;
+
+	for (i = 0; i < NET_POOL_SIZE; i++) {
+		portENTER_CRITICAL(&mux);
+		idle = !pool[i].busy;
+		if (idle) {
+			pool[i].busy    = true;
+			pool[i].host[0] = '\0';
+		}
+		portEXIT_CRITICAL(&mux);
+		if (idle) {
+			pool[i].client.stop();
+			portENTER_CRITICAL(&mux);
+			pool[i].busy = false;
+			portEXIT_CRITICAL(&mux);
+		}
+	}
+}
+
+/**
+ * Copy the counters
+ * @param [out] stats Counters
+ */
+void ENetwork::getStats(net_stats_t *stats)
+{
+	portENTER_CRITICAL(&mux);
+	*stats = st;
+	portEXIT_CRITICAL(&mux);
+}
+
+/**
+ * Reset the counters
+ */
+void ENetwork::resetStats()
+{
+	portENTER_CRITICAL(&mux);
+	memset(&st, 0, sizeof(st));
+	since = millis();
+	portEXIT_CRITICAL(&mux);
+}
+
+/**
+ * Write the counters as JSON
+ * @param [in] out Output
+ */
+void ENetwork::printJSON(Print& out)
+{
+	net_stats_t s;
+
+	getStats(&s);
+	out.printf("{\"ms\":%lu,\"requests\":%u,\"reused\":%u,\"retries\":%u,"
+			"\"connect\":{\"count\":%u,\"errors\":%u,\"us\":%u,\"max_us\":%u},"
+			"\"dns\":{\"hits\":%u,\"lookups\":%u,\"errors\":%u,\"us\":%u,"
+			"\"max_us\":%u},\"ttfb\":{\"us\":%u,\"max_us\":%u}}",
+			millis() - since, s.requests, s.reused, s.retries, s.connects,
+			s.connectErrors, s.connectUs, s.connectMaxUs, s.dnsHits,
+			s.dnsLookups, s.dnsErrors, s.dnsUs, s.dnsMaxUs, s.ttfbUs,
+			s.ttfbMaxUs);
+}
+
+/* ======================= PRIVATE ======================= */
+
+/**
+ * Connect a client to a server
+ * @param [in] client Client
+ * @param [in] host Server
+ * @param [in] port Port
+ * @return bool true on success
+ */
+bool ENetwork::connect(WiFiClient *client, const char *host, uint16_t port)
+{
+	IPAddress ip;
+	uint32_t us;
+	bool ok;
+
+	client->stop();
+	if (!resolve(host, ip))
+		return false;
+
+	us = micros();
+	ok = client->connect(ip, port, NET_TIMEOUT);
+	us = micros() - us;
+	if (ok)
+		client->setTimeout(NET_TIMEOUT / 1000);
+
+	portENTER_CRITICAL(&mux);
+	if (ok) {
+		st.connects++;
+		addTime(&st.connectUs, &st.connectMaxUs, us);
+	} else {
+		st.connectErrors++;
+	}
+	portEXIT_CRITICAL(&mux);
+
+	if (!ok)
+		log_e("Cannot connect to %s:%u", host, port);
+	return ok;
+}
+
+/**
+ * Add a time to a counter and its maximum
+ * @param [in,out] total Counter
+ * @param [in,out] max Maximum
+ * @param [in] us Time
+ */
+void ENetwork::addTime(uint32_t *total, uint32_t *max, uint32_t us)
+{
+	*total += us;
+	if (us > *max)
+		*max = us;
+}
+
+/**
+ * Count a request
+ * @param [in] reused Sent on a kept-alive connection
+ * @param [in] retry Sent again on a new connection
+ * @param [in] ttfbUs Time to the first byte of the response (us)
+ */
+void ENetwork::countRequest(bool reused, bool retry, uint32_t ttfbUs)
+{
+	portENTER_CRITICAL(&mux);
+	st.requests++;
+	if (reused)
+		st.reused++;
+	if (retry)
+		st.retries++;
+	addTime(&st.ttfbUs, &st.ttfbMaxUs, ttfbUs);
+	portEXIT_CRITICAL(&mux);
+}
@@ -0,0 +1,261 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EPixmapCache.cpp
+ * @class EPixmapCache
+ * Keep decoded pixmaps in RAM (PSRAM when available) to avoid reading them
+ * again from the file system
+ */
+#include <EPixmapCache.h>
+
+/**
+ * Constructor
+ * @param [in] budget Memory budget (bytes)
+ */
+EPixmapCache::EPixmapCache(uint32_t budget) :
+	budget(budget), usage(0), clock(0), hits(0), misses(0)
+{
+	memset(entries, 0, sizeof(entries));
+}
+
+/**
+ * Destructor
+ */
+EPixmapCache::~EPixmapCache()
+{
+	clear();
+}
+
+/**
+ * Get a cached pixmap
+ * @param [in] pixmap Pixmap
+ * @param [in] half Half size pixmap
+ * @param [out] w Width
+ * @param [out] h Height
+ * @return const uint16_t* Pixels or NULL if the pixmap is not cached
+ */
+const uint16_t *EPixmapCache::get(ETheme::pixmap_t pixmap, bool half,
+		uint16_t *w, uint16_t *h)
+{
+	int i = getIndex(pixmap, half);
+
+	if (i < 0 || !entries[i].pixels) {
+		misses++;
+		return NULL;
+	}
+
+	hits++;
+	entries[i].lastUse = ++clock;
+	*w = entries[i].w;
+	*h = entries[i].h;
+	return entries[i].pixels;
+}
+
+/**
+ * Allocate a new pixmap in the cache
+ *
+ * Least recently used pixmaps (not pinned) are evicted until the new one
+ * fits in the budget.
+ *
+ * @param [in] pixmap Pixmap
+ * @param [in] half Half size pixmap
+ * @param [in] w Width
+ * @param [in] h Height
+ * @return uint16_t* Buffer to be filled with w x h pixels or NULL if the
+ * pixmap cannot be cached
+ */
+uint16_t *EPixmapCache::put(ETheme::pixmap_t pixmap, bool half,
+		uint16_t w, uint16_t h)
+{
+	int i, j, lru;
+	uint32_t size = (uint32_t)w * h * sizeof(uint16_t);
+	uint16_t *pixels = NULL;
+
+	if ((i = getIndex(pixmap, half)) < 0 || size == 0 || size > (budget / 2))
+		return NULL;
+
+	evict(i);
+
+	while ((usage + size) > budget) {
+		lru = -1;
+		for (j = 0; j < PIXMAP_CACHE_ENTRIES; j++) {
+			if (entries[j].pixels && !entries[j].pinned &&
+					(lru < 0 || entries[j].lastUse < entries[lru].lastUse))
+				lru = j;
+		}
+		if (lru < 0)
+			return NULL;
+		evict(lru);
+	}
+
+#ifdef BOARD_HAS_PSRAM
+	if (psramFound())
+		pixels = (uint16_t*)ps_malloc(size);
+#endif
+	if (!pixels)
+		pixels = (uint16_t*)malloc(size);
+	if (!pixels) {
+		log_e("Cannot allocate pixmap %d (%u bytes)", pixmap,
+				(unsigned int)size);
+		return NULL;
+	}
+
+	entries[i].pixels  = pixels;
+	entries[i].w       = w;
+	entries[i].h       = h;
+	entries[i].lastUse = ++clock;
+	usage += size;
+	return pixels;
+}
+
+/**
+ * Remove a pixmap from the cache
+ * @param [in] pixmap Pixmap
+ * @param [in] half Half size pixmap
+ */
+void EPixmapCache::remove(ETheme::pixmap_t pixmap, bool half)
+{
+	int i = getIndex(pixmap, half);
+
+	if (i >= 0)
+		evict(i);
+}
+
+/**
+ * Pin/unpin a pixmap (both sizes)
+ * @param [in] pixmap Pixmap
+ * @param [in] pinned Pinned pixmaps are never evicted
+ */
+void EPixmapCache::setPinned(ETheme::pixmap_t pixmap, bool pinned)
+{
+	int i = getIndex(pixmap, false);
+
+	if (i >= 0) {
+		entries[i].pinned     = pinned;
+		entries[i + 1].pinned = pinned;
+	}
+}
+
+/**
+ * Remove all pixmaps (pinned ones included)
+ */
+void EPixmapCache::clear()
+{
+	int i;
+
+	for (i = 0; i < PIXMAP_CACHE_ENTRIES; i++)
+		evict(i);
+}
+
+/**
+ * Set memory budget
+ * @param [in] budget Memory budget (bytes)
+ * \note Pixmaps already cached are not evicted until the next put()
+ */
+void EPixmapCache::setBudget(uint32_t budget)
+{
+	this->budget = budget;
+}
+
+/**
+ * Get memory budget
+ * @return uint32_t Bytes
+ */
+uint32_t EPixmapCache::getBudget() const
+{
+	return budget;
+}
+
+/**
+ * Get memory in use
+ * @return uint32_t Bytes
+ */
+uint32_t EPixmapCache::getUsage() const
+{
+	return usage;
+}
+
+/**
+ * Get number of hits
+ * @return uint32_t
+ */
+uint32_t EPixmapCache::getHits() const
+{
+	return hits;
+}
+
+/**
+ * Get number of misses
+ * @return uint32_t
+ */
+uint32_t EPixmapCache::getMisses() const
+{
+	return misses;
+}
+
+/**
+ * Reset hit/miss counters
+ */
+void EPixmapCache::resetStats()
+{
+	hits   = 0;
+	misses = 0;
+}
+
+/* ======================= PRIVATE ======================= */
+
+/**
+ * Get entry index
+ * @param [in] pixmap Pixmap
+ * @param [in] half Half size pixmap
+ * @return int Index or -1 for invalid pixmaps
+ */
+int EPixmapCache::getIndex(ETheme::pixmap_t pixmap, bool half)
+{
+	int i = (int)pixmap * 2 + (half ? 1 : 0);
+
+	if (i < 0 || i >= PIXMAP_CACHE_ENTRIES)
+		return -1;
+	return i;
+}
+
+/**
+ * Free an entry (keeps the pinned flag)
+ * @param [in] i Entry index
+ */
+void EPixmapCache::evict(int i)
+{
+	if (entries[i].pixels) {
+		free(entries[i].pixels);
+		usage -= (uint32_t)entries[i].w * entries[i].h * sizeof(uint16_t);
+		entries[i].pixels = NULL;
+	}
+}
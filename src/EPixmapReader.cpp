@@ -0,0 +1,326 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EPixmapReader.cpp
+ * @class EPixmapReader
+ * Read pixel map files (raw or compressed) with one file system access per
+ * block of data
+ */
+#include <EPixmapReader.h>
+#include <Adafruit_GFX_RGB565.h>
+
+/**
+ * Constructor
+ */
+EPixmapReader::EPixmapReader() :
+	w(0), h(0), left(0), packed(false), palette(NULL), input(NULL),
+	inputLen(0), inputPos(0), runLeft(0), litLeft(0), runColor(0)
+{
+}
+
+/**
+ * Destructor
+ */
+EPixmapReader::~EPixmapReader()
+{
+	close();
+}
+
+/**
+ * Open a pixmap file and read its header
+ *
+ * When a compressed file (.px2) does not exist, the raw file (.px) with the
+ * same name is opened instead.
+ *
+ * @param [in] pfs File system
+ * @param [in] file File name
+ * @return bool true on success
+ */
+bool EPixmapReader::open(fs::FS *pfs, const String& file)
+{
+	uint8_t hdr[4];
+
+	close();
+	pic = pfs->open(file, "r");
+	if (!pic && file.endsWith(".px2"))
+		pic = pfs->open(file.substring(0, file.length() - 1), "r");
+	if (!pic)
+		return false;
+
+	if (pic.read(hdr, sizeof(hdr)) != sizeof(hdr)) {
+		log_e("Invalid pixmap file: %s", file.c_str());
+		close();
+		return false;
+	}
+
+	if (!memcmp(hdr, PX2_MAGIC, 3)) {
+		if (hdr[3] != PX2_VERSION || !openPacked()) {
+			log_e("Invalid pixmap file: %s", file.c_str());
+			close();
+			return false;
+		}
+	} else {
+		w = hdr[0] | (hdr[1] << 8);
+		h = hdr[2] | (hdr[3] << 8);
+	}
+	left = (uint32_t)w * h;
+	return true;
+}
+
+/**
+ * Close the pixmap file
+ */
+void EPixmapReader::close()
+{
+	if (pic)
+		pic.close();
+	if (palette)
+		free(palette);
+	w = 0;
+	h = 0;
+	left = 0;
+	packed = false;
+	palette = NULL;
+	input = NULL;
+	inputLen = 0;
+	inputPos = 0;
+	runLeft = 0;
+	litLeft = 0;
+}
+
+/**
+ * Get pixmap width
+ * @return uint16_t
+ */
+uint16_t EPixmapReader::width()
+{
+	return w;
+}
+
+/**
+ * Get pixmap height
+ * @return uint16_t
+ */
+uint16_t EPixmapReader::height()
+{
+	return h;
+}
+
+/**
+ * Check if the file is compressed
+ * @return bool
+ */
+bool EPixmapReader::isPacked()
+{
+	return packed;
+}
+
+/**
+ * Read the next lines
+ * @param [out] dst Buffer for lines x width() pixels
+ * @param [in] lines Number of lines
+ * @return int Number of lines read
+ * \note Raw pixels are stored in little endian, same as the ESP32
+ */
+int EPixmapReader::read(uint16_t *dst, int lines)
+{
+	uint32_t count;
+
+	if (!pic || w == 0 || lines <= 0)
+		return 0;
+	if ((uint32_t)lines > (left / w))
+		lines = left / w;
+	if (lines <= 0)
+		return 0;
+
+	if (packed) {
+		count = decode(dst, (uint32_t)lines * w);
+	} else {
+		count = pic.read((uint8_t*)dst,
+				(size_t)lines * w * sizeof(uint16_t)) / sizeof(uint16_t);
+		left -= count;
+	}
+	return count / w;
+}
+
+/**
+ * Read the next lines at half size (each pixel is the average of a 2x2
+ * block, the last column and line of odd sizes are dropped)
+ * @param [out] dst Buffer for lines x (width() / 2) pixels
+ * @param [in] lines Number of lines (half size)
+ * @param [in] scratch Buffer for two lines of width() pixels
+ * @return int Number of lines read
+ */
+int EPixmapReader::readHalf(uint16_t *dst, int lines, uint16_t *scratch)
+{
+	int i;
+	uint16_t wh = w / 2;
+
+	for (i = 0; i < lines && left >= (2 * (uint32_t)w); i++) {
+		if (read(scratch, 2) != 2)
+			break;
+		rgb565Half(dst, scratch, scratch + w, wh);
+		dst += wh;
+	}
+	return i;
+}
+
+/**
+ * Read the next span of pixels
+ *
+ * For compressed files, a run of pixels of the same color is returned as a
+ * fill: only the color is stored in dst[0].
+ *
+ * @param [out] dst Buffer for max pixels
+ * @param [in] max Maximum number of pixels
+ * @param [out] fill true if all the pixels have the color dst[0]
+ * @return uint32_t Number of pixels (0 at the end of the file)
+ */
+uint32_t EPixmapReader::readSpan(uint16_t *dst, uint32_t max, bool *fill)
+{
+	uint32_t n, i;
+	int c, idx;
+
+	*fill = false;
+	if (!pic || max == 0 || left == 0)
+		return 0;
+	if (max > left)
+		max = left;
+
+	if (!packed) {
+		n = pic.read((uint8_t*)dst, max * sizeof(uint16_t)) / sizeof(uint16_t);
+		left -= n;
+		return n;
+	}
+
+	// Next packet
+	if (!runLeft && !litLeft) {
+		if ((c = getByte()) < 0)
+			return 0;
+		if (c & PX2_RUN) {
+			if ((idx = getByte()) < 0)
+				return 0;
+			runLeft  = (c & ~PX2_RUN) + 1;
+			runColor = palette[idx];
+		} else {
+			litLeft = c + 1;
+		}
+	}
+
+	if (runLeft) {
+		n = (runLeft < max) ? runLeft : max;
+		dst[0] = runColor;
+		*fill  = true;
+		runLeft -= n;
+	} else {
+		n = (litLeft < max) ? litLeft : max;
+		for (i = 0; i < n; i++) {
+			if ((c = getByte()) < 0)
+				break;
+			dst[i] = palette[c];
+		}
+		litLeft = (i < n) ? 0 : (litLeft - n);
+		n = i;
+	}
+	left -= n;
+	return n;
+}
+
+/* ======================= PRIVATE ======================= */
+
+/**
+ * Read the header of a compressed file (after the magic number)
+ * @return bool true on success
+ */
+bool EPixmapReader::openPacked()
+{
+	uint8_t hdr[5];
+	int colors;
+
+	if (pic.read(hdr, sizeof(hdr)) != sizeof(hdr))
+		return false;
+
+	w = hdr[0] | (hdr[1] << 8);
+	h = hdr[2] | (hdr[3] << 8);
+	colors = hdr[4] + 1;
+
+	// Palette (256 entries) followed by the input buffer
+	palette = (uint16_t*)calloc(1, 256 * sizeof(uint16_t) + PIXMAP_INPUT_BUFFER);
+	if (!palette)
+		return false;
+	input = (uint8_t*)&palette[256];
+
+	if (pic.read((uint8_t*)palette, colors * sizeof(uint16_t)) !=
+			colors * sizeof(uint16_t))
+		return false;
+
+	packed = true;
+	return true;
+}
+
+/**
+ * Get next byte of a compressed file
+ * @return int Byte or -1 at the end of the file
+ */
+int EPixmapReader::getByte()
+{
+	if (inputPos >= inputLen) {
+		inputLen = pic.read(input, PIXMAP_INPUT_BUFFER);
+		inputPos = 0;
+		if (inputLen <= 0) {
+			inputLen = 0;
+			return -1;
+		}
+	}
+	return input[inputPos++];
+}
+
+/**
+ * Decode pixels of a compressed file
+ * @param [out] dst Buffer for count pixels
+ * @param [in] count Number of pixels
+ * @return uint32_t Number of pixels decoded
+ */
+uint32_t EPixmapReader::decode(uint16_t *dst, uint32_t count)
+{
+	uint32_t n, i, total = 0;
+	bool fill;
+
+	while (total < count &&
+			(n = readSpan(dst + total, count - total, &fill)) > 0) {
+		if (fill) {
+			for (i = 1; i < n; i++)
+				dst[total + i] = dst[total];
+		}
+		total += n;
+	}
+	return total;
+}
@@ -0,0 +1,198 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EProfiler.cpp
+ * @class EProfiler
+ * Count the time and the bus traffic of the drawing code
+ */
+#include <EProfiler.h>
+
+/**
+ * Constructor: start measuring
+ * @param [in] profiler Profiler
+ * @param [in] section Section
+ * @param [in] redraw Count a redraw (widgets) instead of a call
+ */
+EProfiler::Scope::Scope(EProfiler *profiler, int section, bool redraw) :
+	profiler(profiler), section(section), redraw(redraw)
+{
+	profiler->readBus(&pixels, &bytes);
+	start = micros();
+}
+
+/**
+ * Destructor: add the measures to the section
+ */
+EProfiler::Scope::~Scope()
+{
+	profile_counters_t *c = &profiler->counters[section];
+	uint32_t p, b;
+
+	c->us += micros() - start;
+	profiler->readBus(&p, &b);
+	c->pixels += p - pixels;
+	c->bytes  += b - bytes;
+	if (redraw)
+		c->redraws++;
+	else
+		c->calls++;
+}
+
+/**
+ * Constructor
+ * @param [in] names Names of the sections (kept, not copied)
+ * @param [in] count Number of sections
+ * @param [in] tft TFT module (bus counters)
+ */
+EProfiler::EProfiler(const char *const *names, int count,
+		Adafruit_SPITFT *tft) :
+	names(names), count(count), counters(NULL), tft(tft), since(0)
+{
+	this->counters = new profile_counters_t[count];
+	reset();
+}
+
+/**
+ * Destructor
+ */
+EProfiler::~EProfiler()
+{
+	if (this->counters)
+		delete[] this->counters;
+}
+
+/**
+ * Count a call of a section that is not measured (e.g. a widget value set)
+ * @param [in] section Section
+ */
+void EProfiler::call(int section)
+{
+	counters[section].calls++;
+}
+
+/**
+ * Get the counters of a section
+ * @param [in] section Section
+ * @return profile_counters_t
+ */
+const EProfiler::profile_counters_t& EProfiler::get(int section)
+{
+	return counters[section];
+}
+
+/**
+ * Reset all counters, including the bus counters
+ */
+void EProfiler::reset()
+{
+	memset(counters, 0, count * sizeof(profile_counters_t));
+#if defined(SPITFT_STATS)
+	tft->resetStats();
+#endif
+	since = millis();
+}
+
+/**
+ * Get the bus counters of the TFT module (zero without SPITFT_STATS)
+ * @param [out] bus Bus counters
+ */
+void EProfiler::getBus(SPITFT_Stats *bus)
+{
+#if defined(SPITFT_STATS)
+	*bus = tft->getStats();
+#else
+	memset(bus, 0, sizeof(SPITFT_Stats));
+#endif
+}
+
+/**
+ * Print the counters as JSON: time since the last reset, bus counters and
+ * the counters of each section
+ * @param [in] out Output
+ */
+void EProfiler::printJSON(Print& out)
+{
+	SPITFT_Stats bus;
+	int i;
+
+	getBus(&bus);
+	out.printf("{\"ms\":%lu,\"bus\":{\"transactions\":%u,\"windows\":%u,"
+			"\"bytes\":%u,\"pixels\":%u},\"sections\":[",
+			millis() - since, bus.transactions, bus.addrWindows,
+			bus.bytes, bus.pixels);
+	for (i = 0; i < count; i++) {
+		const profile_counters_t& c = counters[i];
+		out.printf("%s{\"name\":\"%s\",\"calls\":%u,\"redraws\":%u,"
+				"\"us\":%u,\"pixels\":%u,\"bytes\":%u}", i ? "," : "",
+				names[i], c.calls, c.redraws, c.us, c.pixels, c.bytes);
+	}
+	out.print("]}");
+}
+
+/**
+ * Write the counters of the sections that ran to the log
+ */
+void EProfiler::log()
+{
+	SPITFT_Stats bus;
+	int i;
+
+	getBus(&bus);
+	log_i("Profile of the last %lu ms: %u transactions, %u windows, "
+			"%u bytes, %u pixels", millis() - since, bus.transactions,
+			bus.addrWindows, bus.bytes, bus.pixels);
+	for (i = 0; i < count; i++) {
+		const profile_counters_t& c = counters[i];
+		if (!c.calls && !c.redraws)
+			continue;
+		log_i("  %-18s %6u calls %6u redraws %9u us %8u px %8u bytes",
+				names[i], c.calls, c.redraws, c.us, c.pixels, c.bytes);
+	}
+}
+
+/* ======================= PRIVATE ======================= */
+
+/**
+ * Read the bus counters
+ * @param [out] pixels Pixels written
+ * @param [out] bytes Bus bytes
+ */
+void EProfiler::readBus(uint32_t *pixels, uint32_t *bytes)
+{
+#if defined(SPITFT_STATS)
+	const SPITFT_Stats& st = tft->getStats();
+	*pixels = st.pixels;
+	*bytes  = st.bytes;
+#else
+	*pixels = 0;
+	*bytes  = 0;
+#endif
+}
@@ -0,0 +1,651 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file ERenderQueue.cpp
+ * @class ERenderQueue
+ * Render command queue: screen updates posted by the tasks, drawn by the
+ * render task
+ */
+#include <ERenderQueue.h>
+
+/**
+ * Constructor
+ */
+ERenderQueue::ERenderQueue() :
+	notify(NULL), notifyArg(NULL)
+{
+	int i;
+
+	for (i = 0; i < RENDER_MAX; i++) {
+		slots[i].dirty   = false;
+		slots[i].posted  = 0;
+		slots[i].value.i = 0;
+		slots[i].period  = 0;
+		slots[i].text[0] = '\0';
+		drawTime[i]      = 0;
+		maxLatency[i]    = 0;
+	}
+	wifi.steady  = false;
+	wifi.phases  = 0;
+	wifi.period  = 0;
+	wifi.next    = 0;
+	radio        = wifi;
+	memset(&stats, 0, sizeof(stats));
+	mux = portMUX_INITIALIZER_UNLOCKED;
+}
+
+/**
+ * Set the function that wakes up the render task
+ *
+ * The function is called (outside of the lock) every time an update is
+ * posted.
+ *
+ * @param [in] notify Function (NULL: none)
+ * @param [in] arg Argument passed to the function
+ */
+void ERenderQueue::setNotify(void (*notify)(void *arg), void *arg)
+{
+	this->notify    = notify;
+	this->notifyArg = arg;
+}
+
+/**
+ * Set backlight level
+ * @param [in] level Backlight level
+ */
+void ERenderQueue::setBacklight(int level)
+{
+	post(RENDER_BACKLIGHT, level);
+}
+
+/**
+ * Set temperature scale
+ * @param [in] scale Temperature scale
+ */
+void ERenderQueue::setTempScale(temp_scale_t scale)
+{
+	post(RENDER_TEMP_SCALE, (int)scale);
+}
+
+/**
+ * Set time format
+ * @param [in] timeFormat Time format
+ */
+void ERenderQueue::setTimeFormat(time_format_t timeFormat)
+{
+	post(RENDER_TIME_FORMAT, (int)timeFormat);
+}
+
+/**
+ * Redraw all elements
+ */
+void ERenderQueue::showAll()
+{
+	post(RENDER_SHOW_ALL, 1);
+}
+
+/**
+ * Set clock: hours
+ * @param [in] hours Hours
+ */
+void ERenderQueue::setHours(int hours)
+{
+	post(RENDER_HOURS, hours);
+}
+
+/**
+ * Set clock: minutes
+ * @param [in] minutes Minutes
+ */
+void ERenderQueue::setMinutes(int minutes)
+{
+	post(RENDER_MINUTES, minutes);
+}
+
+/**
+ * Set clock: seconds
+ * @param [in] seconds Seconds
+ */
+void ERenderQueue::setSeconds(int seconds)
+{
+	post(RENDER_SECONDS, seconds);
+}
+
+/**
+ * Set date
+ * @param [in] date Date
+ */
+void ERenderQueue::setDate(const String& date)
+{
+	post(RENDER_DATE, date);
+}
+
+/**
+ * Set city name
+ * @param [in] city City
+ */
+void ERenderQueue::setCity(const String& city)
+{
+	post(RENDER_CITY, city);
+}
+
+/**
+ * Set IP address
+ * @param [in] ip IP address
+ */
+void ERenderQueue::setIP(const String& ip)
+{
+	post(RENDER_IP, ip);
+}
+
+/**
+ * Show/hide WiFi icon
+ *
+ * When the icon is blinking, the value is shown at the end of the blinking.
+ *
+ * @param [in] show Show or hide the icon
+ */
+void ERenderQueue::showWiFi(bool show)
+{
+	setIcon(&wifi, RENDER_WIFI, show);
+}
+
+/**
+ * Blink WiFi icon
+ * @param [in] phases Number of phases (on, off, on...)
+ * @param [in] period Duration of each phase (ms)
+ */
+void ERenderQueue::blinkWiFi(int phases, unsigned long period)
+{
+	blink(&wifi, RENDER_WIFI, phases, period);
+}
+
+/**
+ * Show/hide antenna icon
+ *
+ * When the icon is blinking, the value is shown at the end of the blinking.
+ *
+ * @param [in] show Show or hide the icon
+ */
+void ERenderQueue::showRadio(bool show)
+{
+	setIcon(&radio, RENDER_RADIO, show);
+}
+
+/**
+ * Blink antenna icon
+ * @param [in] phases Number of phases (on, off, on...)
+ * @param [in] period Duration of each phase (ms)
+ */
+void ERenderQueue::blinkRadio(int phases, unsigned long period)
+{
+	blink(&radio, RENDER_RADIO, phases, period);
+}
+
+/**
+ * Show weather icon
+ * @param [in] weather Weather
+ * @param [in] period Period of the day ('d' or 'n')
+ */
+void ERenderQueue::showWeather(weather_t weather, char period)
+{
+	portENTER_CRITICAL(&mux);
+	slots[RENDER_WEATHER].value.i = (int)weather;
+	slots[RENDER_WEATHER].period  = period;
+	touch(&slots[RENDER_WEATHER]);
+	portEXIT_CRITICAL(&mux);
+
+	if (notify)
+		notify(notifyArg);
+}
+
+/**
+ * Show temperature 1
+ * @param [in] temp Temperature (in Celsius)
+ */
+void ERenderQueue::showTemp1(float temp)
+{
+	postFloat(RENDER_TEMP1, temp);
+}
+
+/**
+ * Show humidity 1
+ * @param [in] humidity Humidity
+ */
+void ERenderQueue::showHumidity1(int humidity)
+{
+	post(RENDER_HUMIDITY1, humidity);
+}
+
+/**
+ * Show sensor's channel
+ * @param [in] channel Channel
+ */
+void ERenderQueue::showChannel(int channel)
+{
+	post(RENDER_CHANNEL, channel);
+}
+
+/**
+ * Show temperature 2
+ * @param [in] temp Temperature (in Celsius)
+ */
+void ERenderQueue::showTemp2(float temp)
+{
+	postFloat(RENDER_TEMP2, temp);
+}
+
+/**
+ * Show humidity 2
+ * @param [in] humidity Humidity
+ */
+void ERenderQueue::showHumidity2(int humidity)
+{
+	post(RENDER_HUMIDITY2, humidity);
+}
+
+/**
+ * Show forecast weather icon
+ * @param [in] i Forecast number
+ * @param [in] weather Weather
+ */
+void ERenderQueue::showForecastWeather(int i, weather_t weather)
+{
+	if (i >= 0 && i < RENDER_FORECASTS)
+		post((render_el_t)(RENDER_FORECAST_WEATHER + i), (int)weather);
+}
+
+/**
+ * Show forecast label
+ * @param [in] i Forecast number
+ * @param [in] label Label
+ */
+void ERenderQueue::showForecastLabel(int i, const String& label)
+{
+	if (i >= 0 && i < RENDER_FORECASTS)
+		post((render_el_t)(RENDER_FORECAST_LABEL + i), label);
+}
+
+/**
+ * Show forecast temperature 1
+ * @param [in] i Forecast number
+ * @param [in] temp Temperature (in Celsius)
+ */
+void ERenderQueue::showForecastTemp1(int i, float temp)
+{
+	if (i >= 0 && i < RENDER_FORECASTS)
+		postFloat((render_el_t)(RENDER_FORECAST_TEMP1 + i), temp);
+}
+
+/**
+ * Show forecast temperature 2
+ * @param [in] i Forecast number
+ * @param [in] temp Temperature (in Celsius)
+ */
+void ERenderQueue::showForecastTemp2(int i, float temp)
+{
+	if (i >= 0 && i < RENDER_FORECASTS)
+		postFloat((render_el_t)(RENDER_FORECAST_TEMP2 + i), temp);
+}
+
+/**
+ * Check for updates waiting to be drawn
+ * @return bool true if there are updates or blinking icons
+ */
+bool ERenderQueue::isPending()
+{
+	bool pending;
+	int i;
+
+	portENTER_CRITICAL(&mux);
+	pending = (wifi.phases > 0 || radio.phases > 0);
+	for (i = 0; i < RENDER_MAX && !pending; i++)
+		pending = slots[i].dirty;
+	portEXIT_CRITICAL(&mux);
+	return pending;
+}
+
+/**
+ * Draw pending updates
+ *
+ * The pending updates are taken all at once and applied to the interface,
+ * which draws the widgets that changed (clock first), then the frame is
+ * flushed to the TFT module. Must be called by the task that owns the screen.
+ *
+ * @param [in] gui Embedded GUI
+ * @return unsigned long Time (ms) until the next blinking phase, at most
+ * RENDER_IDLE_MS
+ */
+unsigned long ERenderQueue::render(EInterface *gui)
+{
+	slot_t frame[RENDER_MAX];
+	unsigned long now, t0, wait, w;
+	int i, n = 0;
+
+	now = millis();
+	portENTER_CRITICAL(&mux);
+	wait = updateBlink(&wifi, RENDER_WIFI, now);
+	w    = updateBlink(&radio, RENDER_RADIO, now);
+	if (w < wait)
+		wait = w;
+	for (i = 0; i < RENDER_MAX; i++) {
+		frame[i].dirty = slots[i].dirty;
+		if (slots[i].dirty) {
+			frame[i] = slots[i];
+			slots[i].dirty = false;
+			n++;
+		}
+	}
+	portEXIT_CRITICAL(&mux);
+
+	if (n == 0)
+		return wait;
+
+	t0 = micros();
+	for (i = 0; i < RENDER_MAX; i++) {
+		if (frame[i].dirty)
+			draw(gui, (render_el_t)i, frame[i]);
+	}
+	// Widgets that changed are drawn here, clock first
+	gui->update();
+	for (i = 0; i < RENDER_MAX; i++) {
+		if (!frame[i].dirty)
+			continue;
+		drawTime[i] = micros();
+		if ((drawTime[i] - frame[i].posted) > maxLatency[i])
+			maxLatency[i] = drawTime[i] - frame[i].posted;
+	}
+	gui->flush();
+
+	stats.frames++;
+	stats.drawn += n;
+	if ((micros() - t0) > stats.maxFrameUs)
+		stats.maxFrameUs = micros() - t0;
+	return wait;
+}
+
+/**
+ * Get the time the last update of an element was drawn
+ * @param [in] el Element
+ * @return unsigned long Time (us, micros())
+ */
+unsigned long ERenderQueue::getDrawTime(render_el_t el)
+{
+	return drawTime[el];
+}
+
+/**
+ * Get the worst latency between post and draw of an element
+ * @param [in] el Element
+ * @return unsigned long Latency (us)
+ */
+unsigned long ERenderQueue::getMaxLatency(render_el_t el)
+{
+	return maxLatency[el];
+}
+
+/**
+ * Get statistics
+ * @return const render_stats_t& Statistics
+ */
+const ERenderQueue::render_stats_t& ERenderQueue::getStats()
+{
+	return stats;
+}
+
+/* ======================= PRIVATE ======================= */
+
+/**
+ * Post a number
+ * @param [in] el Element
+ * @param [in] value Value
+ */
+void ERenderQueue::post(render_el_t el, int value)
+{
+	portENTER_CRITICAL(&mux);
+	slots[el].value.i = value;
+	touch(&slots[el]);
+	portEXIT_CRITICAL(&mux);
+
+	if (notify)
+		notify(notifyArg);
+}
+
+/**
+ * Post a float number
+ * @param [in] el Element
+ * @param [in] value Value
+ */
+void ERenderQueue::postFloat(render_el_t el, float value)
+{
+	portENTER_CRITICAL(&mux);
+	slots[el].value.f = value;
+	touch(&slots[el]);
+	portEXIT_CRITICAL(&mux);
+
+	if (notify)
+		notify(notifyArg);
+}
+
+/**
+ * Post a text
+ * @param [in] el Element
+ * @param [in] text Text (truncated to RENDER_TEXT_MAX - 1 characters)
+ */
+void ERenderQueue::post(render_el_t el, const String& text)
+{
+	const char *str = text.c_str();
+
+	portENTER_CRITICAL(&mux);
+	strncpy(slots[el].text, str, RENDER_TEXT_MAX - 1);
+	slots[el].text[RENDER_TEXT_MAX - 1] = '\0';
+	touch(&slots[el]);
+	portEXIT_CRITICAL(&mux);
+
+	if (notify)
+		notify(notifyArg);
+}
+
+/**
+ * Mark an element to be drawn (lock held)
+ *
+ * The latency of an element is counted from the oldest update that has not
+ * been drawn yet.
+ *
+ * @param [in] s Element
+ */
+void ERenderQueue::touch(slot_t *s)
+{
+	stats.posted++;
+	if (s->dirty) {
+		stats.coalesced++;
+	} else {
+		s->dirty  = true;
+		s->posted = micros();
+	}
+}
+
+/**
+ * Set the steady value of an icon
+ * @param [in] b Icon
+ * @param [in] el Element
+ * @param [in] show Show or hide the icon
+ */
+void ERenderQueue::setIcon(blink_t *b, render_el_t el, bool show)
+{
+	portENTER_CRITICAL(&mux);
+	b->steady = show;
+	if (b->phases == 0) {
+		slots[el].value.i = show;
+		touch(&slots[el]);
+	}
+	portEXIT_CRITICAL(&mux);
+
+	if (notify)
+		notify(notifyArg);
+}
+
+/**
+ * Start blinking an icon
+ *
+ * The icon is shown now and toggled on each phase. After the last phase, the
+ * steady value (showWiFi(), showRadio()) is shown. Blinking again restarts
+ * the phases.
+ *
+ * @param [in] b Icon
+ * @param [in] el Element
+ * @param [in] phases Number of phases
+ * @param [in] period Duration of each phase (ms)
+ */
+void ERenderQueue::blink(blink_t *b, render_el_t el, int phases,
+		unsigned long period)
+{
+	if (phases <= 0)
+		return;
+
+	portENTER_CRITICAL(&mux);
+	b->phases = phases;
+	b->period = period;
+	b->next   = millis() + period;
+	slots[el].value.i = 1;
+	touch(&slots[el]);
+	portEXIT_CRITICAL(&mux);
+
+	if (notify)
+		notify(notifyArg);
+}
+
+/**
+ * Advance a blinking icon (lock held)
+ * @param [in] b Icon
+ * @param [in] el Element
+ * @param [in] now Current time (ms)
+ * @return unsigned long Time (ms) until the next phase, RENDER_IDLE_MS when
+ * the icon is not blinking
+ */
+unsigned long ERenderQueue::updateBlink(blink_t *b, render_el_t el,
+		unsigned long now)
+{
+	if (b->phases == 0)
+		return RENDER_IDLE_MS;
+
+	if ((long)(now - b->next) >= 0) {
+		b->phases--;
+		if (b->phases > 0)
+			slots[el].value.i = !slots[el].value.i;
+		else
+			slots[el].value.i = b->steady;
+		touch(&slots[el]);
+		b->next = now + b->period;
+	}
+
+	if (b->phases == 0)
+		return RENDER_IDLE_MS;
+	return min(b->next - now, (unsigned long)RENDER_IDLE_MS);
+}
+
+/**
+ * Draw an element
+ * @param [in] gui Embedded GUI
+ * @param [in] el Element
+ * @param [in] s Update
+ */
+void ERenderQueue::draw(EInterface *gui, render_el_t el, const slot_t& s)
+{
+	switch (el) {
+		case RENDER_BACKLIGHT:
+			gui->setBacklight(s.value.i);
+			break;
+		case RENDER_TEMP_SCALE:
+			gui->setTempScale((temp_scale_t)s.value.i);
+			break;
+		case RENDER_TIME_FORMAT:
+			gui->setTimeFormat((time_format_t)s.value.i);
+			break;
+		case RENDER_SHOW_ALL:
+			gui->showAll();
+			break;
+		case RENDER_HOURS:
+			gui->setHours(s.value.i);
+			break;
+		case RENDER_MINUTES:
+			gui->setMinutes(s.value.i);
+			break;
+		case RENDER_SECONDS:
+			gui->setSeconds(s.value.i);
+			break;
+		case RENDER_DATE:
+			gui->setDate(s.text);
+			break;
+		case RENDER_CITY:
+			gui->setCity(s.text);
+			break;
+		case RENDER_IP:
+			gui->setIP(s.text);
+			break;
+		case RENDER_WIFI:
+			gui->showWiFi(s.value.i != 0);
+			break;
+		case RENDER_RADIO:
+			gui->showRadio(s.value.i != 0);
+			break;
+		case RENDER_WEATHER:
+			gui->showWeather((weather_t)s.value.i, s.period);
+			break;
+		case RENDER_TEMP1:
+			gui->showTemp1(s.value.f);
+			break;
+		case RENDER_HUMIDITY1:
+			gui->showHumidity1(s.value.i);
+			break;
+		case RENDER_CHANNEL:
+			gui->showChannel(s.value.i);
+			break;
+		case RENDER_TEMP2:
+			gui->showTemp2(s.value.f);
+			break;
+		case RENDER_HUMIDITY2:
+			gui->showHumidity2(s.value.i);
+			break;
+		default:
+			if (el >= RENDER_FORECAST_TEMP2) {
+				gui->showForecastTemp2(el - RENDER_FORECAST_TEMP2, s.value.f);
+			} else if (el >= RENDER_FORECAST_TEMP1) {
+				gui->showForecastTemp1(el - RENDER_FORECAST_TEMP1, s.value.f);
+			} else if (el >= RENDER_FORECAST_LABEL) {
+				gui->showForecastLabel(el - RENDER_FORECAST_LABEL, s.text);
+			} else {
+				gui->showForecastWeather(el - RENDER_FORECAST_WEATHER,
+						(weather_t)s.value.i);
+			}
+			break;
+	}
+}
@@ -0,0 +1,388 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EScreenEncoder.cpp
+ * @class EScreenEncoder
+ * Encode screenshots (PNG or BMP) on the fly, a strip of lines at a time
+ */
+#include <EScreenEncoder.h>
+
+/** PNG: file signature */
+static const uint8_t pngSignature[8] = {
+	0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'
+};
+/** PNG: image end chunk */
+static const uint8_t pngEnd[12] = {
+	0, 0, 0, 0, 'I', 'E', 'N', 'D', 0xae, 0x42, 0x60, 0x82
+};
+/** PNG: header chunk, 24 bits RGB */
+#define PNG_IHDR_SIZE 13
+/** PNG: bytes per encoded line: stored block header, filter, RGB */
+#define PNG_LINE_SIZE(w) (5 + 1 + 3 * (w))
+/** BMP: headers (file, BITMAPINFOHEADER, RGB565 masks) */
+#define BMP_HEADER_SIZE (14 + 40 + 12)
+/** BMP: bytes per line (4 bytes aligned) */
+#define BMP_LINE_SIZE(w) (((w) * 2 + 3) & ~3)
+/** Adler-32 modulus */
+#define ADLER_MOD 65521
+
+/** CRC-32 (PNG, zlib), 4 bits at a time */
+static const uint32_t crcTable[16] = {
+	0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+	0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+	0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+	0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+};
+
+/**
+ * Constructor
+ * @param [in] format File format
+ * @param [in] width Screen width
+ * @param [in] height Screen height
+ * @param [in] reader Function that reads the screen
+ * @param [in] arg Argument passed to reader
+ */
+EScreenEncoder::EScreenEncoder(screen_format_t format, int16_t width,
+		int16_t height, screen_reader_t reader, void *arg) :
+	format(format), width(width), height(height), reader(reader),
+	readerArg(arg), step(STEP_HEADER), strip(NULL), stripY(0),
+	stripLines(0), line(0), out(NULL), outSize(0), outLen(0), outPos(0),
+	produced(0), crc(0), adler(1), errors(0)
+{
+	if (format == SCREEN_PNG)
+		outSize = PNG_LINE_SIZE(width);
+	else
+		outSize = BMP_LINE_SIZE(width);
+	// Large enough for the headers
+	if (outSize < BMP_HEADER_SIZE + 64)
+		outSize = BMP_HEADER_SIZE + 64;
+
+	this->strip = new uint16_t[width * SCREEN_STRIP_LINES];
+	this->out   = new uint8_t[outSize];
+}
+
+/**
+ * Destructor
+ */
+EScreenEncoder::~EScreenEncoder()
+{
+	if (this->strip)
+		delete[] this->strip;
+	if (this->out)
+		delete[] this->out;
+}
+
+/**
+ * Check if the buffers could be allocated
+ * @return bool true if the encoder can be used
+ */
+bool EScreenEncoder::isValid()
+{
+	return strip && out && width > 0 && height > 0 && reader;
+}
+
+/**
+ * Get the MIME type of the file
+ * @return const char* MIME type
+ */
+const char *EScreenEncoder::getContentType()
+{
+	return (format == SCREEN_PNG) ? "image/png" : "image/bmp";
+}
+
+/**
+ * Get the file size
+ * @return size_t Bytes
+ */
+size_t EScreenEncoder::getSize()
+{
+	if (format == SCREEN_PNG) {
+		return sizeof(pngSignature) + (12 + PNG_IHDR_SIZE) +
+			(12 + getPNGDataSize()) + sizeof(pngEnd);
+	}
+	return BMP_HEADER_SIZE + (size_t)BMP_LINE_SIZE(width) * height;
+}
+
+/**
+ * Read the next bytes of the file
+ * @param [out] buf Buffer
+ * @param [in] len Buffer size
+ * @return size_t Bytes copied (0: end of file)
+ */
+size_t EScreenEncoder::read(uint8_t *buf, size_t len)
+{
+	size_t n, copied = 0;
+
+	if (!isValid())
+		return 0;
+
+	while (copied < len) {
+		if (outPos == outLen) {
+			if (step == STEP_DONE)
+				break;
+			outLen = 0;
+			outPos = 0;
+			encode();
+			continue;
+		}
+		n = outLen - outPos;
+		if (n > len - copied)
+			n = len - copied;
+		memcpy(buf + copied, out + outPos, n);
+		outPos += n;
+		copied += n;
+	}
+	produced += copied;
+	return copied;
+}
+
+/**
+ * Check if the whole file has been read
+ * @return bool true at the end of the file
+ */
+bool EScreenEncoder::isDone()
+{
+	return step == STEP_DONE && outPos == outLen;
+}
+
+/**
+ * Get the number of strips that could not be read (sent as black lines)
+ * @return unsigned int Strips
+ */
+unsigned int EScreenEncoder::getErrors()
+{
+	return errors;
+}
+
+/**
+ * Get the memory used by the encoder (buffers and object)
+ * @return size_t Bytes
+ */
+size_t EScreenEncoder::getMemoryUsage()
+{
+	return sizeof(*this) + width * SCREEN_STRIP_LINES * sizeof(uint16_t) +
+		outSize;
+}
+
+/* ======================= PRIVATE ======================= */
+
+/**
+ * Encode the next part of the file into the output buffer
+ */
+void EScreenEncoder::encode()
+{
+	switch (step) {
+		case STEP_HEADER:
+			encodeHeader();
+			step = STEP_LINES;
+			break;
+		case STEP_LINES:
+			encodeLine();
+			if (++line == height)
+				step = STEP_TRAILER;
+			break;
+		case STEP_TRAILER:
+			encodeTrailer();
+			step = STEP_DONE;
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * Encode the file header
+ */
+void EScreenEncoder::encodeHeader()
+{
+	uint32_t v;
+
+	if (format == SCREEN_BMP) {
+		uint8_t *p = out;
+		uint32_t fields[] = {
+			// File header (after "BM")
+			(uint32_t)getSize(), 0, BMP_HEADER_SIZE,
+			// BITMAPINFOHEADER, negative height: top-down
+			40, (uint32_t)width, (uint32_t)-height, 1 | (16 << 16),
+			3 /* BI_BITFIELDS */, (uint32_t)BMP_LINE_SIZE(width) * height,
+			2835, 2835, 0, 0,
+			// RGB565 masks
+			0xf800, 0x07e0, 0x001f
+		};
+		*p++ = 'B';
+		*p++ = 'M';
+		for (v = 0; v < sizeof(fields) / sizeof(fields[0]); v++) {
+			*p++ = fields[v];
+			*p++ = fields[v] >> 8;
+			*p++ = fields[v] >> 16;
+			*p++ = fields[v] >> 24;
+		}
+		outLen = p - out;
+		return;
+	}
+
+	uint8_t ihdr[PNG_IHDR_SIZE] = {
+		0, 0, (uint8_t)(width >> 8), (uint8_t)width,
+		0, 0, (uint8_t)(height >> 8), (uint8_t)height,
+		8, 2, 0, 0, 0 // 8 bits RGB, deflate, no interlace
+	};
+	// zlib header: deflate, 32K window, no dictionary, fastest
+	static const uint8_t zlibHeader[2] = {0x78, 0x01};
+
+	put(pngSignature, sizeof(pngSignature));
+	put32(PNG_IHDR_SIZE);
+	crc = 0xffffffff;
+	put((const uint8_t*)"IHDR", 4);
+	put(ihdr, sizeof(ihdr));
+	put32(crc ^ 0xffffffff);
+	put32(getPNGDataSize());
+	crc = 0xffffffff;
+	put((const uint8_t*)"IDAT", 4);
+	put(zlibHeader, sizeof(zlibHeader));
+}
+
+/**
+ * Encode a line, reading the next strip of the screen when needed
+ */
+void EScreenEncoder::encodeLine()
+{
+	const uint16_t *px;
+	uint8_t *p;
+	uint32_t a, b;
+	uint16_t c, len;
+	int16_t x;
+
+	if (line >= stripY + stripLines) {
+		stripY     = line;
+		stripLines = height - line;
+		if (stripLines > SCREEN_STRIP_LINES)
+			stripLines = SCREEN_STRIP_LINES;
+		if (!reader(stripY, stripLines, strip, readerArg)) {
+			memset(strip, 0, width * stripLines * sizeof(uint16_t));
+			errors++;
+		}
+	}
+	px = strip + (line - stripY) * width;
+
+	if (format == SCREEN_BMP) {
+		p = out;
+		for (x = 0; x < width; x++) {
+			*p++ = px[x];
+			*p++ = px[x] >> 8;
+		}
+		while ((size_t)(p - out) < (size_t)BMP_LINE_SIZE(width))
+			*p++ = 0;
+		outLen = p - out;
+		return;
+	}
+
+	// Stored deflate block: final flag, length, one's complement of length
+	len  = 1 + 3 * width;
+	p    = out;
+	*p++ = (line == height - 1) ? 1 : 0;
+	*p++ = len;
+	*p++ = len >> 8;
+	*p++ = ~len;
+	*p++ = (uint16_t)~len >> 8;
+	*p++ = 0; // No filter
+	for (x = 0; x < width; x++) {
+		c = px[x];
+		*p++ = ((c >> 8) & 0xf8) | (c >> 13);
+		*p++ = ((c >> 3) & 0xfc) | ((c >> 9) & 0x03);
+		*p++ = ((c << 3) & 0xf8) | ((c >> 2) & 0x07);
+	}
+
+	// Adler-32 of the line (no overflow: a line is shorter than 5552 bytes)
+	a = adler & 0xffff;
+	b = adler >> 16;
+	for (p = out + 5; p < out + 5 + len; p++) {
+		a += *p;
+		b += a;
+	}
+	adler = ((b % ADLER_MOD) << 16) | (a % ADLER_MOD);
+
+	outLen = 0;
+	put(out, 5 + len);
+}
+
+/**
+ * Encode the file trailer
+ */
+void EScreenEncoder::encodeTrailer()
+{
+	if (format != SCREEN_PNG)
+		return;
+	put32(adler);
+	put32(crc ^ 0xffffffff);
+	put(pngEnd, sizeof(pngEnd));
+}
+
+/**
+ * Append bytes to the output buffer, updating the chunk CRC
+ * @param [in] data Bytes (can be in the output buffer already, at outLen)
+ * @param [in] len Number of bytes
+ */
+void EScreenEncoder::put(const uint8_t *data, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		crc = (crc >> 4) ^ crcTable[(crc ^ data[i]) & 0x0f];
+		crc = (crc >> 4) ^ crcTable[(crc ^ (data[i] >> 4)) & 0x0f];
+	}
+	if (data != out + outLen)
+		memcpy(out + outLen, data, len);
+	outLen += len;
+}
+
+/**
+ * Append a 32 bits big endian number to the output buffer
+ * @param [in] value Number
+ */
+void EScreenEncoder::put32(uint32_t value)
+{
+	uint8_t b[4] = {
+		(uint8_t)(value >> 24), (uint8_t)(value >> 16),
+		(uint8_t)(value >> 8), (uint8_t)value
+	};
+
+	put(b, sizeof(b));
+}
+
+/**
+ * Size of the PNG image data: zlib header, one stored block per line and
+ * Adler-32
+ * @return uint32_t Bytes
+ */
+uint32_t EScreenEncoder::getPNGDataSize()
+{
+	return 2 + (uint32_t)PNG_LINE_SIZE(width) * height + 4;
+}
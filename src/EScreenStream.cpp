@@ -0,0 +1,409 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EScreenStream.cpp
+ * @class EScreenStream
+ * Build the messages of the live screen stream from the areas written
+ */
+#include <EScreenStream.h>
+
+/** Longest run of pixels */
+#define RUN_MAX 256
+
+/**
+ * Append a 16 bits little endian number
+ * @param [out] p Buffer
+ * @param [in] value Number
+ * @return uint8_t* Next byte of the buffer
+ */
+static inline uint8_t *put16(uint8_t *p, uint16_t value)
+{
+	p[0] = value & 0xff;
+	p[1] = value >> 8;
+	return p + 2;
+}
+
+/**
+ * Encode a line of pixels as runs
+ * @param [in] px Pixels
+ * @param [in] n Number of pixels
+ * @param [out] buf Buffer
+ * @param [in] len Buffer size
+ * @return size_t Bytes written (0: the line does not fit)
+ */
+static size_t encodeRuns(const uint16_t *px, int16_t n, uint8_t *buf,
+		size_t len)
+{
+	uint8_t *p = buf, *end = buf + len;
+	int16_t i = 0, run;
+
+	while (i < n) {
+		for (run = 1; i + run < n && run < RUN_MAX &&
+				px[i + run] == px[i]; run++);
+		if (end - p < 3)
+			return 0;
+		*p++ = run - 1;
+		p = put16(p, px[i]);
+		i += run;
+	}
+	return p - buf;
+}
+
+/**
+ * Constructor
+ * @param [in] width Screen width
+ * @param [in] height Screen height
+ * @param [in] reader Function that reads the screen
+ * @param [in] arg Argument passed to reader
+ */
+EScreenStream::EScreenStream(int16_t width, int16_t height,
+		screen_area_reader_t reader, void *arg) :
+	width(width), height(height), reader(reader), readerArg(arg),
+	line(NULL), lineSize(0)
+{
+	int i;
+
+	for (i = 0; i < SCREEN_STREAM_CLIENTS; i++)
+		clients[i].id = 0;
+	memset(&stats, 0, sizeof(stats));
+
+	// Large enough for both orientations
+	this->lineSize = (width > height) ? width : height;
+	this->line     = new uint16_t[lineSize];
+}
+
+/**
+ * Destructor
+ */
+EScreenStream::~EScreenStream()
+{
+	if (this->line)
+		delete[] this->line;
+}
+
+/**
+ * Check if the buffers could be allocated
+ * @return bool true if the stream can be used
+ */
+bool EScreenStream::isValid()
+{
+	return line && width > 0 && height > 0 && reader;
+}
+
+/**
+ * Get the list the screen writes must be recorded into
+ * (see EInterface::setDamage())
+ * @return SPITFT_Damage*
+ */
+SPITFT_Damage *EScreenStream::getDamage()
+{
+	return &frame;
+}
+
+/**
+ * Set the screen size: when it changes (layout), the viewers get the new
+ * size and the whole screen again
+ * @param [in] width Screen width
+ * @param [in] height Screen height
+ */
+void EScreenStream::setSize(int16_t width, int16_t height)
+{
+	int i;
+
+	if (width == this->width && height == this->height)
+		return;
+	if (width > lineSize || height > lineSize) {
+		delete[] line;
+		lineSize = (width > height) ? width : height;
+		line     = new uint16_t[lineSize];
+	}
+	this->width  = width;
+	this->height = height;
+	frame.clear();
+	for (i = 0; i < SCREEN_STREAM_CLIENTS; i++) {
+		if (clients[i].id)
+			restart(&clients[i]);
+	}
+}
+
+/**
+ * Hand the areas written since the last call to the viewers
+ */
+void EScreenStream::update()
+{
+	uint32_t merges;
+	int i;
+
+	frame.clip(width, height);
+	for (i = 0; i < SCREEN_STREAM_CLIENTS && frame.count(); i++) {
+		if (!clients[i].id)
+			continue;
+		merges = clients[i].damage.merges();
+		clients[i].damage.add(frame);
+		stats.merges += clients[i].damage.merges() - merges;
+	}
+	frame.clear();
+}
+
+/**
+ * Add a viewer: it gets the screen size, then the whole screen
+ * @param [in] id Client ID (not 0)
+ * @return bool false if there are too many viewers
+ */
+bool EScreenStream::addClient(uint32_t id)
+{
+	stream_client_t *client = findClient(0);
+
+	if (!id || !client)
+		return false;
+	client->id = id;
+	restart(client);
+	return true;
+}
+
+/**
+ * Remove a viewer
+ * @param [in] id Client ID
+ */
+void EScreenStream::removeClient(uint32_t id)
+{
+	stream_client_t *client = findClient(id);
+
+	if (id && client)
+		client->id = 0;
+}
+
+/**
+ * Get a viewer
+ * @param [in] i Index, 0 to SCREEN_STREAM_CLIENTS - 1
+ * @return uint32_t Client ID (0: none)
+ */
+uint32_t EScreenStream::getClient(int i)
+{
+	if (i < 0 || i >= SCREEN_STREAM_CLIENTS)
+		return 0;
+	return clients[i].id;
+}
+
+/**
+ * Check if a viewer has messages to take
+ * @param [in] id Client ID
+ * @return bool true if nextMessage() would build a message
+ */
+bool EScreenStream::isPending(uint32_t id)
+{
+	stream_client_t *client = findClient(id);
+
+	return id && client && (client->sendSize || client->damage.count());
+}
+
+/**
+ * A viewer could not take a message: its areas stay queued and keep
+ * merging until it can
+ * @param [in] id Client ID
+ */
+void EScreenStream::setBusy(uint32_t id)
+{
+	if (isPending(id))
+		stats.deferred++;
+}
+
+/**
+ * Build the next message for a viewer
+ *
+ * Areas are sent oldest first; an area that does not fit is split, its
+ * remaining lines being queued again.
+ *
+ * @param [in] id Client ID
+ * @param [out] buf Buffer
+ * @param [in] len Buffer size, at least SCREEN_RECT_HEADER + 2 + 2 * width
+ * @return size_t Message size (0: nothing to send)
+ */
+size_t EScreenStream::nextMessage(uint32_t id, uint8_t *buf, size_t len)
+{
+	stream_client_t *client = findClient(id);
+	SPITFT_Rect rect;
+	uint8_t *p = buf + 2;
+	uint8_t count = 0;
+	int16_t rows;
+	size_t n;
+
+	if (!id || !client || len < 5)
+		return 0;
+
+	if (client->sendSize) {
+		client->sendSize = false;
+		buf[0] = SCREEN_MSG_SIZE;
+		put16(put16(buf + 1, width), height);
+		stats.messages++;
+		stats.bytes += 5;
+		return 5;
+	}
+
+	while (client->damage.count() && count < 255) {
+		rect = client->damage.rect(0);
+		n = encodeRect(rect, p, len - (p - buf), &rows);
+		if (!n) {
+			if (count)
+				break;
+			// Not even a line fits in the buffer
+			client->damage.remove(0);
+			stats.errors++;
+			continue;
+		}
+		client->damage.remove(0);
+		if (rows < rect.h)
+			client->damage.add(rect.x, rect.y + rows, rect.w, rect.h - rows);
+		stats.pixels += (uint32_t)rect.w * rows;
+		p += n;
+		count++;
+	}
+	if (!count)
+		return 0;
+
+	buf[0] = SCREEN_MSG_RECTS;
+	buf[1] = count;
+	stats.messages++;
+	stats.bytes += p - buf;
+	return p - buf;
+}
+
+/**
+ * Get the counters
+ * @return stream_stats_t
+ */
+const EScreenStream::stream_stats_t& EScreenStream::getStats()
+{
+	return stats;
+}
+
+/**
+ * Get the memory used by the stream
+ * @return size_t Bytes
+ */
+size_t EScreenStream::getMemoryUsage()
+{
+	return sizeof(*this) + lineSize * sizeof(uint16_t);
+}
+
+/* ======================= PRIVATE ======================= */
+
+/**
+ * Find a viewer
+ * @param [in] id Client ID (0: a free entry)
+ * @return stream_client_t* NULL if not found
+ */
+EScreenStream::stream_client_t *EScreenStream::findClient(uint32_t id)
+{
+	int i;
+
+	for (i = 0; i < SCREEN_STREAM_CLIENTS; i++) {
+		if (clients[i].id == id)
+			return &clients[i];
+	}
+	return NULL;
+}
+
+/**
+ * Queue the screen size and the whole screen for a viewer
+ * @param [in] client Viewer
+ */
+void EScreenStream::restart(stream_client_t *client)
+{
+	client->sendSize = true;
+	client->damage.clear();
+	client->damage.add(0, 0, width, height);
+}
+
+/**
+ * Encode the first lines of an area that fit in a buffer, as runs when
+ * they are not bigger than the raw pixels
+ * @param [in] rect Area
+ * @param [out] buf Buffer
+ * @param [in] len Buffer size
+ * @param [out] rows Lines encoded
+ * @return size_t Bytes written (0: not even one line fits)
+ */
+size_t EScreenStream::encodeRect(const SPITFT_Rect& rect, uint8_t *buf,
+		size_t len, int16_t *rows)
+{
+	size_t lineBytes = (size_t)rect.w * 2;
+	size_t rawRows, rle = 0, n;
+	uint8_t *p = buf + SCREEN_RECT_HEADER;
+	uint8_t encoding = SCREEN_RECT_RLE;
+	int16_t j, i;
+
+	*rows = 0;
+	if (len <= SCREEN_RECT_HEADER || rect.w > lineSize)
+		return 0;
+	len -= SCREEN_RECT_HEADER;
+	rawRows = len / lineBytes;
+	if (rawRows > (size_t)rect.h)
+		rawRows = rect.h;
+
+	// Runs, given up as soon as they get bigger than the pixels
+	for (j = 0; j < rect.h; j++) {
+		if (!reader(rect.x, rect.y + j, rect.w, 1, line, readerArg)) {
+			stats.errors++;
+			memset(line, 0, lineBytes);
+		}
+		n = encodeRuns(line, rect.w, p + rle, len - rle);
+		if (!n)
+			break;
+		rle += n;
+		(*rows)++;
+		if (rle > *rows * lineBytes)
+			break;
+	}
+
+	if (!*rows || rle > *rows * lineBytes) {
+		if (!rawRows)
+			return 0;
+		encoding = SCREEN_RECT_RAW;
+		for (j = 0; j < (int16_t)rawRows; j++) {
+			if (!reader(rect.x, rect.y + j, rect.w, 1, line, readerArg)) {
+				stats.errors++;
+				memset(line, 0, lineBytes);
+			}
+			for (i = 0; i < rect.w; i++)
+				p = put16(p, line[i]);
+		}
+		*rows = rawRows;
+		stats.rawRects++;
+	} else {
+		p += rle;
+		stats.rleRects++;
+	}
+
+	buf[0] = encoding;
+	put16(put16(put16(put16(buf + 1, rect.x), rect.y), rect.w), *rows);
+	return p - buf;
+}
@@ -0,0 +1,194 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file ETftDMA.cpp
+ * @class ETftDMA
+ * Send pixels to the TFT module with DMA, while the CPU keeps drawing
+ */
+#include <esp_heap_caps.h>
+#include <ETftDMA.h>
+
+/**
+ * Constructor
+ * @param [in] freq SPI clock (Hz), the same used by the TFT driver
+ * @param [in] host SPI host of the TFT module
+ * @param [in] channel DMA channel
+ */
+ETftDMA::ETftDMA(uint32_t freq, spi_host_device_t host, int channel) :
+	host(host), channel(channel), freq(freq), hw(NULL), dev(NULL),
+	next(0), inFlight(0), saved(false)
+{
+	memset(trans, 0, sizeof(trans));
+}
+
+/**
+ * Destructor
+ */
+ETftDMA::~ETftDMA()
+{
+	while (inFlight)
+		waitTransfer();
+	release();
+	if (dev)
+		spi_bus_remove_device(dev);
+}
+
+/**
+ * Attach a DMA capable device to the SPI host
+ * @param [in] maxBytes Largest transfer
+ * @return bool true on success
+ */
+bool ETftDMA::begin(uint32_t maxBytes)
+{
+	spi_bus_config_t buscfg;
+	spi_device_interface_config_t devcfg;
+	esp_err_t err;
+
+	if (dev)
+		return true;
+
+	// Pins are already routed by the Arduino SPI driver
+	memset(&buscfg, 0, sizeof(buscfg));
+	buscfg.mosi_io_num     = -1;
+	buscfg.miso_io_num     = -1;
+	buscfg.sclk_io_num     = -1;
+	buscfg.quadwp_io_num   = -1;
+	buscfg.quadhd_io_num   = -1;
+	buscfg.max_transfer_sz = maxBytes;
+	err = spi_bus_initialize(host, &buscfg, channel);
+	if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+		log_e("spi_bus_initialize: %d", err);
+		return false;
+	}
+
+	// Chip select is driven by Adafruit_SPITFT
+	memset(&devcfg, 0, sizeof(devcfg));
+	devcfg.clock_speed_hz = freq;
+	devcfg.mode           = 0;
+	devcfg.spics_io_num   = -1;
+	devcfg.queue_size     = SPITFT_DMA_QUEUE_DEPTH;
+	devcfg.flags          = SPI_DEVICE_NO_DUMMY;
+	err = spi_bus_add_device(host, &devcfg, &dev);
+	if (err != ESP_OK) {
+		log_e("spi_bus_add_device: %d", err);
+		dev = NULL;
+		return false;
+	}
+
+	hw = (host == VSPI_HOST) ? &SPI3 : &SPI2;
+	return true;
+}
+
+/**
+ * Allocate a buffer in DMA capable memory
+ * @param [in] bytes Size
+ * @return void* Buffer or NULL
+ */
+void *ETftDMA::allocBuffer(uint32_t bytes)
+{
+	return heap_caps_malloc(bytes, MALLOC_CAP_DMA);
+}
+
+/**
+ * Free a buffer
+ * @param [in] buf Buffer
+ */
+void ETftDMA::freeBuffer(void *buf)
+{
+	heap_caps_free(buf);
+}
+
+/**
+ * Queue a transfer
+ * @param [in] data Bytes (DMA capable memory)
+ * @param [in] len Number of bytes
+ */
+void ETftDMA::startTransfer(const uint8_t *data, uint32_t len)
+{
+	spi_transaction_t *t = &trans[next];
+
+	if (!saved) {
+		regClock    = hw->clock.val;
+		regUser     = hw->user.val;
+		regUser1    = hw->user1.val;
+		regUser2    = hw->user2.val;
+		regCtrl     = hw->ctrl.val;
+		regCtrl2    = hw->ctrl2.val;
+		regPin      = hw->pin.val;
+		regDmaConf  = hw->dma_conf.val;
+		regMosiDlen = hw->mosi_dlen.val;
+		regMisoDlen = hw->miso_dlen.val;
+		saved = true;
+	}
+
+	memset(t, 0, sizeof(*t));
+	t->length    = len * 8;
+	t->tx_buffer = data;
+	if (spi_device_queue_trans(dev, t, portMAX_DELAY) != ESP_OK) {
+		log_e("spi_device_queue_trans failed");
+		return;
+	}
+	next = (next + 1) % SPITFT_DMA_QUEUE_DEPTH;
+	inFlight++;
+}
+
+/**
+ * Wait for the oldest transfer
+ */
+void ETftDMA::waitTransfer()
+{
+	spi_transaction_t *t;
+
+	if (!inFlight)
+		return;
+	spi_device_get_trans_result(dev, &t, portMAX_DELAY);
+	inFlight--;
+}
+
+/**
+ * Restore the Arduino SPI driver settings
+ */
+void ETftDMA::release()
+{
+	if (!saved)
+		return;
+	hw->clock.val     = regClock;
+	hw->user.val      = regUser;
+	hw->user1.val     = regUser1;
+	hw->user2.val     = regUser2;
+	hw->ctrl.val      = regCtrl;
+	hw->ctrl2.val     = regCtrl2;
+	hw->pin.val       = regPin;
+	hw->dma_conf.val  = regDmaConf;
+	hw->mosi_dlen.val = regMosiDlen;
+	hw->miso_dlen.val = regMisoDlen;
+	saved = false;
+}
@@ -0,0 +1,269 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EWeatherScheduler.cpp
+ * @class EWeatherScheduler
+ * Refresh scheduler of the weather information
+ */
+#include <EWeatherScheduler.h>
+
+/**
+ * Constructor
+ * @param [in] ow Weather client
+ */
+EWeatherScheduler::EWeatherScheduler(OpenWeather *ow) :
+	ow(ow), scheduled(false), failures(0),
+	retryMin(WEATHER_RETRY_MIN * 1000), retryMax(WEATHER_RETRY_MAX * 1000)
+{
+	int i;
+
+	for (i = 0; i < OpenWeather::RES_COUNT; i++) {
+		interval[i] = WEATHER_RETRY_MAX * 1000;
+		due[i]      = 0;
+	}
+	memset(&st, 0, sizeof(st));
+}
+
+/**
+ * Set the polling intervals (used from the next request)
+ * @param [in] current Current weather (seconds)
+ * @param [in] forecast Forecast (seconds)
+ */
+void EWeatherScheduler::setIntervals(uint32_t current, uint32_t forecast)
+{
+	interval[OpenWeather::RES_CURRENT]  = current * 1000;
+	interval[OpenWeather::RES_FORECAST] = forecast * 1000;
+}
+
+/**
+ * Set the delays after errors
+ * @param [in] min Delay after the first error (seconds)
+ * @param [in] max Longest delay, doubled at each consecutive error up to
+ *                 it (seconds)
+ */
+void EWeatherScheduler::setRetry(uint32_t min, uint32_t max)
+{
+	retryMin = min * 1000;
+	retryMax = max * 1000;
+}
+
+/**
+ * Request everything at the next poll
+ */
+void EWeatherScheduler::refresh()
+{
+	scheduled = false;
+}
+
+/**
+ * Send the requests due
+ *
+ * A failed request delays the requests due with it, so that a server
+ * throttling the device is not asked again right away.
+ *
+ * @param [in] now Time (millis())
+ * @param [out] changed Information changed (WEATHER_CHANGED_*)
+ * @return int 0 on success (or nothing due), error number otherwise
+ */
+int EWeatherScheduler::poll(unsigned long now, unsigned int *changed)
+{
+	bool pending[OpenWeather::RES_COUNT];
+	OpenWeather::resource_t res;
+	uint32_t delay, d;
+	int i, ret = 0;
+
+	*changed = 0;
+	for (i = 0; i < OpenWeather::RES_COUNT; i++) {
+		if (!scheduled)
+			due[i] = now;
+		pending[i] = (long)(now - due[i]) >= 0;
+	}
+	scheduled = true;
+	if (!pending[OpenWeather::RES_CURRENT] &&
+			!pending[OpenWeather::RES_FORECAST])
+		return 0;
+
+	if (ow->getFetchMode() == OpenWeather::FETCH_SINGLE) {
+		// One request brings both, on the shorter interval
+		pending[OpenWeather::RES_CURRENT]  = true;
+		pending[OpenWeather::RES_FORECAST] = true;
+		res      = OpenWeather::RES_FORECAST;
+		ret      = ow->updateForecast();
+		*changed = account(res, ret, true);
+		if (ret == 0) {
+			delay = nextDelay(OpenWeather::RES_CURRENT);
+			d     = nextDelay(OpenWeather::RES_FORECAST);
+			if (d < delay)
+				delay = d;
+		}
+	} else {
+		for (i = 0; i < OpenWeather::RES_COUNT && ret == 0; i++) {
+			if (!pending[i])
+				continue;
+			res = (OpenWeather::resource_t)i;
+			if (res == OpenWeather::RES_CURRENT)
+				ret = ow->updateDailyForecast();
+			else
+				ret = ow->updateWeeklyForecast();
+			*changed |= account(res, ret, false);
+			if (ret == 0) {
+				due[i]     = now + nextDelay(res);
+				pending[i] = false;
+			}
+		}
+		delay = 0;
+	}
+
+	if (ret != 0) {
+		delay = errorDelay(res);
+		log_i("Weather update failed (%d), next attempt in %u s", ret,
+				(unsigned int)(delay / 1000));
+	}
+	for (i = 0; i < OpenWeather::RES_COUNT; i++) {
+		if (pending[i])
+			due[i] = now + delay;
+	}
+	return ret;
+}
+
+/**
+ * Time to the next request
+ * @param [in] now Time (millis())
+ * @return unsigned long Milliseconds (0: due now)
+ */
+unsigned long EWeatherScheduler::nextPoll(unsigned long now)
+{
+	long next = -1, d;
+	int i;
+
+	if (!scheduled)
+		return 0;
+	for (i = 0; i < OpenWeather::RES_COUNT; i++) {
+		d = (long)(due[i] - now);
+		if (next < 0 || d < next)
+			next = d;
+	}
+	return next > 0 ? next : 0;
+}
+
+/**
+ * Return the number of consecutive errors
+ * @return unsigned int
+ */
+unsigned int EWeatherScheduler::getFailures()
+{
+	return failures;
+}
+
+/**
+ * Return the counters
+ * @return const sched_stats_t&
+ */
+const sched_stats_t& EWeatherScheduler::getStats()
+{
+	return st;
+}
+
+/* ======================= PRIVATE ======================= */
+
+/**
+ * Delay of the next request of a resource after a success
+ * @param [in] res Resource
+ * @return uint32_t Interval, or the max-age of the server when longer (ms)
+ */
+uint32_t EWeatherScheduler::nextDelay(OpenWeather::resource_t res)
+{
+	long maxAge = ow->getCache(res).maxAge;
+
+	if (maxAge > WEATHER_SERVER_DELAY_MAX)
+		maxAge = WEATHER_SERVER_DELAY_MAX;
+	if (maxAge * 1000 > (long)interval[res])
+		return maxAge * 1000;
+	return interval[res];
+}
+
+/**
+ * Delay of the next request after an error
+ * @param [in] res Resource that failed
+ * @return uint32_t Delay doubled at each consecutive error, or the
+ *                  Retry-After of the server when longer, plus up to 25%
+ *                  of jitter (ms)
+ */
+uint32_t EWeatherScheduler::errorDelay(OpenWeather::resource_t res)
+{
+	long retryAfter = ow->getCache(res).retryAfter;
+	uint32_t delay = retryMin;
+	unsigned int i;
+
+	for (i = 1; i < failures && delay < retryMax; i++)
+		delay *= 2;
+	if (delay > retryMax)
+		delay = retryMax;
+	if (retryAfter > WEATHER_SERVER_DELAY_MAX)
+		retryAfter = WEATHER_SERVER_DELAY_MAX;
+	if (retryAfter * 1000 > (long)delay)
+		delay = retryAfter * 1000;
+	return delay + random(delay / 4 + 1);
+}
+
+/**
+ * Account an update
+ * @param [in] res Resource
+ * @param [in] ret Result of the update
+ * @param [in] current The update also brought the current weather
+ * @return unsigned int Information changed (WEATHER_CHANGED_*)
+ */
+unsigned int EWeatherScheduler::account(OpenWeather::resource_t res, int ret,
+		bool current)
+{
+	unsigned int changed = 0;
+
+	st.requests++;
+	if (ret != 0) {
+		st.errors++;
+		failures++;
+		return 0;
+	}
+	failures = 0;
+
+	if (ow->isChanged(res))
+		changed |= 1 << res;
+	if (current && ow->isChanged(OpenWeather::RES_CURRENT))
+		changed |= WEATHER_CHANGED_CURRENT;
+
+	if (ow->getCache(res).status == OW_NOT_MODIFIED)
+		st.notModified++;
+	else if (changed)
+		st.changed++;
+	else
+		st.unchanged++;
+	return changed;
+}
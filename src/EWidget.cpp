@@ -0,0 +1,115 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EWidget.cpp
+ * @class EWidget
+ * Retained state of a screen element, used to skip redrawing values that
+ * did not change
+ */
+#include <EWidget.h>
+
+/**
+ * Constructor
+ */
+EWidget::EWidget() : invalid(false)
+{
+	value[0] = '\0';
+	drawn[0] = '\0';
+}
+
+/**
+ * Set a value without drawing it
+ *
+ * The widget is clean: it will only be drawn when the value changes or
+ * when it is invalidated.
+ *
+ * @param [in] value Formatted value
+ */
+void EWidget::reset(const char *value)
+{
+	set(value);
+	drawDone();
+}
+
+/**
+ * Set the formatted value
+ * @param [in] value Formatted value
+ * @return bool true if the widget must be drawn
+ */
+bool EWidget::set(const char *value)
+{
+	size_t len = strlen(value);
+
+	if (len >= WIDGET_VALUE_MAX) {
+		// Too long to be compared, always draw it
+		len = WIDGET_VALUE_MAX - 1;
+		this->invalid = true;
+	}
+	memcpy(this->value, value, len);
+	this->value[len] = '\0';
+	return isDirty();
+}
+
+/**
+ * Get the formatted value
+ * @return const char*
+ */
+const char *EWidget::get()
+{
+	return value;
+}
+
+/**
+ * Check whether the widget must be drawn
+ * @return bool true if the value changed since it was drawn or the widget
+ * was invalidated
+ */
+bool EWidget::isDirty()
+{
+	return (invalid || strcmp(value, drawn) != 0);
+}
+
+/**
+ * Force the widget to be drawn, even if its value does not change
+ */
+void EWidget::invalidate()
+{
+	invalid = true;
+}
+
+/**
+ * Mark the current value as drawn
+ */
+void EWidget::drawDone()
+{
+	strcpy(drawn, value);
+	invalid = false;
+}
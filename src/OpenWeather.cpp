@@ -34,17 +34,110 @@
  * Provide weather information through OpenWeather API
  */
 
-#include <HTTPClient.h>
+#include <ctype.h>
+#include <EHttpRequest.h>
 #include <ArduinoJson.h>
 #include "OpenWeather.h"
 
 #define MAX_URL_SIZE  512
 
+/** Conditions kept from the weather array of a forecast */
+#define FC_WEATHER_MAX 3
+
+/** Filter: dt, main (6 fields) and the id of each weather condition */
+#define FC_FILTER_SIZE (JSON_OBJECT_SIZE(3) + JSON_OBJECT_SIZE(6) + \
+		JSON_ARRAY_SIZE(1) + JSON_OBJECT_SIZE(1))
+
+/** One forecast, filtered: values plus copies of the keys */
+#define FC_DOC_SIZE (JSON_OBJECT_SIZE(3) + JSON_OBJECT_SIZE(6) + \
+		JSON_ARRAY_SIZE(FC_WEATHER_MAX) + \
+		FC_WEATHER_MAX * JSON_OBJECT_SIZE(1) + 96)
+
+/**
+ * Build the filter of a forecast: only the fields of weather_info_t are
+ * kept (the current weather and each entry of the forecast list have the
+ * same layout)
+ * @param [out] filter Filter
+ */
+static void forecastFilter(JsonDocument& filter)
+{
+	JsonObject main = filter.createNestedObject("main");
+
+	filter["dt"] = true;
+	filter["weather"][0]["id"] = true;
+	main["temp"]       = true;
+	main["temp_min"]   = true;
+	main["temp_max"]   = true;
+	main["feels_like"] = true;
+	main["pressure"]   = true;
+	main["humidity"]   = true;
+}
+
+/**
+ * Fill weather information from a (filtered) forecast
+ * @param [in] doc Forecast
+ * @param [out] info Weather information
+ */
+static void readForecast(JsonDocument& doc, weather_info_t *info)
+{
+	info->temp     = doc["main"]["temp"];
+	info->min      = doc["main"]["temp_min"];
+	info->max      = doc["main"]["temp_max"];
+	info->feels    = doc["main"]["feels_like"];
+	info->pressure = doc["main"]["pressure"];
+	info->humidity = doc["main"]["humidity"];
+	info->weather  = OpenWeather::getWeatherFromID(doc["weather"][0]["id"]);
+	info->date     = doc["dt"];
+}
+
+/**
+ * Compare weather information
+ * @param [in] x Weather information
+ * @param [in] y Weather information
+ * @return bool true when they are equal
+ */
+static bool sameInfo(const weather_info_t *x, const weather_info_t *y)
+{
+	return x->temp == y->temp && x->min == y->min && x->max == y->max &&
+		x->feels == y->feels && x->humidity == y->humidity &&
+		x->pressure == y->pressure && x->weather == y->weather &&
+		x->date == y->date;
+}
+
+/**
+ * Keep a cache validator
+ * @param [out] dst Validator (left empty when too long: never cut)
+ * @param [in] value Header value
+ */
+static void setValidator(char *dst, const String& value)
+{
+	if (value.length() < OW_VALIDATOR_MAX)
+		strcpy(dst, value.c_str());
+	else
+		dst[0] = '\0';
+}
+
+/**
+ * Read max-age from a Cache-Control header
+ * @param [in] value Header value
+ * @return long Seconds (0 for no-cache and no-store), -1 when not given
+ */
+static long cacheMaxAge(const String& value)
+{
+	const char *cc = value.c_str(), *p;
+
+	if (strstr(cc, "no-cache") || strstr(cc, "no-store"))
+		return 0;
+	p = strstr(cc, "max-age=");
+	return p ? atol(p + 8) : -1;
+}
+
 /**
  * Constructor
  */
 OpenWeather::OpenWeather() :
-	key(""), city("")
+	key(""), city(""), server(OW_SERVER), net(NULL), docUsage(0),
+	fetchMode(OW_FETCH_MODE)
 {
 	int i;
 	for (i = 0; i < MAX_FORECAST_DAYS; i++) {
@@ -57,6 +150,8 @@ OpenWeather::OpenWeather() :
 		weeklyFC[i].weather  = CLEAR_SKY;
 		weeklyFC[i].date     = 0;
 	}
+	dailyFC = weeklyFC[0];
+	clearCache();
 }
 
 /**
@@ -75,6 +170,8 @@ OpenWeather::OpenWeather(const String& key)
  */
 void OpenWeather::setCity(const String& city)
 {
+	if (this->city != city)
+		clearCache();
 	this->city = city;
 }
 
@@ -84,6 +181,8 @@ void OpenWeather::setCity(const String& city)
  */
 void OpenWeather::setAPIKey(const String& key)
 {
+	if (this->key != key)
+		clearCache();
 	this->key = key;
 }
 
@@ -107,84 +206,137 @@ const String OpenWeather::getAPIKey()
 
 /**
  * Retrieve daily forecast from the server
- * @return 0 on success, error number otherwise
+ * @return 0 on success (or not modified), error number otherwise
  */
 int OpenWeather::updateDailyForecast()
 {
-	char url[MAX_URL_SIZE];
-	HTTPClient http;
-	int res;
+	return fetch(RES_CURRENT, FC_PATH_DAILY, "", false);
+}
 
-	// URL
-	snprintf(url, MAX_URL_SIZE,
-			"%s?q=%s&appid=%s", FC_URL_DAILY,
-			city.c_str(), key.c_str());
+/**
+ * Set the network layer used for the requests
+ * @param [in] net Network layer
+ */
+void OpenWeather::setNetwork(ENetwork *net)
+{
+	this->net = net;
+}
 
-	// Retrieve from server
-	http.begin(url);
-	res = http.GET();
+/**
+ * Set the server
+ * @param [in] server URL of the server (http://host[:port])
+ */
+void OpenWeather::setServer(const String& server)
+{
+	this->server = server;
+}
 
-	// Check result
-	if(res > 0) {
-		if(res == HTTP_CODE_OK) {
-			// Parse information
-			res = parseDaily(http.getString());
-		} else {
-			log_e("HTTP/GET response error: %d", res);
-		}
-	} else {
-		log_e("HTTP/GET error: %d", res);
-	}
+/**
+ * Set how updateForecast() retrieves the weather
+ * @param [in] mode FETCH_SINGLE: one request (forecast), FETCH_SPLIT: two
+ *                  requests (current weather and forecast)
+ */
+void OpenWeather::setFetchMode(fetch_mode_t mode)
+{
+	fetchMode = mode;
+}
 
-	http.end();
-	return res;
+/**
+ * Return the fetch mode
+ * @return fetch_mode_t
+ */
+OpenWeather::fetch_mode_t OpenWeather::getFetchMode()
+{
+	return fetchMode;
 }
 
 /**
  * Retrieve weekly forecast from the server
- * @return 0 on success, error number otherwise
+ * @param [in] current Also set the current weather (first forecast entry)
+ * @return 0 on success (or not modified), error number otherwise
  */
-int OpenWeather::updateWeeklyForecast()
+int OpenWeather::updateWeeklyForecast(bool current)
+{
+	return fetch(RES_FORECAST, FC_PATH_WEEKLY, "&cnt=24", current);
+}
+
+/**
+ * Retrieve forecast from the server
+ *
+ * With FETCH_SINGLE, one exchange fills both the current weather and the
+ * forecast: the current weather is the first entry of the forecast (the
+ * nearest 3 hour step). When the forecast was received but could not be
+ * parsed, both are retrieved again with the two requests of FETCH_SPLIT.
+ * Connection and HTTP errors are returned as they are: more requests would
+ * not help a server that is down or throttling the device.
+ *
+ * @return 0 on success, error number otherwise (first error)
+ */
+int OpenWeather::updateForecast()
 {
-	char url[MAX_URL_SIZE];
-	HTTPClient http;
 	int res;
 
-	// URL
-	snprintf(url, MAX_URL_SIZE,
-			"%s?q=%s&appid=%s&cnt=24", FC_URL_WEEKLY,
-			city.c_str(), key.c_str());
+	if (fetchMode == FETCH_SINGLE) {
+		res = updateWeeklyForecast(true);
+		if (res == 0 || cache[RES_FORECAST].status != HTTP_OK)
+			return res;
+		log_i("Forecast not parsed (%d), trying two requests", res);
+	}
 
-	// Retrieve from server
-	http.begin(url);
-	res = http.GET();
+	res = updateDailyForecast();
+	if (res == 0)
+		res = updateWeeklyForecast();
+	return res;
+}
 
-	// Check result
-	if(res > 0) {
-		if(res == HTTP_CODE_OK) {
-			// Parse information
-			res = parseWeekly(http.getString());
-		} else {
-			log_e("HTTP/GET response error: %d", res);
-		}
-	} else {
-		log_e("HTTP/GET error: %d", res);
+/**
+ * Forget the cache validators (next requests are unconditional)
+ */
+void OpenWeather::clearCache()
+{
+	int i;
+
+	for (i = 0; i < RES_COUNT; i++) {
+		cache[i].etag[0]     = '\0';
+		cache[i].modified[0] = '\0';
+		cache[i].maxAge      = -1;
+		cache[i].retryAfter  = 0;
+		cache[i].status      = 0;
+		cache[i].changed     = false;
 	}
+}
 
-	http.end();
-	return res;
+/**
+ * Return the cache state of a resource
+ * @param [in] res Resource
+ * @return const ow_cache_t& Cache state
+ */
+const ow_cache_t& OpenWeather::getCache(resource_t res)
+{
+	return cache[res];
 }
 
 /**
- * Retrieve forecast from the server
- * @return 0 on success, error number otherwise
+ * Tell whether the last update changed the information
+ *
+ * False when the server answered 304 Not Modified, or sent the same
+ * values again.
+ *
+ * @param [in] res Resource
+ * @return bool true when the information changed
  */
-int OpenWeather::updateForecast()
+bool OpenWeather::isChanged(resource_t res)
 {
-	int res = 0;
-	res |= updateDailyForecast();
-	res |= updateWeeklyForecast();
-	return res;
+	return cache[res].changed;
+}
+
+/**
+ * Return the JSON document memory used by the last parse
+ * @return size_t Bytes (largest forecast entry for the weekly forecast)
+ */
+size_t OpenWeather::getDocumentUsage()
+{
+	return docUsage;
 }
 
 /**
@@ -235,84 +387,180 @@ weather_t OpenWeather::getWeatherFromID(int id)
 	return (weather_t)id;
 }
 
-
-/* ======================= PRIVATE ======================= */
-
 /**
  * Parse daily forecast information
- * @param [in] json JSON string
+ * @param [in] json JSON document (current weather)
  * @return int 0 on success, negative number otherwise
  */
-int OpenWeather::parseDaily(const String& json)
+int OpenWeather::parseDaily(Stream& json)
 {
-	int id;
-	StaticJsonDocument<1024> doc;
-	DeserializationError error = deserializeJson(doc, json);
+	StaticJsonDocument<FC_FILTER_SIZE> filter;
+	StaticJsonDocument<FC_DOC_SIZE> doc;
+	DeserializationError error;
 
+	forecastFilter(filter);
+	error = deserializeJson(doc, json, DeserializationOption::Filter(filter));
+	docUsage = doc.memoryUsage();
 	if (error) {
 		log_e("deserializeJson() failed: %s", error.c_str());
 		return -1;
 	}
 
-	id = doc["weather"][0]["id"];
-
-	dailyFC.temp     = doc["main"]["temp"];
-	dailyFC.min      = doc["main"]["temp_min"];
-	dailyFC.max      = doc["main"]["temp_max"];
-	dailyFC.feels    = doc["main"]["feels_like"];
-	dailyFC.pressure = doc["main"]["pressure"];
-	dailyFC.humidity = doc["main"]["humidity"];
-
-	dailyFC.weather  = getWeatherFromID(id);
-	dailyFC.date     = doc["dt"];
-
+	readForecast(doc, &dailyFC);
 	return 0;
 }
 
 /**
  * Parse weekly forecast information
- * @param [in] json JSON string
+ *
+ * The entries of the forecast list are parsed one at a time as they are
+ * read, so memory does not depend on the number of entries. The first
+ * entry of each day is kept. The forecast is left untouched when the
+ * document is malformed or truncated.
+ *
+ * @param [in] json JSON document (5 day / 3 hour forecast)
+ * @param [in] current Also set the current weather (first entry)
  * @return int 0 on success, negative number otherwise
  */
-int OpenWeather::parseWeekly(const String& json)
+int OpenWeather::parseWeekly(Stream& json, bool current)
 {
-	int i, j, cnt, lday, cday, id;
+	StaticJsonDocument<FC_FILTER_SIZE> filter;
+	StaticJsonDocument<FC_DOC_SIZE> doc;
+	weather_info_t fc[MAX_FORECAST_DAYS];
+	DeserializationError error;
+	int i, j, lday, cday;
 	time_t t;
-	StaticJsonDocument<20480> doc;
-	DeserializationError error = deserializeJson(doc, json);
+	char c;
 
-	if (error) {
-		log_e("deserializeJson() failed: %s", error.c_str());
+	docUsage = 0;
+	if (!json.find("\"list\"") || !json.find("[")) {
+		log_e("Forecast list not found");
 		return -1;
 	}
 
-	cnt  = doc["cnt"];
+	forecastFilter(filter);
 	j    = 0;
 	lday = -1;
-	for (i = 0; i < cnt; i++) {
-		t = doc["list"][i]["dt"];
-		cday = day(t);
+	do {
+		error = deserializeJson(doc, json,
+				DeserializationOption::Filter(filter));
+		if (doc.memoryUsage() > docUsage)
+			docUsage = doc.memoryUsage();
+		if (error) {
+			log_e("deserializeJson() failed: %s", error.c_str());
+			return -1;
+		}
 
+		t    = doc["dt"];
+		cday = day(t);
 		if (cday != lday) {
 			lday = cday;
-
-			id = doc["list"][i]["weather"][0]["id"];
-			weeklyFC[j].temp     = doc["list"][i]["main"]["temp"];
-			weeklyFC[j].min      = doc["list"][i]["main"]["temp_min"];
-			weeklyFC[j].max      = doc["list"][i]["main"]["temp_max"];
-			weeklyFC[j].feels    = doc["list"][i]["main"]["feels_like"];
-			weeklyFC[j].pressure = doc["list"][i]["main"]["pressure"];
-			weeklyFC[j].humidity = doc["list"][i]["main"]["humidity"];
-
-			weeklyFC[j].weather  = getWeatherFromID(id);
-			weeklyFC[j].date     = t;
+			readForecast(doc, &fc[j]);
 			j++;
+		}
 
-			if (j >= MAX_FORECAST_DAYS)
-				break;
+		// Next entry (',') or end of the list (']')
+		do {
+			if (json.readBytes(&c, 1) != 1) {
+				log_e("Forecast list truncated");
+				return -1;
+			}
+		} while (isspace(c));
+		if (c != ',' && c != ']') {
+			log_e("Malformed forecast list");
+			return -1;
 		}
-	}
+	} while (c == ',' && j < MAX_FORECAST_DAYS);
 
+	for (i = 0; i < j; i++)
+		weeklyFC[i] = fc[i];
+	// The first entry of the list is always the first of its day
+	if (current)
+		dailyFC = fc[0];
 	return 0;
 }
 
+/* ======================= PRIVATE ======================= */
+
+/**
+ * Send a (conditional) request and parse the response
+ *
+ * The validators of the information held (ETag, Last-Modified) go with the
+ * request, so the server can answer 304 Not Modified instead of the whole
+ * document, which is then not parsed. The validators and max-age of a
+ * response are kept once it has been parsed.
+ *
+ * @param [in] res Resource
+ * @param [in] path Path on the server
+ * @param [in] query Parameters added after the city and the API key
+ * @param [in] current Forecast: also set the current weather
+ * @return 0 on success (or not modified), error number otherwise
+ */
+int OpenWeather::fetch(resource_t res, const char *path, const char *query,
+		bool current)
+{
+	static const char *const headers[] = {
+		"ETag", "Last-Modified", "Cache-Control", "Retry-After"
+	};
+	weather_info_t daily = dailyFC, weekly[MAX_FORECAST_DAYS];
+	ow_cache_t *c = &cache[res];
+	char url[MAX_URL_SIZE];
+	EHttpRequest http(net);
+	int ret, i;
+
+	// URL
+	snprintf(url, MAX_URL_SIZE,
+			"%s%s?q=%s&appid=%s%s", server.c_str(), path,
+			city.c_str(), key.c_str(), query);
+
+	if (c->etag[0])
+		http.addHeader("If-None-Match", c->etag);
+	if (c->modified[0])
+		http.addHeader("If-Modified-Since", c->modified);
+	http.collectHeaders(headers, sizeof(headers) / sizeof(headers[0]));
+
+	// Retrieve from server (the body is parsed straight from the
+	// connection, kept open for the next request)
+	ret = http.GET(url);
+
+	c->status     = ret;
+	c->retryAfter = 0;
+	c->changed    = false;
+	if (current)
+		cache[RES_CURRENT].changed = false;
+
+	// Check result
+	if (ret == HTTP_OK) {
+		// Parse information
+		memcpy(weekly, weeklyFC, sizeof(weekly));
+		if (res == RES_CURRENT)
+			ret = parseDaily(http.getStream());
+		else
+			ret = parseWeekly(http.getStream(), current);
+
+		if (ret == 0) {
+			setValidator(c->etag, http.header("ETag"));
+			setValidator(c->modified, http.header("Last-Modified"));
+			c->maxAge = cacheMaxAge(http.header("Cache-Control"));
+
+			if (res == RES_CURRENT || current)
+				cache[RES_CURRENT].changed = !sameInfo(&daily, &dailyFC);
+			for (i = 0; i < MAX_FORECAST_DAYS && res == RES_FORECAST; i++) {
+				if (!sameInfo(&weekly[i], &weeklyFC[i]))
+					c->changed = true;
+			}
+		}
+	} else if (ret == OW_NOT_MODIFIED) {
+		if (http.header("Cache-Control").length())
+			c->maxAge = cacheMaxAge(http.header("Cache-Control"));
+		ret = 0;
+	} else if (ret > 0) {
+		c->retryAfter = http.header("Retry-After").toInt();
+		log_e("HTTP/GET response error: %d", ret);
+	} else {
+		log_e("HTTP/GET error: %d", ret);
+	}
+
+	http.end();
+	return ret;
+}
@@ -0,0 +1,197 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file FS.cpp
+ * File system for the host emulator
+ */
+#include <unistd.h>
+#include "FS.h"
+
+namespace fs {
+
+/** Host file */
+class FileImpl {
+	public:
+		FILE *fp;
+		String path;
+		FSStats *st;
+
+		FileImpl(FILE *fp, const String& path, FSStats *st) :
+			fp(fp), path(path), st(st) {}
+		~FileImpl() {
+			if (fp)
+				fclose(fp);
+		}
+};
+
+size_t File::write(uint8_t c)
+{
+	return write(&c, 1);
+}
+
+size_t File::write(const uint8_t *buf, size_t size)
+{
+	if (!p || !p->fp)
+		return 0;
+	p->st->writes++;
+	size = fwrite(buf, 1, size, p->fp);
+	p->st->writeBytes += size;
+	return size;
+}
+
+int File::available()
+{
+	if (!p || !p->fp)
+		return 0;
+	return size() - position();
+}
+
+int File::read()
+{
+	uint8_t c;
+	if (read(&c, 1) != 1)
+		return -1;
+	return c;
+}
+
+int File::peek()
+{
+	int c;
+	if (!p || !p->fp)
+		return -1;
+	c = fgetc(p->fp);
+	if (c != EOF)
+		ungetc(c, p->fp);
+	return c == EOF ? -1 : c;
+}
+
+size_t File::read(uint8_t *buf, size_t size)
+{
+	if (!p || !p->fp)
+		return 0;
+	p->st->reads++;
+	size = fread(buf, 1, size, p->fp);
+	p->st->readBytes += size;
+	return size;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode)
+{
+	if (!p || !p->fp)
+		return false;
+	p->st->seeks++;
+	return fseek(p->fp, pos, mode == SeekSet ? SEEK_SET :
+			(mode == SeekCur ? SEEK_CUR : SEEK_END)) == 0;
+}
+
+size_t File::position() const
+{
+	if (!p || !p->fp)
+		return 0;
+	return ftell(p->fp);
+}
+
+size_t File::size() const
+{
+	long cur, end;
+	if (!p || !p->fp)
+		return 0;
+	cur = ftell(p->fp);
+	fseek(p->fp, 0, SEEK_END);
+	end = ftell(p->fp);
+	fseek(p->fp, cur, SEEK_SET);
+	return end;
+}
+
+void File::close()
+{
+	p.reset();
+}
+
+File::operator bool() const
+{
+	return p && p->fp;
+}
+
+const char *File::name() const
+{
+	return p ? p->path.c_str() : "";
+}
+
+/**
+ * Constructor
+ * @param [in] root Host directory used as the file system root
+ */
+FS::FS(const String& root) : root(root)
+{
+	resetStats();
+}
+
+/**
+ * Open a file
+ * @param [in] path File path (relative to the file system root)
+ * @param [in] mode Mode ("r", "w" or "a")
+ * @return File
+ */
+File FS::open(const char *path, const char *mode)
+{
+	String hpath = root + path;
+	String hmode = String(mode) + "b";
+	FILE *fp = fopen(hpath.c_str(), hmode.c_str());
+
+	if (!fp)
+		return File();
+
+	st.opens++;
+	return File(FileImplPtr(new FileImpl(fp, String(path), &st)));
+}
+
+bool FS::exists(const char *path)
+{
+	String hpath = root + path;
+	return access(hpath.c_str(), F_OK) == 0;
+}
+
+bool FS::remove(const char *path)
+{
+	String hpath = root + path;
+	return unlink(hpath.c_str()) == 0;
+}
+
+/**
+ * Reset access counters
+ */
+void FS::resetStats()
+{
+	memset(&st, 0, sizeof(st));
+}
+
+} // namespace fs
@@ -0,0 +1,352 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file ILI9341Emu.cpp
+ * @class ILI9341Emu
+ * Emulated ILI9341 controller
+ * Decodes the command stream sent by Adafruit_ILI9341 (CASET, PASET, RAMWR,
+ * RAMRD and MADCTL) into a 240x320 RGB565 frame memory and accounts every
+ * byte that goes through the bus.
+ */
+#include <vector>
+#include "ILI9341Emu.h"
+#include "png.h"
+
+/* Commands */
+#define EMU_CASET  0x2a
+#define EMU_PASET  0x2b
+#define EMU_RAMWR  0x2c
+#define EMU_RAMRD  0x2e
+#define EMU_MADCTL 0x36
+
+/* MADCTL bits */
+#define EMU_MADCTL_MY 0x80
+#define EMU_MADCTL_MX 0x40
+#define EMU_MADCTL_MV 0x20
+
+/**
+ * Constructor
+ * @param [in] cs CS pin
+ * @param [in] dc DC pin
+ */
+ILI9341Emu::ILI9341Emu(int8_t cs, int8_t dc) :
+	cs(cs), dc(dc), csLevel(HIGH), dcLevel(HIGH), clock(1000000),
+	madctl(0), cmd(0), nparam(0), xs(0), xe(EMU_TFTWIDTH - 1),
+	ys(0), ye(EMU_TFTHEIGHT - 1), cx(0), cy(0), pixel(0), timed(false),
+	pendingTime(0)
+{
+	memset(gram, 0, sizeof(gram));
+	resetStats();
+}
+
+/**
+ * Make transfers take (virtual) time
+ *
+ * Each byte advances the virtual clock (delayMicroseconds()) by its bus
+ * time, so time measured with micros() includes the transfers.
+ *
+ * @param [in] timed Enable timed transfers
+ */
+void ILI9341Emu::setTimed(bool timed)
+{
+	this->timed = timed;
+}
+
+/**
+ * Bus has been acquired
+ * @param [in] settings Transaction settings
+ */
+void ILI9341Emu::beginTransaction(const SPISettings& settings)
+{
+	clock = settings._clock;
+	st.transactions++;
+}
+
+/**
+ * Exchange one byte
+ * @param [in] d Byte sent by the host
+ * @return uint8_t Byte sent by the controller
+ */
+uint8_t ILI9341Emu::transfer(uint8_t d)
+{
+	if (cs >= 0 && csLevel != LOW)
+		return 0xff;
+
+	st.bytes++;
+	st.busTime += 8e6 / clock;
+	if (timed) {
+		pendingTime += 8e6 / clock;
+		if (pendingTime >= 1) {
+			delayMicroseconds((uint32_t)pendingTime);
+			pendingTime -= (uint32_t)pendingTime;
+		}
+	}
+
+	if (dcLevel == LOW) {
+		command(d);
+		return 0;
+	}
+	return data(d);
+}
+
+/**
+ * Pin level changed
+ * @param [in] pin Pin number
+ * @param [in] val Level
+ */
+void ILI9341Emu::pinChanged(uint8_t pin, uint8_t val)
+{
+	if (pin == (uint8_t)cs)
+		csLevel = val;
+	else if (pin == (uint8_t)dc)
+		dcLevel = val;
+}
+
+/**
+ * Width in the current orientation
+ * @return int
+ */
+int ILI9341Emu::width()
+{
+	return (madctl & EMU_MADCTL_MV) ? EMU_TFTHEIGHT : EMU_TFTWIDTH;
+}
+
+/**
+ * Height in the current orientation
+ * @return int
+ */
+int ILI9341Emu::height()
+{
+	return (madctl & EMU_MADCTL_MV) ? EMU_TFTWIDTH : EMU_TFTHEIGHT;
+}
+
+/**
+ * Read a pixel
+ * @param [in] x X position (current orientation)
+ * @param [in] y Y position (current orientation)
+ * @return uint16_t RGB565 color
+ */
+uint16_t ILI9341Emu::getPixel(int x, int y)
+{
+	uint16_t *p = gramAt(x, y);
+	return p ? *p : 0;
+}
+
+/**
+ * CRC-32 of the visible image
+ * @return uint32_t
+ */
+uint32_t ILI9341Emu::checksum()
+{
+	uint32_t crc = 0;
+	uint8_t px[2];
+	int x, y;
+
+	for (y = 0; y < height(); y++) {
+		for (x = 0; x < width(); x++) {
+			uint16_t c = getPixel(x, y);
+			px[0] = c >> 8;
+			px[1] = c & 0xff;
+			crc = crc32Update(crc, px, 2);
+		}
+	}
+	return crc;
+}
+
+/**
+ * Save the visible image as PNG
+ * @param [in] file File name
+ * @return bool true on success
+ */
+bool ILI9341Emu::savePNG(const char *file)
+{
+	std::vector<uint8_t> rgb;
+	int x, y;
+
+	rgb.reserve(width() * height() * 3);
+	for (y = 0; y < height(); y++) {
+		for (x = 0; x < width(); x++) {
+			uint16_t c = getPixel(x, y);
+			rgb.push_back(((c >> 11) & 0x1f) * 255 / 31);
+			rgb.push_back(((c >> 5) & 0x3f) * 255 / 63);
+			rgb.push_back((c & 0x1f) * 255 / 31);
+		}
+	}
+	return pngWrite(file, width(), height(), &rgb[0]);
+}
+
+/**
+ * Get counters
+ * @return emu_stats_t
+ */
+const emu_stats_t& ILI9341Emu::stats()
+{
+	return st;
+}
+
+/**
+ * Reset counters
+ */
+void ILI9341Emu::resetStats()
+{
+	memset(&st, 0, sizeof(st));
+}
+
+/* ======================= PRIVATE ======================= */
+
+/**
+ * Map a (column, page) address into the frame memory
+ * @param [in] col Column
+ * @param [in] page Page
+ * @return uint16_t* Pixel (NULL when out of the panel)
+ */
+uint16_t *ILI9341Emu::gramAt(uint16_t col, uint16_t page)
+{
+	uint16_t px, py;
+
+	if (madctl & EMU_MADCTL_MV) {
+		px = page;
+		py = col;
+	} else {
+		px = col;
+		py = page;
+	}
+	if (px >= EMU_TFTWIDTH || py >= EMU_TFTHEIGHT)
+		return NULL;
+	if (madctl & EMU_MADCTL_MX)
+		px = EMU_TFTWIDTH - 1 - px;
+	if (madctl & EMU_MADCTL_MY)
+		py = EMU_TFTHEIGHT - 1 - py;
+
+	return &gram[py * EMU_TFTWIDTH + px];
+}
+
+/**
+ * Advance the write/read pointer inside the window
+ */
+void ILI9341Emu::advance()
+{
+	if (cx++ >= xe) {
+		cx = xs;
+		if (cy++ >= ye)
+			cy = ys;
+	}
+}
+
+/**
+ * Handle a command byte
+ * @param [in] c Command
+ */
+void ILI9341Emu::command(uint8_t c)
+{
+	st.commands++;
+	cmd    = c;
+	nparam = 0;
+
+	switch (cmd) {
+		case EMU_RAMWR:
+			st.addrWindows++;
+			// fall through
+		case EMU_RAMRD:
+			cx = xs;
+			cy = ys;
+			break;
+	}
+}
+
+/**
+ * Handle a data byte
+ * @param [in] d Data
+ * @return uint8_t Data read from the controller (RAMRD)
+ */
+uint8_t ILI9341Emu::data(uint8_t d)
+{
+	uint16_t *p;
+	uint8_t res = 0;
+
+	switch (cmd) {
+		case EMU_CASET:
+		case EMU_PASET:
+			if (nparam < 4)
+				param[nparam] = d;
+			if (nparam == 3) {
+				if (cmd == EMU_CASET) {
+					xs = (param[0] << 8) | param[1];
+					xe = (param[2] << 8) | param[3];
+				} else {
+					ys = (param[0] << 8) | param[1];
+					ye = (param[2] << 8) | param[3];
+				}
+			}
+			break;
+
+		case EMU_MADCTL:
+			if (nparam == 0)
+				madctl = d;
+			break;
+
+		case EMU_RAMWR:
+			if ((nparam & 1) == 0) {
+				pixel = d << 8;
+			} else {
+				pixel |= d;
+				p = gramAt(cx, cy);
+				if (p)
+					*p = pixel;
+				st.pixels++;
+				advance();
+			}
+			break;
+
+		case EMU_RAMRD:
+			// First byte is a dummy read, then R, G, B (6 bits each)
+			if (nparam == 0)
+				break;
+			switch ((nparam - 1) % 3) {
+				case 0:
+					p = gramAt(cx, cy);
+					pixel = p ? *p : 0;
+					res = (pixel >> 8) & 0xf8;
+					break;
+				case 1:
+					res = (pixel >> 3) & 0xfc;
+					break;
+				case 2:
+					res = (pixel << 3) & 0xf8;
+					advance();
+					break;
+			}
+			break;
+	}
+
+	nparam++;
+	return res;
+}
@@ -0,0 +1,150 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file ILI9341Emu.h
+ * \see ILI9341Emu.cpp
+ */
+#ifndef __ILI9341EMU_H__
+#define __ILI9341EMU_H__
+
+#include <Arduino.h>
+#include <SPI.h>
+
+/** Panel width (native orientation) */
+#define EMU_TFTWIDTH  240
+/** Panel height (native orientation) */
+#define EMU_TFTHEIGHT 320
+
+/** Bus and controller counters */
+typedef struct _emu_stats {
+	/** Bytes clocked on the bus (with CS asserted) */
+	unsigned long bytes;
+	/** SPI transactions (beginTransaction() calls) */
+	unsigned long transactions;
+	/** Address windows set (CASET/PASET/RAMWR sequences) */
+	unsigned long addrWindows;
+	/** Command bytes */
+	unsigned long commands;
+	/** Pixels written into the frame memory */
+	unsigned long pixels;
+	/** Bus time at the transaction clock rate (in microseconds) */
+	double busTime;
+} emu_stats_t;
+
+/**
+ * @class ILI9341Emu
+ * Emulated ILI9341 controller attached to the host SPI bus
+ */
+class ILI9341Emu : public SPIDevice, public PinListener {
+	private:
+		/** CS pin */
+		int8_t cs;
+		/** DC pin */
+		int8_t dc;
+		/** CS level */
+		uint8_t csLevel;
+		/** DC level */
+		uint8_t dcLevel;
+		/** Transaction clock (Hz) */
+		uint32_t clock;
+		/** Frame memory (native orientation, RGB565) */
+		uint16_t gram[EMU_TFTWIDTH * EMU_TFTHEIGHT];
+		/** Memory access control */
+		uint8_t madctl;
+		/** Current command */
+		uint8_t cmd;
+		/** Parameter bytes received for the current command */
+		uint32_t nparam;
+		/** Parameter buffer */
+		uint8_t param[4];
+		/** Column window */
+		uint16_t xs, xe;
+		/** Page window */
+		uint16_t ys, ye;
+		/** Write/read pointer */
+		uint16_t cx, cy;
+		/** Pixel being assembled (RAMWR) / read back (RAMRD) */
+		uint16_t pixel;
+		/** Counters */
+		emu_stats_t st;
+		/** Transfers take (virtual) time */
+		bool timed;
+		/** Bus time not yet added to the virtual clock (us) */
+		double pendingTime;
+
+		/* Map a (column, page) address into the frame memory */
+		uint16_t *gramAt(uint16_t col, uint16_t page);
+
+		/* Advance the write/read pointer inside the window */
+		void advance();
+
+		/* Handle a command byte */
+		void command(uint8_t c);
+
+		/* Handle a data byte */
+		uint8_t data(uint8_t d);
+
+	public:
+		/* Constructor */
+		ILI9341Emu(int8_t cs, int8_t dc);
+
+		/* SPIDevice */
+		void beginTransaction(const SPISettings& settings) override;
+		uint8_t transfer(uint8_t data) override;
+
+		/* PinListener */
+		void pinChanged(uint8_t pin, uint8_t val) override;
+
+		/* Make transfers take (virtual) time */
+		void setTimed(bool timed);
+
+		/* Width in the current orientation */
+		int width();
+
+		/* Height in the current orientation */
+		int height();
+
+		/* Read a pixel (current orientation) */
+		uint16_t getPixel(int x, int y);
+
+		/* CRC-32 of the visible image (current orientation) */
+		uint32_t checksum();
+
+		/* Save the visible image as PNG */
+		bool savePNG(const char *file);
+
+		/* Get counters */
+		const emu_stats_t& stats();
+
+		/* Reset counters */
+		void resetStats();
+};
+#endif /* __ILI9341EMU_H__ */
@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file SPI.cpp
+ * SPI master for the host emulator
+ */
+#include "SPI.h"
+
+/** Default SPI bus */
+SPIClass SPI;
+
+void SPIClass::beginTransaction(SPISettings settings)
+{
+	if (dev)
+		dev->beginTransaction(settings);
+}
+
+void SPIClass::endTransaction(void)
+{
+	if (dev)
+		dev->endTransaction();
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+	return dev ? dev->transfer(data) : 0xff;
+}
+
+uint16_t SPIClass::transfer16(uint16_t data)
+{
+	uint16_t res = transfer(data >> 8) << 8;
+	return res | transfer(data & 0xff);
+}
+
+uint32_t SPIClass::transfer32(uint32_t data)
+{
+	uint32_t res = (uint32_t)transfer16(data >> 16) << 16;
+	return res | transfer16(data & 0xffff);
+}
+
+void SPIClass::transfer(void *data, uint32_t size)
+{
+	uint8_t *buf = (uint8_t *)data;
+	while (size--) {
+		*buf = transfer(*buf);
+		buf++;
+	}
+}
+
+void SPIClass::write(uint8_t data)
+{
+	transfer(data);
+}
+
+void SPIClass::write16(uint16_t data)
+{
+	transfer16(data);
+}
+
+void SPIClass::write32(uint32_t data)
+{
+	transfer32(data);
+}
+
+void SPIClass::writeBytes(const uint8_t *data, uint32_t size)
+{
+	while (size--)
+		transfer(*data++);
+}
+
+/**
+ * Write pixels (as the ESP32 core does: 16 bits words, MSB first)
+ * @param [in] data Pixels
+ * @param [in] size Size in bytes
+ */
+void SPIClass::writePixels(const void *data, uint32_t size)
+{
+	const uint16_t *px = (const uint16_t *)data;
+	for (; size >= 2; size -= 2)
+		write16(*px++);
+}
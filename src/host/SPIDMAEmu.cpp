@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file SPIDMAEmu.cpp
+ * Emulated DMA bus of the TFT module
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "SPIDMAEmu.h"
+
+/**
+ * Constructor
+ * @param [in] spi SPI bus the panel is attached to
+ */
+SPIDMAEmu::SPIDMAEmu(SPIClass *spi) : spi(spi)
+{
+	memset(&st, 0, sizeof(st));
+}
+
+bool SPIDMAEmu::begin(uint32_t maxBytes)
+{
+	return true;
+}
+
+void *SPIDMAEmu::allocBuffer(uint32_t bytes)
+{
+	return malloc(bytes);
+}
+
+void SPIDMAEmu::freeBuffer(void *buf)
+{
+	free(buf);
+}
+
+void SPIDMAEmu::startTransfer(const uint8_t *data, uint32_t len)
+{
+	transfer_t t = {data, len};
+
+	queue.push_back(t);
+	st.transfers++;
+	if (queue.size() > st.maxInFlight)
+		st.maxInFlight = queue.size();
+}
+
+void SPIDMAEmu::waitTransfer()
+{
+	if (queue.empty())
+		return;
+	spi->writeBytes(queue.front().data, queue.front().len);
+	st.bytes += queue.front().len;
+	queue.pop_front();
+}
+
+void SPIDMAEmu::release()
+{
+	st.releases++;
+}
+
+/**
+ * Get counters
+ * @return const dma_emu_stats_t& Counters
+ */
+const dma_emu_stats_t& SPIDMAEmu::stats()
+{
+	return st;
+}
@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file SPIDMAEmu.h
+ * \see SPIDMAEmu.cpp
+ */
+#ifndef __SPIDMAEMU_H__
+#define __SPIDMAEMU_H__
+
+#include <deque>
+#include <Adafruit_SPITFT_DMA.h>
+#include <SPI.h>
+
+/** DMA bus counters */
+typedef struct _dma_emu_stats {
+	/** Transfers started */
+	unsigned long transfers;
+	/** Bytes transferred */
+	unsigned long bytes;
+	/** Largest number of transfers in flight */
+	unsigned long maxInFlight;
+	/** release() calls (bus handed back to the CPU) */
+	unsigned long releases;
+} dma_emu_stats_t;
+
+/**
+ * @class SPIDMAEmu
+ * Emulated DMA bus of the TFT module
+ * Transfers are only clocked out on the SPI bus when they are waited for,
+ * as late as the queue allows, so a buffer reused too early, a command sent
+ * before the pixels or a chip deselect under a transfer shows up as a
+ * corrupted frame.
+ */
+class SPIDMAEmu : public SPITFT_DMABus {
+	private:
+		/** Transfer */
+		typedef struct _transfer {
+			/** Data */
+			const uint8_t *data;
+			/** Size */
+			uint32_t len;
+		} transfer_t;
+		/** SPI bus */
+		SPIClass *spi;
+		/** Transfers in flight, oldest first */
+		std::deque<transfer_t> queue;
+		/** Counters */
+		dma_emu_stats_t st;
+
+	public:
+		/* Constructor */
+		SPIDMAEmu(SPIClass *spi);
+
+		/* SPITFT_DMABus */
+		bool begin(uint32_t maxBytes) override;
+		void *allocBuffer(uint32_t bytes) override;
+		void freeBuffer(void *buf) override;
+		void startTransfer(const uint8_t *data, uint32_t len) override;
+		void waitTransfer() override;
+		void release() override;
+
+		/* Get counters */
+		const dma_emu_stats_t& stats();
+};
+#endif /* __SPIDMAEMU_H__ */
@@ -0,0 +1,233 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file WiFi.cpp
+ * Name resolution and TCP client of the ESP32 core on POSIX sockets
+ */
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "WiFi.h"
+
+WiFiClass WiFi;
+
+/* ======================= WiFiClass ======================= */
+
+int WiFiClass::hostByName(const char *host, IPAddress& ip)
+{
+	struct addrinfo hints, *res;
+	struct sockaddr_in *sin;
+	uint8_t *addr;
+
+	lookups++;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family   = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	if (getaddrinfo(host, NULL, &hints, &res) != 0 || !res)
+		return 0;
+	sin  = (struct sockaddr_in *)res->ai_addr;
+	addr = (uint8_t *)&sin->sin_addr.s_addr;
+	ip   = IPAddress(addr[0], addr[1], addr[2], addr[3]);
+	freeaddrinfo(res);
+	return 1;
+}
+
+/* ======================= WiFiClient ======================= */
+
+WiFiClient::WiFiClient() :
+	fd(-1), rxPos(0), rxLen(0), timeout(1000)
+{
+}
+
+WiFiClient::~WiFiClient()
+{
+	stop();
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port, int32_t timeout)
+{
+	struct sockaddr_in sin;
+	struct pollfd pfd;
+	socklen_t len;
+	uint8_t *addr;
+	int i, err = 0, one = 1;
+
+	stop();
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+		return 0;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_port   = htons(port);
+	addr = (uint8_t *)&sin.sin_addr.s_addr;
+	for (i = 0; i < 4; i++)
+		addr[i] = ip[i];
+	if (::connect(fd, (struct sockaddr *)&sin, sizeof(sin)) < 0) {
+		if (errno != EINPROGRESS) {
+			stop();
+			return 0;
+		}
+		pfd.fd     = fd;
+		pfd.events = POLLOUT;
+		len = sizeof(err);
+		if (poll(&pfd, 1, timeout) != 1 ||
+				getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err) {
+			stop();
+			return 0;
+		}
+	}
+	return 1;
+}
+
+size_t WiFiClient::write(const uint8_t *buf, size_t size)
+{
+	size_t sent = 0;
+	struct pollfd pfd;
+	ssize_t n;
+
+	while (fd >= 0 && sent < size) {
+		n = send(fd, buf + sent, size - sent, MSG_NOSIGNAL);
+		if (n > 0) {
+			sent += n;
+			continue;
+		}
+		if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+			break;
+		pfd.fd     = fd;
+		pfd.events = POLLOUT;
+		if (poll(&pfd, 1, timeout) != 1)
+			break;
+	}
+	return sent;
+}
+
+/**
+ * Receive into the buffer when it is empty
+ * @param [in] waitMs Time to wait for data (0: do not wait)
+ * @return int Bytes buffered, 0 when none, -1 when the connection is closed
+ */
+int WiFiClient::fill(int waitMs)
+{
+	struct pollfd pfd;
+	ssize_t n;
+
+	if (rxPos < rxLen)
+		return rxLen - rxPos;
+	if (fd < 0)
+		return -1;
+
+	pfd.fd     = fd;
+	pfd.events = POLLIN;
+	if (poll(&pfd, 1, waitMs) != 1)
+		return 0;
+	n = recv(fd, rx, sizeof(rx), 0);
+	if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+		return -1;
+	if (n < 0)
+		return 0;
+	rxPos = 0;
+	rxLen = n;
+	return n;
+}
+
+int WiFiClient::available()
+{
+	int n = fill(0);
+	return n > 0 ? n : 0;
+}
+
+int WiFiClient::read()
+{
+	if (fill(0) <= 0)
+		return -1;
+	return rx[rxPos++];
+}
+
+int WiFiClient::peek()
+{
+	if (fill(0) <= 0)
+		return -1;
+	return rx[rxPos];
+}
+
+size_t WiFiClient::readBytes(char *buffer, size_t length)
+{
+	unsigned long start = millis();
+	size_t count = 0, n;
+	int avail, wait;
+
+	while (count < length) {
+		wait  = (long)timeout - (long)(millis() - start);
+		avail = fill(wait > 0 ? wait : 0);
+		if (avail <= 0)
+			break;
+		n = std::min(length - count, (size_t)avail);
+		memcpy(buffer + count, rx + rxPos, n);
+		rxPos += n;
+		count += n;
+	}
+	return count;
+}
+
+uint8_t WiFiClient::connected()
+{
+	uint8_t c;
+	ssize_t n;
+
+	if (fd < 0)
+		return 0;
+	if (rxPos < rxLen)
+		return 1;
+	n = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+	if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+		stop();
+		return 0;
+	}
+	return 1;
+}
+
+void WiFiClient::stop()
+{
+	if (fd >= 0)
+		close(fd);
+	fd    = -1;
+	rxPos = 0;
+	rxLen = 0;
+}
@@ -0,0 +1,400 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file arduino.cpp
+ * Minimal Arduino core for the host emulator
+ */
+#include <stdarg.h>
+#include <ctype.h>
+#include <chrono>
+#include "Arduino.h"
+#include "Stream.h"
+
+/** Pin listener */
+static PinListener *pinListener = NULL;
+/** Pin levels */
+static uint8_t pinLevel[256];
+/** Time spent in delay() (virtual, nobody really sleeps) */
+static uint64_t delayedUs = 0;
+/** Count only the virtual time (delay() and emulated devices) */
+static bool virtualClock = false;
+/** Start time */
+static const std::chrono::steady_clock::time_point startTime =
+	std::chrono::steady_clock::now();
+
+/**
+ * Register a pin listener
+ * @param [in] listener Listener
+ */
+void setPinListener(PinListener *listener)
+{
+	pinListener = listener;
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+	pinLevel[pin] = val;
+	if (pinListener)
+		pinListener->pinChanged(pin, val);
+}
+
+int digitalRead(uint8_t pin)
+{
+	return pinLevel[pin];
+}
+
+/**
+ * Count only the virtual time
+ *
+ * When enabled, micros() and millis() return only the time spent in delay()
+ * and delayMicroseconds() (e.g. the emulated bus transfers), not the time
+ * spent running on the host.
+ *
+ * @param [in] enable Enable the virtual clock
+ */
+void setVirtualClock(bool enable)
+{
+	virtualClock = enable;
+}
+
+unsigned long micros(void)
+{
+	if (virtualClock)
+		return (unsigned long)delayedUs;
+
+	std::chrono::steady_clock::duration d =
+		std::chrono::steady_clock::now() - startTime;
+	return (unsigned long)(std::chrono::duration_cast<
+			std::chrono::microseconds>(d).count() + delayedUs);
+}
+
+unsigned long millis(void)
+{
+	return micros() / 1000;
+}
+
+void delay(uint32_t ms)
+{
+	delayedUs += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(uint32_t us)
+{
+	delayedUs += us;
+}
+
+void yield(void)
+{
+}
+
+long random(long howbig)
+{
+	return howbig > 0 ? rand() % howbig : 0;
+}
+
+long random(long howsmall, long howbig)
+{
+	return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+double ledcSetup(uint8_t channel, double freq, uint8_t resolution_bits)
+{
+	return freq;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel)
+{
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty)
+{
+}
+
+/* ======================= String ======================= */
+
+static std::string numToStr(unsigned long long value, unsigned char base)
+{
+	std::string s;
+	do {
+		int d = value % base;
+		s.insert(s.begin(), (char)(d < 10 ? '0' + d : 'a' + d - 10));
+		value /= base;
+	} while (value);
+	return s;
+}
+
+static std::string signedToStr(long long value, unsigned char base)
+{
+	if (value < 0 && base == 10)
+		return "-" + numToStr(-value, base);
+	return numToStr((unsigned long long)value, base);
+}
+
+static std::string floatToStr(double value, unsigned char decimalPlaces)
+{
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+	return buf;
+}
+
+String::String(int value, unsigned char base) : s(signedToStr(value, base)) {}
+String::String(unsigned int value, unsigned char base) : s(numToStr(value, base)) {}
+String::String(long value, unsigned char base) : s(signedToStr(value, base)) {}
+String::String(unsigned long value, unsigned char base) : s(numToStr(value, base)) {}
+String::String(float value, unsigned char decimalPlaces) :
+	s(floatToStr(value, decimalPlaces)) {}
+String::String(double value, unsigned char decimalPlaces) :
+	s(floatToStr(value, decimalPlaces)) {}
+
+int String::indexOf(char ch, unsigned int fromIndex) const
+{
+	size_t pos = s.find(ch, fromIndex);
+	return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& str, unsigned int fromIndex) const
+{
+	size_t pos = s.find(str.s, fromIndex);
+	return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char ch) const
+{
+	size_t pos = s.rfind(ch);
+	return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int beginIndex) const
+{
+	return substring(beginIndex, s.length());
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const
+{
+	if (beginIndex > endIndex)
+		std::swap(beginIndex, endIndex);
+	if (beginIndex >= s.length())
+		return String();
+	if (endIndex > s.length())
+		endIndex = s.length();
+	return String(s.substr(beginIndex, endIndex - beginIndex));
+}
+
+bool String::startsWith(const String& prefix) const
+{
+	return s.compare(0, prefix.s.length(), prefix.s) == 0;
+}
+
+bool String::endsWith(const String& suffix) const
+{
+	return s.length() >= suffix.s.length() &&
+		s.compare(s.length() - suffix.s.length(), suffix.s.length(),
+				suffix.s) == 0;
+}
+
+void String::toLowerCase()
+{
+	for (size_t i = 0; i < s.length(); i++)
+		s[i] = tolower(s[i]);
+}
+
+void String::toUpperCase()
+{
+	for (size_t i = 0; i < s.length(); i++)
+		s[i] = toupper(s[i]);
+}
+
+void String::trim()
+{
+	size_t b = s.find_first_not_of(" \t\r\n");
+	size_t e = s.find_last_not_of(" \t\r\n");
+	if (b == std::string::npos)
+		s.clear();
+	else
+		s = s.substr(b, e - b + 1);
+}
+
+long String::toInt() const
+{
+	return atol(s.c_str());
+}
+
+float String::toFloat() const
+{
+	return atof(s.c_str());
+}
+
+/* ======================= Print ======================= */
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+	size_t n = 0;
+	while (size--) {
+		if (write(*buffer++))
+			n++;
+		else
+			break;
+	}
+	return n;
+}
+
+size_t Print::write(const char *str)
+{
+	if (!str)
+		return 0;
+	return write((const uint8_t *)str, strlen(str));
+}
+
+size_t Print::print(const __FlashStringHelper *str)
+{
+	return write(reinterpret_cast<const char *>(str));
+}
+
+size_t Print::print(const String& str)
+{
+	return write(str.c_str(), str.length());
+}
+
+size_t Print::print(const char *str)
+{
+	return write(str);
+}
+
+size_t Print::print(char c)
+{
+	return write((uint8_t)c);
+}
+
+size_t Print::print(int n, int base)
+{
+	return print(String(n, base));
+}
+
+size_t Print::print(unsigned int n, int base)
+{
+	return print(String(n, base));
+}
+
+size_t Print::print(long n, int base)
+{
+	return print(String(n, base));
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+	return print(String(n, base));
+}
+
+size_t Print::print(double n, int digits)
+{
+	return print(String(n, digits));
+}
+
+size_t Print::println(void)
+{
+	return write("\r\n");
+}
+
+size_t Print::println(const String& str)
+{
+	return print(str) + println();
+}
+
+size_t Print::println(const char *str)
+{
+	return print(str) + println();
+}
+
+size_t Print::println(int n, int base)
+{
+	return print(n, base) + println();
+}
+
+size_t Print::printf(const char *format, ...)
+{
+	char buf[256];
+	va_list ap;
+	va_start(ap, format);
+	vsnprintf(buf, sizeof(buf), format, ap);
+	va_end(ap);
+	return write(buf);
+}
+
+/* ======================= Stream ======================= */
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+	size_t count = 0;
+	int c;
+	while (count < length && (c = read()) >= 0) {
+		*buffer++ = (char)c;
+		count++;
+	}
+	return count;
+}
+
+/**
+ * Advance a match of a string by one character
+ * @param [in] str String
+ * @param [in,out] len Length matched
+ * @param [in] c Character
+ * @return bool true when the whole string has been matched
+ */
+static bool matchNext(const char *str, size_t *len, char c)
+{
+	if (!str || !*str)
+		return false;
+	if (str[*len] != c)
+		*len = 0;
+	if (str[*len] == c)
+		(*len)++;
+	return str[*len] == '\0';
+}
+
+bool Stream::findUntil(const char *target, const char *terminator)
+{
+	size_t t = 0, e = 0;
+	int c;
+
+	if (!target || !*target)
+		return true;
+	while ((c = read()) >= 0) {
+		if (matchNext(target, &t, (char)c))
+			return true;
+		if (matchNext(terminator, &e, (char)c))
+			return false;
+	}
+	return false;
+}
@@ -0,0 +1,689 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file emulator.cpp
+ * Run EInterface on the host against an emulated ILI9341 panel
+ * A fixed sequence of screen updates (frames) is rendered and, for each one,
+ * the SPI traffic, the file system accesses and the time spent are reported.
+ * Frames can be saved as PNG files and compared against golden images.
+ * The frames can also be streamed to emulated viewers of the live screen,
+ * which are checked against the panel.
+ */
+#include <unistd.h>
+#include <getopt.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include <FS.h>
+#include <SPI.h>
+#include <esp_partition.h>
+#include "wstation.h"
+#include "ETheme.h"
+#include "EInterface.h"
+#include "EScreenStream.h"
+#include "ILI9341Emu.h"
+#include "SPIDMAEmu.h"
+
+/** Default file system root */
+#define DEF_FSROOT "../fsroot"
+
+/** Panel */
+static ILI9341Emu panel(TFT_CS, TFT_DC);
+/** DMA bus */
+static SPIDMAEmu dmaBus(&SPI);
+/** Send pixels through the DMA queue */
+static bool useDMA = false;
+/** Tiles of the screen copy (-2: firmware default) */
+static int shadowTiles = -2;
+/** Screen layout */
+static gui_layout_t layout = LAYOUT_PORTRAIT;
+/** Color theme */
+static ETheme colorTheme;
+/** Embedded GUI */
+static EInterface *gui = NULL;
+/** Clock */
+static int hh = 23, mm = 59, ss = 58;
+#if GUI_PROFILE
+/** Print the render profile */
+static bool profile = false;
+
+/**
+ * Print to the standard output
+ */
+class StdoutPrint : public Print {
+	public:
+		size_t write(uint8_t c) {
+			return fputc(c, stdout) == EOF ? 0 : 1;
+		}
+};
+
+/**
+ * Check the bus counters of the TFT module against the panel
+ * @param [in] frame Frame name
+ * @param [in] start Counters at the start of the frame
+ * @return int 1 when they differ, 0 otherwise
+ */
+static int checkBusStats(const char *frame, const SPITFT_Stats& start)
+{
+	const emu_stats_t& st = panel.stats();
+	SPITFT_Stats now;
+
+	gui->getProfiler()->getBus(&now);
+
+	if (now.bytes - start.bytes == st.bytes &&
+			now.addrWindows - start.addrWindows == st.addrWindows &&
+			now.pixels - start.pixels == st.pixels)
+		return 0;
+	fprintf(stderr, "Frame %s: bus counters (%lu bytes, %lu windows, "
+			"%lu pixels) differ from the panel\n", frame,
+			(unsigned long)(now.bytes - start.bytes),
+			(unsigned long)(now.addrWindows - start.addrWindows),
+			(unsigned long)(now.pixels - start.pixels));
+	return 1;
+}
+#endif
+
+/** Messages queued for a viewer (WS_MAX_QUEUED_MESSAGES of the firmware) */
+#define VIEWER_QUEUE 4
+/** Most updates a slow viewer needs to catch up after the last frame */
+#define VIEWER_DRAIN 1000
+
+/** Emulated viewer of the live screen */
+typedef struct _viewer {
+	/** Name */
+	const char *name;
+	/** Messages taken per frame (0: all, as soon as they are queued) */
+	size_t rate;
+	/** Client ID */
+	uint32_t id;
+	/** Messages sent, not taken yet */
+	std::deque<std::vector<uint8_t> > queue;
+	/** Screen as drawn by the viewer */
+	std::vector<uint16_t> mirror;
+	/** Screen width */
+	int width;
+	/** Screen height */
+	int height;
+	/** Messages taken */
+	unsigned long messages;
+	/** Bytes taken */
+	unsigned long bytes;
+	/** Malformed messages */
+	unsigned long errors;
+} viewer_t;
+
+/** Live screen stream (-w) */
+static EScreenStream *stream = NULL;
+/** Viewers: one that keeps up, one that takes a message per frame */
+static viewer_t viewers[] = {
+	{"fast", 0, 1},
+	{"slow", 1, 2},
+};
+
+/** Frame */
+typedef struct _frame {
+	/** Frame name */
+	const char *name;
+	/** Draw function */
+	void (*draw)(void);
+} frame_t;
+
+static void frameBoot(void)
+{
+	gui->setLayout(layout);
+	gui->initialize(useDMA ? &dmaBus : NULL);
+	if (shadowTiles != -2)
+		gui->setShadow(shadowTiles);
+	gui->showLogo();
+	gui->showVersion(50, 200);
+}
+
+static void frameMain(void)
+{
+	int i;
+	static const char *days[] = {"Thu", "Fri", "Sat"};
+
+	gui->clearAll();
+	gui->setCity("Berlin");
+	gui->setDate("Wed, Jun 30, 2021");
+	gui->setIP("192.168.100.120");
+	gui->showWeather(CLOUDS_SCATTERED, 0);
+	gui->showTemp1(23.4);
+	gui->showHumidity1(47);
+	gui->showChannel(1);
+	gui->showTemp2(-3.5);
+	gui->showHumidity2(82);
+	gui->showWiFi(true);
+	gui->setHours(hh);
+	gui->setMinutes(mm);
+	gui->setSeconds(ss);
+	for (i = 0; i < 3; i++) {
+		gui->showForecastLabel(i, days[i]);
+		gui->showForecastTemp1(i, 12.5 + i);
+		gui->showForecastTemp2(i, 18.0 + i);
+		gui->showForecastWeather(i, (weather_t)(CLEAR_SKY + i));
+	}
+	gui->showAll();
+}
+
+static void frameSecond(void)
+{
+	gui->setSeconds(++ss);
+}
+
+static void frameMinute(void)
+{
+	ss = 0;
+	gui->setMinutes(++mm);
+	gui->setSeconds(ss);
+}
+
+static void frameHour(void)
+{
+	hh = 0;
+	mm = 0;
+	ss = 1;
+	gui->setHours(hh);
+	gui->setMinutes(mm);
+	gui->setSeconds(ss);
+}
+
+static void frameOutdoor(void)
+{
+	gui->showChannel(2);
+	gui->showTemp2(8.1);
+	gui->showHumidity2(64);
+}
+
+static void frameResend(void)
+{
+	gui->showChannel(2);
+	gui->showTemp2(8.1);
+	gui->showHumidity2(64);
+	gui->setTempScale(CELSIUS);
+}
+
+static void frameRadio(void)
+{
+	gui->showRadio(true);
+	gui->update();
+	gui->showRadio(false);
+}
+
+static void frameWiFiBlink(void)
+{
+	gui->showWiFi(false);
+	gui->update();
+	gui->showWiFi(true);
+}
+
+static void frameForecast(void)
+{
+	int i;
+	static const char *days[] = {"Fri", "Sat", "Sun"};
+
+	gui->showWeather(RAIN_LIGHT, 0);
+	for (i = 0; i < 3; i++) {
+		gui->showForecastLabel(i, days[i]);
+		gui->showForecastTemp1(i, 10.0 - i);
+		gui->showForecastTemp2(i, 15.5 - i);
+		gui->showForecastWeather(i, (weather_t)(RAIN_LIGHT + i));
+	}
+}
+
+static void frameAll(void)
+{
+	gui->showAll();
+}
+
+/** Frames, in rendering order */
+static const frame_t frames[] = {
+	{"boot",     frameBoot},
+	{"main",     frameMain},
+	{"second",   frameSecond},
+	{"minute",   frameMinute},
+	{"hour",     frameHour},
+	{"outdoor",  frameOutdoor},
+	{"resend",   frameResend},
+	{"radio",    frameRadio},
+	{"wifi",     frameWiFiBlink},
+	{"radio2",   frameRadio},
+	{"forecast", frameForecast},
+	{"showall",  frameAll},
+};
+
+/**
+ * Compare two files
+ * @param [in] a File A
+ * @param [in] b File B
+ * @return bool true if both files have the same content
+ */
+static bool sameFile(const std::string& a, const std::string& b)
+{
+	FILE *fa = fopen(a.c_str(), "rb");
+	FILE *fb = fopen(b.c_str(), "rb");
+	bool res = (fa && fb);
+	int ca, cb;
+
+	while (res) {
+		ca = fgetc(fa);
+		cb = fgetc(fb);
+		if (ca != cb)
+			res = false;
+		else if (ca == EOF)
+			break;
+	}
+	if (fa)
+		fclose(fa);
+	if (fb)
+		fclose(fb);
+	return res;
+}
+
+/**
+ * Compare the copy of the screen kept by the driver with the panel
+ * @return unsigned long Number of known pixels that differ
+ */
+static unsigned long checkShadow(void)
+{
+	SPITFT_Shadow *shadow = gui->getShadow();
+	unsigned long diffs = 0;
+	uint16_t color;
+	int x, y;
+
+	if (!shadow)
+		return 0;
+	for (y = 0; y < panel.height(); y++) {
+		for (x = 0; x < panel.width(); x++) {
+			if (shadow->getPixel(x, y, &color) &&
+					color != panel.getPixel(x, y))
+				diffs++;
+		}
+	}
+	return diffs;
+}
+
+/**
+ * Screen reader of the stream
+ */
+static bool readStream(int16_t x, int16_t y, int16_t w, int16_t h,
+		uint16_t *buf, void *arg)
+{
+	return gui->readScreen(x, y, w, h, buf);
+}
+
+/**
+ * Read a 16 bits little endian number
+ * @param [in] p Buffer
+ * @return uint16_t
+ */
+static uint16_t get16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+/**
+ * Draw a message of the stream, as the viewer page does
+ * @param [in] v Viewer
+ * @param [in] msg Message
+ * @return bool false if the message is malformed
+ */
+static bool applyMessage(viewer_t *v, const std::vector<uint8_t>& msg)
+{
+	const uint8_t *p = &msg[0], *end = p + msg.size();
+	int count, x, y, w, h, i, n;
+	uint16_t color;
+	uint8_t enc;
+
+	v->messages++;
+	v->bytes += msg.size();
+	if (msg.size() == 5 && p[0] == SCREEN_MSG_SIZE) {
+		v->width  = get16(p + 1);
+		v->height = get16(p + 3);
+		v->mirror.assign(v->width * v->height, 0);
+		return true;
+	}
+	if (msg.size() < 2 || p[0] != SCREEN_MSG_RECTS)
+		return false;
+
+	count = p[1];
+	for (p += 2; count--; ) {
+		if (end - p < SCREEN_RECT_HEADER)
+			return false;
+		enc = p[0];
+		x = get16(p + 1);
+		y = get16(p + 3);
+		w = get16(p + 5);
+		h = get16(p + 7);
+		p += SCREEN_RECT_HEADER;
+		if (x + w > v->width || y + h > v->height)
+			return false;
+		for (i = 0; i < w * h; ) {
+			if (enc == SCREEN_RECT_RAW) {
+				if (end - p < 2)
+					return false;
+				n = 1;
+				color = get16(p);
+				p += 2;
+			} else {
+				if (end - p < 3)
+					return false;
+				n = p[0] + 1;
+				color = get16(p + 1);
+				p += 3;
+			}
+			for (; n-- && i < w * h; i++)
+				v->mirror[(y + i / w) * v->width + x + i % w] = color;
+		}
+	}
+	return p == end;
+}
+
+/**
+ * Send the areas drawn to the viewers, as the /ws/screen web service does,
+ * and let them take their messages
+ */
+static void streamFrame(void)
+{
+	static uint8_t msg[SCREEN_STREAM_MSG_SIZE];
+	size_t i, n, len;
+	viewer_t *v;
+
+	stream->setSize(gui->getWidth(), gui->getHeight());
+	stream->update();
+	for (i = 0; i < sizeof(viewers) / sizeof(viewers[0]); i++) {
+		v = &viewers[i];
+		while (stream->isPending(v->id)) {
+			if (v->queue.size() >= VIEWER_QUEUE) {
+				stream->setBusy(v->id);
+				break;
+			}
+			len = stream->nextMessage(v->id, msg, sizeof(msg));
+			if (!len)
+				break;
+			v->queue.push_back(std::vector<uint8_t>(msg, msg + len));
+			if (!v->rate && !applyMessage(v, v->queue.front()))
+				v->errors++;
+			if (!v->rate)
+				v->queue.pop_front();
+		}
+		for (n = 0; n < v->rate && !v->queue.empty(); n++) {
+			if (!applyMessage(v, v->queue.front()))
+				v->errors++;
+			v->queue.pop_front();
+		}
+	}
+}
+
+/**
+ * Compare the screen of a viewer with the panel
+ * @param [in] v Viewer
+ * @return long Pixels that differ, -1 if the viewer has not caught up
+ */
+static long checkViewer(const viewer_t *v)
+{
+	long diffs = 0;
+	int x, y;
+
+	if (stream->isPending(v->id) || !v->queue.empty())
+		return -1;
+	if (v->width != panel.width() || v->height != panel.height())
+		return panel.width() * panel.height();
+	for (y = 0; y < panel.height(); y++) {
+		for (x = 0; x < panel.width(); x++) {
+			if (v->mirror[y * v->width + x] != panel.getPixel(x, y))
+				diffs++;
+		}
+	}
+	return diffs;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Use: %s [-f fsroot] [-b icon_bundle] [-d] [-l] "
+			"[-s tiles] [-w] [-p] [-o output_dir] [-g golden_dir]\n", prog);
+	fprintf(stderr, "  -f  File system root (default: " DEF_FSROOT ")\n");
+	fprintf(stderr, "  -b  Icon bundle partition image\n");
+	fprintf(stderr, "  -d  Send pixels through the (emulated) DMA queue\n");
+	fprintf(stderr, "  -l  Landscape layout\n");
+	fprintf(stderr, "  -s  Tiles of the screen copy (-1: all, 0: none)\n");
+	fprintf(stderr, "  -w  Stream the screen to emulated viewers\n");
+	fprintf(stderr, "  -p  Print the render profile (profiled build)\n");
+	fprintf(stderr, "  -o  Save each frame as <output_dir>/<frame>.png\n");
+	fprintf(stderr, "  -g  Compare each frame with <golden_dir>/<frame>.png\n");
+}
+
+int main(int argc, char **argv)
+{
+	std::string fsroot(DEF_FSROOT), outdir, golden, bundle;
+	unsigned long t0, t1, reads, rbytes, diffs;
+	size_t i, j;
+	long vdiffs;
+	int opt, fails = 0;
+
+	while ((opt = getopt(argc, argv, "f:b:dls:wpo:g:h")) != -1) {
+		switch (opt) {
+			case 'f':
+				fsroot = optarg;
+				break;
+			case 'b':
+				bundle = optarg;
+				break;
+			case 'd':
+				useDMA = true;
+				break;
+			case 'l':
+				layout = LAYOUT_LANDSCAPE;
+				break;
+			case 's':
+				shadowTiles = atoi(optarg);
+				break;
+			case 'w':
+				stream = new EScreenStream(EMU_TFTWIDTH, EMU_TFTHEIGHT,
+						readStream, NULL);
+				break;
+			case 'p':
+#if GUI_PROFILE
+				profile = true;
+				break;
+#else
+				fprintf(stderr, "Built without the render profiler\n");
+				return 1;
+#endif
+			case 'o':
+				outdir = optarg;
+				break;
+			case 'g':
+				golden = optarg;
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (!golden.empty() && outdir.empty())
+		outdir = ".";
+
+	if (!bundle.empty() && !esp_partition_load(ICON_BUNDLE_LABEL,
+				ICON_BUNDLE_SUBTYPE, bundle.c_str())) {
+		fprintf(stderr, "Cannot load %s\n", bundle.c_str());
+		return 1;
+	}
+
+	FS fsys(fsroot.c_str());
+	SPI.attach(&panel);
+	setPinListener(&panel);
+	gui = new EInterface(TFT_CS, TFT_DC, TFT_BACKLIGHT, BACKLIGHT_DEFAULT,
+			colorTheme, &fsys);
+	if (stream) {
+		// Viewers connected before the boot screen
+		gui->setDamage(stream->getDamage());
+		for (j = 0; j < sizeof(viewers) / sizeof(viewers[0]); j++)
+			stream->addClient(viewers[j].id);
+	}
+
+	printf("%-10s %9s %8s %7s %8s %8s %6s %8s %10s %8s\n",
+			"frame", "spi_bytes", "windows", "trans", "pixels", "bus_us",
+			"reads", "rd_bytes", "cpu_us", "crc32");
+
+	for (i = 0; i < sizeof(frames) / sizeof(frames[0]); i++) {
+		panel.resetStats();
+		fsys.resetStats();
+#if GUI_PROFILE
+		SPITFT_Stats bus;
+		gui->getProfiler()->getBus(&bus);
+#endif
+
+		t0 = micros();
+		frames[i].draw();
+		gui->update();
+		t1 = micros();
+		gui->flush();
+
+		const emu_stats_t& st = panel.stats();
+		reads  = fsys.stats().reads;
+		rbytes = fsys.stats().readBytes;
+		printf("%-10s %9lu %8lu %7lu %8lu %8.0f %6lu %8lu %10lu %08x\n",
+				frames[i].name, st.bytes, st.addrWindows, st.transactions,
+				st.pixels, st.busTime, reads, rbytes, t1 - t0,
+				panel.checksum());
+
+#if GUI_PROFILE
+		if (profile)
+			fails += checkBusStats(frames[i].name, bus);
+#endif
+
+		if (stream) {
+			streamFrame();
+			// A viewer that has caught up must show the panel
+			for (j = 0; j < sizeof(viewers) / sizeof(viewers[0]); j++) {
+				vdiffs = checkViewer(&viewers[j]);
+				if (vdiffs > 0) {
+					fprintf(stderr, "Frame %s: %ld pixels of the %s viewer "
+							"differ\n", frames[i].name, vdiffs,
+							viewers[j].name);
+					fails++;
+				} else if (vdiffs < 0 && !viewers[j].rate) {
+					fprintf(stderr, "Frame %s: the %s viewer is behind\n",
+							frames[i].name, viewers[j].name);
+					fails++;
+				}
+			}
+		}
+
+		diffs = checkShadow();
+		if (diffs) {
+			fprintf(stderr, "Frame %s: %lu pixels of the screen copy differ\n",
+					frames[i].name, diffs);
+			fails++;
+		}
+
+		if (!outdir.empty()) {
+			std::string png = outdir + "/" + frames[i].name + ".png";
+			if (!panel.savePNG(png.c_str())) {
+				fprintf(stderr, "Cannot write %s\n", png.c_str());
+				fails++;
+			} else if (!golden.empty()) {
+				std::string ref = golden + "/" + frames[i].name + ".png";
+				if (!sameFile(png, ref)) {
+					fprintf(stderr, "Frame %s differs from %s\n",
+							frames[i].name, ref.c_str());
+					fails++;
+				}
+			}
+		}
+	}
+
+	if (useDMA) {
+		printf("dma: %lu transfers, %lu bytes, %lu max in flight, "
+				"%lu releases\n", dmaBus.stats().transfers,
+				dmaBus.stats().bytes, dmaBus.stats().maxInFlight,
+				dmaBus.stats().releases);
+	}
+	printf("widgets: %u redraws, %u skipped\n", gui->getRedraws(),
+			gui->getSkippedRedraws());
+	if (gui->getShadow()) {
+		SPITFT_Shadow *shadow = gui->getShadow();
+		const SPITFT_ShadowStats& sst = shadow->stats();
+		printf("shadow: %u/%u tiles, %lu%% known, %lu fills and %lu bitmaps "
+				"skipped, %lu cropped, %lu pixels skipped, %lu evictions\n",
+				shadow->slots(), SPITFT_Shadow::tileCount(shadow->width(),
+				shadow->height()), (unsigned long)shadow->knownPixels() * 100 /
+				(shadow->width() * shadow->height()),
+				(unsigned long)sst.fillsSkipped,
+				(unsigned long)sst.bitmapsSkipped,
+				(unsigned long)sst.bitmapsCropped,
+				(unsigned long)sst.pixelsSkipped,
+				(unsigned long)sst.evictions);
+	}
+	if (stream) {
+		for (j = 0; j < sizeof(viewers) / sizeof(viewers[0]); j++) {
+			viewer_t *v = &viewers[j];
+			for (i = 0; i < VIEWER_DRAIN && checkViewer(v) < 0; i++)
+				streamFrame();
+			vdiffs = checkViewer(v);
+			printf("stream: %s viewer: %lu messages, %lu bytes, %lu "
+					"malformed, %lu updates to catch up, %ld pixels differ\n",
+					v->name, v->messages, v->bytes, v->errors,
+					(unsigned long)i, vdiffs);
+			if (vdiffs || v->errors)
+				fails++;
+		}
+		const EScreenStream::stream_stats_t& sst = stream->getStats();
+		printf("stream: %lu raw and %lu run areas, %lu pixels, %lu "
+				"deferred, %lu merges, %lu errors, %u bytes used\n",
+				(unsigned long)sst.rawRects, (unsigned long)sst.rleRects,
+				(unsigned long)sst.pixels, (unsigned long)sst.deferred,
+				(unsigned long)sst.merges, (unsigned long)sst.errors,
+				(unsigned int)stream->getMemoryUsage());
+		if (sst.errors)
+			fails++;
+	}
+#if GUI_PROFILE
+	if (profile) {
+		StdoutPrint out;
+		printf("profile: ");
+		gui->getProfiler()->printJSON(out);
+		printf("\n");
+	}
+#endif
+	printf("icon bundle: %s\n", gui->getIconBundle()->isAvailable() ?
+			"mapped" : "not available");
+	printf("pixmap cache: %u hits, %u misses, %u/%u bytes\n",
+			gui->getPixmapCache()->getHits(),
+			gui->getPixmapCache()->getMisses(),
+			gui->getPixmapCache()->getUsage(),
+			gui->getPixmapCache()->getBudget());
+
+	delete gui;
+	delete stream;
+	return fails ? 1 : 0;
+}
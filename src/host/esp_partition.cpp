@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file esp_partition.cpp
+ * Flash partitions for the host emulator
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "esp_partition.h"
+
+/** Partition loaded from a file */
+typedef struct _host_partition {
+	/** Partition description */
+	esp_partition_t part;
+	/** Content */
+	uint8_t *data;
+} host_partition_t;
+
+/** Loaded partitions */
+static std::vector<host_partition_t> partitions;
+
+/**
+ * Load a data partition from a file
+ * @param [in] label Partition label
+ * @param [in] subtype Partition subtype
+ * @param [in] file File
+ * @return bool true on success
+ */
+bool esp_partition_load(const char *label, int subtype, const char *file)
+{
+	host_partition_t hp;
+	FILE *fp;
+	long size;
+
+	if (!(fp = fopen(file, "rb")))
+		return false;
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	memset(&hp, 0, sizeof(hp));
+	hp.part.type    = ESP_PARTITION_TYPE_DATA;
+	hp.part.subtype = (esp_partition_subtype_t)subtype;
+	hp.part.size    = size;
+	strncpy(hp.part.label, label, sizeof(hp.part.label) - 1);
+	hp.data = (uint8_t*)malloc(size > 0 ? size : 1);
+	if (!hp.data || fread(hp.data, 1, size, fp) != (size_t)size) {
+		free(hp.data);
+		fclose(fp);
+		return false;
+	}
+	fclose(fp);
+	partitions.push_back(hp);
+	return true;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+		esp_partition_subtype_t subtype, const char *label)
+{
+	size_t i;
+
+	for (i = 0; i < partitions.size(); i++) {
+		const esp_partition_t *p = &partitions[i].part;
+		if (p->type != type)
+			continue;
+		if (subtype != ESP_PARTITION_SUBTYPE_ANY && p->subtype != subtype)
+			continue;
+		if (label && strcmp(p->label, label))
+			continue;
+		return p;
+	}
+	return NULL;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t *partition, size_t offset,
+		size_t size, spi_flash_mmap_memory_t memory, const void **out_ptr,
+		spi_flash_mmap_handle_t *out_handle)
+{
+	size_t i;
+
+	for (i = 0; i < partitions.size(); i++) {
+		if (&partitions[i].part != partition)
+			continue;
+		if (offset + size > partition->size)
+			return ESP_ERR_INVALID_ARG;
+		*out_ptr    = partitions[i].data + offset;
+		*out_handle = i + 1;
+		return ESP_OK;
+	}
+	return ESP_ERR_INVALID_ARG;
+}
+
+void spi_flash_munmap(spi_flash_mmap_handle_t handle)
+{
+	// Loaded partitions stay in memory
+}
@@ -0,0 +1,455 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file gfx_bench.cpp
+ * Microbenchmarks of the Adafruit_GFX/Adafruit_SPITFT primitives used by
+ * EInterface, drawn on a bus sink that only counts what it receives (no
+ * panel emulation), so the time measured is the time of the drawing code.
+ *
+ * For each primitive it reports the time per call and the bytes, address
+ * windows and transactions sent per call. Results can be saved as JSON and
+ * compared with a previous run.
+ */
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <string>
+#include <vector>
+#include <SPI.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_ILI9341.h>
+#include <Fonts/FreeSansBold12pt7b.h>
+#include <Fonts/FreeSansBold18pt7b.h>
+#include <Fonts/FreeSans9pt7b.h>
+#include <Fonts/FreeMono9pt7b.h>
+#include "wstation.h"
+
+/** Default number of runs of each benchmark (the fastest one is kept) */
+#define DEF_REPEATS 5
+/** Longest benchmark name */
+#define NAME_MAX_LEN 48
+
+/**
+ * SPI slave that counts the traffic and drops it
+ */
+class BusSink : public SPIDevice, public PinListener {
+	private:
+		/** CS level */
+		uint8_t csLevel;
+		/** DC level */
+		uint8_t dcLevel;
+
+	public:
+		/** Bytes received */
+		unsigned long bytes;
+		/** Address windows (RAMWR commands) */
+		unsigned long windows;
+		/** Transactions */
+		unsigned long transactions;
+
+		BusSink() : csLevel(HIGH), dcLevel(HIGH) {
+			reset();
+		}
+
+		void reset() {
+			bytes = windows = transactions = 0;
+		}
+
+		void beginTransaction(const SPISettings& settings) {
+			transactions++;
+		}
+
+		uint8_t transfer(uint8_t d) {
+			if (csLevel != LOW)
+				return 0xff;
+			bytes++;
+			if (dcLevel == LOW && d == ILI9341_RAMWR)
+				windows++;
+			return 0;
+		}
+
+		void pinChanged(uint8_t pin, uint8_t val) {
+			if (pin == TFT_CS)
+				csLevel = val;
+			else if (pin == TFT_DC)
+				dcLevel = val;
+		}
+};
+
+/** Benchmark */
+typedef struct _bench {
+	/** Name */
+	const char *name;
+	/** Run the i-th call of the primitive */
+	void (*run)(Adafruit_ILI9341 *tft, const void *arg, unsigned long i);
+	/** Argument of run() */
+	const void *arg;
+	/** Calls per run */
+	unsigned long ops;
+} bench_t;
+
+/** Result of a benchmark */
+typedef struct _result {
+	/** Name */
+	std::string name;
+	/** Calls per run */
+	unsigned long ops;
+	/** Time per call (ns, fastest run) */
+	double ns;
+	/** Bus bytes per call */
+	double bytes;
+	/** Address windows per call */
+	double windows;
+	/** Transactions per call */
+	double transactions;
+} result_t;
+
+/** Bus sink */
+static BusSink sink;
+
+/** Characters drawn by drawChar() (clock, temperatures, labels) */
+static const char chars[] = "0123456789:.-% apmCF";
+
+/** Strings measured by getTextBounds() */
+static const char *boundsStrings[] = {"12:34", "-12.5 C", "100%",
+	"192.168.100.200", "Tomorrow"};
+
+/** Radius of the degree symbol (large and small temperatures) */
+static const int16_t radius[] = {5, 3};
+
+/** Bitmap drawn by drawRGBBitmap() (icon size) */
+#define BITMAP_W 32
+#define BITMAP_H 32
+static uint16_t bitmap[BITMAP_W * BITMAP_H];
+
+/**
+ * Position of the i-th call on the screen
+ * @param [in] i Call
+ * @param [in] w Width of the area drawn
+ * @param [in] h Height of the area drawn
+ * @param [out] x X position
+ * @param [out] y Y position
+ */
+static void position(unsigned long i, int16_t w, int16_t h, int16_t *x,
+		int16_t *y)
+{
+	*x = (i * 37) % (ILI9341_TFTWIDTH - w);
+	*y = (i * 53) % (ILI9341_TFTHEIGHT - h);
+}
+
+static void runDrawChar(Adafruit_ILI9341 *tft, const void *arg,
+		unsigned long i)
+{
+	const GFXfont *font = (const GFXfont *)arg;
+	int16_t x, y;
+
+	position(i, font->yAdvance, font->yAdvance, &x, &y);
+	tft->setFont(font);
+	tft->drawChar(x, y + font->yAdvance, chars[i % (sizeof(chars) - 1)],
+			ILI9341_WHITE, ILI9341_WHITE, 1);
+}
+
+static void runTextBounds(Adafruit_ILI9341 *tft, const void *arg,
+		unsigned long i)
+{
+	int16_t x1, y1;
+	uint16_t w, h;
+
+	tft->setFont((const GFXfont *)arg);
+	tft->getTextBounds(boundsStrings[i % (sizeof(boundsStrings) /
+			sizeof(boundsStrings[0]))], 10, 100, &x1, &y1, &w, &h);
+}
+
+static void runFillRect(Adafruit_ILI9341 *tft, const void *arg,
+		unsigned long i)
+{
+	int16_t x, y;
+
+	position(i, 40, 30, &x, &y);
+	tft->fillRect(x, y, 40, 30, i);
+}
+
+static void runDrawRGBBitmap(Adafruit_ILI9341 *tft, const void *arg,
+		unsigned long i)
+{
+	int16_t x, y;
+
+	position(i, BITMAP_W, BITMAP_H, &x, &y);
+	tft->drawRGBBitmap(x, y, bitmap, BITMAP_W, BITMAP_H);
+}
+
+static void runDrawCircle(Adafruit_ILI9341 *tft, const void *arg,
+		unsigned long i)
+{
+	int16_t r = *(const int16_t *)arg, x, y;
+
+	position(i, 2 * r + 1, 2 * r + 1, &x, &y);
+	tft->drawCircle(x + r, y + r, r, ILI9341_WHITE);
+}
+
+static void runWriteColor(Adafruit_ILI9341 *tft, const void *arg,
+		unsigned long i)
+{
+	tft->startWrite();
+	tft->setAddrWindow(0, (i * 10) % ILI9341_TFTHEIGHT, ILI9341_TFTWIDTH, 10);
+	tft->writeColor(i, ILI9341_TFTWIDTH * 10);
+	tft->endWrite();
+}
+
+static const bench_t benches[] = {
+	{"drawChar/FreeSans9pt7b",           runDrawChar,      &FreeSans9pt7b,      4000},
+	{"drawChar/FreeSansBold12pt7b",      runDrawChar,      &FreeSansBold12pt7b, 4000},
+	{"drawChar/FreeSansBold18pt7b",      runDrawChar,      &FreeSansBold18pt7b, 2000},
+	{"drawChar/FreeMono9pt7b",           runDrawChar,      &FreeMono9pt7b,      4000},
+	{"getTextBounds/FreeSans9pt7b",      runTextBounds,    &FreeSans9pt7b,      100000},
+	{"getTextBounds/FreeSansBold12pt7b", runTextBounds,    &FreeSansBold12pt7b, 100000},
+	{"getTextBounds/FreeSansBold18pt7b", runTextBounds,    &FreeSansBold18pt7b, 100000},
+	{"getTextBounds/FreeMono9pt7b",      runTextBounds,    &FreeMono9pt7b,      100000},
+	{"fillRect/40x30",                   runFillRect,      NULL,                2000},
+	{"drawRGBBitmap/32x32",              runDrawRGBBitmap, NULL,                2000},
+	{"drawCircle/r5",                    runDrawCircle,    &radius[0],          20000},
+	{"drawCircle/r3",                    runDrawCircle,    &radius[1],          20000},
+	{"writeColor/2400",                  runWriteColor,    NULL,                500},
+};
+
+/**
+ * Run a benchmark
+ * @param [in] tft TFT module
+ * @param [in] b Benchmark
+ * @param [in] scale Multiplier of the calls per run
+ * @param [in] repeats Number of runs
+ * @return result_t
+ */
+static result_t runBench(Adafruit_ILI9341 *tft, const bench_t *b,
+		double scale, int repeats)
+{
+	unsigned long i, t0, t, best = 0;
+	result_t res;
+	int r;
+
+	res.name = b->name;
+	res.ops  = b->ops * scale;
+	if (res.ops < 1)
+		res.ops = 1;
+
+	for (r = 0; r < repeats; r++) {
+		sink.reset();
+		t0 = micros();
+		for (i = 0; i < res.ops; i++)
+			b->run(tft, b->arg, i);
+		t = micros() - t0;
+		if (r == 0 || t < best)
+			best = t;
+	}
+
+	/* The calls of a run are the same every time */
+	res.ns           = 1000.0 * best / res.ops;
+	res.bytes        = (double)sink.bytes / res.ops;
+	res.windows      = (double)sink.windows / res.ops;
+	res.transactions = (double)sink.transactions / res.ops;
+	return res;
+}
+
+/**
+ * Save the results as JSON (one result per line)
+ * @param [in] file File name
+ * @param [in] results Results
+ * @param [in] repeats Number of runs
+ * @return bool true on success
+ */
+static bool saveJSON(const char *file, const std::vector<result_t>& results,
+		int repeats)
+{
+	FILE *fp = fopen(file, "w");
+	size_t i;
+
+	if (!fp)
+		return false;
+	fprintf(fp, "{\"bench\":\"gfx_bench\",\"spi_hz\":%d,\"repeats\":%d,"
+			"\"results\":[\n", TFT_SPI_FREQ, repeats);
+	for (i = 0; i < results.size(); i++) {
+		const result_t& r = results[i];
+		fprintf(fp, "{\"name\":\"%s\",\"ops\":%lu,\"ns_per_op\":%.1f,"
+				"\"bytes_per_op\":%.2f,\"windows_per_op\":%.3f,"
+				"\"transactions_per_op\":%.3f}%s\n", r.name.c_str(), r.ops,
+				r.ns, r.bytes, r.windows, r.transactions,
+				i + 1 < results.size() ? "," : "");
+	}
+	fprintf(fp, "]}\n");
+	return fclose(fp) == 0;
+}
+
+/**
+ * Load the results saved by saveJSON()
+ * @param [in] file File name
+ * @param [out] results Results
+ * @return bool true on success
+ */
+static bool loadJSON(const char *file, std::vector<result_t>& results)
+{
+	FILE *fp = fopen(file, "r");
+	char line[256], name[NAME_MAX_LEN + 1];
+	result_t r;
+
+	if (!fp)
+		return false;
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "{\"name\":\"%48[^\"]\",\"ops\":%lu,"
+					"\"ns_per_op\":%lf,\"bytes_per_op\":%lf,"
+					"\"windows_per_op\":%lf,\"transactions_per_op\":%lf",
+					name, &r.ops, &r.ns, &r.bytes, &r.windows,
+					&r.transactions) != 6)
+			continue;
+		r.name = name;
+		results.push_back(r);
+	}
+	fclose(fp);
+	return true;
+}
+
+/**
+ * Find a result by name
+ * @param [in] results Results
+ * @param [in] name Name
+ * @return const result_t* Result or NULL
+ */
+static const result_t *findResult(const std::vector<result_t>& results,
+		const std::string& name)
+{
+	size_t i;
+
+	for (i = 0; i < results.size(); i++) {
+		if (results[i].name == name)
+			return &results[i];
+	}
+	return NULL;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Use: %s [-n scale] [-r repeats] [-b filter] "
+			"[-j output.json] [-c baseline.json]\n", prog);
+	fprintf(stderr, "  -n  Multiplier of the calls per run (default: 1)\n");
+	fprintf(stderr, "  -r  Runs of each benchmark, the fastest is kept "
+			"(default: %d)\n", DEF_REPEATS);
+	fprintf(stderr, "  -b  Run only the benchmarks whose name contains "
+			"filter\n");
+	fprintf(stderr, "  -j  Save the results as JSON\n");
+	fprintf(stderr, "  -c  Compare with the results of a previous run\n");
+}
+
+int main(int argc, char **argv)
+{
+	Adafruit_ILI9341 tft(TFT_CS, TFT_DC);
+	std::vector<result_t> results, baseline;
+	std::string filter, output, compare;
+	double scale = 1;
+	int opt, repeats = DEF_REPEATS, changed = 0;
+	size_t i;
+
+	while ((opt = getopt(argc, argv, "n:r:b:j:c:h")) != -1) {
+		switch (opt) {
+			case 'n':
+				scale = atof(optarg);
+				break;
+			case 'r':
+				repeats = atoi(optarg);
+				break;
+			case 'b':
+				filter = optarg;
+				break;
+			case 'j':
+				output = optarg;
+				break;
+			case 'c':
+				compare = optarg;
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (scale <= 0 || repeats < 1) {
+		usage(argv[0]);
+		return 1;
+	}
+	if (!compare.empty() && !loadJSON(compare.c_str(), baseline)) {
+		fprintf(stderr, "Cannot read %s\n", compare.c_str());
+		return 1;
+	}
+
+	srand(1);
+	for (i = 0; i < BITMAP_W * BITMAP_H; i++)
+		bitmap[i] = rand();
+
+	SPI.attach(&sink);
+	setPinListener(&sink);
+	tft.begin(TFT_SPI_FREQ);
+
+	printf("%-34s %7s %10s %9s %8s %7s", "benchmark", "ops", "ns_op",
+			"bytes_op", "wins_op", "tr_op");
+	if (!baseline.empty())
+		printf(" %10s %8s", "base_ns", "change");
+	printf("\n");
+
+	for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+		if (!filter.empty() && !strstr(benches[i].name, filter.c_str()))
+			continue;
+		result_t r = runBench(&tft, &benches[i], scale, repeats);
+		results.push_back(r);
+
+		printf("%-34s %7lu %10.1f %9.1f %8.2f %7.2f", r.name.c_str(), r.ops,
+				r.ns, r.bytes, r.windows, r.transactions);
+		const result_t *base = findResult(baseline, r.name);
+		if (base) {
+			printf(" %10.1f %+7.1f%%", base->ns,
+					base->ns > 0 ? 100.0 * (r.ns - base->ns) / base->ns : 0.0);
+			// Traffic is deterministic: any change is a change of the code
+			if (fabs(base->bytes - r.bytes) > 0.01 ||
+					fabs(base->windows - r.windows) > 0.001) {
+				printf("  traffic was %.1f bytes, %.2f windows", base->bytes,
+						base->windows);
+				changed++;
+			}
+		}
+		printf("\n");
+	}
+
+	if (!output.empty() && !saveJSON(output.c_str(), results, repeats)) {
+		fprintf(stderr, "Cannot write %s\n", output.c_str());
+		return 1;
+	}
+	if (changed)
+		printf("%d benchmarks changed their bus traffic\n", changed);
+	return 0;
+}
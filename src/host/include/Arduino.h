@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file Arduino.h
+ * Minimal Arduino core for the host emulator
+ * Only the subset used by WStation and the bundled libraries is provided.
+ */
+#ifndef __HOST_ARDUINO_H__
+#define __HOST_ARDUINO_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <inttypes.h>
+#include <algorithm>
+
+#include "pgmspace.h"
+#include "WString.h"
+#include "Print.h"
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT  0x01
+#define OUTPUT 0x02
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+using std::min;
+using std::max;
+
+/* Digital I/O */
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+/* Timing */
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield(void);
+
+/* Random numbers */
+long random(long howbig);
+long random(long howsmall, long howbig);
+
+/* LEDC (PWM) */
+double ledcSetup(uint8_t channel, double freq, uint8_t resolution_bits);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcWrite(uint8_t channel, uint32_t duty);
+
+/* FreeRTOS critical sections (the emulator is single threaded) */
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux)  ((void)(mux))
+
+/* Log messages */
+#define log_e(format, ...) fprintf(stderr, "[E] " format "\n", ##__VA_ARGS__)
+#define log_w(format, ...) fprintf(stderr, "[W] " format "\n", ##__VA_ARGS__)
+#define log_i(format, ...) fprintf(stderr, "[I] " format "\n", ##__VA_ARGS__)
+#define log_d(format, ...)
+#define log_v(format, ...)
+
+/**
+ * Digital pin observer
+ * The emulated peripherals (e.g. the TFT panel) register themselves here to
+ * follow the CS and DC lines driven by digitalWrite()
+ */
+class PinListener {
+	public:
+		virtual ~PinListener() {}
+		virtual void pinChanged(uint8_t pin, uint8_t val) = 0;
+};
+
+/* Register a pin listener (only one is supported) */
+void setPinListener(PinListener *listener);
+
+/* Count only the virtual time (delay() and emulated devices) */
+void setVirtualClock(bool enable);
+
+#endif /* __HOST_ARDUINO_H__ */
@@ -0,0 +1,129 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file FS.h
+ * File system for the host emulator
+ * Files are served from a directory on the host (usually fsroot/), and
+ * every access is accounted in FSStats so that the cost of loading
+ * pixmaps can be measured.
+ */
+#ifndef __HOST_FS_H__
+#define __HOST_FS_H__
+
+#include <stdio.h>
+#include <memory>
+#include "Arduino.h"
+#include "Stream.h"
+
+namespace fs {
+
+enum SeekMode {
+	SeekSet = 0,
+	SeekCur = 1,
+	SeekEnd = 2
+};
+
+/** File system access counters */
+typedef struct _fs_stats {
+	/** Files opened */
+	unsigned long opens;
+	/** read() calls */
+	unsigned long reads;
+	/** Bytes read */
+	unsigned long readBytes;
+	/** seek() calls */
+	unsigned long seeks;
+	/** write() calls */
+	unsigned long writes;
+	/** Bytes written */
+	unsigned long writeBytes;
+} FSStats;
+
+class FileImpl;
+typedef std::shared_ptr<FileImpl> FileImplPtr;
+
+class File : public Stream {
+	private:
+		FileImplPtr p;
+
+	public:
+		File(FileImplPtr p = FileImplPtr()) : p(p) {}
+
+		size_t write(uint8_t c) override;
+		size_t write(const uint8_t *buf, size_t size) override;
+		int available() override;
+		int read() override;
+		int peek() override;
+		size_t read(uint8_t *buf, size_t size);
+		size_t readBytes(char *buffer, size_t length) override {
+			return read((uint8_t *)buffer, length);
+		}
+		bool seek(uint32_t pos, SeekMode mode);
+		bool seek(uint32_t pos) { return seek(pos, SeekSet); }
+		size_t position() const;
+		size_t size() const;
+		void close();
+		operator bool() const;
+		const char *name() const;
+};
+
+class FS {
+	private:
+		String root;
+		FSStats st;
+
+	public:
+		explicit FS(const String& root);
+
+		File open(const char *path, const char *mode = "r");
+		File open(const String& path, const char *mode = "r") {
+			return open(path.c_str(), mode);
+		}
+		bool exists(const char *path);
+		bool exists(const String& path) { return exists(path.c_str()); }
+		bool remove(const char *path);
+		bool remove(const String& path) { return remove(path.c_str()); }
+
+		/* Access counters */
+		FSStats& stats() { return st; }
+		void resetStats();
+};
+
+} // namespace fs
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif /* __HOST_FS_H__ */
@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file IPAddress.h
+ * Arduino IPv4 address for the host tools
+ */
+#ifndef __HOST_IPADDRESS_H__
+#define __HOST_IPADDRESS_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include "WString.h"
+
+class IPAddress {
+	private:
+		/* Network byte order */
+		uint8_t bytes[4];
+
+	public:
+		IPAddress() { bytes[0] = bytes[1] = bytes[2] = bytes[3] = 0; }
+		IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+			bytes[0] = a;
+			bytes[1] = b;
+			bytes[2] = c;
+			bytes[3] = d;
+		}
+
+		uint8_t operator[](int index) const { return bytes[index]; }
+		uint8_t& operator[](int index) { return bytes[index]; }
+		bool operator==(const IPAddress& addr) const {
+			return memcmp(bytes, addr.bytes, sizeof(bytes)) == 0;
+		}
+
+		String toString() const {
+			char str[16];
+			snprintf(str, sizeof(str), "%u.%u.%u.%u", bytes[0], bytes[1],
+					bytes[2], bytes[3]);
+			return String(str);
+		}
+};
+
+#endif /* __HOST_IPADDRESS_H__ */
@@ -0,0 +1,72 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file Print.h
+ * Arduino Print class for the host emulator
+ */
+#ifndef __HOST_PRINT_H__
+#define __HOST_PRINT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "WString.h"
+
+class Print {
+	public:
+		virtual ~Print() {}
+
+		virtual size_t write(uint8_t c) = 0;
+		virtual size_t write(const uint8_t *buffer, size_t size);
+
+		size_t write(const char *str);
+		size_t write(const char *buffer, size_t size) {
+			return write((const uint8_t *)buffer, size);
+		}
+
+		size_t print(const __FlashStringHelper *str);
+		size_t print(const String& str);
+		size_t print(const char *str);
+		size_t print(char c);
+		size_t print(int n, int base = DEC);
+		size_t print(unsigned int n, int base = DEC);
+		size_t print(long n, int base = DEC);
+		size_t print(unsigned long n, int base = DEC);
+		size_t print(double n, int digits = 2);
+
+		size_t println(void);
+		size_t println(const String& str);
+		size_t println(const char *str);
+		size_t println(int n, int base = DEC);
+
+		size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+#endif /* __HOST_PRINT_H__ */
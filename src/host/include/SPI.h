@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file SPI.h
+ * SPI master for the host emulator
+ * Every byte clocked out is handed to the attached SPIDevice, which plays
+ * the role of the slave (e.g. the emulated ILI9341 panel).
+ */
+#ifndef __HOST_SPI_H__
+#define __HOST_SPI_H__
+
+#include <stdint.h>
+
+#define SPI_HAS_TRANSACTION
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+
+/** SPI transaction settings */
+class SPISettings {
+	public:
+		SPISettings() : _clock(1000000), _bitOrder(1), _dataMode(SPI_MODE0) {}
+		SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) :
+			_clock(clock), _bitOrder(bitOrder), _dataMode(dataMode) {}
+		uint32_t _clock;
+		uint8_t  _bitOrder;
+		uint8_t  _dataMode;
+};
+
+/** Emulated SPI slave */
+class SPIDevice {
+	public:
+		virtual ~SPIDevice() {}
+		/* Bus has been acquired */
+		virtual void beginTransaction(const SPISettings& settings) {}
+		/* Bus has been released */
+		virtual void endTransaction() {}
+		/* Exchange one byte (MOSI out, MISO in) */
+		virtual uint8_t transfer(uint8_t data) = 0;
+};
+
+class SPIClass {
+	private:
+		SPIDevice *dev;
+
+	public:
+		SPIClass() : dev(0) {}
+
+		/* Attach the emulated slave device */
+		void attach(SPIDevice *device) { dev = device; }
+
+		void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1,
+				int8_t ss = -1) {}
+		void end() {}
+
+		void setFrequency(uint32_t freq) {}
+		void setBitOrder(uint8_t bitOrder) {}
+		void setDataMode(uint8_t dataMode) {}
+
+		void beginTransaction(SPISettings settings);
+		void endTransaction(void);
+
+		uint8_t transfer(uint8_t data);
+		uint16_t transfer16(uint16_t data);
+		uint32_t transfer32(uint32_t data);
+		void transfer(void *data, uint32_t size);
+
+		void write(uint8_t data);
+		void write16(uint16_t data);
+		void write32(uint32_t data);
+		void writeBytes(const uint8_t *data, uint32_t size);
+		void writePixels(const void *data, uint32_t size);
+};
+
+extern SPIClass SPI;
+
+#endif /* __HOST_SPI_H__ */
@@ -0,0 +1,123 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file WString.h
+ * Arduino String class for the host emulator (backed by std::string)
+ */
+#ifndef __HOST_WSTRING_H__
+#define __HOST_WSTRING_H__
+
+#include <stdint.h>
+#include <string>
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class String {
+	private:
+		std::string s;
+
+	public:
+		String(const char *cstr = "") : s(cstr ? cstr : "") {}
+		String(const std::string& str) : s(str) {}
+		String(const __FlashStringHelper *str) :
+			s(reinterpret_cast<const char *>(str)) {}
+		explicit String(char c) : s(1, c) {}
+		explicit String(int value, unsigned char base = 10);
+		explicit String(unsigned int value, unsigned char base = 10);
+		explicit String(long value, unsigned char base = 10);
+		explicit String(unsigned long value, unsigned char base = 10);
+		explicit String(float value, unsigned char decimalPlaces = 2);
+		explicit String(double value, unsigned char decimalPlaces = 2);
+
+		unsigned int length() const { return s.length(); }
+		const char *c_str() const { return s.c_str(); }
+		bool reserve(unsigned int size) { s.reserve(size); return true; }
+
+		bool concat(const String& str) { s += str.s; return true; }
+		bool concat(const char *cstr) { if (cstr) s += cstr; return true; }
+		bool concat(char c) { s += c; return true; }
+
+		String& operator+=(const String& rhs) { concat(rhs); return *this; }
+		String& operator+=(const char *cstr) { concat(cstr); return *this; }
+		String& operator+=(char c) { concat(c); return *this; }
+
+		friend String operator+(const String& lhs, const String& rhs) {
+			return String(lhs.s + rhs.s);
+		}
+		friend String operator+(const String& lhs, const char *rhs) {
+			return String(lhs.s + rhs);
+		}
+		friend String operator+(const char *lhs, const String& rhs) {
+			return String(lhs + rhs.s);
+		}
+
+		bool equals(const String& str) const { return s == str.s; }
+		bool operator==(const String& rhs) const { return s == rhs.s; }
+		bool operator==(const char *cstr) const { return s == cstr; }
+		bool operator!=(const String& rhs) const { return s != rhs.s; }
+		bool operator!=(const char *cstr) const { return s != cstr; }
+		bool operator<(const String& rhs) const { return s < rhs.s; }
+
+		char charAt(unsigned int index) const {
+			return index < s.length() ? s[index] : 0;
+		}
+		char operator[](unsigned int index) const { return charAt(index); }
+
+		int indexOf(char ch, unsigned int fromIndex = 0) const;
+		int indexOf(const String& str, unsigned int fromIndex = 0) const;
+		int lastIndexOf(char ch) const;
+		String substring(unsigned int beginIndex) const;
+		String substring(unsigned int beginIndex, unsigned int endIndex) const;
+		bool startsWith(const String& prefix) const;
+		bool endsWith(const String& suffix) const;
+
+		void toLowerCase();
+		void toUpperCase();
+		void trim();
+
+		long toInt() const;
+		float toFloat() const;
+};
+
+/* Result of a concatenation (Arduino core) */
+class StringSumHelper : public String {
+	public:
+		StringSumHelper(const String& s) : String(s) {}
+		StringSumHelper(const char *p) : String(p) {}
+};
+
+#endif /* __HOST_WSTRING_H__ */
@@ -0,0 +1,85 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file WiFiClient.h
+ * TCP client of the ESP32 core for the host tools, on POSIX sockets
+ * read() does not wait, readBytes() waits for the data up to the timeout,
+ * as on the ESP32.
+ */
+#ifndef __HOST_WIFICLIENT_H__
+#define __HOST_WIFICLIENT_H__
+
+#include "Arduino.h"
+#include "Stream.h"
+#include "IPAddress.h"
+
+/** Receive buffer */
+#define WIFICLIENT_RX_SIZE 1436
+
+class WiFiClient : public Stream {
+	private:
+		int fd;
+		uint8_t rx[WIFICLIENT_RX_SIZE];
+		size_t rxPos;
+		size_t rxLen;
+		uint32_t timeout;
+
+		int fill(int waitMs);
+
+	public:
+		WiFiClient();
+		~WiFiClient();
+
+		int connect(IPAddress ip, uint16_t port, int32_t timeout);
+		int connect(IPAddress ip, uint16_t port) {
+			return connect(ip, port, timeout);
+		}
+		size_t write(uint8_t c) { return write(&c, 1); }
+		size_t write(const uint8_t *buf, size_t size);
+		int available();
+		int read();
+		int peek();
+		size_t readBytes(char *buffer, size_t length);
+		uint8_t connected();
+		void stop();
+		/* Timeout of readBytes() and connect() */
+		int setTimeout(uint32_t seconds) {
+			timeout = seconds * 1000;
+			return 0;
+		}
+
+	private:
+		/* Not copyable */
+		WiFiClient(const WiFiClient&);
+		WiFiClient& operator=(const WiFiClient&);
+};
+
+#endif /* __HOST_WIFICLIENT_H__ */
@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file esp_partition.h
+ * Flash partitions for the host emulator
+ * Partitions are loaded from files with esp_partition_load().
+ */
+#ifndef __HOST_ESP_PARTITION_H__
+#define __HOST_ESP_PARTITION_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK          0
+#define ESP_FAIL        -1
+#define ESP_ERR_NO_MEM  0x101
+#define ESP_ERR_INVALID_ARG  0x102
+
+typedef enum {
+	ESP_PARTITION_TYPE_APP  = 0x00,
+	ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+typedef enum {
+	ESP_PARTITION_SUBTYPE_ANY = 0xff,
+} esp_partition_subtype_t;
+
+typedef enum {
+	SPI_FLASH_MMAP_DATA,
+	SPI_FLASH_MMAP_INST,
+} spi_flash_mmap_memory_t;
+
+typedef uint32_t spi_flash_mmap_handle_t;
+
+/** Partition */
+typedef struct {
+	esp_partition_type_t type;
+	esp_partition_subtype_t subtype;
+	uint32_t address;
+	uint32_t size;
+	char label[17];
+	bool encrypted;
+} esp_partition_t;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+		esp_partition_subtype_t subtype, const char *label);
+
+esp_err_t esp_partition_mmap(const esp_partition_t *partition, size_t offset,
+		size_t size, spi_flash_mmap_memory_t memory, const void **out_ptr,
+		spi_flash_mmap_handle_t *out_handle);
+
+void spi_flash_munmap(spi_flash_mmap_handle_t handle);
+
+/* Host only: load a data partition from a file */
+bool esp_partition_load(const char *label, int subtype, const char *file);
+
+#endif /* __HOST_ESP_PARTITION_H__ */
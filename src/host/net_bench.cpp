@@ -0,0 +1,757 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file net_bench.cpp
+ * Check ENetwork and EHttpRequest against a local stand-in of the
+ * OpenWeather server and measure the requests.
+ *
+ * The stand-in server answers the current weather and forecast requests
+ * with the responses recorded in resources/parse. It can answer with the
+ * chunked transfer encoding, close the connection after each response, or
+ * drop a request (close the connection without answering), the way a
+ * server closes an idle kept-alive connection, answer the conditional
+ * requests (ETag), send Cache-Control or fail with Retry-After. Connections, requests and
+ * DNS lookups are counted on both sides. The first answer on each
+ * connection can be delayed, standing for the handshakes of a remote
+ * server (the loopback interface has no latency).
+ */
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <functional>
+#include "ENetwork.h"
+#include "EHttpRequest.h"
+#include "OpenWeather.h"
+#include "EWeatherScheduler.h"
+
+/** Default directory of the responses */
+#define DEF_RESPONSES "../../resources/parse"
+/** Default number of requests of the benchmark */
+#define DEF_REQUESTS 50
+/** Default delay of a new connection (us) */
+#define DEF_HANDSHAKE 2000
+/** Maximum connections of the stand-in server */
+#define SERVER_CONNECTIONS 8
+/** Chunk size of the chunked responses */
+#define SERVER_CHUNK 1000
+
+/* ====================== Stand-in server ====================== */
+
+/**
+ * OpenWeather stand-in (own thread)
+ */
+class StandInServer {
+	private:
+		/** Listening socket */
+		int lfd;
+		/** Port */
+		uint16_t port;
+		/** Thread */
+		pthread_t thread;
+		/** Responses (daily2: current weather changed) */
+		std::string daily, daily2, forecast;
+		/** Pipe to stop the thread */
+		int stopPipe[2];
+
+		static void *run(void *arg);
+		void loop();
+		bool handle(int fd, std::string& buf);
+		void respond(int fd, const std::string& body, int code,
+				const std::string& tag = "");
+		static std::string etag(const std::string& body);
+
+	public:
+		/** Answer with the chunked transfer encoding */
+		std::atomic<bool> chunked;
+		/** Close the connection after each response */
+		std::atomic<bool> close;
+		/** Requests to drop (connection closed without an answer) */
+		std::atomic<int> drop;
+		/** Delay of the first answer on a connection (us) */
+		std::atomic<unsigned long> handshake;
+		/** Send entity tags and answer the conditional requests */
+		std::atomic<bool> etags;
+		/** Cache-Control max-age (-1: none) */
+		std::atomic<int> maxAge;
+		/** Answer every request with this error status (0: none) */
+		std::atomic<int> fail;
+		/** Retry-After of the errors (0: none) */
+		std::atomic<int> retryAfter;
+		/** Serve the changed current weather */
+		std::atomic<bool> altDaily;
+		/** Answered 304 Not Modified */
+		std::atomic<unsigned long> notModified;
+		/** Connections accepted */
+		std::atomic<unsigned long> accepts;
+		/** Requests answered */
+		std::atomic<unsigned long> requests;
+
+		StandInServer(const std::string& daily, const std::string& forecast);
+		~StandInServer();
+		bool start();
+		uint16_t getPort() { return port; }
+};
+
+StandInServer::StandInServer(const std::string& daily,
+		const std::string& forecast) :
+	lfd(-1), port(0), daily(daily), forecast(forecast), chunked(false),
+	close(false), drop(0), handshake(0), etags(false), maxAge(-1), fail(0),
+	retryAfter(0), altDaily(false), notModified(0), accepts(0), requests(0)
+{
+	size_t p = daily.find("\"temp\":");
+
+	// Same document, another temperature
+	this->daily2 = daily;
+	if (p != std::string::npos)
+		this->daily2.replace(p + 7, 1, daily[p + 7] == '1' ? "2" : "1");
+	stopPipe[0] = stopPipe[1] = -1;
+}
+
+StandInServer::~StandInServer()
+{
+	if (stopPipe[1] >= 0) {
+		if (write(stopPipe[1], "x", 1) == 1)
+			pthread_join(thread, NULL);
+		::close(stopPipe[0]);
+		::close(stopPipe[1]);
+	}
+	if (lfd >= 0)
+		::close(lfd);
+}
+
+/**
+ * Listen on an ephemeral port of the loopback interface
+ * @return bool true on success
+ */
+bool StandInServer::start()
+{
+	struct sockaddr_in sin;
+	socklen_t len = sizeof(sin);
+	int one = 1;
+
+	lfd = socket(AF_INET, SOCK_STREAM, 0);
+	if (lfd < 0)
+		return false;
+	setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family      = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(lfd, (struct sockaddr *)&sin, sizeof(sin)) < 0 ||
+			listen(lfd, SERVER_CONNECTIONS) < 0 ||
+			getsockname(lfd, (struct sockaddr *)&sin, &len) < 0 ||
+			pipe(stopPipe) < 0)
+		return false;
+	port = ntohs(sin.sin_port);
+	return pthread_create(&thread, NULL, run, this) == 0;
+}
+
+void *StandInServer::run(void *arg)
+{
+	((StandInServer *)arg)->loop();
+	return NULL;
+}
+
+/**
+ * Serve the connections until stopped
+ */
+void StandInServer::loop()
+{
+	std::vector<int> fds;
+	std::vector<std::string> bufs;
+	std::vector<bool> fresh;
+	struct pollfd pfd[SERVER_CONNECTIONS + 2];
+	char data[4096];
+	size_t i, n;
+	ssize_t len;
+	int fd;
+
+	while (1) {
+		pfd[0].fd     = stopPipe[0];
+		pfd[0].events = POLLIN;
+		pfd[1].fd     = lfd;
+		pfd[1].events = fds.size() < SERVER_CONNECTIONS ? POLLIN : 0;
+		for (i = 0; i < fds.size(); i++) {
+			pfd[i + 2].fd     = fds[i];
+			pfd[i + 2].events = POLLIN;
+		}
+		n = fds.size() + 2;
+		if (poll(pfd, n, -1) < 0 && errno != EINTR)
+			break;
+		if (pfd[0].revents)
+			break;
+
+		for (i = fds.size(); i-- > 0; ) {
+			if (!pfd[i + 2].revents)
+				continue;
+			len = recv(fds[i], data, sizeof(data), 0);
+			if (len > 0)
+				bufs[i].append(data, len);
+			if (len > 0 && fresh[i] &&
+					bufs[i].find("\r\n\r\n") != std::string::npos) {
+				fresh[i] = false;
+				usleep(handshake);
+			}
+			if (len <= 0 || !handle(fds[i], bufs[i])) {
+				::close(fds[i]);
+				fds.erase(fds.begin() + i);
+				bufs.erase(bufs.begin() + i);
+				fresh.erase(fresh.begin() + i);
+			}
+		}
+
+		if (pfd[1].revents & POLLIN) {
+			fd = accept(lfd, NULL, NULL);
+			if (fd >= 0) {
+				accepts++;
+				fds.push_back(fd);
+				bufs.push_back(std::string());
+				fresh.push_back(true);
+			}
+		}
+	}
+
+	for (i = 0; i < fds.size(); i++)
+		::close(fds[i]);
+}
+
+/**
+ * Answer the complete requests received on a connection
+ * @param [in] fd Connection
+ * @param [in,out] buf Data received
+ * @return bool false to close the connection
+ */
+bool StandInServer::handle(int fd, std::string& buf)
+{
+	size_t end, sp, p;
+	std::string path, head, tag;
+	const std::string *body;
+
+	while ((end = buf.find("\r\n\r\n")) != std::string::npos) {
+		sp   = buf.find(' ');
+		path = buf.substr(sp + 1, buf.find_first_of(" ?", sp + 1) - sp - 1);
+		head = buf.substr(0, end + 2);
+		buf.erase(0, end + 4);
+
+		if (drop > 0) {
+			drop--;
+			return false;
+		}
+		requests++;
+		tag.clear();
+		p = head.find("\r\nIf-None-Match: ");
+		if (p != std::string::npos) {
+			p  += 17;
+			tag = head.substr(p, head.find("\r\n", p) - p);
+		}
+
+		if (path == FC_PATH_DAILY)
+			body = altDaily ? &daily2 : &daily;
+		else if (path == FC_PATH_WEEKLY)
+			body = &forecast;
+		else
+			body = NULL;
+
+		if (fail)
+			respond(fd, "{\"cod\":429,\"message\":\"too many requests\"}",
+					fail);
+		else if (!body)
+			respond(fd, "{\"cod\":\"404\",\"message\":\"not found\"}", 404);
+		else if (etags && tag.size() && tag == etag(*body))
+			respond(fd, "", 304, tag);
+		else
+			respond(fd, *body, 200, etags ? etag(*body) : "");
+		if (close)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Entity tag of a body
+ * @param [in] body Body
+ * @return std::string Tag (quoted)
+ */
+std::string StandInServer::etag(const std::string& body)
+{
+	char buf[32];
+
+	snprintf(buf, sizeof(buf), "\"%zx\"", std::hash<std::string>()(body));
+	return buf;
+}
+
+/**
+ * Send a response
+ * @param [in] fd Connection
+ * @param [in] body Body
+ * @param [in] code Status code
+ * @param [in] tag Entity tag (empty: none)
+ */
+void StandInServer::respond(int fd, const std::string& body, int code,
+		const std::string& tag)
+{
+	std::string res;
+	char buf[256];
+	size_t i, n;
+
+	snprintf(buf, sizeof(buf), "HTTP/1.1 %d %s\r\nServer: stand-in\r\n"
+			"Content-Type: application/json; charset=utf-8\r\n%s", code,
+			code == 200 ? "OK" : code == 304 ? "Not Modified" : "Error",
+			close ? "Connection: close\r\n" : "");
+	res = buf;
+	if (tag.size())
+		res += "ETag: " + tag + "\r\n";
+	if (maxAge >= 0) {
+		snprintf(buf, sizeof(buf), "Cache-Control: public, max-age=%d\r\n",
+				(int)maxAge);
+		res += buf;
+	}
+	if (fail && retryAfter > 0) {
+		snprintf(buf, sizeof(buf), "Retry-After: %d\r\n", (int)retryAfter);
+		res += buf;
+	}
+
+	if (code == 304) {
+		notModified++;
+		res += "\r\n";
+	} else if (chunked) {
+		res += "Transfer-Encoding: chunked\r\n\r\n";
+		for (i = 0; i < body.size(); i += SERVER_CHUNK) {
+			n = std::min((size_t)SERVER_CHUNK, body.size() - i);
+			snprintf(buf, sizeof(buf), "%zx\r\n", n);
+			res += buf;
+			res.append(body, i, n);
+			res += "\r\n";
+		}
+		res += "0\r\n\r\n";
+	} else {
+		snprintf(buf, sizeof(buf), "Content-Length: %zu\r\n\r\n", body.size());
+		res += buf;
+		res += body;
+	}
+	if (send(fd, res.data(), res.size(), MSG_NOSIGNAL) < 0)
+		perror("send");
+}
+
+/* ========================= Checks ========================= */
+
+/**
+ * Print to the standard output
+ */
+class StdoutPrint : public Print {
+	public:
+		size_t write(uint8_t c) {
+			return fputc(c, stdout) == EOF ? 0 : 1;
+		}
+};
+
+/** Checks failed */
+static int fails = 0;
+
+/**
+ * Check a condition
+ * @param [in] ok Condition
+ * @param [in] what Description
+ */
+static void check(bool ok, const char *what)
+{
+	printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+	if (!ok)
+		fails++;
+}
+
+/**
+ * Stream over a string
+ */
+class MemStream : public Stream {
+	private:
+		const std::string& data;
+		size_t pos;
+
+	public:
+		MemStream(const std::string& data) : data(data), pos(0) {}
+
+		int available() { return data.size() - pos; }
+		int read() { return pos < data.size() ? (uint8_t)data[pos++] : -1; }
+		int peek() { return pos < data.size() ? (uint8_t)data[pos] : -1; }
+		size_t write(uint8_t c) { return 0; }
+};
+
+/**
+ * Compare weather information
+ * @param [in] x Weather information
+ * @param [in] y Weather information
+ * @return bool true when they are equal
+ */
+static bool sameInfo(const weather_info_t& x, const weather_info_t& y)
+{
+	return x.temp == y.temp && x.min == y.min && x.max == y.max &&
+		x.feels == y.feels && x.humidity == y.humidity &&
+		x.pressure == y.pressure && x.weather == y.weather &&
+		x.date == y.date;
+}
+
+/**
+ * Check the weather fetched from the stand-in server
+ * @param [in] ow Client
+ * @param [in] ref Same responses parsed from memory
+ * @return bool true when they match
+ */
+static bool checkWeather(OpenWeather& ow, OpenWeather& ref)
+{
+	int i;
+
+	if (!sameInfo(ow.getDailyForecast(), ref.getDailyForecast()))
+		return false;
+	for (i = 0; i < MAX_FORECAST_DAYS; i++) {
+		if (!sameInfo(ow.getWeeklyForecast(i), ref.getWeeklyForecast(i)))
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Read a file
+ * @param [in] file File name
+ * @param [out] data Contents
+ * @return bool true on success
+ */
+static bool readFile(const std::string& file, std::string *data)
+{
+	FILE *fp = fopen(file.c_str(), "rb");
+	char buf[4096];
+	size_t n;
+
+	if (!fp) {
+		fprintf(stderr, "Cannot open %s\n", file.c_str());
+		return false;
+	}
+	data->clear();
+	while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+		data->append(buf, n);
+	fclose(fp);
+	return true;
+}
+
+/**
+ * Time back-to-back forecast requests
+ * @param [in] ow Client
+ * @param [in] server Stand-in server
+ * @param [in] n Number of requests
+ * @param [in] name Name
+ */
+static void bench(OpenWeather& ow, StandInServer& server, int n,
+		const char *name)
+{
+	unsigned long accepts = server.accepts, t;
+	int i, errors = 0;
+
+	t = micros();
+	for (i = 0; i < n; i++)
+		errors += ow.updateWeeklyForecast() != 0;
+	t = micros() - t;
+	printf("  %-24s %4d requests %8.1f us/request %4lu connections"
+			" %d errors\n", name, n, (double)t / n, server.accepts - accepts,
+			errors);
+	if (errors)
+		fails++;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Use: %s [-d responses_dir] [-n requests]"
+			" [-l handshake_us]\n", prog);
+	fprintf(stderr, "  -d  Server responses (default: " DEF_RESPONSES ")\n");
+	fprintf(stderr, "  -n  Requests of the benchmark (default: %d)\n",
+			DEF_REQUESTS);
+	fprintf(stderr, "  -l  Delay of a new connection in the benchmark"
+			" (default: %d us)\n", DEF_HANDSHAKE);
+}
+
+int main(int argc, char **argv)
+{
+	std::string dir(DEF_RESPONSES), daily, forecast;
+	int opt, requests = DEF_REQUESTS, handshake = DEF_HANDSHAKE;
+	unsigned long accepts, lookups, notModified;
+	int i;
+	StdoutPrint out;
+	net_stats_t st;
+	char url[64];
+
+	while ((opt = getopt(argc, argv, "d:n:l:h")) != -1) {
+		switch (opt) {
+			case 'd':
+				dir = optarg;
+				break;
+			case 'n':
+				requests = atoi(optarg);
+				if (requests < 1)
+					requests = 1;
+				break;
+			case 'l':
+				handshake = atoi(optarg);
+				if (handshake < 0)
+					handshake = 0;
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (!readFile(dir + "/out1.txt", &daily) ||
+			!readFile(dir + "/out2.txt", &forecast))
+		return 1;
+
+	OpenWeather split, single;
+	MemStream dailyStream(daily), splitStream(forecast),
+		singleStream(forecast);
+	if (split.parseDaily(dailyStream) || split.parseWeekly(splitStream) ||
+			single.parseWeekly(singleStream, true)) {
+		fprintf(stderr, "Cannot parse the responses\n");
+		return 1;
+	}
+
+	StandInServer server(daily, forecast);
+	if (!server.start()) {
+		perror("stand-in server");
+		return 1;
+	}
+	snprintf(url, sizeof(url), "http://localhost:%u", server.getPort());
+
+	ENetwork net;
+	OpenWeather ow;
+	ow.setNetwork(&net);
+	ow.setServer(url);
+	ow.setCity("Berlin,DE");
+	ow.setAPIKey("0123456789abcdef");
+
+	printf("Keep-alive (two requests per update)\n");
+	ow.setFetchMode(OpenWeather::FETCH_SPLIT);
+	check(ow.updateForecast() == 0 && checkWeather(ow, split),
+			"first update parsed");
+	check(ow.updateForecast() == 0 && checkWeather(ow, split),
+			"second update parsed");
+	net.getStats(&st);
+	check(server.accepts == 1 && server.requests == 4,
+			"4 requests on 1 connection");
+	check(st.requests == 4 && st.reused == 3 && st.connects == 1,
+			"counters: 4 requests, 3 reused, 1 connect");
+	check(WiFi.getLookups() == 1 && st.dnsLookups == 1,
+			"1 DNS lookup");
+
+	printf("Single request per update\n");
+	ow.setFetchMode(OpenWeather::FETCH_SINGLE);
+	net.resetStats();
+	check(ow.updateForecast() == 0 && checkWeather(ow, single),
+			"current weather from the forecast");
+	net.getStats(&st);
+	check(st.requests == 1 && st.reused == 1, "1 request, reused");
+
+	printf("Chunked transfer encoding\n");
+	server.chunked = true;
+	accepts = server.accepts;
+	ow.setFetchMode(OpenWeather::FETCH_SPLIT);
+	check(ow.updateForecast() == 0 && checkWeather(ow, split),
+			"update parsed");
+	check(server.accepts == accepts, "connection kept");
+	server.chunked = false;
+
+	printf("Request dropped by the server (idle connection closed)\n");
+	net.resetStats();
+	server.drop = 1;
+	check(ow.updateWeeklyForecast() == 0 && checkWeather(ow, split),
+			"update parsed");
+	net.getStats(&st);
+	check(st.retries == 1 && st.connects == 1,
+			"sent again on a new connection");
+
+	printf("Connection: close\n");
+	server.close = true;
+	accepts = server.accepts;
+	check(ow.updateForecast() == 0 && ow.updateForecast() == 0,
+			"updates parsed");
+	/* The first request goes on the connection kept from above */
+	check(server.accepts - accepts == 3, "new connection after each request");
+	server.close = false;
+
+	printf("DNS cache\n");
+	net.setKeepAlive(false);
+	net.flushDNS();
+	net.setDNSTTL(100);
+	net.resetStats();
+	lookups = WiFi.getLookups();
+	ow.updateForecast();
+	net.getStats(&st);
+	check(WiFi.getLookups() - lookups == 1 && st.dnsHits == 1,
+			"2 connections, 1 lookup");
+	delay(150);
+	ow.updateForecast();
+	net.getStats(&st);
+	check(WiFi.getLookups() - lookups == 2 && st.dnsHits == 2,
+			"looked up again after the TTL");
+	net.setDNSTTL(NET_DNS_TTL);
+
+	printf("Errors\n");
+	ow.setServer("http://localhost:1");
+	net.resetStats();
+	check(ow.updateWeeklyForecast() == HTTP_ERROR_CONNECT,
+			"connection refused");
+	net.getStats(&st);
+	check(st.connectErrors == 1, "connect error counted");
+	ow.setServer(url);
+
+	printf("Conditional requests\n");
+	ow.setFetchMode(OpenWeather::FETCH_SPLIT);
+	server.etags = true;
+	check(ow.updateForecast() == 0 && !ow.isChanged(OpenWeather::RES_CURRENT)
+			&& !ow.isChanged(OpenWeather::RES_FORECAST),
+			"same information: not changed");
+	notModified = server.notModified;
+	check(ow.updateForecast() == 0 && server.notModified - notModified == 2 &&
+			ow.getCache(OpenWeather::RES_FORECAST).status == OW_NOT_MODIFIED,
+			"validators sent: 304 Not Modified");
+	check(checkWeather(ow, split) &&
+			!ow.isChanged(OpenWeather::RES_CURRENT) &&
+			!ow.isChanged(OpenWeather::RES_FORECAST),
+			"information kept, not changed");
+	server.altDaily = true;
+	check(ow.updateForecast() == 0 && ow.isChanged(OpenWeather::RES_CURRENT)
+			&& !ow.isChanged(OpenWeather::RES_FORECAST),
+			"current weather changed, forecast not modified");
+	server.altDaily = false;
+	ow.setCity("Paris,FR");
+	notModified = server.notModified;
+	check(ow.updateForecast() == 0 && server.notModified == notModified,
+			"validators cleared with the city");
+	ow.setCity("Berlin,DE");
+
+	printf("Refresh scheduler (virtual time)\n");
+	EWeatherScheduler sched(&ow);
+	unsigned long t = 1000000, sent, delay, last;
+	unsigned int changed;
+	bool ok;
+	sched.setIntervals(600, 3600);
+	ow.updateForecast();
+	sent = server.requests;
+	check(sched.poll(t, &changed) == 0 && server.requests - sent == 2 &&
+			changed == 0, "both polled first, not modified");
+	check(sched.nextPoll(t) == 600000, "current weather next, in 600 s");
+	sent = server.requests;
+	sched.poll(t + 599999, &changed);
+	check(server.requests == sent, "nothing before the interval");
+	server.altDaily = true;
+	check(sched.poll(t + 600000, &changed) == 0 &&
+			server.requests - sent == 1 && changed == WEATHER_CHANGED_CURRENT,
+			"current weather polled alone, changed");
+	server.altDaily = false;
+	sent = server.requests;
+	for (i = 2; i <= 6; i++)
+		sched.poll(t + i * 600000, &changed);
+	check(server.requests - sent == 6, "forecast polled after 3600 s");
+	check(sched.getStats().notModified + sched.getStats().changed ==
+			sched.getStats().requests, "every request conditional");
+
+	server.maxAge = 7200;
+	sched.refresh();
+	sched.poll(t, &changed);
+	check(sched.nextPoll(t) == 7200000, "max-age of the server honored");
+	server.maxAge = -1;
+
+	server.fail = 503;
+	sched.refresh();
+	sent = server.requests;
+	ok   = true;
+	last = 0;
+	for (i = 1; i <= 8; i++) {
+		if (sched.poll(t, &changed) == 0)
+			ok = false;
+		delay = sched.nextPoll(t);
+		if (delay < last || delay > WEATHER_RETRY_MAX * 1250)
+			ok = false;
+		if (i == 1 && (delay < WEATHER_RETRY_MIN * 1000 ||
+					delay > WEATHER_RETRY_MIN * 1250))
+			ok = false;
+		last = delay > WEATHER_RETRY_MAX * 1000 ? WEATHER_RETRY_MAX * 1000 :
+			delay;
+		t += delay;
+	}
+	check(ok && sched.getFailures() == 8, "errors: delay doubled up to the limit");
+	check(server.requests - sent == 8, "one request per attempt");
+	server.fail       = 429;
+	server.retryAfter = 2400;
+	sched.poll(t, &changed);
+	delay = sched.nextPoll(t);
+	check(delay >= 2400000 && delay <= 3000000, "Retry-After honored");
+	t += delay;
+	server.fail       = 0;
+	server.retryAfter = 0;
+	// Whole responses, without the max-age kept from the 304 above
+	server.etags      = false;
+	check(sched.poll(t, &changed) == 0 && sched.getFailures() == 0 &&
+			sched.nextPoll(t) == 600000, "back to the intervals");
+
+	ow.setFetchMode(OpenWeather::FETCH_SINGLE);
+	sched.refresh();
+	sent = server.requests;
+	sched.poll(t, &changed);
+	check(server.requests - sent == 1 && sched.nextPoll(t) == 600000,
+			"single request, on the shorter interval");
+	server.fail = 503;
+	sched.refresh();
+	sent = server.requests;
+	sched.poll(t, &changed);
+	check(server.requests - sent == 1, "single request error: no fallback");
+	server.fail = 0;
+
+	printf("Back-to-back forecast requests (%d us per new connection)\n",
+			handshake);
+	server.handshake = handshake;
+	net.setKeepAlive(true);
+	net.resetStats();
+	bench(ow, server, requests, "keep-alive");
+	net.setKeepAlive(false);
+	bench(ow, server, requests, "new connection each");
+
+	printf("Counters: ");
+	net.printJSON(out);
+	printf("\n");
+
+	if (fails)
+		printf("%d check(s) failed\n", fails);
+	return fails ? 1 : 0;
+}
@@ -0,0 +1,816 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file parse_bench.cpp
+ * Regression tests and benchmark of the forecast parsers of OpenWeather.
+ *
+ * The parsers are fed with the server responses recorded in
+ * resources/parse and with synthetic ones: a 40 entry forecast, forecasts
+ * longer than MAX_FORECAST_DAYS, missing fields, oversized city names and
+ * truncated bodies. The resulting weather_info_t are checked against the
+ * previous parser (with an unbounded document) or against the values the
+ * synthetic responses were built from. For each case the time per parse,
+ * the JSON document memory, the allocations, the peak heap and the stack
+ * are reported. The previous parsers (whole response in a String
+ * deserialized into a document on the stack) are measured alongside.
+ *
+ * Each case runs in a thread whose stack is painted beforehand, the way the
+ * FreeRTOS stack high water mark is found, and every allocation is
+ * accounted while it runs. The stack of the cases that fail includes the
+ * fprintf() of log_e() on the host.
+ */
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <getopt.h>
+#include <string>
+#include <vector>
+#include <ArduinoJson.h>
+#include "OpenWeather.h"
+
+/** Default directory of the responses */
+#define DEF_RESPONSES "../../resources/parse"
+/** Default number of parses per case */
+#define DEF_ITERATIONS 100
+/** Stack of the parser threads */
+#define BENCH_STACK (256 * 1024)
+/** Stack paint */
+#define STACK_PAINT 0xa5
+/** Size of a value slot of ArduinoJson on the ESP32 */
+#define ESP32_SLOT_SIZE 16
+/** Document capacity of the ESP32 on this host (slots are larger) */
+#define ESP32_CAPACITY(n) ((n) * JSON_OBJECT_SIZE(1) / ESP32_SLOT_SIZE)
+/** Capacity of the reference document */
+#define REFERENCE_CAPACITY (1024 * 1024)
+/** Length of the oversized city names */
+#define LONG_CITY 8192
+/** Time between the entries of a forecast */
+#define FC_STEP (3 * SECS_PER_HOUR)
+
+/* ====================== Heap accounting ====================== */
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+extern "C" void __libc_free(void *ptr);
+
+/** Bytes allocated */
+static size_t heapUsed = 0;
+/** Peak of heapUsed */
+static size_t heapPeak = 0;
+/** Number of allocations */
+static unsigned long heapAllocs = 0;
+
+static void heapAdd(void *ptr)
+{
+	if (!ptr)
+		return;
+	heapAllocs++;
+	heapUsed += malloc_usable_size(ptr);
+	if (heapUsed > heapPeak)
+		heapPeak = heapUsed;
+}
+
+static void heapRemove(void *ptr)
+{
+	if (ptr)
+		heapUsed -= malloc_usable_size(ptr);
+}
+
+extern "C" void *malloc(size_t size)
+{
+	void *ptr = __libc_malloc(size);
+	heapAdd(ptr);
+	return ptr;
+}
+
+extern "C" void *calloc(size_t n, size_t size)
+{
+	void *ptr = __libc_calloc(n, size);
+	heapAdd(ptr);
+	return ptr;
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+	heapRemove(ptr);
+	ptr = __libc_realloc(ptr, size);
+	heapAdd(ptr);
+	return ptr;
+}
+
+extern "C" void free(void *ptr)
+{
+	heapRemove(ptr);
+	__libc_free(ptr);
+}
+
+/* ========================= Streams ========================= */
+
+/**
+ * Read a response from memory, one byte at a time as from the socket
+ */
+class MemStream : public Stream {
+	private:
+		const std::string& data;
+		size_t pos;
+
+	public:
+		MemStream(const std::string& data) : data(data), pos(0) {}
+
+		int available() { return data.size() - pos; }
+		int read() { return pos < data.size() ? (uint8_t)data[pos++] : -1; }
+		int peek() { return pos < data.size() ? (uint8_t)data[pos] : -1; }
+		size_t write(uint8_t c) { return 0; }
+};
+
+/* ======================== Responses ======================== */
+
+/** Synthetic forecast */
+typedef struct _synth {
+	/** Number of entries */
+	int entries;
+	/** Date of the first entry */
+	time_t start;
+	/** Length of the city name */
+	size_t city;
+	/** Entry without main (-1: none) */
+	int noMain;
+	/** Entry without weather (-1: none) */
+	int noWeather;
+	/** Entry without main.humidity (-1: none) */
+	int noHumidity;
+} synth_t;
+
+/**
+ * Values of a synthetic forecast entry (exact in a float)
+ * @param [in] s Forecast
+ * @param [in] i Entry
+ * @param [out] fc Weather information
+ */
+static void synthEntry(const synth_t *s, int i, weather_info_t *fc)
+{
+	bool main = (i != s->noMain);
+
+	fc->temp     = main ? 250.25 + i : 0;
+	fc->min      = main ? 249.5 + i : 0;
+	fc->max      = main ? 251.75 + i : 0;
+	fc->feels    = main ? 245.125 + i : 0;
+	fc->pressure = main ? 1000 + i : 0;
+	fc->humidity = (main && i != s->noHumidity) ? i : 0;
+	fc->weather  = OpenWeather::getWeatherFromID(
+			i != s->noWeather ? 200 + i : 0);
+	fc->date     = s->start + (time_t)i * FC_STEP;
+}
+
+/**
+ * Build a synthetic forecast, as sent by the server (the city comes first,
+ * so that the parser has to skip it)
+ * @param [in] s Forecast
+ * @return std::string JSON document
+ */
+static std::string synthForecast(const synth_t *s)
+{
+	weather_info_t fc;
+	std::string json;
+	char buf[512];
+	int i;
+
+	snprintf(buf, sizeof(buf), "{\"cod\":\"200\",\"message\":0,\"cnt\":%d,"
+			"\"city\":{\"id\":2950159,\"name\":\"", s->entries);
+	json = buf;
+	json.append(s->city, 'x');
+	json += "\",\"coord\":{\"lat\":52.5244,\"lon\":13.4105},"
+		"\"country\":\"DE\"},\"list\":[";
+
+	for (i = 0; i < s->entries; i++) {
+		synthEntry(s, i, &fc);
+		snprintf(buf, sizeof(buf), "%s{\"dt\":%ld,", i ? ",\n" : "",
+				(long)fc.date);
+		json += buf;
+		if (i != s->noMain) {
+			snprintf(buf, sizeof(buf), "\"main\":{\"temp\":%.3f,"
+					"\"feels_like\":%.3f,\"temp_min\":%.3f,"
+					"\"temp_max\":%.3f,\"pressure\":%.0f,\"sea_level\":1027",
+					fc.temp, fc.feels, fc.min, fc.max, fc.pressure);
+			json += buf;
+			if (i != s->noHumidity) {
+				snprintf(buf, sizeof(buf), ",\"humidity\":%d", fc.humidity);
+				json += buf;
+			}
+			json += "},";
+		}
+		if (i != s->noWeather) {
+			// Two conditions, as the server sends with rain and clouds
+			snprintf(buf, sizeof(buf), "\"weather\":[{\"id\":%d,"
+					"\"main\":\"Rain\",\"description\":\"light rain\","
+					"\"icon\":\"10d\"},{\"id\":804,\"main\":\"Clouds\"}],",
+					(int)fc.weather);
+			json += buf;
+		}
+		json += "\"clouds\":{\"all\":100},\"wind\":{\"speed\":6.86,"
+			"\"deg\":17},\"sys\":{\"pod\":\"n\"},"
+			"\"dt_txt\":\"2020-03-29 18:00:00\"}";
+	}
+	json += "]}";
+	return json;
+}
+
+/**
+ * Forecast expected from a synthetic response: first entry of each day
+ * @param [in] s Forecast
+ * @param [in,out] fc Weather information (entries past the last day are
+ *                    left untouched)
+ */
+static void synthExpected(const synth_t *s, weather_info_t *fc)
+{
+	int i, j = 0, lday = -1;
+	weather_info_t w;
+
+	for (i = 0; i < s->entries && j < MAX_FORECAST_DAYS; i++) {
+		synthEntry(s, i, &w);
+		if (day(w.date) != lday) {
+			lday = day(w.date);
+			fc[j++] = w;
+		}
+	}
+}
+
+/**
+ * Read a file
+ * @param [in] file File name
+ * @param [out] data Contents
+ * @return bool true on success
+ */
+static bool readFile(const std::string& file, std::string *data)
+{
+	FILE *fp = fopen(file.c_str(), "rb");
+	char buf[4096];
+	size_t n;
+
+	if (!fp) {
+		printf("Cannot open %s\n", file.c_str());
+		return false;
+	}
+	data->clear();
+	while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+		data->append(buf, n);
+	fclose(fp);
+	return true;
+}
+
+/* ===================== Previous parsers ===================== */
+
+/**
+ * Current weather, as parsed before: whole response in a String
+ * @param [in] stream Response
+ * @param [in] doc Document
+ * @param [out] fc Weather information
+ * @return int 0 on success, -1 otherwise
+ */
+static int legacyDaily(Stream& stream, JsonDocument& doc, weather_info_t *fc)
+{
+	String json;
+	int c;
+
+	// http.getString()
+	while ((c = stream.read()) >= 0)
+		json += (char)c;
+
+	DeserializationError error = deserializeJson(doc, json);
+	if (error) {
+		log_e("deserializeJson() failed: %s", error.c_str());
+		return -1;
+	}
+	fc->temp     = doc["main"]["temp"];
+	fc->min      = doc["main"]["temp_min"];
+	fc->max      = doc["main"]["temp_max"];
+	fc->feels    = doc["main"]["feels_like"];
+	fc->pressure = doc["main"]["pressure"];
+	fc->humidity = doc["main"]["humidity"];
+	fc->weather  = OpenWeather::getWeatherFromID(doc["weather"][0]["id"]);
+	fc->date     = doc["dt"];
+	return 0;
+}
+
+/**
+ * Forecast, as parsed before: whole response in a String, list indexed
+ * @param [in] stream Response
+ * @param [in] doc Document
+ * @param [out] fc Weather information
+ * @return int 0 on success, -1 otherwise
+ */
+static int legacyWeekly(Stream& stream, JsonDocument& doc, weather_info_t *fc)
+{
+	int i, j, cnt, lday, cday, c;
+	String json;
+	time_t t;
+
+	// http.getString()
+	while ((c = stream.read()) >= 0)
+		json += (char)c;
+
+	DeserializationError error = deserializeJson(doc, json);
+	if (error) {
+		log_e("deserializeJson() failed: %s", error.c_str());
+		return -1;
+	}
+	cnt  = doc["cnt"];
+	j    = 0;
+	lday = -1;
+	for (i = 0; i < cnt; i++) {
+		t = doc["list"][i]["dt"];
+		cday = day(t);
+		if (cday != lday) {
+			lday = cday;
+			fc[j].temp     = doc["list"][i]["main"]["temp"];
+			fc[j].min      = doc["list"][i]["main"]["temp_min"];
+			fc[j].max      = doc["list"][i]["main"]["temp_max"];
+			fc[j].feels    = doc["list"][i]["main"]["feels_like"];
+			fc[j].pressure = doc["list"][i]["main"]["pressure"];
+			fc[j].humidity = doc["list"][i]["main"]["humidity"];
+			fc[j].weather  = OpenWeather::getWeatherFromID(
+					doc["list"][i]["weather"][0]["id"]);
+			fc[j].date     = t;
+			if (++j >= MAX_FORECAST_DAYS)
+				break;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Previous parsers, with their documents on the stack
+ * @param [in] stream Response
+ * @param [out] fc Weather information
+ * @param [out] usage Document memory used
+ * @return int 0 on success, -1 otherwise
+ */
+static int __attribute__((noinline)) legacyParseWeekly(Stream& stream,
+		weather_info_t *fc, size_t *usage)
+{
+	StaticJsonDocument<ESP32_CAPACITY(20480)> doc;
+	int res = legacyWeekly(stream, doc, fc);
+	*usage = doc.memoryUsage();
+	return res;
+}
+
+static int __attribute__((noinline)) legacyParseDaily(Stream& stream,
+		weather_info_t *fc, size_t *usage)
+{
+	StaticJsonDocument<ESP32_CAPACITY(1024)> doc;
+	int res = legacyDaily(stream, doc, fc);
+	*usage = doc.memoryUsage();
+	return res;
+}
+
+/* ========================= Runs ========================= */
+
+/** Parsers */
+enum {
+	/* Previous parser */
+	PARSER_LEGACY,
+	/* Stream and filter (OpenWeather) */
+	PARSER_STREAM,
+	/* Previous parser with an unbounded document (results only) */
+	PARSER_REFERENCE,
+};
+
+/** Parser run */
+typedef struct _run {
+	/** Response */
+	const std::string *json;
+	/** Parser: 0 current weather, 1 forecast */
+	int weekly;
+	/** Current weather from the forecast */
+	bool current;
+	/** Parser */
+	int parser;
+	/** Number of parses */
+	int iterations;
+	/** Result */
+	int res;
+	/** Weather information */
+	weather_info_t fc[MAX_FORECAST_DAYS];
+	/** Current weather (forecast with current) */
+	weather_info_t now;
+	/** JSON document memory (bytes) */
+	size_t doc;
+	/** Peak heap (bytes) */
+	size_t heap;
+	/** Allocations per parse */
+	unsigned long allocs;
+	/** Time per parse (us) */
+	double us;
+} run_t;
+
+/**
+ * Parse a response (thread)
+ * @param [in,out] arg Run
+ * @return void* NULL
+ */
+static void *parse(void *arg)
+{
+	run_t *r = (run_t *)arg;
+	OpenWeather *ow = new OpenWeather();
+	unsigned long allocs, t;
+	size_t base;
+	int i, n;
+
+	base     = heapUsed;
+	heapPeak = heapUsed;
+	allocs   = heapAllocs;
+	t        = micros();
+	for (n = 0; n < r->iterations; n++) {
+		MemStream stream(*r->json);
+
+		if (r->parser == PARSER_LEGACY) {
+			memset(r->fc, 0, sizeof(r->fc));
+			r->res = r->weekly ? legacyParseWeekly(stream, r->fc, &r->doc) :
+				legacyParseDaily(stream, r->fc, &r->doc);
+		} else if (r->parser == PARSER_REFERENCE) {
+			DynamicJsonDocument doc(REFERENCE_CAPACITY);
+			memset(r->fc, 0, sizeof(r->fc));
+			r->res = r->weekly ? legacyWeekly(stream, doc, r->fc) :
+				legacyDaily(stream, doc, r->fc);
+			r->doc = doc.memoryUsage();
+		} else if (r->weekly) {
+			r->res = ow->parseWeekly(stream, r->current);
+			r->doc = ow->getDocumentUsage();
+		} else {
+			r->res = ow->parseDaily(stream);
+			r->doc = ow->getDocumentUsage();
+		}
+	}
+	r->us     = (double)(micros() - t) / r->iterations;
+	r->heap   = heapPeak - base;
+	r->allocs = (heapAllocs - allocs) / r->iterations;
+
+	if (r->parser == PARSER_STREAM) {
+		if (r->weekly) {
+			for (i = 0; i < MAX_FORECAST_DAYS; i++)
+				r->fc[i] = ow->getWeeklyForecast(i);
+		} else {
+			r->fc[0] = ow->getDailyForecast();
+		}
+		r->now = ow->getDailyForecast();
+	}
+	delete ow;
+	return NULL;
+}
+
+/** Empty thread (stack used by the thread itself) */
+static void *idle(void *arg)
+{
+	return NULL;
+}
+
+/**
+ * Run a function in a thread with a painted stack
+ * @param [in] fn Function
+ * @param [in] arg Argument
+ * @return size_t Stack used (bytes)
+ */
+static size_t runThread(void *(*fn)(void *), void *arg)
+{
+	static uint8_t stack[BENCH_STACK] __attribute__((aligned(64)));
+	pthread_attr_t attr;
+	pthread_t thread;
+	size_t i;
+
+	memset(stack, STACK_PAINT, sizeof(stack));
+	pthread_attr_init(&attr);
+	pthread_attr_setstack(&attr, stack, sizeof(stack));
+	if (pthread_create(&thread, &attr, fn, arg) != 0) {
+		pthread_attr_destroy(&attr);
+		return 0;
+	}
+	pthread_join(thread, NULL);
+	pthread_attr_destroy(&attr);
+
+	// Stacks grow down
+	for (i = 0; i < sizeof(stack) && stack[i] == STACK_PAINT; i++)
+		;
+	return sizeof(stack) - i;
+}
+
+/* ========================= Cases ========================= */
+
+/** Test case */
+typedef struct _test {
+	/** Name */
+	std::string name;
+	/** Parser */
+	int parser;
+	/** Forecast (otherwise current weather) */
+	int weekly;
+	/** Current weather from the forecast */
+	bool current;
+	/** Response */
+	std::string json;
+	/** Result expected */
+	int res;
+	/** Weather information expected (not checked for the previous parser) */
+	weather_info_t fc[MAX_FORECAST_DAYS];
+	/** Current weather expected (forecast with current) */
+	weather_info_t now;
+} test_t;
+
+/**
+ * Add a test case
+ * @param [in,out] tests Test cases
+ * @param [in] name Name
+ * @param [in] parser Parser
+ * @param [in] weekly Forecast (otherwise current weather)
+ * @param [in] json Response
+ * @param [in] res Result expected
+ * @return test_t& Test case, expecting the forecast of a new client
+ */
+static test_t& addTest(std::vector<test_t>& tests, const std::string& name,
+		int parser, int weekly, const std::string& json, int res)
+{
+	OpenWeather ow;
+	test_t t;
+	int i;
+
+	t.name    = name;
+	t.parser  = parser;
+	t.weekly  = weekly;
+	t.current = false;
+	t.json    = json;
+	t.res     = res;
+	for (i = 0; i < MAX_FORECAST_DAYS; i++)
+		t.fc[i] = ow.getWeeklyForecast(i);
+	if (!weekly)
+		t.fc[0] = ow.getDailyForecast();
+	t.now = ow.getDailyForecast();
+	tests.push_back(t);
+	return tests.back();
+}
+
+/**
+ * Set the weather information expected from the reference parser
+ * @param [in,out] t Test case
+ * @return bool false when the reference parser fails
+ */
+static bool referenceExpected(test_t& t)
+{
+	run_t ref;
+	int i;
+
+	ref.json       = &t.json;
+	ref.weekly     = t.weekly;
+	ref.current    = false;
+	ref.parser     = PARSER_REFERENCE;
+	ref.iterations = 1;
+	runThread(parse, &ref);
+	if (ref.res != 0)
+		return false;
+	// Entries past the last day are left untouched
+	for (i = 0; i < (t.weekly ? MAX_FORECAST_DAYS : 1) && ref.fc[i].date; i++)
+		t.fc[i] = ref.fc[i];
+	return true;
+}
+
+/**
+ * Compare weather information
+ * @param [in] name Test case
+ * @param [in] entry Entry (-1: current weather from the forecast)
+ * @param [in] x Weather information
+ * @param [in] y Weather information expected
+ * @return int 1 when they differ, 0 otherwise
+ */
+static int compareInfo(const std::string& name, int entry,
+		const weather_info_t *x, const weather_info_t *y)
+{
+	if (x->temp == y->temp && x->min == y->min && x->max == y->max &&
+			x->feels == y->feels && x->humidity == y->humidity &&
+			x->pressure == y->pressure && x->weather == y->weather &&
+			x->date == y->date)
+		return 0;
+
+	printf("%s: entry %d: %ld %.3f %.3f %.3f %.3f %d %.0f %d,"
+			" expected %ld %.3f %.3f %.3f %.3f %d %.0f %d\n",
+			name.c_str(), entry, (long)x->date, x->temp, x->min, x->max,
+			x->feels, x->humidity, x->pressure, (int)x->weather,
+			(long)y->date, y->temp, y->min, y->max, y->feels,
+			y->humidity, y->pressure, (int)y->weather);
+	return 1;
+}
+
+/**
+ * Compare the weather information of a run to the expected one
+ * @param [in] t Test case
+ * @param [in] r Run
+ * @return int Number of entries that differ
+ */
+static int compareRun(const test_t& t, const run_t *r)
+{
+	int i, diffs = 0;
+
+	for (i = 0; i < (t.weekly ? MAX_FORECAST_DAYS : 1); i++)
+		diffs += compareInfo(t.name, i, &r->fc[i], &t.fc[i]);
+	if (t.weekly)
+		diffs += compareInfo(t.name, -1, &r->now, &t.now);
+	return diffs;
+}
+
+/**
+ * Build the test cases
+ * @param [in] dir Directory of the recorded responses
+ * @param [out] tests Test cases
+ * @return bool false when a response cannot be read
+ */
+static bool buildTests(const std::string& dir, std::vector<test_t>& tests)
+{
+	std::string current, forecast, json;
+	synth_t s;
+	size_t pos;
+
+	if (!readFile(dir + "/out1.txt", &current) ||
+			!readFile(dir + "/out2.txt", &forecast))
+		return false;
+
+	// Recorded responses, previous and current parsers
+	addTest(tests, "current", PARSER_LEGACY, 0, current, 0);
+	if (!referenceExpected(addTest(tests, "current", PARSER_STREAM, 0,
+					current, 0)))
+		return false;
+	addTest(tests, "forecast/40", PARSER_LEGACY, 1, forecast, 0);
+	if (!referenceExpected(addTest(tests, "forecast/40", PARSER_STREAM, 1,
+					forecast, 0)))
+		return false;
+	test_t& fnow = addTest(tests, "forecast/current", PARSER_STREAM, 1,
+			forecast, 0);
+	fnow.current = true;
+	if (!referenceExpected(fnow))
+		return false;
+	// The first entry of the list is the first of the first day
+	fnow.now = fnow.fc[0];
+
+	// Oversized city name
+	json = current;
+	pos  = json.find("\"name\":\"");
+	if (pos != std::string::npos)
+		json.insert(pos + 8, std::string(LONG_CITY, 'x'));
+	test_t& city = addTest(tests, "current/long city", PARSER_STREAM, 0,
+			json, 0);
+	city.fc[0] = tests[1].fc[0];
+
+	// Synthetic forecasts: 40 entries from 18:00 (6 days), 64 from 00:00
+	// (more days than kept)
+	s.entries    = 40;
+	s.start      = 1585504800;
+	s.city       = 6;
+	s.noMain     = -1;
+	s.noWeather  = -1;
+	s.noHumidity = -1;
+	synthExpected(&s, addTest(tests, "synthetic/40", PARSER_STREAM, 1,
+				synthForecast(&s), 0).fc);
+
+	// Current weather from the forecast (single request): first entry
+	test_t& now = addTest(tests, "synthetic/current", PARSER_STREAM, 1,
+			synthForecast(&s), 0);
+	now.current = true;
+	synthExpected(&s, now.fc);
+	synthEntry(&s, 0, &now.now);
+
+	s.city = LONG_CITY;
+	synthExpected(&s, addTest(tests, "synthetic/long city", PARSER_STREAM, 1,
+				synthForecast(&s), 0).fc);
+
+	s.city       = 6;
+	s.noMain     = 2;
+	s.noWeather  = 10;
+	s.noHumidity = 18;
+	synthExpected(&s, addTest(tests, "synthetic/missing", PARSER_STREAM, 1,
+				synthForecast(&s), 0).fc);
+
+	s.entries    = 64;
+	s.start      = 1585440000;
+	s.noMain     = -1;
+	s.noWeather  = -1;
+	s.noHumidity = -1;
+	synthExpected(&s, addTest(tests, "synthetic/64", PARSER_STREAM, 1,
+				synthForecast(&s), 0).fc);
+
+	// Truncated bodies: the forecast must be left untouched
+	addTest(tests, "current/truncated", PARSER_STREAM, 0,
+			current.substr(0, current.size() / 2), -1);
+	addTest(tests, "forecast/empty", PARSER_STREAM, 1, "", -1);
+	addTest(tests, "forecast/no list", PARSER_STREAM, 1,
+			forecast.substr(0, forecast.find("\"list\"")), -1);
+	addTest(tests, "forecast/list start", PARSER_STREAM, 1,
+			forecast.substr(0, forecast.find("[") + 1), -1);
+	addTest(tests, "forecast/mid entry", PARSER_STREAM, 1,
+			forecast.substr(0, forecast.size() / 2), -1);
+	pos = forecast.find("},{", forecast.size() / 2);
+	addTest(tests, "forecast/after comma", PARSER_STREAM, 1,
+			forecast.substr(0, pos + 2), -1);
+	addTest(tests, "forecast/no list end", PARSER_STREAM, 1,
+			forecast.substr(0, forecast.rfind("],\"city\"")), -1);
+	addTest(tests, "forecast/current cut", PARSER_STREAM, 1,
+			forecast.substr(0, forecast.size() / 2), -1).current = true;
+	return true;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Use: %s [-d responses_dir] [-n iterations]\n", prog);
+	fprintf(stderr, "  -d  Server responses (default: " DEF_RESPONSES ")\n");
+	fprintf(stderr, "  -n  Parses per case (default: %d)\n", DEF_ITERATIONS);
+}
+
+int main(int argc, char **argv)
+{
+	std::string dir(DEF_RESPONSES);
+	std::vector<test_t> tests;
+	int opt, fails = 0, iterations = DEF_ITERATIONS;
+	size_t i, base, stack;
+	const char *check;
+	run_t r;
+
+	while ((opt = getopt(argc, argv, "d:n:h")) != -1) {
+		switch (opt) {
+			case 'd':
+				dir = optarg;
+				break;
+			case 'n':
+				iterations = atoi(optarg);
+				if (iterations < 1)
+					iterations = 1;
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (!buildTests(dir, tests))
+		return 1;
+
+	// Once for the first use of the thread and stdio functions
+	runThread(idle, NULL);
+	base = runThread(idle, NULL);
+	printf("%-22s %-16s %6s %5s %9s %6s %7s %6s %7s\n", "case", "parser",
+			"result", "check", "us", "doc", "heap", "allocs", "stack");
+
+	for (i = 0; i < tests.size(); i++) {
+		const test_t& t = tests[i];
+
+		r.json       = &t.json;
+		r.weekly     = t.weekly;
+		r.current    = t.current;
+		r.parser     = t.parser;
+		r.iterations = iterations;
+		stack = runThread(parse, &r);
+
+		if (t.parser == PARSER_LEGACY) {
+			check = "-";
+		} else if (r.res != t.res || compareRun(t, &r) != 0) {
+			check = "FAIL";
+			fails++;
+		} else {
+			check = "ok";
+		}
+		printf("%-22s %-16s %6d %5s %9.2f %6lu %7lu %6lu %7lu\n",
+				t.name.c_str(), t.parser == PARSER_LEGACY ?
+				"string+document" : "stream+filter", r.res, check, r.us,
+				(unsigned long)r.doc, (unsigned long)r.heap, r.allocs,
+				(unsigned long)(stack - base));
+	}
+
+	if (fails)
+		printf("%d case(s) failed\n", fails);
+	return fails ? 1 : 0;
+}
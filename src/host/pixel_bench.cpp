@@ -0,0 +1,325 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file pixel_bench.cpp
+ * Check the RGB565 pixel kernels (Adafruit_GFX_RGB565) against per-pixel
+ * reference loops, for every length up to a few words and every alignment
+ * of the buffers, then compare their cost on a screen line and a strip.
+ */
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <vector>
+#include <Arduino.h>
+#include <Adafruit_GFX_RGB565.h>
+
+/** Longest buffer checked */
+#define CHECK_LEN 67
+/** Pixels per benchmark call (a strip of EInterface) */
+#define BENCH_LEN 1024
+/** Default number of calls per benchmark run */
+#define DEF_CALLS 4000
+/** Runs of each benchmark (the fastest is kept) */
+#define BENCH_RUNS 5
+
+/* ===================== Reference loops ===================== */
+
+/*
+ * The ESP32 has no vector unit: keep the compiler from vectorizing the
+ * reference loops, so both sides run scalar code as they would there
+ */
+#pragma GCC optimize("no-tree-vectorize")
+
+static void refFill(uint16_t *dst, uint16_t color, uint32_t len)
+{
+	while (len--)
+		*dst++ = color;
+}
+
+static void refSwap(uint16_t *dst, const uint16_t *src, uint32_t len)
+{
+	while (len--)
+		*dst++ = __builtin_bswap16(*src++);
+}
+
+static void refHalf(uint16_t *dst, const uint16_t *line0,
+		const uint16_t *line1, uint32_t len)
+{
+	uint16_t p[4];
+	uint32_t i, r, g, b;
+	int k;
+
+	for (i = 0; i < len; i++) {
+		p[0] = line0[2 * i];
+		p[1] = line0[2 * i + 1];
+		p[2] = line1[2 * i];
+		p[3] = line1[2 * i + 1];
+		r = g = b = 0;
+		for (k = 0; k < 4; k++) {
+			r += p[k] >> 11;
+			g += (p[k] >> 5) & 0x3f;
+			b += p[k] & 0x1f;
+		}
+		dst[i] = (((r + 2) / 4) << 11) | (((g + 2) / 4) << 5) | ((b + 2) / 4);
+	}
+}
+
+static void refBlend(uint16_t *dst, const uint16_t *src, const uint8_t *alpha,
+		uint16_t bg, uint32_t len)
+{
+	uint32_t i, a, r, g, b;
+
+	for (i = 0; i < len; i++) {
+		a = (alpha[i] + 4) / 8;
+		r = ((src[i] >> 11) * a + (bg >> 11) * (32 - a)) / 32;
+		g = (((src[i] >> 5) & 0x3f) * a + ((bg >> 5) & 0x3f) * (32 - a)) / 32;
+		b = ((src[i] & 0x1f) * a + (bg & 0x1f) * (32 - a)) / 32;
+		dst[i] = (r << 11) | (g << 5) | b;
+	}
+}
+
+/* ======================== Checks ========================= */
+
+/** Random pixels, with the extreme values of the channels */
+static uint16_t randomPixel(void)
+{
+	switch (rand() % 8) {
+		case 0:
+			return 0x0000;
+		case 1:
+			return 0xffff;
+		default:
+			return rand();
+	}
+}
+
+/**
+ * Compare two buffers, including the guard pixels around them
+ * @param [in] kernel Kernel name
+ * @param [in] got Kernel output
+ * @param [in] exp Reference output
+ * @param [in] size Buffer size
+ * @param [in] len Length checked
+ * @param [in] align Offset of the buffers
+ * @return int 1 when they differ, 0 otherwise
+ */
+static int compare(const char *kernel, const uint16_t *got,
+		const uint16_t *exp, size_t size, uint32_t len, int align)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		if (got[i] != exp[i]) {
+			fprintf(stderr, "%s: length %u, offset %d: pixel %d is %04x "
+					"(expected %04x)\n", kernel, len, align,
+					(int)i - align, got[i], exp[i]);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Check the kernels against the reference loops
+ * @return int Number of failed checks
+ */
+static int check(void)
+{
+	const size_t size = 2 * CHECK_LEN + 8;
+	uint16_t src[size], line1[size], got[size], exp[size];
+	uint8_t alpha[size];
+	unsigned long checks = 0;
+	int fails = 0, so, d;
+	uint32_t len;
+	size_t i;
+
+	for (len = 0; len <= CHECK_LEN; len++) {
+		for (so = 0; so < 2; so++) {
+			for (d = 0; d < 2; d++) {
+				for (i = 0; i < size; i++) {
+					src[i]   = randomPixel();
+					line1[i] = randomPixel();
+					alpha[i] = (i % 5 == 0) ? 0 : (i % 5 == 1) ? 255 : rand();
+					got[i]   = exp[i] = randomPixel();
+				}
+				uint16_t color = randomPixel();
+
+				rgb565Fill(got + d, color, len);
+				refFill(exp + d, color, len);
+				fails += compare("fill", got, exp, size, len, d);
+
+				rgb565Swap(got + d, src + so, len);
+				refSwap(exp + d, src + so, len);
+				fails += compare("swap", got, exp, size, len, d);
+
+				// In place
+				memcpy(got, src, sizeof(got));
+				memcpy(exp, src, sizeof(exp));
+				rgb565Swap(got + d, got + d, len);
+				refSwap(exp + d, exp + d, len);
+				fails += compare("swap (in place)", got, exp, size, len, d);
+
+				rgb565Half(got + d, src + so, line1 + so, len);
+				refHalf(exp + d, src + so, line1 + so, len);
+				fails += compare("half", got, exp, size, len, d);
+
+				rgb565Blend(got + d, src + so, alpha + so, color, len);
+				refBlend(exp + d, src + so, alpha + so, color, len);
+				fails += compare("blend", got, exp, size, len, d);
+				checks += 5;
+			}
+		}
+	}
+
+	// Every pixel over every background, at every alpha step
+	for (i = 0; i < 0x10000; i += 7) {
+		uint16_t px[33], bl[33], rf[33], bg = randomPixel();
+		uint8_t al[33];
+		for (d = 0; d < 33; d++) {
+			px[d] = i;
+			al[d] = d * 8 > 255 ? 255 : d * 8;
+		}
+		rgb565Blend(bl, px, al, bg, 33);
+		refBlend(rf, px, al, bg, 33);
+		fails += compare("blend (steps)", bl, rf, 33, 33, 0);
+		checks++;
+	}
+
+	printf("checks: %lu, %d failed\n", checks, fails);
+	return fails;
+}
+
+/* ====================== Benchmarks ======================= */
+
+/** Buffers of the benchmarks */
+static uint16_t benchSrc[2 * BENCH_LEN], benchDst[2 * BENCH_LEN];
+static uint8_t benchAlpha[BENCH_LEN];
+
+/**
+ * Time calls of a function (fastest of BENCH_RUNS runs)
+ * @param [in] fn Function
+ * @param [in] calls Number of calls per run
+ * @return unsigned long Time (us)
+ */
+static unsigned long timeCalls(void (*fn)(void), unsigned long calls)
+{
+	unsigned long i, t0, t, best = 0;
+	int r;
+
+	for (r = 0; r < BENCH_RUNS; r++) {
+		t0 = micros();
+		for (i = 0; i < calls; i++)
+			fn();
+		t = micros() - t0;
+		if (r == 0 || t < best)
+			best = t;
+	}
+	return best;
+}
+
+/**
+ * Time calls of a kernel and of its reference loop
+ * @param [in] name Kernel name
+ * @param [in] kernel Kernel call
+ * @param [in] ref Reference call
+ * @param [in] calls Number of calls
+ */
+static void bench(const char *name, void (*kernel)(void), void (*ref)(void),
+		unsigned long calls)
+{
+	unsigned long tr = timeCalls(ref, calls), tk = timeCalls(kernel, calls);
+
+	printf("%-8s %8lu %10.2f %10.2f %7.2fx\n", name, calls,
+			1000.0 * tr / calls / BENCH_LEN, 1000.0 * tk / calls / BENCH_LEN,
+			tk ? (double)tr / tk : 0.0);
+}
+
+static void kFill(void) { rgb565Fill(benchDst, benchSrc[0], BENCH_LEN); }
+static void rFill(void) { refFill(benchDst, benchSrc[0], BENCH_LEN); }
+static void kSwap(void) { rgb565Swap(benchDst, benchSrc, BENCH_LEN); }
+static void rSwap(void) { refSwap(benchDst, benchSrc, BENCH_LEN); }
+static void kHalf(void)
+{
+	rgb565Half(benchDst, benchSrc, benchSrc + BENCH_LEN, BENCH_LEN / 2);
+}
+static void rHalf(void)
+{
+	refHalf(benchDst, benchSrc, benchSrc + BENCH_LEN, BENCH_LEN / 2);
+}
+static void kBlend(void)
+{
+	rgb565Blend(benchDst, benchSrc, benchAlpha, 0x0000, BENCH_LEN);
+}
+static void rBlend(void)
+{
+	refBlend(benchDst, benchSrc, benchAlpha, 0x0000, BENCH_LEN);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Use: %s [-n calls]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long calls = DEF_CALLS;
+	int opt, fails;
+	size_t i;
+
+	while ((opt = getopt(argc, argv, "n:h")) != -1) {
+		switch (opt) {
+			case 'n':
+				calls = atol(optarg);
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+
+	srand(1);
+	fails = check();
+
+	for (i = 0; i < 2 * BENCH_LEN; i++)
+		benchSrc[i] = rand();
+	for (i = 0; i < BENCH_LEN; i++)
+		benchAlpha[i] = rand();
+
+	printf("\n%-8s %8s %10s %10s %8s\n", "kernel", "calls", "ref_ns_px",
+			"swar_ns_px", "speedup");
+	bench("fill", kFill, rFill, calls);
+	bench("swap", kSwap, rSwap, calls);
+	bench("half", kHalf, rHalf, calls);
+	bench("blend", kBlend, rBlend, calls);
+
+	return fails ? 1 : 0;
+}
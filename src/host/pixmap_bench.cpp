@@ -0,0 +1,314 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file pixmap_bench.cpp
+ * Compare the cost of decoding pixel map files with the per-pixel reader
+ * (two File::read() calls per pixel) against the EPixmapReader strip reader,
+ * raw files (.px) against compressed files (.px2), and half size icons
+ * scaled at run time against the half size files made by the asset pipeline
+ * (<icon>_half.px, <icon>_half.px2).
+ */
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <FS.h>
+#include "EPixmapReader.h"
+
+/** Default file system root (compressed pixmaps) */
+#define DEF_FSROOT "../fsroot"
+/** Default file system root with raw pixmaps */
+#define DEF_RAWROOT "build/fsroot_px"
+/** Default number of iterations */
+#define DEF_ITERATIONS 20
+/** Forecast icons drawn on each forecast refresh */
+#define FORECAST_ICONS 3
+
+/** Benchmark result */
+typedef struct _result {
+	/** read() calls */
+	unsigned long reads;
+	/** seek() calls */
+	unsigned long seeks;
+	/** Bytes read */
+	unsigned long bytes;
+	/** Time per decode (us) */
+	double us;
+} result_t;
+
+/**
+ * Read 16 bits number from file (legacy reader, File passed by value)
+ */
+static uint16_t readInt(File f)
+{
+	char num[2];
+	num[0] = f.read();
+	num[1] = f.read();
+	return (((num[1] << 8) & 0xff00) | (num[0] & 0xff));
+}
+
+/**
+ * Legacy decoder: one pixel at a time into a full image buffer
+ */
+static void decodeLegacy(FS& fsys, const std::string& file, uint32_t *sum)
+{
+	int w, h, pos, imgsize;
+	File pic = fsys.open(file.c_str(), "r");
+
+	if (!pic)
+		return;
+	w = readInt(pic);
+	h = readInt(pic);
+	imgsize = w * h;
+	uint16_t *buffer = new uint16_t[imgsize];
+	pos = 0;
+	while (pic.available() && pos < imgsize)
+		buffer[pos++] = readInt(pic);
+	pic.close();
+	*sum += buffer[imgsize / 2];
+	delete[] buffer;
+}
+
+/**
+ * Strip decoder: PIXMAP_STRIP_PIXELS buffer, whole lines per read()
+ */
+static void decodeStrip(FS& fsys, const std::string& file, uint32_t *sum)
+{
+	static uint16_t strip[PIXMAP_STRIP_PIXELS];
+	EPixmapReader pic;
+	int n, lines;
+
+	if (!pic.open(&fsys, file.c_str()) || pic.width() == 0)
+		return;
+	n = PIXMAP_STRIP_PIXELS / pic.width();
+	while ((lines = pic.read(strip, n)) > 0)
+		*sum += strip[0];
+}
+
+/**
+ * Strip decoder at half size
+ */
+static void decodeHalf(FS& fsys, const std::string& file, uint32_t *sum)
+{
+	static uint16_t strip[PIXMAP_STRIP_PIXELS];
+	EPixmapReader pic;
+	int n, lines;
+
+	if (!pic.open(&fsys, file.c_str()) || pic.width() < 2)
+		return;
+	n = (PIXMAP_STRIP_PIXELS - 2 * pic.width()) / (pic.width() / 2);
+	while ((lines = pic.readHalf(strip, n,
+					strip + PIXMAP_STRIP_PIXELS - 2 * pic.width())) > 0)
+		*sum += strip[0];
+}
+
+/**
+ * Span decoder: runs are returned as fills, as drawn by EInterface
+ */
+static void decodeSpans(FS& fsys, const std::string& file, uint32_t *sum)
+{
+	static uint16_t strip[PIXMAP_STRIP_PIXELS];
+	EPixmapReader pic;
+	uint32_t n;
+	bool fill;
+
+	if (!pic.open(&fsys, file.c_str()))
+		return;
+	while ((n = pic.readSpan(strip, PIXMAP_STRIP_PIXELS, &fill)) > 0)
+		*sum += strip[0] + fill;
+}
+
+/**
+ * Get file size
+ */
+static unsigned long fileSize(const std::string& root, const std::string& file)
+{
+	struct stat st;
+
+	if (stat((root + file).c_str(), &st) != 0)
+		return 0;
+	return st.st_size;
+}
+
+/**
+ * Add a result to the summary
+ */
+static void sum(result_t *total, const result_t& res)
+{
+	total->reads += res.reads;
+	total->seeks += res.seeks;
+	total->bytes += res.bytes;
+	total->us    += res.us;
+}
+
+/**
+ * Run a decoder
+ */
+static result_t run(FS& fsys, const std::string& file, int iterations,
+		void (*decode)(FS&, const std::string&, uint32_t*))
+{
+	result_t res;
+	unsigned long t0;
+	uint32_t sum = 0;
+	int i;
+
+	fsys.resetStats();
+	decode(fsys, file, &sum);
+	res.reads = fsys.stats().reads;
+	res.seeks = fsys.stats().seeks;
+	res.bytes = fsys.stats().readBytes;
+
+	t0 = micros();
+	for (i = 0; i < iterations; i++)
+		decode(fsys, file, &sum);
+	res.us = (double)(micros() - t0) / iterations;
+	return res;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Use: %s [-f fsroot] [-r raw_fsroot] [-n iterations]\n",
+			prog);
+	fprintf(stderr, "  -f  File system root with .px2 files (default: "
+			DEF_FSROOT ")\n");
+	fprintf(stderr, "  -r  File system root with .px files (default: "
+			DEF_RAWROOT ")\n");
+}
+
+int main(int argc, char **argv)
+{
+	std::string fsroot(DEF_FSROOT), rawroot(DEF_RAWROOT);
+	std::vector<std::string> files;
+	struct dirent *de;
+	DIR *dir;
+	int opt, iterations = DEF_ITERATIONS;
+	size_t i, len;
+	result_t legacy, strip, packed, spans, hraw, hpacked, sraw, spacked;
+	result_t fcScaled = {0, 0, 0, 0}, fcRaw = {0, 0, 0, 0};
+	result_t fcPacked = {0, 0, 0, 0};
+	result_t fcHalfRaw = {0, 0, 0, 0}, fcHalfPacked = {0, 0, 0, 0};
+	unsigned long rawSize = 0, packedSize = 0;
+	int fcIcons = 0;
+	std::string name, zname, half, zhalf;
+
+	while ((opt = getopt(argc, argv, "f:r:n:h")) != -1) {
+		switch (opt) {
+			case 'f':
+				fsroot = optarg;
+				break;
+			case 'r':
+				rawroot = optarg;
+				break;
+			case 'n':
+				iterations = atoi(optarg);
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (iterations <= 0)
+		iterations = 1;
+
+	if (!(dir = opendir(rawroot.c_str()))) {
+		fprintf(stderr, "Cannot open %s\n", rawroot.c_str());
+		return 1;
+	}
+	while ((de = readdir(dir))) {
+		len = strlen(de->d_name);
+		if (len > 3 && !strcmp(de->d_name + len - 3, ".px") &&
+				!strstr(de->d_name, "_half."))
+			files.push_back(std::string("/") + de->d_name);
+	}
+	closedir(dir);
+	std::sort(files.begin(), files.end());
+
+	FS rawfs(rawroot.c_str());
+	FS fsys(fsroot.c_str());
+
+	printf("%-13s %22s %22s %29s %15s\n", "", "per-pixel (.px)",
+			"strip (.px)", "strip (.px2)", "spans (.px2)");
+	printf("%-13s %7s %6s %7s %7s %6s %7s %7s %6s %6s %7s %6s %7s\n",
+			"file", "bytes", "reads", "us", "bytes", "reads", "us",
+			"size", "bytes", "reads", "us", "reads", "us");
+	for (i = 0; i < files.size(); i++) {
+		name  = files[i];
+		zname = name + "2";
+		half  = name.substr(0, name.size() - 3) + "_half.px";
+		zhalf = half + "2";
+
+		legacy = run(rawfs, name, iterations, decodeLegacy);
+		strip  = run(rawfs, name, iterations, decodeStrip);
+		packed = run(fsys, zname, iterations, decodeStrip);
+		spans  = run(fsys, zname, iterations, decodeSpans);
+		printf("%-13s %7lu %6lu %7.1f %7lu %6lu %7.1f %7lu %6lu %6lu %7.1f"
+				" %6lu %7.1f\n", name.c_str(),
+				legacy.bytes, legacy.reads, legacy.us,
+				strip.bytes, strip.reads, strip.us,
+				fileSize(fsroot, zname), packed.bytes, packed.reads, packed.us,
+				spans.reads, spans.us);
+
+		rawSize    += fileSize(rawroot, name) + fileSize(rawroot, half);
+		packedSize += fileSize(fsroot, zname) + fileSize(fsroot, zhalf);
+
+		// Forecast row: first 60x60 weather icons with half size files
+		if (fcIcons < FORECAST_ICONS && legacy.bytes == (60 * 60 * 2 + 4) &&
+				rawfs.exists(half.c_str()) && fsys.exists(zhalf.c_str())) {
+			hraw    = run(rawfs, half, iterations, decodeStrip);
+			hpacked = run(fsys, zhalf, iterations, decodeStrip);
+			sraw    = run(rawfs, name, iterations, decodeHalf);
+			spacked = run(fsys, zname, iterations, decodeHalf);
+			sum(&fcScaled, legacy);
+			sum(&fcHalfRaw, sraw);
+			sum(&fcHalfPacked, spacked);
+			sum(&fcRaw, hraw);
+			sum(&fcPacked, hpacked);
+			fcIcons++;
+		}
+	}
+
+	printf("\nPixmap files (full and half size): .px %lu bytes, "
+			".px2 %lu bytes\n", rawSize, packedSize);
+	printf("\nForecast refresh (%d icons, 60x60 -> 30x30):\n", fcIcons);
+	printf("  scaled at run time, per-pixel: %6lu bytes %6lu reads %8.1f us\n",
+			fcScaled.bytes, fcScaled.reads, fcScaled.us);
+	printf("  scaled at run time, .px:       %6lu bytes %6lu reads %8.1f us\n",
+			fcHalfRaw.bytes, fcHalfRaw.reads, fcHalfRaw.us);
+	printf("  scaled at run time, .px2:      %6lu bytes %6lu reads %8.1f us\n",
+			fcHalfPacked.bytes, fcHalfPacked.reads, fcHalfPacked.us);
+	printf("  half size .px files, strip:    %6lu bytes %6lu reads %8.1f us\n",
+			fcRaw.bytes, fcRaw.reads, fcRaw.us);
+	printf("  half size .px2 files, strip:   %6lu bytes %6lu reads %8.1f us\n",
+			fcPacked.bytes, fcPacked.reads, fcPacked.us);
+	return 0;
+}
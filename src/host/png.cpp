@@ -0,0 +1,158 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file png.cpp
+ * Minimal PNG writer
+ * Image data is stored with uncompressed deflate blocks, so the output is
+ * fully deterministic and golden images can be compared byte by byte.
+ */
+#include <stdio.h>
+#include <vector>
+#include "png.h"
+
+/** Maximum size of a stored deflate block */
+#define DEFLATE_MAX_BLOCK 65535
+
+/**
+ * Update a CRC-32 (IEEE 802.3)
+ * @param [in] crc Current CRC (0 for a new one)
+ * @param [in] data Data
+ * @param [in] len Data length
+ * @return uint32_t Updated CRC
+ */
+uint32_t crc32Update(uint32_t crc, const uint8_t *data, size_t len)
+{
+	static uint32_t table[256];
+	static bool init = false;
+	uint32_t c;
+	int i, k;
+
+	if (!init) {
+		for (i = 0; i < 256; i++) {
+			c = i;
+			for (k = 0; k < 8; k++)
+				c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+			table[i] = c;
+		}
+		init = true;
+	}
+
+	crc = ~crc;
+	while (len--)
+		crc = table[(crc ^ *data++) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+static void put32(std::vector<uint8_t>& v, uint32_t n)
+{
+	v.push_back(n >> 24);
+	v.push_back(n >> 16);
+	v.push_back(n >> 8);
+	v.push_back(n);
+}
+
+static void writeChunk(FILE *fp, const char *type, const std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> chunk;
+	uint32_t crc;
+
+	put32(chunk, data.size());
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	crc = crc32Update(0, &chunk[4], chunk.size() - 4);
+	put32(chunk, crc);
+	fwrite(&chunk[0], 1, chunk.size(), fp);
+}
+
+/**
+ * Write a RGB888 image as a PNG file
+ * @param [in] file File name
+ * @param [in] width Image width
+ * @param [in] height Image height
+ * @param [in] rgb Pixels (3 bytes per pixel, row major)
+ * @return bool true on success
+ */
+bool pngWrite(const char *file, int width, int height, const uint8_t *rgb)
+{
+	static const uint8_t signature[8] = {
+		0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'
+	};
+	std::vector<uint8_t> raw, hdr, idat;
+	uint32_t a = 1, b = 0;
+	size_t pos, len;
+	int y;
+	FILE *fp;
+
+	// Scanlines, filter type 0
+	for (y = 0; y < height; y++) {
+		raw.push_back(0);
+		raw.insert(raw.end(), rgb + y * width * 3, rgb + (y + 1) * width * 3);
+	}
+
+	// Header: 8 bits RGB, no interlace
+	put32(hdr, width);
+	put32(hdr, height);
+	hdr.push_back(8);
+	hdr.push_back(2);
+	hdr.push_back(0);
+	hdr.push_back(0);
+	hdr.push_back(0);
+
+	// zlib stream with stored blocks
+	idat.push_back(0x78);
+	idat.push_back(0x01);
+	for (pos = 0; pos < raw.size(); pos += len) {
+		len = raw.size() - pos;
+		if (len > DEFLATE_MAX_BLOCK)
+			len = DEFLATE_MAX_BLOCK;
+		idat.push_back((pos + len) == raw.size() ? 1 : 0);
+		idat.push_back(len & 0xff);
+		idat.push_back(len >> 8);
+		idat.push_back(~len & 0xff);
+		idat.push_back((~len >> 8) & 0xff);
+		idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + len);
+	}
+	for (pos = 0; pos < raw.size(); pos++) {
+		a = (a + raw[pos]) % 65521;
+		b = (b + a) % 65521;
+	}
+	put32(idat, (b << 16) | a);
+
+	fp = fopen(file, "wb");
+	if (!fp)
+		return false;
+	fwrite(signature, 1, sizeof(signature), fp);
+	writeChunk(fp, "IHDR", hdr);
+	writeChunk(fp, "IDAT", idat);
+	writeChunk(fp, "IEND", std::vector<uint8_t>());
+	fclose(fp);
+	return true;
+}
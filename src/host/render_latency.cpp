@@ -0,0 +1,446 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file render_latency.cpp
+ * Measure the clock update latency of two ways of sharing the screen between
+ * the firmware tasks, replaying the same one minute workload:
+ *
+ *  - mutex: each task draws while holding the screen mutex, as the firmware
+ *    did before the render queue (the radio and WiFi blinks hold it across
+ *    delay()). The clock task has the highest priority, so it gets the mutex
+ *    as soon as the current holder releases it.
+ *  - queue: tasks post updates to ERenderQueue and the render task draws
+ *    them (same loop as taskRender() in main.ino).
+ *
+ * Time is virtual: only delay() and the emulated SPI transfers count (CPU
+ * time of the ESP32 is not modeled). Latency is the time from the clock tick
+ * to the seconds being drawn.
+ */
+#include <unistd.h>
+#include <getopt.h>
+#include <string>
+#include <vector>
+#include <FS.h>
+#include <SPI.h>
+#include "wstation.h"
+#include "ETheme.h"
+#include "EInterface.h"
+#include "ERenderQueue.h"
+#include "ILI9341Emu.h"
+
+/** Default file system root */
+#define DEF_FSROOT "../fsroot"
+/** Workload duration (ms) */
+#define DURATION 60000
+
+/** Workload events */
+typedef enum _event_type {
+	EV_CLOCK,
+	EV_WIFI,
+	EV_INDOOR,
+	EV_OUTDOOR,
+	EV_RADIO,
+	EV_FORECAST,
+	EV_WIFI_BLINK
+} event_type_t;
+
+/** Workload event */
+typedef struct _event {
+	/** Time (ms) */
+	unsigned long time;
+	/** Type */
+	event_type_t type;
+	/** Priority of the task that handles the event (mutex model) */
+	int priority;
+} event_t;
+
+/** Latency results */
+typedef struct _result {
+	/** Clock ticks drawn */
+	unsigned long ticks;
+	/** Worst latency (us) */
+	unsigned long maxUs;
+	/** Total latency (us) */
+	unsigned long long totalUs;
+} result_t;
+
+/** Panel */
+static ILI9341Emu panel(TFT_CS, TFT_DC);
+/** Color theme */
+static ETheme colorTheme;
+/** Start of the workload (us) */
+static unsigned long start;
+
+/**
+ * Build the workload (sorted by time)
+ *
+ * Clock ticks every second, WiFi status every second (loop()), indoor sensor
+ * every 10 s, outdoor sensor every 5 s, radio data received four times, a
+ * forecast update and a WiFi reconnection.
+ *
+ * @param [out] events Events
+ */
+static void workload(std::vector<event_t>& events)
+{
+	static const unsigned long radio[] = {4950, 16800, 38010, 55500};
+	unsigned long t;
+	size_t i;
+
+	for (t = 0; t < DURATION; t += 1000) {
+		events.push_back({t, EV_CLOCK, 2});
+		events.push_back({t + 500, EV_WIFI, 1});
+	}
+	for (t = 3300; t < DURATION; t += 10000)
+		events.push_back({t, EV_INDOOR, 0});
+	for (t = 2200; t < DURATION; t += SENSOR_DISPLAY_INTERVAL * 1000)
+		events.push_back({t, EV_OUTDOOR, 0});
+	for (i = 0; i < sizeof(radio) / sizeof(radio[0]); i++)
+		events.push_back({radio[i], EV_RADIO, 0});
+	events.push_back({12400, EV_FORECAST, 0});
+	events.push_back({42400, EV_FORECAST, 0});
+	events.push_back({30700, EV_WIFI_BLINK, 1});
+
+	std::stable_sort(events.begin(), events.end(),
+			[](const event_t& a, const event_t& b) {
+				return a.time < b.time;
+			});
+}
+
+/**
+ * Draw the initial screen
+ * @param [in] gui Embedded GUI
+ */
+static void mainScreen(EInterface *gui)
+{
+	gui->initialize();
+	gui->clearAll();
+	gui->setCity("Berlin");
+	gui->setDate("Wed, Jun 30, 2021");
+	gui->setIP("192.168.100.120");
+	gui->showWeather(CLOUDS_SCATTERED, 0);
+	gui->showWiFi(true);
+	gui->showAll();
+	gui->flush();
+}
+
+/**
+ * Time of an event (virtual us)
+ */
+static unsigned long eventTime(const event_t& e)
+{
+	return start + e.time * 1000;
+}
+
+/**
+ * Wait (virtual time) until a given time
+ * @param [in] t Time (us)
+ */
+static void waitUntil(unsigned long t)
+{
+	if ((long)(t - micros()) > 0)
+		delayMicroseconds(t - micros());
+}
+
+/**
+ * Handle an event drawing directly on the screen (mutex model)
+ * @param [in] gui Embedded GUI
+ * @param [in] e Event
+ * @param [in] n Event number
+ */
+static void drawEvent(EInterface *gui, const event_t& e, int n)
+{
+	int i;
+
+	switch (e.type) {
+		case EV_CLOCK:
+			gui->setHours(12 + e.time / 3600000);
+			gui->setMinutes((e.time / 60000) % 60);
+			gui->setSeconds((e.time / 1000) % 60);
+			break;
+		case EV_WIFI:
+			gui->showWiFi(true);
+			gui->setIP("192.168.100.120");
+			break;
+		case EV_INDOOR:
+			gui->showTemp1(23.4 + n % 3);
+			gui->showHumidity1(47 + n % 5);
+			break;
+		case EV_OUTDOOR:
+			gui->showChannel(1 + n % 3);
+			gui->showTemp2(-3.5 + n % 7);
+			gui->showHumidity2(60 + n % 20);
+			break;
+		case EV_RADIO:
+			gui->showRadio(true);
+			gui->flush();
+			delay(RADIO_BLINK_TIME);
+			gui->showRadio(false);
+			break;
+		case EV_FORECAST:
+			gui->showWeather((weather_t)(RAIN_LIGHT + n % 3), 0);
+			for (i = 0; i < 3; i++) {
+				gui->showForecastLabel(i, (n + i) % 2 ? "Fri" : "Sat");
+				gui->showForecastTemp1(i, 10.0 - i - n % 2);
+				gui->showForecastTemp2(i, 15.5 - i + n % 2);
+				gui->showForecastWeather(i, (weather_t)(CLEAR_SKY + i + n % 2));
+			}
+			break;
+		case EV_WIFI_BLINK:
+			for (i = 0; i < WIFI_BLINK_PHASES; i++) {
+				gui->showWiFi((i % 2) == 0);
+				gui->flush();
+				delay(WIFI_BLINK_TIME);
+			}
+			break;
+	}
+	gui->flush();
+}
+
+/**
+ * Post an event to the render queue (queue model)
+ * @param [in] screen Render queue
+ * @param [in] e Event
+ * @param [in] n Event number
+ */
+static void postEvent(ERenderQueue *screen, const event_t& e, int n)
+{
+	int i;
+
+	switch (e.type) {
+		case EV_CLOCK:
+			screen->setHours(12 + e.time / 3600000);
+			screen->setMinutes((e.time / 60000) % 60);
+			screen->setSeconds((e.time / 1000) % 60);
+			break;
+		case EV_WIFI:
+			screen->showWiFi(true);
+			screen->setIP("192.168.100.120");
+			break;
+		case EV_INDOOR:
+			screen->showTemp1(23.4 + n % 3);
+			screen->showHumidity1(47 + n % 5);
+			break;
+		case EV_OUTDOOR:
+			screen->showChannel(1 + n % 3);
+			screen->showTemp2(-3.5 + n % 7);
+			screen->showHumidity2(60 + n % 20);
+			break;
+		case EV_RADIO:
+			screen->blinkRadio(1, RADIO_BLINK_TIME);
+			break;
+		case EV_FORECAST:
+			screen->showWeather((weather_t)(RAIN_LIGHT + n % 3), 0);
+			for (i = 0; i < 3; i++) {
+				screen->showForecastLabel(i, (n + i) % 2 ? "Fri" : "Sat");
+				screen->showForecastTemp1(i, 10.0 - i - n % 2);
+				screen->showForecastTemp2(i, 15.5 - i + n % 2);
+				screen->showForecastWeather(i,
+						(weather_t)(CLEAR_SKY + i + n % 2));
+			}
+			break;
+		case EV_WIFI_BLINK:
+			screen->blinkWiFi(WIFI_BLINK_PHASES, WIFI_BLINK_TIME);
+			break;
+	}
+}
+
+/**
+ * Record the latency of a clock tick
+ */
+static void addTick(result_t *res, unsigned long tick, unsigned long drawn)
+{
+	res->ticks++;
+	res->totalUs += drawn - tick;
+	if ((drawn - tick) > res->maxUs)
+		res->maxUs = drawn - tick;
+}
+
+/**
+ * Run the workload drawing under a shared mutex
+ * @param [in] gui Embedded GUI
+ * @param [in] events Workload
+ * @return result_t Clock latency
+ */
+static result_t runMutex(EInterface *gui, const std::vector<event_t>& events)
+{
+	result_t res = {0, 0, 0};
+	std::vector<bool> done(events.size(), false);
+	size_t i, next, left = events.size();
+	int pick;
+
+	while (left > 0) {
+		/* Highest priority task waiting for the mutex */
+		pick = -1;
+		next = events.size();
+		for (i = 0; i < events.size(); i++) {
+			if (done[i])
+				continue;
+			if (next == events.size())
+				next = i;
+			if ((long)(eventTime(events[i]) - micros()) > 0)
+				break;
+			if (pick < 0 || events[i].priority > events[pick].priority)
+				pick = i;
+		}
+		if (pick < 0) {
+			waitUntil(eventTime(events[next]));
+			continue;
+		}
+
+		drawEvent(gui, events[pick], pick);
+		if (events[pick].type == EV_CLOCK)
+			addTick(&res, eventTime(events[pick]), micros());
+		done[pick] = true;
+		left--;
+	}
+	return res;
+}
+
+/**
+ * Run the workload through the render queue
+ * @param [in] gui Embedded GUI
+ * @param [in] screen Render queue
+ * @param [in] events Workload
+ * @return result_t Clock latency
+ */
+static result_t runQueue(EInterface *gui, ERenderQueue *screen,
+		const std::vector<event_t>& events)
+{
+	result_t res = {0, 0, 0};
+	unsigned long wait = 0, last = 0, wake, tick = 0, drawn = 0;
+	bool notified = false, ticked = false;
+	size_t next = 0;
+
+	while (next < events.size() || screen->isPending()) {
+		/* Sleep until notified or the next blinking phase */
+		wake = micros() + wait * 1000;
+		if (!notified && next < events.size() &&
+				(long)(eventTime(events[next]) - wake) < 0)
+			wake = eventTime(events[next]);
+		if (!notified)
+			waitUntil(wake);
+
+		/* Bounded frame rate */
+		if ((micros() - last) < RENDER_FRAME_MS * 1000)
+			waitUntil(last + RENDER_FRAME_MS * 1000);
+		last = micros();
+
+		/* Updates posted up to now */
+		for (notified = false; next < events.size() &&
+				(long)(eventTime(events[next]) - micros()) <= 0; next++) {
+			postEvent(screen, events[next], next);
+			if (events[next].type == EV_CLOCK) {
+				tick   = eventTime(events[next]);
+				ticked = true;
+			}
+		}
+
+		wait = screen->render(gui);
+		if (ticked && screen->getDrawTime(ERenderQueue::RENDER_SECONDS) != drawn) {
+			drawn = screen->getDrawTime(ERenderQueue::RENDER_SECONDS);
+			addTick(&res, tick, drawn);
+			ticked = false;
+		}
+
+		/* Updates posted while drawing wake up the task right away */
+		notified = (next < events.size() &&
+				(long)(eventTime(events[next]) - micros()) <= 0);
+	}
+	return res;
+}
+
+/**
+ * Print a result
+ */
+static void printResult(const char *model, const result_t& res)
+{
+	printf("%-8s %6lu %10.1f %10.1f\n", model, res.ticks,
+			res.maxUs / 1000.0,
+			res.ticks ? res.totalUs / 1000.0 / res.ticks : 0.0);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Use: %s [-f fsroot]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+	std::string fsroot(DEF_FSROOT);
+	std::vector<event_t> events;
+	ERenderQueue screen;
+	EInterface *gui;
+	result_t mutexRes, queueRes;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "f:h")) != -1) {
+		switch (opt) {
+			case 'f':
+				fsroot = optarg;
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+
+	FS fsys(fsroot.c_str());
+	SPI.attach(&panel);
+	setPinListener(&panel);
+	setVirtualClock(true);
+	panel.setTimed(true);
+	workload(events);
+
+	gui = new EInterface(TFT_CS, TFT_DC, TFT_BACKLIGHT, BACKLIGHT_DEFAULT,
+			colorTheme, &fsys);
+	mainScreen(gui);
+	start = micros();
+	mutexRes = runMutex(gui, events);
+	delete gui;
+
+	gui = new EInterface(TFT_CS, TFT_DC, TFT_BACKLIGHT, BACKLIGHT_DEFAULT,
+			colorTheme, &fsys);
+	mainScreen(gui);
+	start = micros();
+	queueRes = runQueue(gui, &screen, events);
+	delete gui;
+
+	printf("Clock latency, %d s workload, SPI at %d MHz\n", DURATION / 1000,
+			TFT_SPI_FREQ / 1000000);
+	printf("%-8s %6s %10s %10s\n", "model", "ticks", "max_ms", "avg_ms");
+	printResult("mutex", mutexRes);
+	printResult("queue", queueRes);
+	printf("queue: %lu frames, %lu posted, %lu coalesced, %lu drawn, "
+			"%.1f ms longest frame\n", screen.getStats().frames,
+			screen.getStats().posted, screen.getStats().coalesced,
+			screen.getStats().drawn, screen.getStats().maxFrameUs / 1000.0);
+	return 0;
+}
@@ -0,0 +1,412 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file screenshot_bench.cpp
+ * Measure a screenshot sweep: the same number of screenshots as devices in
+ * a fleet, each one of a different screen, taken with EScreenEncoder as the
+ * /screenshot.png and /screenshot.bmp web services do, read in TCP segment
+ * sized chunks.
+ *
+ * Each source of pixels (full copy of the screen, partial copy, readback
+ * from the TFT module) and format is reported with the bytes sent, CPU time,
+ * bytes read from the TFT module, bus time and peak heap used during the
+ * screenshot. Every file is decoded and checked against the emulated panel.
+ */
+#include <unistd.h>
+#include <malloc.h>
+#include <getopt.h>
+#include <new>
+#include <string>
+#include <vector>
+#include <FS.h>
+#include <SPI.h>
+#include "wstation.h"
+#include "ETheme.h"
+#include "EInterface.h"
+#include "EScreenEncoder.h"
+#include "ILI9341Emu.h"
+#include "png.h"
+
+/** Default file system root */
+#define DEF_FSROOT "../fsroot"
+/** Default number of screenshots */
+#define DEF_DEVICES 20
+/** Bytes read per call (TCP MSS of the ESP32 lwIP) */
+#define DEF_CHUNK 1436
+
+/** Panel */
+static ILI9341Emu panel(TFT_CS, TFT_DC);
+/** Color theme */
+static ETheme colorTheme;
+/** Embedded GUI */
+static EInterface *gui = NULL;
+/** Heap in use (operator new) */
+static size_t heapUsed = 0;
+/** Highest heapUsed since the last reset */
+static size_t heapPeak = 0;
+
+/** Pixel sources */
+typedef struct _source {
+	/** Name */
+	const char *name;
+	/** Tiles of the screen copy (-1: all, 0: none) */
+	int tiles;
+} source_t;
+
+static const source_t sources[] = {
+	{"shadow",  -1},
+	{"partial", GUI_SHADOW_TILES},
+	{"readback", 0},
+};
+
+void *operator new(size_t size)
+{
+	void *p = malloc(size);
+
+	if (!p)
+		throw std::bad_alloc();
+	heapUsed += malloc_usable_size(p);
+	if (heapUsed > heapPeak)
+		heapPeak = heapUsed;
+	return p;
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void *p) noexcept
+{
+	if (!p)
+		return;
+	heapUsed -= malloc_usable_size(p);
+	free(p); // Allocated by operator new above
+}
+#pragma GCC diagnostic pop
+
+/**
+ * Screen reader of the encoder
+ */
+static bool readScreen(int16_t y, int16_t lines, uint16_t *buf, void *arg)
+{
+	return gui->readScreen(0, y, gui->getWidth(), lines, buf);
+}
+
+/**
+ * Draw the main screen, a different one for each device
+ * @param [in] n Device
+ */
+static void drawScreen(int n)
+{
+	gui->clearAll();
+	gui->setCity("Berlin");
+	gui->setDate("Wed, Jun 30, 2021");
+	gui->setIP("192.168.100.120");
+	gui->showWeather(CLOUDS_SCATTERED, 0);
+	gui->showTemp1(21.0 + n % 7);
+	gui->showHumidity1(40 + n % 30);
+	gui->showChannel(1 + n % 3);
+	gui->showTemp2(-3.5 + n % 11);
+	gui->showHumidity2(82 - n % 20);
+	gui->showWiFi(true);
+	gui->setHours(n % 24);
+	gui->setMinutes(n % 60);
+	gui->setSeconds((n * 7) % 60);
+	gui->showAll();
+	gui->flush();
+}
+
+/**
+ * Expand a RGB565 pixel to RGB888 (bit replication, as EScreenEncoder)
+ */
+static void rgb888(uint16_t c, uint8_t *rgb)
+{
+	uint8_t r = c >> 11, g = (c >> 5) & 0x3f, b = c & 0x1f;
+
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+static uint32_t get32be(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static uint32_t get32le(const uint8_t *p)
+{
+	return ((uint32_t)p[3] << 24) | (p[2] << 16) | (p[1] << 8) | p[0];
+}
+
+/**
+ * Check a PNG file against the panel: chunk CRCs, stored deflate blocks,
+ * Adler-32 and pixels
+ * @param [in] f File
+ * @return const char* Error or NULL
+ */
+static const char *checkPNG(const std::vector<uint8_t>& f)
+{
+	static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	std::vector<uint8_t> z, raw;
+	uint32_t len, a = 1, b = 0;
+	size_t pos = 8, i;
+	int x, y, w = 0, h = 0;
+	uint8_t rgb[3];
+	bool end = false, final = false;
+
+	if (f.size() < 8 || memcmp(&f[0], sig, 8))
+		return "bad signature";
+	while (!end) {
+		if (pos + 12 > f.size())
+			return "truncated";
+		len = get32be(&f[pos]);
+		if (pos + 12 + len > f.size())
+			return "truncated chunk";
+		if (crc32Update(0, &f[pos + 4], len + 4) !=
+				get32be(&f[pos + 8 + len]))
+			return "bad chunk CRC";
+		if (!memcmp(&f[pos + 4], "IHDR", 4)) {
+			w = get32be(&f[pos + 8]);
+			h = get32be(&f[pos + 12]);
+			if (f[pos + 16] != 8 || f[pos + 17] != 2)
+				return "not RGB888";
+		} else if (!memcmp(&f[pos + 4], "IDAT", 4)) {
+			z.insert(z.end(), &f[pos + 8], &f[pos + 8 + len]);
+		} else if (!memcmp(&f[pos + 4], "IEND", 4)) {
+			end = true;
+		}
+		pos += 12 + len;
+	}
+	if (pos != f.size())
+		return "data after IEND";
+	if (w != panel.width() || h != panel.height())
+		return "bad size";
+	if (z.size() < 6 || ((z[0] << 8) | z[1]) % 31 || (z[0] & 0x0f) != 8)
+		return "bad zlib header";
+
+	for (pos = 2; !final; ) {
+		if (pos + 5 > z.size() || (z[pos] & 0x06))
+			return "not a stored block";
+		final = z[pos] & 1;
+		len = z[pos + 1] | (z[pos + 2] << 8);
+		if ((len ^ 0xffff) != (uint32_t)(z[pos + 3] | (z[pos + 4] << 8)))
+			return "bad stored block length";
+		pos += 5;
+		if (pos + len > z.size())
+			return "truncated block";
+		raw.insert(raw.end(), &z[pos], &z[pos + len]);
+		pos += len;
+	}
+	for (i = 0; i < raw.size(); i++) {
+		a = (a + raw[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+	if (pos + 4 != z.size() || get32be(&z[pos]) != ((b << 16) | a))
+		return "bad Adler-32";
+
+	if (raw.size() != (size_t)h * (1 + 3 * w))
+		return "bad image data size";
+	for (y = 0; y < h; y++) {
+		const uint8_t *p = &raw[y * (1 + 3 * w)];
+		if (*p++ != 0)
+			return "unexpected filter";
+		for (x = 0; x < w; x++, p += 3) {
+			rgb888(panel.getPixel(x, y), rgb);
+			if (memcmp(p, rgb, 3))
+				return "pixels differ";
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Check a BMP file against the panel
+ * @param [in] f File
+ * @return const char* Error or NULL
+ */
+static const char *checkBMP(const std::vector<uint8_t>& f)
+{
+	uint32_t offset, stride;
+	int x, y, w, h;
+
+	if (f.size() < 66 || f[0] != 'B' || f[1] != 'M' ||
+			get32le(&f[2]) != f.size())
+		return "bad file header";
+	offset = get32le(&f[10]);
+	w = get32le(&f[18]);
+	h = -(int32_t)get32le(&f[22]);
+	if (w != panel.width() || h != panel.height())
+		return "bad size (top-down expected)";
+	if ((f[28] | (f[29] << 8)) != 16 || get32le(&f[30]) != 3 ||
+			get32le(&f[54]) != 0xf800 || get32le(&f[58]) != 0x07e0 ||
+			get32le(&f[62]) != 0x001f)
+		return "not RGB565";
+	stride = (w * 2 + 3) & ~3;
+	if (offset + stride * h != f.size())
+		return "bad image size";
+	for (y = 0; y < h; y++) {
+		for (x = 0; x < w; x++) {
+			const uint8_t *p = &f[offset + y * stride + x * 2];
+			if ((p[0] | (p[1] << 8)) != panel.getPixel(x, y))
+				return "pixels differ";
+		}
+	}
+	return NULL;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Use: %s [-f fsroot] [-n devices] [-c chunk] "
+			"[-o output_dir]\n", prog);
+	fprintf(stderr, "  -f  File system root (default: " DEF_FSROOT ")\n");
+	fprintf(stderr, "  -n  Screenshots in the sweep (default: %d)\n",
+			DEF_DEVICES);
+	fprintf(stderr, "  -c  Bytes read at a time (default: %d)\n", DEF_CHUNK);
+	fprintf(stderr, "  -o  Save the last screenshot of each run\n");
+}
+
+int main(int argc, char **argv)
+{
+	static const EScreenEncoder::screen_format_t formats[] = {
+		EScreenEncoder::SCREEN_PNG, EScreenEncoder::SCREEN_BMP
+	};
+	std::string fsroot(DEF_FSROOT), outdir;
+	std::vector<uint8_t> file, chunk;
+	unsigned long t0, cpuUs, rdBytes, chunks;
+	size_t s, f, n, base, peak, mem = 0;
+	double busUs;
+	int opt, dev, devices = DEF_DEVICES, chunkSize = DEF_CHUNK, fails = 0;
+	const char *err;
+
+	while ((opt = getopt(argc, argv, "f:n:c:o:h")) != -1) {
+		switch (opt) {
+			case 'f':
+				fsroot = optarg;
+				break;
+			case 'n':
+				devices = atoi(optarg);
+				break;
+			case 'c':
+				chunkSize = atoi(optarg);
+				break;
+			case 'o':
+				outdir = optarg;
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (devices <= 0 || chunkSize <= 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	FS fsys(fsroot.c_str());
+	SPI.attach(&panel);
+	setPinListener(&panel);
+	gui = new EInterface(TFT_CS, TFT_DC, TFT_BACKLIGHT, BACKLIGHT_DEFAULT,
+			colorTheme, &fsys);
+	gui->initialize();
+	chunk.resize(chunkSize);
+	file.reserve(1 << 20); // Not part of the screenshot heap
+
+	printf("%d screenshots, %d bytes per read\n", devices, chunkSize);
+	printf("%-9s %-6s %8s %7s %9s %9s %9s %9s %6s\n", "source", "format",
+			"bytes", "chunks", "cpu_us", "rd_bytes", "bus_us", "heap_peak",
+			"check");
+
+	for (s = 0; s < sizeof(sources) / sizeof(sources[0]); s++) {
+		gui->setShadow(sources[s].tiles);
+		for (f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+			cpuUs   = 0;
+			rdBytes = 0;
+			chunks  = 0;
+			busUs   = 0;
+			peak    = 0;
+			err     = NULL;
+			for (dev = 0; dev < devices; dev++) {
+				drawScreen(dev);
+				file.clear();
+				panel.resetStats();
+				base     = heapUsed;
+				heapPeak = heapUsed;
+
+				t0 = micros();
+				EScreenEncoder *enc = new EScreenEncoder(formats[f],
+						gui->getWidth(), gui->getHeight(), readScreen, NULL);
+				while ((n = enc->read(&chunk[0], chunk.size())) > 0) {
+					file.insert(file.end(), chunk.begin(), chunk.begin() + n);
+					chunks++;
+				}
+				if (file.size() != enc->getSize() || enc->getErrors())
+					err = "bad size";
+				mem = enc->getMemoryUsage();
+				delete enc;
+				cpuUs += micros() - t0;
+
+				if (heapPeak - base > peak)
+					peak = heapPeak - base;
+				rdBytes += panel.stats().bytes;
+				busUs   += panel.stats().busTime;
+				if (!err) {
+					err = (formats[f] == EScreenEncoder::SCREEN_PNG) ?
+						checkPNG(file) : checkBMP(file);
+				}
+			}
+			printf("%-9s %-6s %8zu %7lu %9lu %9lu %9.0f %9zu %6s\n",
+					sources[s].name, (f == 0) ? "png" : "bmp", file.size(),
+					chunks / devices, cpuUs / devices, rdBytes / devices,
+					busUs / devices, peak, err ? "FAIL" : "ok");
+			if (err) {
+				fprintf(stderr, "%s %s: %s\n", sources[s].name,
+						(f == 0) ? "png" : "bmp", err);
+				fails++;
+			}
+			if (!outdir.empty()) {
+				std::string name = outdir + "/screenshot_" +
+					sources[s].name + ((f == 0) ? ".png" : ".bmp");
+				FILE *fp = fopen(name.c_str(), "wb");
+				if (!fp || fwrite(&file[0], 1, file.size(), fp) !=
+						file.size()) {
+					fprintf(stderr, "Cannot write %s\n", name.c_str());
+					fails++;
+				}
+				if (fp)
+					fclose(fp);
+			}
+		}
+	}
+	printf("encoder memory: %zu bytes (strip of %d lines and one line)\n",
+			mem, SCREEN_STRIP_LINES);
+
+	delete gui;
+	return fails ? 1 : 0;
+}
@@ -0,0 +1,350 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file text_bench.cpp
+ * Check EFontMetrics against Adafruit_GFX::getTextBounds and compare their
+ * cost. Strings known at compile time are measured by the compiler (the
+ * results are checked here), dynamic strings by the flat metrics table.
+ *
+ * Also compare the SPI traffic of print() on the TFT module: glyphs drawn as
+ * spans (Adafruit_GFX::drawChar) against the original per-pixel rasterizer.
+ */
+#include <unistd.h>
+#include <stdlib.h>
+#include <vector>
+#include <SPI.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_ILI9341.h>
+#include <Fonts/FreeSansBold12pt7b.h>
+#include <Fonts/FreeSansBold18pt7b.h>
+#include <Fonts/FreeSans9pt7b.h>
+#include <Fonts/FreeMono9pt7b.h>
+#include "wstation.h"
+#include "EFontMetrics.h"
+#include "ILI9341Emu.h"
+
+/** Screen width (portrait) */
+#define SCREEN_W 240
+/** Screen height (portrait) */
+#define SCREEN_H 320
+/** Default number of random strings */
+#define DEF_STRINGS 20000
+
+/** Font under test */
+typedef struct _font {
+	/** Name */
+	const char *name;
+	/** Font */
+	const GFXfont *font;
+} font_t;
+
+/** Literal string measured at compile time */
+typedef struct _literal {
+	/** Font */
+	const GFXfont *font;
+	/** String */
+	const char *str;
+	/** Bounds (compile time) */
+	EFontMetrics::bounds_t bounds;
+} literal_t;
+
+#define LITERAL(font, str) {&font, str, EFontMetrics::textBounds(font, str)}
+
+static const font_t fonts[] = {
+	{"FreeSans9pt7b",      &FreeSans9pt7b},
+	{"FreeSansBold12pt7b", &FreeSansBold12pt7b},
+	{"FreeSansBold18pt7b", &FreeSansBold18pt7b},
+	{"FreeMono9pt7b",      &FreeMono9pt7b},
+};
+
+/** Background areas of EInterface */
+static constexpr literal_t literals[] = {
+	LITERAL(FreeMono9pt7b,      "000.000.000.000"),
+	LITERAL(FreeSans9pt7b,      "Ap"),
+	LITERAL(FreeSans9pt7b,      "000"),
+	LITERAL(FreeSans9pt7b,      "AAA"),
+	LITERAL(FreeMono9pt7b,      WSTATION_VERSION),
+	LITERAL(FreeSansBold18pt7b, "-000.0 C"),
+	LITERAL(FreeSans9pt7b,      "-000.0 C"),
+	LITERAL(FreeSansBold18pt7b, "000%"),
+	LITERAL(FreeSans9pt7b,      " "),
+	LITERAL(FreeSans9pt7b,      ""),
+};
+
+static_assert(EFontMetrics::textAdvance(FreeSans9pt7b, "000") ==
+		3 * EFontMetrics::advance(FreeSans9pt7b, '0'), "advance");
+
+/** Dynamic string */
+typedef struct _sample {
+	/** String */
+	char str[16];
+	/** Cursor position (X axis) */
+	int16_t x;
+	/** Cursor position (Y axis) */
+	int16_t y;
+} sample_t;
+
+/** Strings printed with FreeSansBold18pt7b (clock, temperature, humidity) */
+static const char *printStrings[] = {"12:34", "-12.5  C", "100%"};
+
+/** Panel */
+static ILI9341Emu panel(TFT_CS, TFT_DC);
+
+/** Characters of the random strings */
+static const char charset[] = "0123456789.-:% CFapmABCDEFGHIJKLMNOPQRSTUVWXYZ"
+	"abcdefghijklmnopqrstuvwxyz,";
+
+/**
+ * Fill a random string
+ * @param [out] str String
+ * @param [in] max Maximum length
+ */
+static void randomString(char *str, int max)
+{
+	int i, len = 1 + rand() % max;
+
+	for (i = 0; i < len; i++)
+		str[i] = charset[rand() % (sizeof(charset) - 1)];
+	str[len] = '\0';
+}
+
+/**
+ * Print a string drawing each set bit of the glyphs with writePixel(), as
+ * Adafruit_GFX::drawChar() did for custom fonts
+ * @param [in] tft TFT module
+ * @param [in] font Font
+ * @param [in] x Cursor position (X axis)
+ * @param [in] y Cursor position (Y axis, baseline)
+ * @param [in] str String
+ * @param [in] color Color
+ */
+static void printPixels(Adafruit_ILI9341 *tft, const GFXfont *font,
+		int16_t x, int16_t y, const char *str, uint16_t color)
+{
+	const GFXglyph *glyph;
+	uint16_t bo;
+	uint8_t xx, yy, bits = 0, bit = 0;
+
+	for (; *str; str++) {
+		glyph = &font->glyph[(uint8_t)*str - font->first];
+		bo    = glyph->bitmapOffset;
+		bit   = 0;
+		tft->startWrite();
+		for (yy = 0; yy < glyph->height; yy++) {
+			for (xx = 0; xx < glyph->width; xx++) {
+				if (!(bit++ & 7))
+					bits = font->bitmap[bo++];
+				if (bits & 0x80)
+					tft->writePixel(x + glyph->xOffset + xx,
+							y + glyph->yOffset + yy, color);
+				bits <<= 1;
+			}
+		}
+		tft->endWrite();
+		x += glyph->xAdvance;
+	}
+}
+
+/**
+ * Print the SPI traffic of a print() call
+ * @param [in] mode Rasterizer
+ * @param [in] str String
+ */
+static void printTraffic(const char *mode, const char *str)
+{
+	const emu_stats_t& st = panel.stats();
+
+	printf("%-10s %-10s %8lu %8lu %9lu %8.0f %08x\n", mode, str,
+			st.transactions, st.addrWindows, st.bytes, st.busTime,
+			panel.checksum());
+}
+
+/**
+ * Compare the SPI traffic of print() with both glyph rasterizers
+ * @return int Number of strings drawn differently
+ */
+static int glyphTraffic(void)
+{
+	Adafruit_ILI9341 tft(TFT_CS, TFT_DC);
+	uint32_t crc;
+	size_t i;
+	int fails = 0;
+
+	SPI.attach(&panel);
+	setPinListener(&panel);
+	tft.begin(TFT_SPI_FREQ);
+	tft.setFont(&FreeSansBold18pt7b);
+
+	printf("\nprint() with FreeSansBold18pt7b, SPI at %d MHz\n",
+			TFT_SPI_FREQ / 1000000);
+	printf("%-10s %-10s %8s %8s %9s %8s %8s\n", "glyphs", "string",
+			"trans", "windows", "spi_bytes", "bus_us", "crc32");
+
+	for (i = 0; i < sizeof(printStrings) / sizeof(printStrings[0]); i++) {
+		tft.fillScreen(ILI9341_BLACK);
+		panel.resetStats();
+		printPixels(&tft, &FreeSansBold18pt7b, 20, 100, printStrings[i],
+				ILI9341_WHITE);
+		printTraffic("pixels", printStrings[i]);
+		crc = panel.checksum();
+
+		tft.fillScreen(ILI9341_BLACK);
+		panel.resetStats();
+		tft.setTextColor(ILI9341_WHITE);
+		tft.setCursor(20, 100);
+		tft.print(printStrings[i]);
+		printTraffic("spans", printStrings[i]);
+		if (panel.checksum() != crc) {
+			fprintf(stderr, "\"%s\" differs from the per-pixel "
+					"rasterizer\n", printStrings[i]);
+			fails++;
+		}
+
+		tft.fillScreen(ILI9341_BLACK);
+		panel.resetStats();
+		tft.setTextColor(ILI9341_WHITE, ILI9341_BLACK);
+		tft.setCursor(20, 100);
+		tft.print(printStrings[i]);
+		printTraffic("opaque", printStrings[i]);
+		if (panel.checksum() != crc) {
+			fprintf(stderr, "\"%s\" (opaque) differs from the per-pixel "
+					"rasterizer\n", printStrings[i]);
+			fails++;
+		}
+	}
+	return fails;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Use: %s [-n strings]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+	GFXcanvas1 screen(SCREEN_W, SCREEN_H);
+	std::vector<sample_t> samples;
+	std::vector<bool> fast;
+	int16_t x1, y1, fx1, fy1;
+	uint16_t w, h, fw, fh;
+	unsigned long t0, tref, tfast, fallbacks;
+	int opt, strings = DEF_STRINGS, fails = 0;
+	size_t i, f, n;
+
+	while ((opt = getopt(argc, argv, "n:h")) != -1) {
+		switch (opt) {
+			case 'n':
+				strings = atoi(optarg);
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+
+	/* Compile time metrics */
+	for (i = 0; i < sizeof(literals) / sizeof(literals[0]); i++) {
+		screen.setFont(literals[i].font);
+		screen.getTextBounds(literals[i].str, 50, 100, &x1, &y1, &w, &h);
+		EFontMetrics::place(literals[i].bounds, 50, 100, &fx1, &fy1,
+				&fw, &fh);
+		if (x1 != fx1 || y1 != fy1 || w != fw || h != fh) {
+			fprintf(stderr, "Literal \"%s\": %d,%d %ux%u (expected "
+					"%d,%d %ux%u)\n", literals[i].str, fx1, fy1, fw, fh,
+					x1, y1, w, h);
+			fails++;
+		}
+	}
+	printf("literals: %u checked, %d failed\n",
+			(unsigned)(sizeof(literals) / sizeof(literals[0])), fails);
+
+	/* Dynamic strings */
+	srand(1);
+	samples.resize(strings);
+	fast.resize(strings);
+	for (n = 0; n < samples.size(); n++) {
+		randomString(samples[n].str, sizeof(samples[n].str) - 1);
+		samples[n].x = rand() % (SCREEN_W / 2);
+		samples[n].y = rand() % SCREEN_H;
+	}
+
+	printf("%-20s %8s %9s %10s %10s %8s\n", "font", "strings",
+			"fallbacks", "gfx_ns", "table_ns", "speedup");
+
+	for (f = 0; f < sizeof(fonts) / sizeof(fonts[0]); f++) {
+		EFontMetrics metrics(fonts[f].font);
+		screen.setFont(fonts[f].font);
+
+		t0 = micros();
+		for (n = 0; n < samples.size(); n++)
+			screen.getTextBounds(samples[n].str, samples[n].x,
+					samples[n].y, &x1, &y1, &w, &h);
+		tref = micros() - t0;
+
+		t0 = micros();
+		for (n = 0; n < samples.size(); n++)
+			fast[n] = metrics.getTextBounds(samples[n].str, samples[n].x,
+					samples[n].y, SCREEN_W, SCREEN_H, &fx1, &fy1, &fw, &fh);
+		tfast = micros() - t0;
+
+		/* Same results as Adafruit_GFX when the text does not wrap */
+		fallbacks = 0;
+		for (n = 0; n < samples.size(); n++) {
+			if (!fast[n]) {
+				fallbacks++;
+				continue;
+			}
+			screen.getTextBounds(samples[n].str, samples[n].x,
+					samples[n].y, &x1, &y1, &w, &h);
+			metrics.getTextBounds(samples[n].str, samples[n].x,
+					samples[n].y, SCREEN_W, SCREEN_H, &fx1, &fy1, &fw, &fh);
+			if ((x1 != fx1 || y1 != fy1 || w != fw || h != fh) &&
+					fails++ < 10) {
+				fprintf(stderr, "%s \"%s\" at %d,%d: %d,%d %ux%u "
+						"(expected %d,%d %ux%u)\n", fonts[f].name,
+						samples[n].str, samples[n].x, samples[n].y,
+						fx1, fy1, fw, fh, x1, y1, w, h);
+			}
+		}
+
+		printf("%-20s %8lu %9lu %10.1f %10.1f %7.1fx\n", fonts[f].name,
+				(unsigned long)samples.size(), fallbacks,
+				1000.0 * tref / samples.size(),
+				1000.0 * tfast / samples.size(),
+				tfast ? (double)tref / tfast : 0.0);
+	}
+
+	fails += glyphTraffic();
+
+	if (fails)
+		fprintf(stderr, "%d mismatches\n", fails);
+	return fails ? 1 : 0;
+}
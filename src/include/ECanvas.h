@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file ECanvas.h
+ * \see ECanvas.cpp
+ */
+#ifndef __ECANVAS_H__
+#define __ECANVAS_H__
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_SPITFT.h>
+
+/** Number of canvases in the pool */
+#define CANVAS_POOL_SIZE   2
+/** Maximum number of pixels of each canvas (largest widget: 130x27) */
+#define CANVAS_POOL_PIXELS 3600
+
+/**
+ * Off-screen 16 bits canvas with a fixed capacity that can be reshaped
+ * to any size that fits on it
+ */
+class ECanvas : public GFXcanvas16 {
+	private:
+		/** Capacity (in pixels) */
+		uint32_t capacity;
+		/** Canvas in use */
+		bool busy;
+
+		friend class ECanvasPool;
+
+	public:
+		/* Constructor */
+		ECanvas(uint32_t capacity);
+
+		/* Reshape the canvas */
+		bool reshape(uint16_t w, uint16_t h);
+
+		/* Send the canvas to the screen */
+		void push(Adafruit_SPITFT *tft, int16_t x, int16_t y);
+};
+
+/**
+ * Fixed pool of scratch canvases
+ */
+class ECanvasPool {
+	private:
+		/** Canvases */
+		ECanvas *canvas[CANVAS_POOL_SIZE];
+
+	public:
+		/* Constructor */
+		ECanvasPool();
+
+		/* Destructor */
+		~ECanvasPool();
+
+		/* Get a free canvas */
+		ECanvas *acquire(uint16_t w, uint16_t h);
+
+		/* Give back a canvas to the pool */
+		void release(ECanvas *c);
+};
+#endif /* __ECANVAS_H__ */
@@ -0,0 +1,241 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EFontMetrics.h
+ * \see EFontMetrics.cpp
+ */
+#ifndef __EFONTMETRICS_H__
+#define __EFONTMETRICS_H__
+
+#include <Arduino.h>
+#include <gfxfont.h>
+
+/**
+ * Text metrics of a GFX font
+ *
+ * The static functions are constexpr and read the glyph table of the font
+ * (which must be declared constexpr), so strings known at compile time are
+ * measured by the compiler. Dynamic strings are measured by an instance,
+ * which keeps a flat table with the advance and the bounding box of each
+ * character. Both follow Adafruit_GFX::getTextBounds (text size 1) for a
+ * single line of text that does not wrap.
+ */
+class EFontMetrics {
+	public:
+		/** Bounds of a text, relative to the cursor position */
+		typedef struct _bounds {
+			/** Top left corner (X axis) */
+			int16_t x1;
+			/** Top left corner (Y axis) */
+			int16_t y1;
+			/** Width */
+			uint16_t w;
+			/** Height */
+			uint16_t h;
+		} bounds_t;
+
+		/**
+		 * Check if a character is present in a font
+		 * @param [in] font Font
+		 * @param [in] c Character
+		 */
+		static constexpr bool hasGlyph(const GFXfont& font, char c)
+		{
+			return (c >= font.first && c <= font.last);
+		}
+
+		/**
+		 * Get the glyph of a character (must be present in the font)
+		 * @param [in] font Font
+		 * @param [in] c Character
+		 */
+		static constexpr const GFXglyph& glyph(const GFXfont& font, char c)
+		{
+			return font.glyph[(uint8_t)c - font.first];
+		}
+
+		/**
+		 * Get the advance of a character (cursor displacement)
+		 * @param [in] font Font
+		 * @param [in] c Character
+		 */
+		static constexpr int16_t advance(const GFXfont& font, char c)
+		{
+			return hasGlyph(font, c) ? glyph(font, c).xAdvance : 0;
+		}
+
+		/**
+		 * Get the bounds of a character, relative to the cursor position
+		 * @param [in] font Font
+		 * @param [in] c Character (must be present in the font)
+		 */
+		static constexpr bounds_t glyphBounds(const GFXfont& font, char c)
+		{
+			return {glyph(font, c).xOffset, glyph(font, c).yOffset,
+				glyph(font, c).width, glyph(font, c).height};
+		}
+
+		/**
+		 * Get the width of a string (sum of the advances)
+		 * @param [in] font Font
+		 * @param [in] str String
+		 */
+		static constexpr int16_t textAdvance(const GFXfont& font,
+				const char *str)
+		{
+			return *str ? advance(font, *str) + textAdvance(font, str + 1) : 0;
+		}
+
+		/**
+		 * Get the bounds of a string, relative to the cursor position
+		 * @param [in] font Font
+		 * @param [in] str String
+		 */
+		static constexpr bounds_t textBounds(const GFXfont& font,
+				const char *str)
+		{
+			return makeBounds(minLeft(font, str, 0), minTop(font, str),
+					maxRight(font, str, 0), maxBottom(font, str));
+		}
+
+		/**
+		 * Place bounds at a cursor position
+		 * @param [in] b Bounds (relative to the cursor)
+		 * @param [in] x Cursor position (X axis)
+		 * @param [in] y Cursor position (Y axis)
+		 * @param [out] x1 Top left corner (X axis)
+		 * @param [out] y1 Top left corner (Y axis)
+		 * @param [out] w Width
+		 * @param [out] h Height
+		 */
+		static void place(const bounds_t& b, int16_t x, int16_t y,
+				int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h)
+		{
+			*x1 = x + b.x1;
+			*y1 = y + b.y1;
+			*w  = b.w;
+			*h  = b.h;
+		}
+
+		/* Constructor */
+		EFontMetrics(const GFXfont *font);
+
+		/* Destructor */
+		~EFontMetrics();
+
+		/* Get the font */
+		const GFXfont *getFont();
+
+		/* Get the bounds of a string */
+		bool getTextBounds(const char *str, int16_t x, int16_t y,
+				int16_t width, int16_t height, int16_t *x1, int16_t *y1,
+				uint16_t *w, uint16_t *h);
+
+	private:
+		/** Flat metrics of a character */
+		typedef struct _metrics {
+			/** Advance */
+			uint8_t advance;
+			/** Left column (relative to the cursor) */
+			int8_t left;
+			/** Top row (relative to the baseline) */
+			int8_t top;
+			/** Right column (relative to the cursor) */
+			int8_t right;
+			/** Bottom row (relative to the baseline) */
+			int8_t bottom;
+		} metrics_t;
+		/** Font */
+		const GFXfont *font;
+		/** Metrics, indexed by character - first */
+		metrics_t *table;
+		/** First character */
+		uint8_t first;
+		/** Last character */
+		uint8_t last;
+		/** Newline distance */
+		uint8_t yAdvance;
+
+		static constexpr int16_t min(int16_t a, int16_t b)
+		{
+			return (a < b) ? a : b;
+		}
+
+		static constexpr int16_t max(int16_t a, int16_t b)
+		{
+			return (a > b) ? a : b;
+		}
+
+		static constexpr int16_t minLeft(const GFXfont& font,
+				const char *str, int16_t x)
+		{
+			return !*str ? 0x7fff : !hasGlyph(font, *str) ?
+				minLeft(font, str + 1, x) :
+				min(x + glyph(font, *str).xOffset,
+						minLeft(font, str + 1, x + advance(font, *str)));
+		}
+
+		static constexpr int16_t maxRight(const GFXfont& font,
+				const char *str, int16_t x)
+		{
+			return !*str ? -0x7fff : !hasGlyph(font, *str) ?
+				maxRight(font, str + 1, x) :
+				max(x + glyph(font, *str).xOffset + glyph(font, *str).width - 1,
+						maxRight(font, str + 1, x + advance(font, *str)));
+		}
+
+		static constexpr int16_t minTop(const GFXfont& font, const char *str)
+		{
+			return !*str ? 0x7fff : !hasGlyph(font, *str) ?
+				minTop(font, str + 1) :
+				min(glyph(font, *str).yOffset, minTop(font, str + 1));
+		}
+
+		static constexpr int16_t maxBottom(const GFXfont& font,
+				const char *str)
+		{
+			return !*str ? -0x7fff : !hasGlyph(font, *str) ?
+				maxBottom(font, str + 1) :
+				max(glyph(font, *str).yOffset + glyph(font, *str).height - 1,
+						maxBottom(font, str + 1));
+		}
+
+		static constexpr bounds_t makeBounds(int16_t minx, int16_t miny,
+				int16_t maxx, int16_t maxy)
+		{
+			return {(int16_t)((maxx >= minx) ? minx : 0),
+				(int16_t)((maxy >= miny) ? miny : 0),
+				(uint16_t)((maxx >= minx) ? (maxx - minx + 1) : 0),
+				(uint16_t)((maxy >= miny) ? (maxy - miny + 1) : 0)};
+		}
+};
+
+#endif /* __EFONTMETRICS_H__ */
@@ -0,0 +1,119 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EGlyphCache.h
+ * \see EGlyphCache.cpp
+ */
+#ifndef __EGLYPHCACHE_H__
+#define __EGLYPHCACHE_H__
+
+#include <Arduino.h>
+#include <gfxfont.h>
+#include <ETheme.h>
+
+/** Maximum number of characters in a cache */
+#define GLYPH_CACHE_MAX 12
+
+/**
+ * Characters of a font pre-rendered into RGB565 tiles
+ *
+ * Each tile is one character cell: xAdvance pixels wide and as tall as the
+ * tallest cached glyph, opaque (foreground and background colors). Strings
+ * made only of cached characters can be composed by copying tiles.
+ */
+class EGlyphCache {
+	private:
+		/** Glyph metrics */
+		typedef struct _tile {
+			/** Character */
+			char c;
+			/** Tile offset in the buffer */
+			uint32_t offset;
+			/** Tile width (character advance) */
+			uint8_t advance;
+			/** Glyph bounding box: X offset */
+			int8_t xo;
+			/** Glyph bounding box: Y offset */
+			int8_t yo;
+			/** Glyph bounding box: width */
+			uint8_t w;
+			/** Glyph bounding box: height */
+			uint8_t h;
+		} tile_t;
+		/** Font */
+		const GFXfont *font;
+		/** Tiles */
+		tile_t tiles[GLYPH_CACHE_MAX];
+		/** Number of tiles */
+		int count;
+		/** Tiles height */
+		int16_t height;
+		/** Y offset of the tiles top row (relative to the baseline) */
+		int16_t top;
+		/** Tiles pixels */
+		uint16_t *buffer;
+		/** Size of the buffer (pixels) */
+		uint32_t size;
+		/** Foreground color of the cached tiles */
+		color_t fg;
+		/** Background color of the cached tiles */
+		color_t bg;
+		/** Cache state */
+		bool valid;
+
+		/* Find the tile of a character */
+		const tile_t *getTile(char c);
+
+	public:
+		/* Constructor */
+		EGlyphCache(const GFXfont *font, const char *chars);
+
+		/* Destructor */
+		~EGlyphCache();
+
+		/* Get the font */
+		const GFXfont *getFont();
+
+		/* Render the tiles for the given colors (when needed) */
+		bool build(color_t fg, color_t bg);
+
+		/* Drop the rendered tiles */
+		void invalidate();
+
+		/* Get the bounds of a string */
+		bool getTextBounds(const char *str, int16_t x, int16_t y,
+				int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h);
+
+		/* Copy the tiles of a string into a pixel buffer */
+		bool draw(uint16_t *dst, int16_t dw, int16_t dh,
+				int16_t x, int16_t y, const char *str);
+};
+#endif /* __EGLYPHCACHE_H__ */
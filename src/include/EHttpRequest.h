@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EHttpRequest.h
+ * \see EHttpRequest.cpp
+ */
+#ifndef __EHTTPREQUEST_H__
+#define __EHTTPREQUEST_H__
+
+#include <Arduino.h>
+#include <Stream.h>
+#include "ENetwork.h"
+
+/** Maximum request size (request line and headers) */
+#define HTTP_REQUEST_MAX 768
+/** Maximum response header line (longer ones are cut) */
+#define HTTP_LINE_MAX 256
+/** Maximum number of response headers kept */
+#define HTTP_HEADERS_MAX 4
+/** Rest of a response read to keep its connection (bytes) */
+#define HTTP_DRAIN_MAX 2048
+
+/** Status code: OK */
+#define HTTP_OK 200
+
+/** Malformed or unsupported URL */
+#define HTTP_ERROR_URL        (-1)
+/** Name resolution or connection failed */
+#define HTTP_ERROR_CONNECT    (-2)
+/** Request not sent */
+#define HTTP_ERROR_SEND       (-3)
+/** No response or malformed response */
+#define HTTP_ERROR_RESPONSE   (-4)
+
+/**
+ * HTTP/1.1 GET request on a connection of ENetwork
+ *
+ * The response body is read as a Stream, decoded from the chunked transfer
+ * encoding when needed. At the end of the request the connection is given
+ * back to the pool, open when the whole response has been read and the
+ * server keeps it alive. A request sent on a kept-alive connection that the
+ * server has closed in the meantime is sent again on a new connection.
+ */
+class EHttpRequest : public Stream {
+	private:
+		/** Network layer */
+		ENetwork *net;
+		/** Connection */
+		WiFiClient *client;
+		/** Additional request headers */
+		String reqHeaders;
+		/** Names of the response headers kept */
+		const char *names[HTTP_HEADERS_MAX];
+		/** Values of the response headers kept */
+		String values[HTTP_HEADERS_MAX];
+		/** Number of response headers kept */
+		int nheaders;
+		/** Content-Length (-1: unknown) */
+		long length;
+		/** Body left: whole body or current chunk */
+		long left;
+		/** Chunked transfer encoding */
+		bool chunked;
+		/** End of the body reached */
+		bool done;
+		/** Server keeps the connection open */
+		bool keep;
+		/** Byte read by peek() (-1: none) */
+		int peeked;
+
+		/* Read a line of the response */
+		int readLine(char *buf, size_t size);
+		/* Read the status line and the headers */
+		int readHeaders(uint32_t *ttfbUs);
+		/* Start the next chunk */
+		bool nextChunk();
+		/* Read a byte of the body */
+		int readBody();
+
+	public:
+		/* Constructor */
+		EHttpRequest(ENetwork *net);
+
+		/* Destructor */
+		~EHttpRequest();
+
+		/* Add a request header */
+		void addHeader(const char *name, const char *value);
+
+		/* Keep response headers */
+		void collectHeaders(const char *const names[], int count);
+
+		/* Send a GET request */
+		int GET(const char *url);
+
+		/* Value of a response header kept */
+		const String& header(const char *name);
+
+		/* Size of the response body (-1: unknown) */
+		long getSize();
+
+		/* Response body */
+		Stream& getStream();
+
+		/* End the request */
+		void end();
+
+		/* Stream */
+		int available();
+		int read();
+		int peek();
+		size_t write(uint8_t c);
+};
+
+#endif /* __EHTTPREQUEST_H__ */
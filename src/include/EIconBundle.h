@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EIconBundle.h
+ * \see EIconBundle.cpp
+ */
+#ifndef __EICONBUNDLE_H__
+#define __EICONBUNDLE_H__
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <ETheme.h>
+
+/** Icon bundle partition: label */
+#define ICON_BUNDLE_LABEL "icons"
+/** Icon bundle partition: subtype (see partitions.csv) */
+#define ICON_BUNDLE_SUBTYPE 0x40
+/** Icon bundle: magic number */
+#define ICON_BUNDLE_MAGIC "WSIB"
+/** Icon bundle: format version */
+#define ICON_BUNDLE_VERSION 0
+
+/**
+ * Icons stored as RGB565 images in a dedicated flash partition
+ *
+ * The partition is memory mapped, so the pixels can be sent to the display
+ * straight from flash. It is generated by convert_to_bundle.py (little
+ * endian):
+ *   - Header:  "WSIB", version (16 bits), number of entries (16 bits)
+ *   - Entries: width (16 bits), height (16 bits) and offset (32 bits) of
+ *              each ETheme::pixmap_t, at full and half size
+ *              (entry = pixmap * 2 + half), offset 0 when not available
+ *   - Pixels:  RGB565 (16 bits), 4 bytes aligned
+ */
+class EIconBundle {
+	private:
+		/** Bundle entry */
+		typedef struct _entry {
+			/** Width */
+			uint16_t w;
+			/** Height */
+			uint16_t h;
+			/** Offset of the pixels from the start of the bundle */
+			uint32_t offset;
+		} entry_t;
+
+		/** Mapped partition */
+		const uint8_t *base;
+		/** Partition size */
+		uint32_t size;
+		/** Entries */
+		const entry_t *entries;
+		/** Number of entries */
+		uint16_t count;
+		/** Mapping handle */
+		spi_flash_mmap_handle_t handle;
+
+	public:
+		/* Constructor */
+		EIconBundle();
+
+		/* Destructor */
+		~EIconBundle();
+
+		/* Map the icon bundle partition */
+		bool begin();
+
+		/* Unmap the icon bundle partition */
+		void end();
+
+		/* Check if the bundle is mapped */
+		bool isAvailable();
+
+		/* Get an icon */
+		const uint16_t *get(ETheme::pixmap_t pixmap, bool half,
+				uint16_t *w, uint16_t *h);
+};
+#endif /* __EICONBUNDLE_H__ */
@@ -39,6 +39,15 @@
 #include <Adafruit_ILI9341.h>
 #include <wstation.h>
 #include <ETheme.h>
+#include <ECanvas.h>
+#include <EGlyphCache.h>
+#include <EFontMetrics.h>
+#include <EPixmapCache.h>
+#include <EIconBundle.h>
+#include <EPixmapReader.h>
+#include <EWidget.h>
+#include <ELayout.h>
+#include <EProfiler.h>
 
 /** Backlight: minimum level */
 #define BACKLIGHT_MIN      0x32
@@ -47,6 +56,68 @@
 /** Backlight: maximum level */
 #define BACKLIGHT_MAX      0xff
 
+/** Minimum run of pixels sent as a single fill when streaming pixmaps */
+#define PIXMAP_FILL_MIN 16
+
+/** Keep status icons (radio, WiFi, battery) always cached */
+#ifndef GUI_PIN_STATUS_ICONS
+#define GUI_PIN_STATUS_ICONS 1
+#endif
+
+/** Send pixels to the TFT module with DMA, when a DMA bus is given (not yet
+ * validated on a device: enabled with SPI_DMA in the Makefile) */
+#ifndef GUI_SPI_DMA
+#define GUI_SPI_DMA 0
+#endif
+
+/** Keep a copy of the screen (whole screen in PSRAM, otherwise some tiles) */
+#ifndef GUI_SHADOW
+#define GUI_SHADOW 1
+#endif
+
+/** Tiles of the screen copy without PSRAM (512 bytes each, -1: all) */
+#ifndef GUI_SHADOW_TILES
+#define GUI_SHADOW_TILES 48
+#endif
+
+/** Screen layout */
+#ifndef GUI_LAYOUT
+#define GUI_LAYOUT LAYOUT_PORTRAIT
+#endif
+
+/** Profile the drawing code (see EProfiler, needs SPITFT_STATS) */
+#ifndef GUI_PROFILE
+#define GUI_PROFILE 0
+#endif
+
+/** Interval between two profiles written to the log (ms) */
+#ifndef GUI_PROFILE_LOG_MS
+#define GUI_PROFILE_LOG_MS 60000
+#endif
+
+/** Profiled drawing functions, numbered after the widgets */
+typedef enum _gui_profile {
+	PROFILE_UPDATE = WIDGET_MAX,
+	PROFILE_CLEAR_ALL,
+	PROFILE_SHOW_ALL,
+	PROFILE_CLOCK_TEXT,
+	PROFILE_TEXT,
+	PROFILE_TEXT_RIGHT,
+	PROFILE_LABEL,
+	PROFILE_LINE,
+	PROFILE_ICON,
+	PROFILE_TEMP,
+	PROFILE_HUMIDITY,
+	PROFILE_PIXMAP,
+	PROFILE_PIXMAP_HALF,
+	PROFILE_LOGO,
+	PROFILE_VERSION,
+	PROFILE_MAX
+} gui_profile_t;
+
+/** Number of fonts with a metrics table */
+#define GUI_FONTS 4
+
 /** Invalid temperature */
 #define GUI_INV_TEMP     -1E6
 /** Invalid humidity */
@@ -56,13 +127,6 @@
 
 class EInterface {
 	private:
-		/** Clock elements */
-		typedef enum _clock_el {
-			CLOCK_ALL,
-			CLOCK_HOURS,
-			CLOCK_MINUTES,
-			CLOCK_SECONDS
-		} clock_el_t;
 		/** GUI state */
 		bool state;
 		/** TFT screen: CS pin */
@@ -75,6 +139,32 @@ class EInterface {
 		int backlight;
 		/** TFT module */
 		Adafruit_ILI9341 *tft;
+		/** Scratch canvases to compose screen regions */
+		ECanvasPool *canvasPool;
+		/** Clock characters: hours and minutes */
+		EGlyphCache *clockDigits;
+		/** Clock characters: seconds */
+		EGlyphCache *clockSeconds;
+		/** Clock characters: am/pm */
+		EGlyphCache *clockPeriod;
+		/** Text metrics of the fonts */
+		EFontMetrics *metrics[GUI_FONTS];
+		/** Screen layout */
+		const ELayout::layout_t *layout;
+		/** Colors of the layout elements */
+		color_t palette[ELayout::COLOR_MAX];
+		/** Decoded pixmaps */
+		EPixmapCache *pixmapCache;
+		/** Icons in flash */
+		EIconBundle *iconBundle;
+		/** Strip buffer to stream pixmaps */
+		uint16_t *strip;
+		/** Asynchronous pixel transfers */
+		SPITFT_DMAQueue *dmaQueue;
+		/** Copy of the screen */
+		SPITFT_Shadow *shadow;
+		/** Tile buffers of the screen copy */
+		uint16_t *shadowPool;
 		/** Color theme */
 		ETheme theme;
 		/** File system */
@@ -118,36 +208,102 @@ class EInterface {
 		/** Outdoor sensor's channel */
 		int channel;
 		/** Forecast labels */
-		String forecastLabels[3];
+		String forecastLabels[GUI_FORECASTS];
 		/** Forecast Temperature 1 */
-		float forecastTemp1[3];
+		float forecastTemp1[GUI_FORECASTS];
 		/** Forecast Temperature 2 */
-		float forecastTemp2[3];
+		float forecastTemp2[GUI_FORECASTS];
 		/** Forecast weather */
-		weather_t forecastWeather[3];
+		weather_t forecastWeather[GUI_FORECASTS];
+		/** Screen elements */
+		EWidget widgets[WIDGET_MAX];
+		/** Widgets drawn */
+		unsigned int redraws;
+		/** Widgets not drawn (value did not change) */
+		unsigned int skipped;
+#if GUI_PROFILE
+		/** Render profiler */
+		EProfiler *profiler;
+#endif
+
+
+		/* Format the value of a widget */
+		const char *formatWidget(int w, char *str, size_t size);
+
+		/* Update the value of a widget */
+		void setWidget(int w);
+
+		/* Draw a widget */
+		void drawWidget(int w);
+
+		/* Print a text over its background area */
+		void drawText(const ELayout::element_t& el, const char *str);
+
+		/* Print a text right justified over its background area */
+		void drawTextRight(const ELayout::element_t& el, const char *str);
+
+		/* Print a text clearing only its own bounds */
+		void drawLabel(const ELayout::element_t& el, const char *str);
+
+		/* Print a text on a region composed off-screen */
+		void drawLine(const ELayout::element_t& el, const char *str);
 
+		/* Draw or clear a status icon */
+		void drawIcon(const ELayout::element_t& el, ETheme::pixmap_t pixmap,
+				bool show);
 
 		/* Print a temperature value with degree symbol */
-		void drawTemp(float temp, int x, int y);
+		void drawTemp(const ELayout::element_t& el, const char *str,
+				int16_t dx, int16_t r);
 
 		/* Print humidity value */
-		void drawHumidity(int humidity, int x, int y);
+		void drawHumidity(const ELayout::element_t& el, int humidity,
+				const char *str);
 
-		/* Print a forecast temperature */
-		void drawForecastTemp(float temp, int x, int y, int16_t color);
+		/* Format a temperature value */
+		void formatTemp(float temp, char *str, size_t size);
 
-		/* Read 16 bits number from file */
-		uint16_t readInt(File f);
+		/* Get the bounds of a string */
+		void getTextBounds(const GFXfont *font, const char *str,
+				int16_t x, int16_t y, int16_t *x1, int16_t *y1,
+				uint16_t *w, uint16_t *h);
+
+		/* Print a clock element */
+		void drawClockText(EGlyphCache *cache, const ELayout::element_t& el,
+				const char *str);
+
+		/* Begin drawing a screen region */
+		Adafruit_GFX *beginRegion(int16_t x, int16_t y, int16_t w, int16_t h,
+				int16_t *ox, int16_t *oy);
+
+		/* Finish drawing a screen region */
+		void endRegion(Adafruit_GFX *gfx, int16_t ox, int16_t oy);
 
  		/* Draw a pixel map file on the screen */
-		void drawPixmap(int x, int y, String file);
+		void drawPixmap(int x, int y, ETheme::pixmap_t pixmap);
 
 		/* Draw a pixel map file at half size on the screen */
-		void drawPixmapHalf(int x, int y, String file);
+		void drawPixmapHalf(int x, int y, ETheme::pixmap_t pixmap);
+
+		/* Decode a pixel map file into the cache and draw it */
+		void loadPixmap(int x, int y, ETheme::pixmap_t pixmap,
+				bool half, EPixmapReader& pic, bool scale);
+
+		/* Stream a pixel map to the screen */
+		void streamPixmap(int x, int y, EPixmapReader& pic, bool half);
+
+		/* Send lines of a pixel map at half size to the address window */
+		void streamLines(EPixmapReader& pic, uint16_t *scratch, int n);
+
+		/* Send a pixel map to the address window */
+		void streamSpans(EPixmapReader& pic);
 
 		/* Convert weather type into the corresponding icon */
 		ETheme::pixmap_t getWeatherIcon(weather_t weather, char period);
 
+		/* Resolve the colors of the layout elements */
+		void setPalette();
+
 		/* Get Celsius temperature converted (when needed) */
 		float convCelsius(float temp);
 
@@ -161,11 +317,26 @@ class EInterface {
 		~EInterface();
 
 		/* Initialize interface */
-		void initialize();
+		void initialize(SPITFT_DMABus *dma = NULL);
+
+		/* Keep a copy of the screen */
+		bool setShadow(int tiles);
+
+		/* Draw the widgets that changed */
+		void update();
+
+		/* Draw changes and wait until they have been sent to the TFT module */
+		void flush();
 
 		/* Set backlight level */
 		void setBacklight(int level);
 
+		/* Set color theme */
+		void setTheme(ETheme theme);
+
+		/* Set screen layout */
+		void setLayout(gui_layout_t id);
+
 		/* Set temperature scale */
 		void setTempScale(temp_scale_t scale);
 
@@ -187,9 +358,6 @@ class EInterface {
 		/* Set clock: seconds */
 		void setSeconds(int seconds);
 
-		/* Show clock */
-		void showClock(clock_el_t elements);
-
 		/* Show weather icon */
 		void showWeather(weather_t weather, char period);
 
@@ -256,7 +424,7 @@ class EInterface {
 		/* Show version */
 		void showVersion(int x, int y);
 
-		/* Draw all graphical elements in the screen */
+		/* Redraw all graphical elements in the screen */
 		void showAll();
 
 		/* Get temperature scale */
@@ -265,6 +433,21 @@ class EInterface {
 		/* Get time format */
 		time_format_t getTimeFormat();
 
+		/* Get pixmap cache */
+		EPixmapCache *getPixmapCache();
+
+		/* Get icon bundle */
+		EIconBundle *getIconBundle();
+
+		/* Get the copy of the screen */
+		SPITFT_Shadow *getShadow();
+
+		/* Get the number of widgets drawn */
+		unsigned int getRedraws();
+
+		/* Get the number of widget updates skipped */
+		unsigned int getSkippedRedraws();
+
 		/* Clear the whole screen */
 		void clearAll();
 
@@ -279,9 +462,23 @@ class EInterface {
 
 		/* Print text */
 		void print(int x, int y, int16_t color, int16_t bgcolor, const String& text);
-#ifdef DEBUG_SCREENSHOT
-		/* Take a screenshot */
-		void takeScreenshot(String file);
+
+		/* Read pixels of the screen */
+		bool readScreen(int16_t x, int16_t y, int16_t w, int16_t h,
+				uint16_t *buf);
+
+		/* Get the screen width */
+		int16_t getWidth();
+
+		/* Get the screen height */
+		int16_t getHeight();
+
+		/* Record the areas of the screen written */
+		void setDamage(SPITFT_Damage *damage);
+
+#if GUI_PROFILE
+		/* Get the render profiler */
+		EProfiler *getProfiler();
 #endif
 };
 #endif /* __EINTERFACE_H__ */
@@ -0,0 +1,280 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file ELayout.h
+ * Screen layout: position, font and color of each screen element
+ */
+#ifndef __ELAYOUT_H__
+#define __ELAYOUT_H__
+
+#include <EFontMetrics.h>
+
+/** Number of forecasts */
+#define GUI_FORECASTS 3
+
+/** Screen elements, in drawing order */
+typedef enum _gui_widget {
+	WIDGET_HOURS = 0,
+	WIDGET_PERIOD,
+	WIDGET_MINUTES,
+	WIDGET_SECONDS,
+	WIDGET_DATE,
+	WIDGET_CITY,
+	WIDGET_IP,
+	WIDGET_WIFI,
+	WIDGET_RADIO,
+	WIDGET_WEATHER,
+	WIDGET_LABEL_INDOOR,
+	WIDGET_LABEL_OUTDOOR,
+	WIDGET_TEMP1,
+	WIDGET_HUMIDITY1,
+	WIDGET_CHANNEL,
+	WIDGET_TEMP2,
+	WIDGET_HUMIDITY2,
+	WIDGET_BATTERY1,
+	WIDGET_BATTERY2,
+	WIDGET_FORECAST_WEATHER,
+	WIDGET_FORECAST_LABEL = WIDGET_FORECAST_WEATHER + GUI_FORECASTS,
+	WIDGET_FORECAST_TEMP2 = WIDGET_FORECAST_LABEL + GUI_FORECASTS,
+	WIDGET_FORECAST_TEMP1 = WIDGET_FORECAST_TEMP2 + GUI_FORECASTS,
+	WIDGET_MAX = WIDGET_FORECAST_TEMP1 + GUI_FORECASTS
+} gui_widget_t;
+
+/** Available layouts */
+typedef enum _gui_layout {
+	/** Portrait, 240x320 */
+	LAYOUT_PORTRAIT = 0,
+	/** Landscape, 320x240 */
+	LAYOUT_LANDSCAPE,
+	/** Number of layouts */
+	LAYOUT_MAX
+} gui_layout_t;
+
+/**
+ * Screen layout
+ *
+ * A layout is described in layouts.h with the helpers below, which are
+ * constexpr: the background area of each element is measured from its font
+ * by the compiler, so the firmware only walks a flat table.
+ */
+class ELayout {
+	public:
+		/** Colors of the theme, indexes of the palette */
+		typedef enum _color {
+			COLOR_NONE = 0,
+			COLOR_CITY,
+			COLOR_IP,
+			COLOR_DATE,
+			COLOR_CLOCK,
+			COLOR_TEMP_LABEL,
+			COLOR_TEMPERATURE,
+			COLOR_WEEKDAY,
+			COLOR_WEEK_TEMP1,
+			COLOR_WEEK_TEMP2,
+			COLOR_MAX
+		} color_id_t;
+
+		/** Screen element */
+		typedef struct _element {
+			/** Background area: top left corner (X axis) */
+			int16_t x;
+			/** Background area: top left corner (Y axis) */
+			int16_t y;
+			/** Background area: width (0: bounds of the text) */
+			int16_t w;
+			/** Background area: height */
+			int16_t h;
+			/** Cursor or icon position (X axis) */
+			int16_t cx;
+			/** Cursor or icon position (Y axis) */
+			int16_t cy;
+			/** Font */
+			const GFXfont *font;
+			/** Color */
+			color_id_t color;
+		} element_t;
+
+		/** Layout of the whole screen */
+		typedef struct _layout {
+			/** Screen rotation */
+			uint8_t rotation;
+			/** Logo position (X axis) */
+			int16_t logoX;
+			/** Logo position (Y axis) */
+			int16_t logoY;
+			/** Elements, indexed by gui_widget_t */
+			element_t el[WIDGET_MAX];
+		} layout_t;
+
+		/**
+		 * Clock element: pre-rendered characters over a background that
+		 * fits the largest string, with a margin of 2 pixels
+		 * @param [in] font Font
+		 * @param [in] area Largest string
+		 * @param [in] pad Extra width of the background area
+		 * @param [in] x Cursor position (X axis)
+		 * @param [in] y Cursor position (Y axis)
+		 */
+		static constexpr element_t clock(const GFXfont& font,
+				const char *area, int16_t pad, int16_t x, int16_t y)
+		{
+			return clock(EFontMetrics::textBounds(font, area), font, pad, x, y);
+		}
+
+		/**
+		 * Text over the background area of the largest string
+		 * @param [in] font Font
+		 * @param [in] area Largest string
+		 * @param [in] x Cursor position (X axis)
+		 * @param [in] y Cursor position (Y axis)
+		 * @param [in] color Color
+		 */
+		static constexpr element_t text(const GFXfont& font,
+				const char *area, int16_t x, int16_t y, color_id_t color)
+		{
+			return text(EFontMetrics::textBounds(font, area), font,
+					x, y, x, color);
+		}
+
+		/**
+		 * Text right justified, over the background area of the largest
+		 * string
+		 * @param [in] font Font
+		 * @param [in] area Largest string
+		 * @param [in] x Background area position (X axis)
+		 * @param [in] y Cursor position (Y axis)
+		 * @param [in] right Right end of the text
+		 * @param [in] color Color
+		 */
+		static constexpr element_t textRight(const GFXfont& font,
+				const char *area, int16_t x, int16_t y, int16_t right,
+				color_id_t color)
+		{
+			return text(EFontMetrics::textBounds(font, area), font,
+					x, y, right, color);
+		}
+
+		/**
+		 * Text over a background area that goes until a given position
+		 * @param [in] font Font
+		 * @param [in] area String with the ascender and descender
+		 * @param [in] x Cursor position (X axis)
+		 * @param [in] y Cursor position (Y axis)
+		 * @param [in] right Right end of the background area
+		 * @param [in] color Color
+		 */
+		static constexpr element_t line(const GFXfont& font,
+				const char *area, int16_t x, int16_t y, int16_t right,
+				color_id_t color)
+		{
+			return line(EFontMetrics::textBounds(font, area), font,
+					x, y, right, color);
+		}
+
+		/**
+		 * Value (text and symbols) over a background area that starts at
+		 * the cursor and fits the largest string
+		 * @param [in] font Font
+		 * @param [in] area Largest string
+		 * @param [in] pad Extra width of the background area
+		 * @param [in] x Cursor position (X axis)
+		 * @param [in] y Cursor position (Y axis)
+		 * @param [in] color Color
+		 */
+		static constexpr element_t value(const GFXfont& font,
+				const char *area, int16_t pad, int16_t x, int16_t y,
+				color_id_t color)
+		{
+			return value(EFontMetrics::textBounds(font, area), font,
+					pad, x, y, color);
+		}
+
+		/**
+		 * Text that only clears its own bounds
+		 * @param [in] font Font
+		 * @param [in] x Cursor position (X axis)
+		 * @param [in] y Cursor position (Y axis)
+		 * @param [in] color Color
+		 */
+		static constexpr element_t label(const GFXfont& font,
+				int16_t x, int16_t y, color_id_t color)
+		{
+			return {x, y, 0, 0, x, y, &font, color};
+		}
+
+		/**
+		 * Icon
+		 * @param [in] x Position (X axis)
+		 * @param [in] y Position (Y axis)
+		 * @param [in] w Width
+		 * @param [in] h Height
+		 */
+		static constexpr element_t icon(int16_t x, int16_t y,
+				int16_t w, int16_t h)
+		{
+			return {x, y, w, h, x, y, NULL, COLOR_NONE};
+		}
+
+	private:
+		static constexpr element_t clock(const EFontMetrics::bounds_t& b,
+				const GFXfont& font, int16_t pad, int16_t x, int16_t y)
+		{
+			return {(int16_t)(x + b.x1 - 2), (int16_t)(y + b.y1 - 2),
+				(int16_t)(b.w + pad), (int16_t)(b.h + 2), x, y, &font,
+				COLOR_CLOCK};
+		}
+
+		static constexpr element_t text(const EFontMetrics::bounds_t& b,
+				const GFXfont& font, int16_t x, int16_t y, int16_t cx,
+				color_id_t color)
+		{
+			return {(int16_t)(x + b.x1), (int16_t)(y + b.y1), (int16_t)b.w,
+				(int16_t)(b.h + 1), cx, y, &font, color};
+		}
+
+		static constexpr element_t line(const EFontMetrics::bounds_t& b,
+				const GFXfont& font, int16_t x, int16_t y, int16_t right,
+				color_id_t color)
+		{
+			return {(int16_t)(x + b.x1), (int16_t)(y + b.y1),
+				(int16_t)(right - x - b.x1), (int16_t)(b.h + 1), x, y, &font,
+				color};
+		}
+
+		static constexpr element_t value(const EFontMetrics::bounds_t& b,
+				const GFXfont& font, int16_t pad, int16_t x, int16_t y,
+				color_id_t color)
+		{
+			return {x, (int16_t)(y - b.h), (int16_t)(b.w + pad),
+				(int16_t)(b.h + 1), x, y, &font, color};
+		}
+};
+#endif /* __ELAYOUT_H__ */
@@ -0,0 +1,198 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file ENetwork.h
+ * \see ENetwork.cpp
+ */
+#ifndef __ENETWORK_H__
+#define __ENETWORK_H__
+
+#include <Arduino.h>
+#include <Print.h>
+#include <WiFi.h>
+#include <WiFiClient.h>
+
+/** Host names kept by the DNS cache */
+#ifndef NET_DNS_ENTRIES
+#define NET_DNS_ENTRIES 4
+#endif
+
+/** Time DNS answers are kept (ms) */
+#ifndef NET_DNS_TTL
+#define NET_DNS_TTL 300000
+#endif
+
+/** Connections kept alive (one per server) */
+#ifndef NET_POOL_SIZE
+#define NET_POOL_SIZE 2
+#endif
+
+/** Idle time after which a connection is not reused (ms) */
+#ifndef NET_IDLE_TIMEOUT
+#define NET_IDLE_TIMEOUT 30000
+#endif
+
+/** Connect and receive timeout (ms) */
+#ifndef NET_TIMEOUT
+#define NET_TIMEOUT 5000
+#endif
+
+/** Maximum host name length (longer names are not cached) */
+#define NET_HOST_MAX 64
+
+/** Network counters */
+typedef struct _net_stats {
+	/** HTTP requests */
+	uint32_t requests;
+	/** Requests sent on a kept-alive connection */
+	uint32_t reused;
+	/** Requests sent again: the kept-alive connection had been closed */
+	uint32_t retries;
+	/** Connections opened */
+	uint32_t connects;
+	/** Connections that failed */
+	uint32_t connectErrors;
+	/** Name resolutions answered from the cache */
+	uint32_t dnsHits;
+	/** Name resolutions sent to the DNS server */
+	uint32_t dnsLookups;
+	/** Name resolutions that failed */
+	uint32_t dnsErrors;
+	/** Time spent resolving names (us) */
+	uint32_t dnsUs;
+	/** Longest name resolution (us) */
+	uint32_t dnsMaxUs;
+	/** Time spent connecting (us) */
+	uint32_t connectUs;
+	/** Longest connection (us) */
+	uint32_t connectMaxUs;
+	/** Time from the requests to the first byte of the responses (us) */
+	uint32_t ttfbUs;
+	/** Longest time to first byte (us) */
+	uint32_t ttfbMaxUs;
+} net_stats_t;
+
+/**
+ * Network layer of the outbound requests
+ *
+ * Keeps one connection per server open between requests (keep-alive),
+ * caches the DNS answers for NET_DNS_TTL and counts the time spent in name
+ * resolution, connection and waiting for the servers. Shared by the tasks:
+ * a connection is used by one request at a time, a request finding the
+ * connection of its server in use gets a connection of its own.
+ */
+class ENetwork {
+	private:
+		/** Cached DNS answer */
+		typedef struct _dns_entry {
+			/** Host name (empty: unused entry) */
+			char host[NET_HOST_MAX];
+			/** Address */
+			IPAddress ip;
+			/** Expiration (millis()) */
+			unsigned long expires;
+		} dns_entry_t;
+
+		/** Connection of the pool */
+		typedef struct _connection {
+			/** Server (empty: not connected) */
+			char host[NET_HOST_MAX];
+			/** Port */
+			uint16_t port;
+			/** Connection */
+			WiFiClient client;
+			/** Taken by a request */
+			bool busy;
+			/** End of the last request (millis()) */
+			unsigned long lastUse;
+		} connection_t;
+
+		/** DNS cache */
+		dns_entry_t dns[NET_DNS_ENTRIES];
+		/** Connections */
+		connection_t pool[NET_POOL_SIZE];
+		/** Time DNS answers are kept (ms) */
+		uint32_t dnsTTL;
+		/** Keep connections open between requests */
+		bool keepAlive;
+		/** Counters */
+		net_stats_t st;
+		/** Counters start (millis()) */
+		unsigned long since;
+		/** Protects the cache, the pool and the counters */
+		portMUX_TYPE mux;
+
+		/* Connect a client to a server */
+		bool connect(WiFiClient *client, const char *host, uint16_t port);
+		/* Add a time to a counter and its maximum */
+		static void addTime(uint32_t *total, uint32_t *max, uint32_t us);
+
+		friend class EHttpRequest;
+		/* Count a request */
+		void countRequest(bool reused, bool retry, uint32_t ttfbUs);
+
+	public:
+		/* Constructor */
+		ENetwork();
+
+		/* Resolve a host name */
+		bool resolve(const char *host, IPAddress& ip);
+
+		/* Forget the DNS answers */
+		void flushDNS();
+
+		/* Set the time DNS answers are kept */
+		void setDNSTTL(uint32_t ms);
+
+		/* Keep connections open between requests */
+		void setKeepAlive(bool keepAlive);
+
+		/* Take a connection to a server */
+		WiFiClient *acquire(const char *host, uint16_t port, bool fresh,
+				bool *reused);
+
+		/* Give a connection back */
+		void release(WiFiClient *client, bool keep);
+
+		/* Close the idle connections */
+		void closeIdle();
+
+		/* Copy the counters */
+		void getStats(net_stats_t *stats);
+
+		/* Reset the counters */
+		void resetStats();
+
+		/* Write the counters as JSON */
+		void printJSON(Print& out);
+};
+
+#endif /* __ENETWORK_H__ */
@@ -0,0 +1,131 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EPixmapCache.h
+ * \see EPixmapCache.cpp
+ */
+#ifndef __EPIXMAPCACHE_H__
+#define __EPIXMAPCACHE_H__
+
+#include <Arduino.h>
+#include <ETheme.h>
+
+/** Default memory budget (bytes) */
+#ifndef PIXMAP_CACHE_BUDGET
+#define PIXMAP_CACHE_BUDGET 24576
+#endif
+/** Number of pixmaps that can be cached (full and half size) */
+#define PIXMAP_CACHE_ENTRIES ((ETheme::FIG_UNKNOWN + 1) * 2)
+
+/**
+ * Least recently used cache of decoded (RGB565) pixmaps
+ *
+ * Pixmaps are identified by their ETheme::pixmap_t type and size (full or
+ * half). Pinned pixmaps are never evicted, and pixmaps larger than half of the
+ * budget are never cached.
+ */
+class EPixmapCache {
+	private:
+		/** Cache entry */
+		typedef struct _entry {
+			/** Pixels */
+			uint16_t *pixels;
+			/** Width */
+			uint16_t w;
+			/** Height */
+			uint16_t h;
+			/** Last use (LRU clock) */
+			uint32_t lastUse;
+			/** Never evict this entry */
+			bool pinned;
+		} entry_t;
+		/** Entries, indexed by pixmap and size */
+		entry_t entries[PIXMAP_CACHE_ENTRIES];
+		/** Memory budget (bytes) */
+		uint32_t budget;
+		/** Memory in use (bytes) */
+		uint32_t usage;
+		/** LRU clock */
+		uint32_t clock;
+		/** Hits */
+		uint32_t hits;
+		/** Misses */
+		uint32_t misses;
+
+		/* Get entry index */
+		int getIndex(ETheme::pixmap_t pixmap, bool half);
+
+		/* Free an entry */
+		void evict(int i);
+
+	public:
+		/* Constructor */
+		EPixmapCache(uint32_t budget = PIXMAP_CACHE_BUDGET);
+
+		/* Destructor */
+		~EPixmapCache();
+
+		/* Get a cached pixmap */
+		const uint16_t *get(ETheme::pixmap_t pixmap, bool half,
+				uint16_t *w, uint16_t *h);
+
+		/* Allocate a new pixmap in the cache */
+		uint16_t *put(ETheme::pixmap_t pixmap, bool half,
+				uint16_t w, uint16_t h);
+
+		/* Remove a pixmap from the cache */
+		void remove(ETheme::pixmap_t pixmap, bool half);
+
+		/* Pin/unpin a pixmap */
+		void setPinned(ETheme::pixmap_t pixmap, bool pinned);
+
+		/* Remove all pixmaps (pinned ones included) */
+		void clear();
+
+		/* Set memory budget */
+		void setBudget(uint32_t budget);
+
+		/* Get memory budget */
+		uint32_t getBudget() const;
+
+		/* Get memory in use */
+		uint32_t getUsage() const;
+
+		/* Get number of hits */
+		uint32_t getHits() const;
+
+		/* Get number of misses */
+		uint32_t getMisses() const;
+
+		/* Reset hit/miss counters */
+		void resetStats();
+};
+#endif /* __EPIXMAPCACHE_H__ */
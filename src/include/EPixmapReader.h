@@ -0,0 +1,137 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EPixmapReader.h
+ * \see EPixmapReader.cpp
+ */
+#ifndef __EPIXMAPREADER_H__
+#define __EPIXMAPREADER_H__
+
+#include <FS.h>
+
+/** Size of the strip buffer used to stream pixmaps (pixels) */
+#ifndef PIXMAP_STRIP_PIXELS
+#define PIXMAP_STRIP_PIXELS 1024
+#endif
+
+/** Input buffer size for compressed pixmaps (bytes) */
+#define PIXMAP_INPUT_BUFFER 256
+
+/** Compressed pixmap: magic number */
+#define PX2_MAGIC "PX2"
+/** Compressed pixmap: format version */
+#define PX2_VERSION 0
+/** Compressed pixmap: run packet flag */
+#define PX2_RUN 0x80
+/** Compressed pixmap: maximum number of pixels per packet */
+#define PX2_MAX_PACKET 128
+
+/**
+ * Read pixel map files by whole lines or by spans of pixels
+ *
+ * Raw files (.px): width and height (16 bits, little endian) followed by
+ * width x height RGB565 pixels (16 bits, little endian).
+ *
+ * Compressed files (.px2): "PX2" and version (1 byte), width and height
+ * (16 bits, little endian), number of colors - 1 (1 byte), the palette
+ * (RGB565, 16 bits, little endian) and packets of palette indexes, covering
+ * all lines without breaks:
+ *   - 1nnnnnnn i:            run of n + 1 pixels of color i
+ *   - 0nnnnnnn i0 i1 ... in: n + 1 pixels of colors i0 ... in
+ */
+class EPixmapReader {
+	private:
+		/** Pixmap file */
+		File pic;
+		/** Width */
+		uint16_t w;
+		/** Height */
+		uint16_t h;
+		/** Pixels left to read */
+		uint32_t left;
+		/** Compressed file */
+		bool packed;
+		/** Palette (compressed files) */
+		uint16_t *palette;
+		/** Input buffer (compressed files) */
+		uint8_t *input;
+		/** Bytes in the input buffer */
+		int inputLen;
+		/** Next byte in the input buffer */
+		int inputPos;
+		/** Pixels left in the current run packet */
+		uint8_t runLeft;
+		/** Pixels left in the current literal packet */
+		uint8_t litLeft;
+		/** Color of the current run packet */
+		uint16_t runColor;
+
+		/* Read the header of a compressed file */
+		bool openPacked();
+
+		/* Get next byte of a compressed file */
+		int getByte();
+
+		/* Decode pixels */
+		uint32_t decode(uint16_t *dst, uint32_t count);
+
+	public:
+		/* Constructor */
+		EPixmapReader();
+
+		/* Destructor */
+		~EPixmapReader();
+
+		/* Open a pixmap file */
+		bool open(fs::FS *pfs, const String& file);
+
+		/* Close the pixmap file */
+		void close();
+
+		/* Get pixmap width */
+		uint16_t width();
+
+		/* Get pixmap height */
+		uint16_t height();
+
+		/* Check if the file is compressed */
+		bool isPacked();
+
+		/* Read the next lines */
+		int read(uint16_t *dst, int lines);
+
+		/* Read the next lines at half size */
+		int readHalf(uint16_t *dst, int lines, uint16_t *scratch);
+
+		/* Read the next span of pixels */
+		uint32_t readSpan(uint16_t *dst, uint32_t max, bool *fill);
+};
+#endif /* __EPIXMAPREADER_H__ */
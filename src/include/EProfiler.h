@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EProfiler.h
+ * \see EProfiler.cpp
+ */
+#ifndef __EPROFILER_H__
+#define __EPROFILER_H__
+
+#include <Arduino.h>
+#include <Print.h>
+#include <Adafruit_SPITFT.h>
+
+/**
+ * Render profiler
+ *
+ * Counts, for each section of the drawing code (a widget or a drawing
+ * function), how many times it ran, the time spent and the pixels and bus
+ * bytes it sent to the TFT module. Sections may nest: each one counts what
+ * happened while it ran, including its inner sections. The bus figures come
+ * from the counters of Adafruit_SPITFT, which must be built with
+ * SPITFT_STATS (they read as zero otherwise).
+ */
+class EProfiler {
+	public:
+		/** Counters of a section */
+		typedef struct _profile_counters {
+			/** Times run (widgets: values set) */
+			uint32_t calls;
+			/** Widgets: times drawn */
+			uint32_t redraws;
+			/** Time spent (us) */
+			uint32_t us;
+			/** Pixels written */
+			uint32_t pixels;
+			/** Bus bytes */
+			uint32_t bytes;
+		} profile_counters_t;
+
+		/**
+		 * Measure the rest of a block as a section
+		 */
+		class Scope {
+			private:
+				/** Profiler */
+				EProfiler *profiler;
+				/** Section */
+				int section;
+				/** Count a redraw instead of a call */
+				bool redraw;
+				/** Start time */
+				unsigned long start;
+				/** Pixels written at the start */
+				uint32_t pixels;
+				/** Bus bytes at the start */
+				uint32_t bytes;
+
+			public:
+				/* Constructor: start measuring */
+				Scope(EProfiler *profiler, int section, bool redraw = false);
+
+				/* Destructor: add the measures to the section */
+				~Scope();
+		};
+
+	private:
+		/** Names of the sections */
+		const char *const *names;
+		/** Number of sections */
+		int count;
+		/** Counters of the sections */
+		profile_counters_t *counters;
+		/** TFT module */
+		Adafruit_SPITFT *tft;
+		/** Time of the last reset (ms) */
+		unsigned long since;
+
+		/* Read the bus counters */
+		void readBus(uint32_t *pixels, uint32_t *bytes);
+
+	public:
+		/* Constructor */
+		EProfiler(const char *const *names, int count, Adafruit_SPITFT *tft);
+
+		/* Destructor */
+		~EProfiler();
+
+		/* Count a call of a section that is not measured */
+		void call(int section);
+
+		/* Get the counters of a section */
+		const profile_counters_t& get(int section);
+
+		/* Get the bus counters of the TFT module */
+		void getBus(SPITFT_Stats *bus);
+
+		/* Reset all counters */
+		void reset();
+
+		/* Print the counters as JSON */
+		void printJSON(Print& out);
+
+		/* Write the counters to the log */
+		void log();
+};
+#endif /* __EPROFILER_H__ */
@@ -0,0 +1,278 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file ERenderQueue.h
+ * \see ERenderQueue.cpp
+ */
+#ifndef __ERENDERQUEUE_H__
+#define __ERENDERQUEUE_H__
+
+#include <Arduino.h>
+#include <EInterface.h>
+
+/** Minimum interval between two frames (ms) */
+#ifndef RENDER_FRAME_MS
+#define RENDER_FRAME_MS 40
+#endif
+
+/** Longest time the render task sleeps without being notified (ms) */
+#define RENDER_IDLE_MS 1000
+
+/** Maximum length of text elements (including the terminator) */
+#define RENDER_TEXT_MAX 48
+
+/** Number of forecast days */
+#define RENDER_FORECASTS 3
+
+/**
+ * Render command queue
+ *
+ * Tasks post updates of the screen elements (e.g. "temperature 2 is 21.4",
+ * "radio icon on for 300 ms") and the render task draws them. Only the last
+ * value of each element is kept, so a value posted several times between two
+ * frames is drawn once. Blinking icons are timed state handled by the render
+ * task, nobody holds the screen while waiting for them.
+ *
+ * Posting is safe from any task, drawing (render()) must be done by a single
+ * task, which owns the EInterface.
+ */
+class ERenderQueue {
+	public:
+		/** Screen elements, in drawing order */
+		typedef enum _render_el {
+			RENDER_BACKLIGHT,
+			RENDER_TEMP_SCALE,
+			RENDER_TIME_FORMAT,
+			RENDER_SHOW_ALL,
+			RENDER_HOURS,
+			RENDER_MINUTES,
+			RENDER_SECONDS,
+			RENDER_DATE,
+			RENDER_CITY,
+			RENDER_IP,
+			RENDER_WIFI,
+			RENDER_RADIO,
+			RENDER_WEATHER,
+			RENDER_TEMP1,
+			RENDER_HUMIDITY1,
+			RENDER_CHANNEL,
+			RENDER_TEMP2,
+			RENDER_HUMIDITY2,
+			RENDER_FORECAST_WEATHER,
+			RENDER_FORECAST_LABEL = RENDER_FORECAST_WEATHER + RENDER_FORECASTS,
+			RENDER_FORECAST_TEMP1 = RENDER_FORECAST_LABEL + RENDER_FORECASTS,
+			RENDER_FORECAST_TEMP2 = RENDER_FORECAST_TEMP1 + RENDER_FORECASTS,
+			RENDER_MAX = RENDER_FORECAST_TEMP2 + RENDER_FORECASTS
+		} render_el_t;
+
+		/** Queue statistics */
+		typedef struct _render_stats {
+			/** Frames drawn */
+			unsigned long frames;
+			/** Updates posted */
+			unsigned long posted;
+			/** Updates replaced by a newer value before being drawn */
+			unsigned long coalesced;
+			/** Elements drawn */
+			unsigned long drawn;
+			/** Longest frame (us) */
+			unsigned long maxFrameUs;
+		} render_stats_t;
+
+	private:
+		/** Pending update of an element */
+		typedef struct _slot {
+			/** Waiting to be drawn */
+			bool dirty;
+			/** Post time (us) */
+			unsigned long posted;
+			/** Value */
+			union {
+				int i;
+				float f;
+			} value;
+			/** Weather period */
+			char period;
+			/** Text value */
+			char text[RENDER_TEXT_MAX];
+		} slot_t;
+		/** Blinking icon */
+		typedef struct _blink {
+			/** Value shown when the icon is not blinking */
+			bool steady;
+			/** Phases left (on, off, on...) */
+			int phases;
+			/** Phase period (ms) */
+			unsigned long period;
+			/** Time of the next phase (ms) */
+			unsigned long next;
+		} blink_t;
+		/** Pending updates */
+		slot_t slots[RENDER_MAX];
+		/** WiFi icon */
+		blink_t wifi;
+		/** Radio icon */
+		blink_t radio;
+		/** Time (us) the last update of each element was drawn */
+		unsigned long drawTime[RENDER_MAX];
+		/** Worst latency (us) between post and draw of each element */
+		unsigned long maxLatency[RENDER_MAX];
+		/** Statistics */
+		render_stats_t stats;
+		/** Lock */
+		portMUX_TYPE mux;
+		/** Wake up the render task */
+		void (*notify)(void *arg);
+		/** Argument of notify */
+		void *notifyArg;
+
+		/* Post a number */
+		void post(render_el_t el, int value);
+
+		/* Post a float number */
+		void postFloat(render_el_t el, float value);
+
+		/* Post a text */
+		void post(render_el_t el, const String& text);
+
+		/* Mark an element to be drawn (lock held) */
+		void touch(slot_t *s);
+
+		/* Set the steady value of an icon */
+		void setIcon(blink_t *b, render_el_t el, bool show);
+
+		/* Start blinking an icon */
+		void blink(blink_t *b, render_el_t el, int phases,
+				unsigned long period);
+
+		/* Advance a blinking icon (lock held) */
+		unsigned long updateBlink(blink_t *b, render_el_t el,
+				unsigned long now);
+
+		/* Draw an element */
+		void draw(EInterface *gui, render_el_t el, const slot_t& s);
+
+	public:
+		/* Constructor */
+		ERenderQueue();
+
+		/* Set the function that wakes up the render task */
+		void setNotify(void (*notify)(void *arg), void *arg);
+
+		/* Set backlight level */
+		void setBacklight(int level);
+
+		/* Set temperature scale */
+		void setTempScale(temp_scale_t scale);
+
+		/* Set time format */
+		void setTimeFormat(time_format_t timeFormat);
+
+		/* Redraw all elements */
+		void showAll();
+
+		/* Set clock: hours */
+		void setHours(int hours);
+
+		/* Set clock: minutes */
+		void setMinutes(int minutes);
+
+		/* Set clock: seconds */
+		void setSeconds(int seconds);
+
+		/* Set date */
+		void setDate(const String& date);
+
+		/* Set city name */
+		void setCity(const String& city);
+
+		/* Set IP address */
+		void setIP(const String& ip);
+
+		/* Show/hide WiFi icon */
+		void showWiFi(bool show);
+
+		/* Blink WiFi icon */
+		void blinkWiFi(int phases, unsigned long period);
+
+		/* Show/hide antenna icon */
+		void showRadio(bool show);
+
+		/* Blink antenna icon */
+		void blinkRadio(int phases, unsigned long period);
+
+		/* Show weather icon */
+		void showWeather(weather_t weather, char period);
+
+		/* Show temperature 1 */
+		void showTemp1(float temp);
+
+		/* Show humidity 1 */
+		void showHumidity1(int humidity);
+
+		/* Show sensor's channel */
+		void showChannel(int channel);
+
+		/* Show temperature 2 */
+		void showTemp2(float temp);
+
+		/* Show humidity 2 */
+		void showHumidity2(int humidity);
+
+		/* Show forecast weather icon */
+		void showForecastWeather(int i, weather_t weather);
+
+		/* Show forecast label */
+		void showForecastLabel(int i, const String& label);
+
+		/* Show forecast temperature 1 */
+		void showForecastTemp1(int i, float temp);
+
+		/* Show forecast temperature 2 */
+		void showForecastTemp2(int i, float temp);
+
+		/* Check for updates waiting to be drawn */
+		bool isPending();
+
+		/* Draw pending updates */
+		unsigned long render(EInterface *gui);
+
+		/* Get the time the last update of an element was drawn */
+		unsigned long getDrawTime(render_el_t el);
+
+		/* Get the worst latency between post and draw of an element */
+		unsigned long getMaxLatency(render_el_t el);
+
+		/* Get statistics */
+		const render_stats_t& getStats();
+};
+
+#endif /* __ERENDERQUEUE_H__ */
@@ -0,0 +1,171 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EScreenEncoder.h
+ * \see EScreenEncoder.cpp
+ */
+#ifndef __ESCREENENCODER_H__
+#define __ESCREENENCODER_H__
+
+#include <Arduino.h>
+
+/** Screen lines read at a time */
+#ifndef SCREEN_STRIP_LINES
+#define SCREEN_STRIP_LINES 8
+#endif
+
+/**
+ * Screenshot encoder
+ *
+ * Produces a PNG or BMP file of the screen on the fly, reading it a strip of
+ * lines at a time: memory use is bounded by one strip and one encoded line,
+ * whatever the screen size, and nothing is stored. PNG files use stored
+ * (uncompressed) deflate blocks, one per line, so their size is known in
+ * advance and encoding costs a CRC and an Adler-32 per byte.
+ */
+class EScreenEncoder {
+	public:
+		/** File formats */
+		typedef enum _screen_format {
+			/** PNG, 24 bits RGB */
+			SCREEN_PNG,
+			/** BMP, 16 bits RGB565 (top-down) */
+			SCREEN_BMP
+		} screen_format_t;
+
+		/**
+		 * Read lines of the screen
+		 * @param [in] y First line
+		 * @param [in] lines Number of lines
+		 * @param [out] buf Pixels (RGB565), width * lines
+		 * @param [in] arg Argument given to the encoder
+		 * @return bool false on error
+		 */
+		typedef bool (*screen_reader_t)(int16_t y, int16_t lines,
+				uint16_t *buf, void *arg);
+
+	private:
+		/** Encoding steps */
+		typedef enum _screen_step {
+			STEP_HEADER,
+			STEP_LINES,
+			STEP_TRAILER,
+			STEP_DONE
+		} screen_step_t;
+
+		/** Format */
+		screen_format_t format;
+		/** Screen width */
+		int16_t width;
+		/** Screen height */
+		int16_t height;
+		/** Screen reader */
+		screen_reader_t reader;
+		/** Argument of reader */
+		void *readerArg;
+		/** Next step */
+		screen_step_t step;
+		/** Strip of screen lines */
+		uint16_t *strip;
+		/** First line in strip */
+		int16_t stripY;
+		/** Lines in strip */
+		int16_t stripLines;
+		/** Next line to encode */
+		int16_t line;
+		/** Encoded bytes not read yet */
+		uint8_t *out;
+		/** Capacity of out */
+		size_t outSize;
+		/** Bytes in out */
+		size_t outLen;
+		/** Bytes of out already read */
+		size_t outPos;
+		/** Bytes produced */
+		size_t produced;
+		/** CRC of the PNG chunk being written */
+		uint32_t crc;
+		/** Adler-32 of the PNG image data */
+		uint32_t adler;
+		/** Strips that could not be read */
+		unsigned int errors;
+
+		/* Encode the next part of the file into out */
+		void encode();
+
+		/* Encode the file header */
+		void encodeHeader();
+
+		/* Encode a line */
+		void encodeLine();
+
+		/* Encode the file trailer */
+		void encodeTrailer();
+
+		/* Append bytes to out, updating the chunk CRC */
+		void put(const uint8_t *data, size_t len);
+
+		/* Append a 32 bits big endian number to out */
+		void put32(uint32_t value);
+
+		/* Size of the PNG image data (IDAT chunk) */
+		uint32_t getPNGDataSize();
+
+	public:
+		/* Constructor */
+		EScreenEncoder(screen_format_t format, int16_t width,
+				int16_t height, screen_reader_t reader, void *arg);
+
+		/* Destructor */
+		~EScreenEncoder();
+
+		/* Check if the buffers could be allocated */
+		bool isValid();
+
+		/* Get the MIME type of the file */
+		const char *getContentType();
+
+		/* Get the file size */
+		size_t getSize();
+
+		/* Read the next bytes of the file */
+		size_t read(uint8_t *buf, size_t len);
+
+		/* Check if the whole file has been read */
+		bool isDone();
+
+		/* Get the number of strips that could not be read */
+		unsigned int getErrors();
+
+		/* Get the memory used by the encoder */
+		size_t getMemoryUsage();
+};
+#endif /* __ESCREENENCODER_H__ */
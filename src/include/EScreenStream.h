@@ -0,0 +1,195 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EScreenStream.h
+ * \see EScreenStream.cpp
+ */
+#ifndef __ESCREENSTREAM_H__
+#define __ESCREENSTREAM_H__
+
+#include <Arduino.h>
+#include <Adafruit_SPITFT_Damage.h>
+
+/** Maximum number of viewers */
+#ifndef SCREEN_STREAM_CLIENTS
+#define SCREEN_STREAM_CLIENTS 2
+#endif
+
+/** Maximum message size (bytes) */
+#ifndef SCREEN_STREAM_MSG_SIZE
+#define SCREEN_STREAM_MSG_SIZE 4096
+#endif
+
+/** Message: screen size (uint16 width, uint16 height) */
+#define SCREEN_MSG_SIZE  0
+/** Message: areas of the screen (uint8 count, then the areas) */
+#define SCREEN_MSG_RECTS 1
+
+/** Area: RGB565 pixels, row by row */
+#define SCREEN_RECT_RAW 0
+/** Area: runs of pixels (uint8 length - 1, uint16 RGB565 color) */
+#define SCREEN_RECT_RLE 1
+/** Area header: uint8 encoding, uint16 x, y, width, height */
+#define SCREEN_RECT_HEADER 9
+
+/**
+ * Live screen stream
+ *
+ * Builds the binary messages sent to the viewers of the screen: the screen
+ * size and all of it when a viewer connects, then only the areas written
+ * since. Each viewer has its own bounded list of areas: while it cannot
+ * take messages, new areas are merged into it, so a slow viewer never holds
+ * the renderer nor grows memory, it just gets bigger areas later. Pixels
+ * are read from the screen when the message is built.
+ *
+ * Numbers are little endian. An area is sent in one or more messages, as
+ * raw pixels or runs, whichever is smaller.
+ */
+class EScreenStream {
+	public:
+		/**
+		 * Read an area of the screen
+		 * @param [in] x Left
+		 * @param [in] y Top
+		 * @param [in] w Width
+		 * @param [in] h Height
+		 * @param [out] buf Pixels (RGB565), w * h
+		 * @param [in] arg Argument given to the stream
+		 * @return bool false on error
+		 */
+		typedef bool (*screen_area_reader_t)(int16_t x, int16_t y,
+				int16_t w, int16_t h, uint16_t *buf, void *arg);
+
+		/** Stream counters */
+		typedef struct _stream_stats {
+			/** Messages built */
+			uint32_t messages;
+			/** Bytes of the messages */
+			uint32_t bytes;
+			/** Areas sent as raw pixels */
+			uint32_t rawRects;
+			/** Areas sent as runs */
+			uint32_t rleRects;
+			/** Pixels sent */
+			uint32_t pixels;
+			/** Times a viewer could not take a message */
+			uint32_t deferred;
+			/** Areas merged because a list was full */
+			uint32_t merges;
+			/** Areas that could not be read or sent */
+			uint32_t errors;
+		} stream_stats_t;
+
+	private:
+		/** Viewer */
+		typedef struct _stream_client {
+			/** Client ID (0: free) */
+			uint32_t id;
+			/** Screen size not sent yet */
+			bool sendSize;
+			/** Areas not sent yet */
+			SPITFT_Damage damage;
+		} stream_client_t;
+
+		/** Screen width */
+		int16_t width;
+		/** Screen height */
+		int16_t height;
+		/** Screen reader */
+		screen_area_reader_t reader;
+		/** Argument of reader */
+		void *readerArg;
+		/** Areas written since the last update() */
+		SPITFT_Damage frame;
+		/** Viewers */
+		stream_client_t clients[SCREEN_STREAM_CLIENTS];
+		/** One line of an area */
+		uint16_t *line;
+		/** Capacity of line (pixels) */
+		int16_t lineSize;
+		/** Counters */
+		stream_stats_t stats;
+
+		/* Find a viewer */
+		stream_client_t *findClient(uint32_t id);
+
+		/* Queue the size and the whole screen for a viewer */
+		void restart(stream_client_t *client);
+
+		/* Encode the first lines of an area */
+		size_t encodeRect(const SPITFT_Rect& rect, uint8_t *buf, size_t len,
+				int16_t *rows);
+
+	public:
+		/* Constructor */
+		EScreenStream(int16_t width, int16_t height,
+				screen_area_reader_t reader, void *arg);
+
+		/* Destructor */
+		~EScreenStream();
+
+		/* Check if the buffers could be allocated */
+		bool isValid();
+
+		/* Get the list the screen writes must be recorded into */
+		SPITFT_Damage *getDamage();
+
+		/* Set the screen size */
+		void setSize(int16_t width, int16_t height);
+
+		/* Hand the areas written to the viewers */
+		void update();
+
+		/* Add a viewer */
+		bool addClient(uint32_t id);
+
+		/* Remove a viewer */
+		void removeClient(uint32_t id);
+
+		/* Get a viewer */
+		uint32_t getClient(int i);
+
+		/* Check if a viewer has messages to take */
+		bool isPending(uint32_t id);
+
+		/* A viewer could not take a message */
+		void setBusy(uint32_t id);
+
+		/* Build the next message for a viewer */
+		size_t nextMessage(uint32_t id, uint8_t *buf, size_t len);
+
+		/* Get the counters */
+		const stream_stats_t& getStats();
+
+		/* Get the memory used by the stream */
+		size_t getMemoryUsage();
+};
+#endif /* __ESCREENSTREAM_H__ */
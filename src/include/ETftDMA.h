@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file ETftDMA.h
+ * \see ETftDMA.cpp
+ */
+#ifndef __ETFTDMA_H__
+#define __ETFTDMA_H__
+
+#include <Arduino.h>
+#include <driver/spi_master.h>
+#include <soc/spi_struct.h>
+#include <Adafruit_SPITFT_DMA.h>
+
+/** Default DMA channel */
+#define TFT_DMA_CHANNEL 1
+
+/**
+ * DMA transfers to the TFT module with the ESP-IDF SPI master driver
+ *
+ * The Arduino SPI driver keeps handling commands and short writes on the
+ * same SPI host, so the host registers are saved before the first DMA
+ * transfer and restored once the queue is idle.
+ */
+class ETftDMA : public SPITFT_DMABus {
+	private:
+		/** SPI host */
+		spi_host_device_t host;
+		/** DMA channel */
+		int channel;
+		/** SPI clock (Hz) */
+		uint32_t freq;
+		/** SPI host registers */
+		volatile spi_dev_t *hw;
+		/** SPI device */
+		spi_device_handle_t dev;
+		/** Transactions (one per transfer in flight) */
+		spi_transaction_t trans[SPITFT_DMA_QUEUE_DEPTH];
+		/** Next transaction */
+		uint8_t next;
+		/** Transfers in flight */
+		uint8_t inFlight;
+		/** Registers saved (Arduino SPI driver settings) */
+		bool saved;
+		/** Saved registers */
+		uint32_t regClock, regUser, regUser1, regUser2, regCtrl, regCtrl2,
+				 regPin, regDmaConf, regMosiDlen, regMisoDlen;
+
+	public:
+		/* Constructor */
+		ETftDMA(uint32_t freq, spi_host_device_t host = VSPI_HOST,
+				int channel = TFT_DMA_CHANNEL);
+
+		/* Destructor */
+		~ETftDMA();
+
+		/* SPITFT_DMABus */
+		bool begin(uint32_t maxBytes) override;
+		void *allocBuffer(uint32_t bytes) override;
+		void freeBuffer(void *buf) override;
+		void startTransfer(const uint8_t *data, uint32_t len) override;
+		void waitTransfer() override;
+		void release() override;
+};
+#endif /* __ETFTDMA_H__ */
@@ -61,6 +61,7 @@ class ETheme {
 		color_t weektemp2;
 		color_t defaultText;
 		String icons[23];
+		String iconsHalf[23];
 
 	public:
 		/** Types of pixmaps in the LCD screen */
@@ -113,6 +114,14 @@ class ETheme {
 			FIG_UNKNOWN,
 		} pixmap_t;
 
+		/** Pixmap sizes */
+		typedef enum _pixmap_size {
+			/** Original size */
+			PIXMAP_FULL = 0,
+			/** Half size (forecast) */
+			PIXMAP_HALF,
+		} pixmap_size_t;
+
 		/**
 		 * Default constructor
 		 */
@@ -136,29 +145,49 @@ class ETheme {
 			weektemp2   = 0xf186; // RGB(240, 40, 40)
 			defaultText = 0xffff; // RGB(255,255,255)
 			// Pixmap files
-			icons[FIG_01D] = "/01d.px";
-			icons[FIG_01N] = "/01n.px";
-			icons[FIG_02D] = "/02d.px";
-			icons[FIG_02N] = "/02n.px";
-			icons[FIG_03D] = "/03d.px";
-			icons[FIG_03N] = "/03d.px";
-			icons[FIG_04D] = "/04d.px";
-			icons[FIG_04N] = "/04d.px";
-			icons[FIG_09D] = "/09d.px";
-			icons[FIG_09N] = "/09d.px";
-			icons[FIG_10D] = "/10d.px";
-			icons[FIG_10N] = "/10n.px";
-			icons[FIG_11D] = "/11d.px";
-			icons[FIG_11N] = "/11d.px";
-			icons[FIG_13D] = "/13d.px";
-			icons[FIG_13N] = "/13d.px";
-			icons[FIG_50D] = "/50d.px";
-			icons[FIG_50N] = "/50d.px";
-			icons[FIG_RADIO]   = "/radio.px";
-			icons[FIG_WIFI]    = "/wifi.px";
-			icons[FIG_BATTERY] = "/battery.px";
-			icons[FIG_LOGO]    = "/logo.px";
-			icons[FIG_UNKNOWN] = "/unknown.px";
+			icons[FIG_01D] = "/01d.px2";
+			icons[FIG_01N] = "/01n.px2";
+			icons[FIG_02D] = "/02d.px2";
+			icons[FIG_02N] = "/02n.px2";
+			icons[FIG_03D] = "/03d.px2";
+			icons[FIG_03N] = "/03d.px2";
+			icons[FIG_04D] = "/04d.px2";
+			icons[FIG_04N] = "/04d.px2";
+			icons[FIG_09D] = "/09d.px2";
+			icons[FIG_09N] = "/09d.px2";
+			icons[FIG_10D] = "/10d.px2";
+			icons[FIG_10N] = "/10n.px2";
+			icons[FIG_11D] = "/11d.px2";
+			icons[FIG_11N] = "/11d.px2";
+			icons[FIG_13D] = "/13d.px2";
+			icons[FIG_13N] = "/13d.px2";
+			icons[FIG_50D] = "/50d.px2";
+			icons[FIG_50N] = "/50d.px2";
+			icons[FIG_RADIO]   = "/radio.px2";
+			icons[FIG_WIFI]    = "/wifi.px2";
+			icons[FIG_BATTERY] = "/battery.px2";
+			icons[FIG_LOGO]    = "/logo.px2";
+			icons[FIG_UNKNOWN] = "/unknown.px2";
+			// Half size pixmap files (weather icons only)
+			iconsHalf[FIG_01D] = "/01d_half.px2";
+			iconsHalf[FIG_01N] = "/01n_half.px2";
+			iconsHalf[FIG_02D] = "/02d_half.px2";
+			iconsHalf[FIG_02N] = "/02n_half.px2";
+			iconsHalf[FIG_03D] = "/03d_half.px2";
+			iconsHalf[FIG_03N] = "/03d_half.px2";
+			iconsHalf[FIG_04D] = "/04d_half.px2";
+			iconsHalf[FIG_04N] = "/04d_half.px2";
+			iconsHalf[FIG_09D] = "/09d_half.px2";
+			iconsHalf[FIG_09N] = "/09d_half.px2";
+			iconsHalf[FIG_10D] = "/10d_half.px2";
+			iconsHalf[FIG_10N] = "/10n_half.px2";
+			iconsHalf[FIG_11D] = "/11d_half.px2";
+			iconsHalf[FIG_11N] = "/11d_half.px2";
+			iconsHalf[FIG_13D] = "/13d_half.px2";
+			iconsHalf[FIG_13N] = "/13d_half.px2";
+			iconsHalf[FIG_50D] = "/50d_half.px2";
+			iconsHalf[FIG_50N] = "/50d_half.px2";
+			iconsHalf[FIG_UNKNOWN] = "/unknown_half.px2";
 		}
 
 		/**
@@ -260,9 +289,13 @@ class ETheme {
 		/**
 		 * Return the file name for a given icon
 		 * @param [in] pixmap_t Pixmap
-		 * @return char* File name
+		 * @param [in] size Pixmap size
+		 * @return char* File name (empty if there is no file for this size)
 		 */
-		String getPixmapFile(pixmap_t pixmap) {
+		String getPixmapFile(pixmap_t pixmap,
+				pixmap_size_t size = PIXMAP_FULL) {
+			if (size == PIXMAP_HALF)
+				return this->iconsHalf[pixmap];
 			return this->icons[pixmap];
 		}
 };
@@ -0,0 +1,139 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EWeatherScheduler.h
+ * \see EWeatherScheduler.cpp
+ */
+#ifndef __EWEATHERSCHEDULER_H__
+#define __EWEATHERSCHEDULER_H__
+
+#include <Arduino.h>
+#include "OpenWeather.h"
+
+/** Shortest delay after an error (s) */
+#ifndef WEATHER_RETRY_MIN
+#define WEATHER_RETRY_MIN 30
+#endif
+
+/** Longest delay after consecutive errors (s) */
+#ifndef WEATHER_RETRY_MAX
+#define WEATHER_RETRY_MAX 1800
+#endif
+
+/** Longest delay the server can set: max-age, Retry-After (s) */
+#ifndef WEATHER_SERVER_DELAY_MAX
+#define WEATHER_SERVER_DELAY_MAX 10800
+#endif
+
+/** poll(): the current weather changed */
+#define WEATHER_CHANGED_CURRENT  (1 << OpenWeather::RES_CURRENT)
+/** poll(): the forecast changed */
+#define WEATHER_CHANGED_FORECAST (1 << OpenWeather::RES_FORECAST)
+
+/** Scheduler counters */
+typedef struct _sched_stats {
+	/** Updates requested */
+	uint32_t requests;
+	/** Answered 304 Not Modified (nothing parsed) */
+	uint32_t notModified;
+	/** Parsed, same information as before */
+	uint32_t unchanged;
+	/** Parsed, information changed */
+	uint32_t changed;
+	/** Failed */
+	uint32_t errors;
+} sched_stats_t;
+
+/**
+ * Refresh scheduler of the weather information
+ *
+ * The current weather and the forecast are polled on their own intervals,
+ * with conditional requests (OpenWeather keeps the validators), and not
+ * before the max-age given by the server. Errors delay the next request
+ * exponentially, from WEATHER_RETRY_MIN up to WEATHER_RETRY_MAX (or the
+ * Retry-After of the server), with some jitter so that devices do not
+ * retry in step. With OpenWeather::FETCH_SINGLE, one request brings both,
+ * on the shorter interval.
+ */
+class EWeatherScheduler {
+	private:
+		/** Weather client */
+		OpenWeather *ow;
+		/** Interval of each resource (ms) */
+		uint32_t interval[OpenWeather::RES_COUNT];
+		/** Next request of each resource (millis()) */
+		unsigned long due[OpenWeather::RES_COUNT];
+		/** Requests scheduled (false: everything is due) */
+		bool scheduled;
+		/** Consecutive errors */
+		unsigned int failures;
+		/** Shortest delay after an error (ms) */
+		uint32_t retryMin;
+		/** Longest delay after consecutive errors (ms) */
+		uint32_t retryMax;
+		/** Counters */
+		sched_stats_t st;
+
+		/* Delay of the next request of a resource after a success */
+		uint32_t nextDelay(OpenWeather::resource_t res);
+		/* Delay of the next request after an error */
+		uint32_t errorDelay(OpenWeather::resource_t res);
+		/* Account an update */
+		unsigned int account(OpenWeather::resource_t res, int ret,
+				bool current);
+
+	public:
+		/* Constructor */
+		EWeatherScheduler(OpenWeather *ow);
+
+		/* Set the polling intervals */
+		void setIntervals(uint32_t current, uint32_t forecast);
+
+		/* Set the delays after errors */
+		void setRetry(uint32_t min, uint32_t max);
+
+		/* Request everything at the next poll */
+		void refresh();
+
+		/* Send the requests due */
+		int poll(unsigned long now, unsigned int *changed);
+
+		/* Time to the next request */
+		unsigned long nextPoll(unsigned long now);
+
+		/* Return the number of consecutive errors */
+		unsigned int getFailures();
+
+		/* Return the counters */
+		const sched_stats_t& getStats();
+};
+
+#endif /* __EWEATHERSCHEDULER_H__ */
@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file EWidget.h
+ * \see EWidget.cpp
+ */
+#ifndef __EWIDGET_H__
+#define __EWIDGET_H__
+
+#include <Arduino.h>
+
+/** Maximum length of a widget value (longer values are never compared) */
+#define WIDGET_VALUE_MAX 32
+
+/**
+ * Retained state of a screen element
+ *
+ * A widget keeps the formatted value it was last drawn with. A new value
+ * only makes the widget dirty when its formatted output is different.
+ */
+class EWidget {
+	private:
+		/** Value to be drawn */
+		char value[WIDGET_VALUE_MAX];
+		/** Value on the screen */
+		char drawn[WIDGET_VALUE_MAX];
+		/** Screen content is not valid */
+		bool invalid;
+
+	public:
+		/* Constructor */
+		EWidget();
+
+		/* Set a value without drawing it */
+		void reset(const char *value);
+
+		/* Set the formatted value */
+		bool set(const char *value);
+
+		/* Get the formatted value */
+		const char *get();
+
+		/* Check whether the widget must be drawn */
+		bool isDirty();
+
+		/* Force the widget to be drawn */
+		void invalidate();
+
+		/* Mark the current value as drawn */
+		void drawDone();
+};
+#endif /* __EWIDGET_H__ */
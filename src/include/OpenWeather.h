@@ -35,15 +35,33 @@
 #ifndef __OPENWEATHER_H__
 #define __OPENWEATHER_H__
 
+#include <Stream.h>
 #include <Time.h>
 #include <wstation.h>
 
-/** URL for daily forecast */
-#define FC_URL_DAILY "http://api.openweathermap.org/data/2.5/weather"
-/** URL for weekly forecast */
-#define FC_URL_WEEKLY "http://api.openweathermap.org/data/2.5/forecast"
+class ENetwork;
+
+/** Server */
+#define OW_SERVER "http://api.openweathermap.org"
+/** Path for daily forecast */
+#define FC_PATH_DAILY "/data/2.5/weather"
+/** Path for weekly forecast */
+#define FC_PATH_WEEKLY "/data/2.5/forecast"
 /** Maximum days for forecast */
 #define MAX_FORECAST_DAYS 7
+/** Maximum size of a cache validator (ETag or Last-Modified) */
+#define OW_VALIDATOR_MAX 48
+/** HTTP status: not modified (conditional request) */
+#define OW_NOT_MODIFIED 304
+
+/** Fetch mode used by updateForecast() */
+#ifndef OW_FETCH_MODE
+#ifdef OW_FETCH_SPLIT
+#define OW_FETCH_MODE OpenWeather::FETCH_SPLIT
+#else
+#define OW_FETCH_MODE OpenWeather::FETCH_SINGLE
+#endif
+#endif
 
 /** Forecast information structure */
 typedef struct _weather_info {
@@ -65,22 +83,65 @@ typedef struct _weather_info {
 	time_t date;
 } weather_info_t;
 
+/** Cache state of a resource of the server */
+typedef struct _ow_cache {
+	/** ETag of the information held (empty: none) */
+	char etag[OW_VALIDATOR_MAX];
+	/** Last-Modified of the information held (empty: none) */
+	char modified[OW_VALIDATOR_MAX];
+	/** Cache-Control max-age (seconds), -1 when not given */
+	long maxAge;
+	/** Retry-After (seconds) of the last error, 0 when not given */
+	long retryAfter;
+	/** HTTP status of the last request (negative: HTTP_ERROR_*) */
+	int status;
+	/** The last successful request changed the information */
+	bool changed;
+} ow_cache_t;
 
 class OpenWeather {
+	public:
+		/** How updateForecast() retrieves the weather */
+		typedef enum {
+			/** Forecast only: current weather from its first entry */
+			FETCH_SINGLE,
+			/** Current weather and forecast: two requests */
+			FETCH_SPLIT,
+		} fetch_mode_t;
+
+		/** Resources of the server */
+		typedef enum {
+			/** Current weather */
+			RES_CURRENT,
+			/** Forecast */
+			RES_FORECAST,
+			/** Number of resources */
+			RES_COUNT,
+		} resource_t;
+
 	private:
 		/** API key */
 		String key;
 		/** City */
 		String city;
+		/** Server URL */
+		String server;
+		/** Network layer */
+		ENetwork *net;
 		/** Daily forecast */
 		weather_info_t dailyFC;
 		/** Weekly forecast */
 		weather_info_t weeklyFC[MAX_FORECAST_DAYS];
+		/** JSON document memory used by the last parse (peak) */
+		size_t docUsage;
+		/** Fetch mode */
+		fetch_mode_t fetchMode;
+		/** Cache state of each resource */
+		ow_cache_t cache[RES_COUNT];
 
-		/* Parse daily forecast information */
-		int parseDaily(const String& json);
-		/* Parse weekly forecast information */
-		int parseWeekly(const String& json);
+		/* Send a (conditional) request and parse the response */
+		int fetch(resource_t res, const char *path, const char *query,
+				bool current);
 
 	public:
 		/* Constructor */
@@ -101,15 +162,45 @@ class OpenWeather {
 		/* Return API key */
 		const String getAPIKey();
 
+		/* Set the network layer used for the requests */
+		void setNetwork(ENetwork *net);
+
+		/* Set the server */
+		void setServer(const String& server);
+
+		/* Set how updateForecast() retrieves the weather */
+		void setFetchMode(fetch_mode_t mode);
+
+		/* Return the fetch mode */
+		fetch_mode_t getFetchMode();
+
+		/* Forget the cache validators (next requests are unconditional) */
+		void clearCache();
+
+		/* Return the cache state of a resource */
+		const ow_cache_t& getCache(resource_t res);
+
+		/* Tell whether the last update changed the information */
+		bool isChanged(resource_t res);
+
 		/* Retrieve daily forecast from the server */
 		int updateDailyForecast();
 
 		/* Retrieve weekly forecast from the server */
-		int updateWeeklyForecast();
+		int updateWeeklyForecast(bool current = false);
 
 		/* Retrieve forecast from the server */
 		int updateForecast();
 
+		/* Parse daily forecast information */
+		int parseDaily(Stream& json);
+
+		/* Parse weekly forecast information */
+		int parseWeekly(Stream& json, bool current = false);
+
+		/* Return the JSON document memory used by the last parse */
+		size_t getDocumentUsage();
+
 		/* Get daily forecast */
 		weather_info_t getDailyForecast();
 
@@ -0,0 +1,161 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2020 Renê de Souza Pinto
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file layouts.h
+ * Screen layouts
+ *
+ * Each layout lists every screen element (see gui_widget_t, in the same
+ * order) with its position, font and color. Background areas are measured
+ * at compile time, so this file must be included after the fonts.
+ */
+#ifndef __LAYOUTS_H__
+#define __LAYOUTS_H__
+
+#include <ELayout.h>
+
+/** Screen layouts, indexed by gui_layout_t */
+static constexpr ELayout::layout_t layouts[LAYOUT_MAX] = {
+	/* Portrait, 240x320 */
+	{
+		2, 10, 124,
+		{
+			/* Clock */
+			ELayout::clock(FreeSansBold18pt7b, "00:", 2, 60, 95),
+			ELayout::clock(FreeSans9pt7b, "pm", 2, 190, 95),
+			ELayout::clock(FreeSansBold18pt7b, "00", 8, 110, 95),
+			ELayout::clock(FreeSansBold12pt7b, "00", 5, 155, 95),
+			/* Date, city and IP address */
+			ELayout::line(FreeSans9pt7b, "Ap", 70, 55, 240,
+					ELayout::COLOR_DATE),
+			ELayout::label(FreeSansBold12pt7b, 70, 40, ELayout::COLOR_CITY),
+			ELayout::textRight(FreeMono9pt7b, "000.000.000.000", 50, 10, 210,
+					ELayout::COLOR_IP),
+			/* WiFi, radio and weather icons */
+			ELayout::icon(216, 0, 24, 24),
+			ELayout::icon(180, 170, 14, 24),
+			ELayout::icon(0, 18, 60, 60),
+			/* Indoor/Outdoor labels */
+			ELayout::label(FreeSans9pt7b, 5, 120, ELayout::COLOR_TEMP_LABEL),
+			ELayout::label(FreeSans9pt7b, 5, 185, ELayout::COLOR_TEMP_LABEL),
+			/* Indoor and outdoor values */
+			ELayout::value(FreeSansBold18pt7b, "-000.0 C", 0, 5, 160,
+					ELayout::COLOR_TEMPERATURE),
+			ELayout::value(FreeSansBold18pt7b, "000%", 6, 150, 160,
+					ELayout::COLOR_NONE),
+			ELayout::text(FreeSans9pt7b, "000", 80, 185,
+					ELayout::COLOR_TEMP_LABEL),
+			ELayout::value(FreeSansBold18pt7b, "-000.0 C", 0, 5, 225,
+					ELayout::COLOR_TEMPERATURE),
+			ELayout::value(FreeSansBold18pt7b, "000%", 6, 150, 225,
+					ELayout::COLOR_NONE),
+			/* Batteries */
+			ELayout::icon(200, 107, 32, 15),
+			ELayout::icon(200, 172, 32, 15),
+			/* Forecast: icons, labels, temperatures 2 and 1 */
+			ELayout::icon(5, 240, 30, 30),
+			ELayout::icon(90, 240, 30, 30),
+			ELayout::icon(168, 240, 30, 30),
+			ELayout::text(FreeSans9pt7b, "AAA", 40, 260, ELayout::COLOR_WEEKDAY),
+			ELayout::text(FreeSans9pt7b, "AAA", 125, 260, ELayout::COLOR_WEEKDAY),
+			ELayout::text(FreeSans9pt7b, "AAA", 203, 260, ELayout::COLOR_WEEKDAY),
+			ELayout::value(FreeSans9pt7b, "-000.0 C", 0, 5, 285,
+					ELayout::COLOR_WEEK_TEMP2),
+			ELayout::value(FreeSans9pt7b, "-000.0 C", 0, 90, 285,
+					ELayout::COLOR_WEEK_TEMP2),
+			ELayout::value(FreeSans9pt7b, "-000.0 C", 0, 168, 285,
+					ELayout::COLOR_WEEK_TEMP2),
+			ELayout::value(FreeSans9pt7b, "-000.0 C", 0, 5, 305,
+					ELayout::COLOR_WEEK_TEMP1),
+			ELayout::value(FreeSans9pt7b, "-000.0 C", 0, 90, 305,
+					ELayout::COLOR_WEEK_TEMP1),
+			ELayout::value(FreeSans9pt7b, "-000.0 C", 0, 168, 305,
+					ELayout::COLOR_WEEK_TEMP1),
+		}
+	},
+	/* Landscape, 320x240: forecasts on a column at the right side */
+	{
+		3, 50, 84,
+		{
+			/* Clock */
+			ELayout::clock(FreeSansBold18pt7b, "00:", 2, 60, 95),
+			ELayout::clock(FreeSans9pt7b, "pm", 2, 190, 95),
+			ELayout::clock(FreeSansBold18pt7b, "00", 8, 110, 95),
+			ELayout::clock(FreeSansBold12pt7b, "00", 5, 155, 95),
+			/* Date, city and IP address */
+			ELayout::line(FreeSans9pt7b, "Ap", 70, 55, 240,
+					ELayout::COLOR_DATE),
+			ELayout::label(FreeSansBold12pt7b, 70, 40, ELayout::COLOR_CITY),
+			ELayout::textRight(FreeMono9pt7b, "000.000.000.000", 126, 10, 286,
+					ELayout::COLOR_IP),
+			/* WiFi, radio and weather icons */
+			ELayout::icon(296, 0, 24, 24),
+			ELayout::icon(180, 170, 14, 24),
+			ELayout::icon(0, 18, 60, 60),
+			/* Indoor/Outdoor labels */
+			ELayout::label(FreeSans9pt7b, 5, 120, ELayout::COLOR_TEMP_LABEL),
+			ELayout::label(FreeSans9pt7b, 5, 185, ELayout::COLOR_TEMP_LABEL),
+			/* Indoor and outdoor values */
+			ELayout::value(FreeSansBold18pt7b, "-000.0 C", 0, 5, 160,
+					ELayout::COLOR_TEMPERATURE),
+			ELayout::value(FreeSansBold18pt7b, "000%", 6, 150, 160,
+					ELayout::COLOR_NONE),
+			ELayout::text(FreeSans9pt7b, "000", 80, 185,
+					ELayout::COLOR_TEMP_LABEL),
+			ELayout::value(FreeSansBold18pt7b, "-000.0 C", 0, 5, 225,
+					ELayout::COLOR_TEMPERATURE),
+			ELayout::value(FreeSansBold18pt7b, "000%", 6, 150, 225,
+					ELayout::COLOR_NONE),
+			/* Batteries */
+			ELayout::icon(200, 107, 32, 15),
+			ELayout::icon(200, 172, 32, 15),
+			/* Forecast: icons, labels, temperatures 2 and 1 */
+			ELayout::icon(248, 28, 30, 30),
+			ELayout::icon(248, 100, 30, 30),
+			ELayout::icon(248, 172, 30, 30),
+			ELayout::text(FreeSans9pt7b, "AAA", 283, 48, ELayout::COLOR_WEEKDAY),
+			ELayout::text(FreeSans9pt7b, "AAA", 283, 120, ELayout::COLOR_WEEKDAY),
+			ELayout::text(FreeSans9pt7b, "AAA", 283, 192, ELayout::COLOR_WEEKDAY),
+			ELayout::value(FreeSans9pt7b, "-000.0 C", 0, 248, 73,
+					ELayout::COLOR_WEEK_TEMP2),
+			ELayout::value(FreeSans9pt7b, "-000.0 C", 0, 248, 145,
+					ELayout::COLOR_WEEK_TEMP2),
+			ELayout::value(FreeSans9pt7b, "-000.0 C", 0, 248, 217,
+					ELayout::COLOR_WEEK_TEMP2),
+			ELayout::value(FreeSans9pt7b, "-000.0 C", 0, 248, 93,
+					ELayout::COLOR_WEEK_TEMP1),
+			ELayout::value(FreeSans9pt7b, "-000.0 C", 0, 248, 165,
+					ELayout::COLOR_WEEK_TEMP1),
+			ELayout::value(FreeSans9pt7b, "-000.0 C", 0, 248, 237,
+					ELayout::COLOR_WEEK_TEMP1),
+		}
+	},
+};
+#endif /* __LAYOUTS_H__ */
@@ -37,6 +37,11 @@
 
 #include <ESPAsyncWebServer.h>
 #include "UserConf.h"
+#include "EInterface.h"
+#include "ENetwork.h"
+
+/** Longest wait for the screen mutex in the web server task (ticks) */
+#define WS_SCREEN_TIMEOUT pdMS_TO_TICKS(100)
 
 /* HTML form fields */
 #define PARAM_SSID     "ssid"
@@ -58,10 +63,23 @@
 
 /* Reset mutex */
 extern volatile SemaphoreHandle_t reset_mutex;
+/* Screen mutex */
+extern volatile SemaphoreHandle_t t_mutex;
+/* Embedded GUI */
+extern EInterface *gui;
+/* Render task */
+extern TaskHandle_t renderTask;
 /* User configuration */
 extern UserConf confData;
+/* Outbound requests */
+extern ENetwork network;
 
 /* Setup all web services */
 void SetupWebServices(AsyncWebServer *webServer);
 
+#ifdef SCREEN_STREAM
+/* Send the areas of the screen drawn to the live screen viewers */
+bool updateScreenStream();
+#endif
+
 #endif /* __WEB_SERVICES_H__ */
@@ -77,6 +77,8 @@
 #define TFT_CS 17
 /** TFT module led pin */
 #define TFT_BACKLIGHT 27
+/** TFT module SPI clock (Hz) */
+#define TFT_SPI_FREQ 40000000
 
 /** Sensor data display interval (in seconds) */
 #define SENSOR_DISPLAY_INTERVAL 5
@@ -84,8 +86,23 @@
 /** Sensor data expiration period (in seconds) */
 #define SENSOR_DATA_EXPIRATION 600
 
-/** Weather information update interval (in seconds) */
-#define WEATHER_UPDATE_INTERVAL 60
+/** Radio icon blink when sensor data is received (in milliseconds) */
+#define RADIO_BLINK_TIME 300
+
+/** WiFi icon blink phases when reconnecting */
+#define WIFI_BLINK_PHASES 4
+/** WiFi icon blink phase duration (in milliseconds) */
+#define WIFI_BLINK_TIME 400
+
+/** Current weather polling interval (in seconds) */
+#ifndef WEATHER_CURRENT_INTERVAL
+#define WEATHER_CURRENT_INTERVAL 600
+#endif
+
+/** Forecast polling interval (in seconds) */
+#ifndef WEATHER_FORECAST_INTERVAL
+#define WEATHER_FORECAST_INTERVAL 3600
+#endif
 
 /** NTP date/time update interval (in seconds) */
 #define NTP_UPDATE_INTERVAL 1800
@@ -238,7 +255,4 @@ void userSetupDone(void);
 void WiFiReconnect(void);
 void updateFromConf(void);
 void factoryReset(void);
-#ifdef DEBUG_SCREENSHOT
-void takeScreenshot(void);
-#endif
 #endif /* __WSTATION_H__ */
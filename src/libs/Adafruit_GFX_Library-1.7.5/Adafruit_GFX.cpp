@@ -32,6 +32,7 @@ POSSIBILITY OF SUCH DAMAGE.
  */
 
 #include "Adafruit_GFX.h"
+#include "Adafruit_GFX_RGB565.h"
 #include "glcdfont.c"
 #ifdef __AVR__
 #include <avr/pgmspace.h>
@@ -1187,30 +1188,20 @@ void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
     int8_t xo = pgm_read_byte(&glyph->xOffset),
            yo = pgm_read_byte(&glyph->yOffset);
     uint8_t xx, yy, bits = 0, bit = 0;
-    int16_t xo16 = 0, yo16 = 0;
-
-    if (size_x > 1 || size_y > 1) {
-      xo16 = xo;
-      yo16 = yo;
-    }
 
     // Todo: Add character clipping here
 
-    // NOTE: THERE IS NO 'BACKGROUND' COLOR OPTION ON CUSTOM FONTS.
-    // THIS IS ON PURPOSE AND BY DESIGN.  The background color feature
-    // has typically been used with the 'classic' font to overwrite old
-    // screen contents with new data.  This ONLY works because the
-    // characters are a uniform size; it's not a sensible thing to do with
-    // proportionally-spaced fonts with glyphs of varying sizes (and that
-    // may overlap).  To replace previously-drawn text when using a custom
-    // font, use the getTextBounds() function to determine the smallest
-    // rectangle encompassing a string, erase the area with fillRect(),
-    // then draw new text.  This WILL infortunately 'blink' the text, but
-    // is unavoidable.  Drawing 'background' pixels will NOT fix this,
-    // only creates a new set of problems.  Have an idea to work around
-    // this (a canvas object type for MCUs that can afford the RAM and
-    // displays supporting setAddrWindow() and pushColors()), but haven't
-    // implemented this yet.
+    // Glyph rows are drawn as horizontal spans (runs of set bits), one
+    // writeFastHLine() per span instead of one writePixel() per bit.
+    //
+    // Opaque mode (bg != color) fills the clear bits of the glyph's bounding
+    // box with the background color in the same pass. Only the bounding box
+    // is covered: proportional glyphs have varying sizes and may overlap, so
+    // to replace previously-drawn text use getTextBounds() to determine the
+    // smallest rectangle encompassing a string and erase it with fillRect().
+
+    bool opaque = (bg != color), on, span = false;
+    uint8_t x0 = 0;
 
     startWrite();
     for (yy = 0; yy < h; yy++) {
@@ -1218,21 +1209,47 @@ void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
         if (!(bit++ & 7)) {
           bits = pgm_read_byte(&bitmap[bo++]);
         }
-        if (bits & 0x80) {
-          if (size_x == 1 && size_y == 1) {
-            writePixel(x + xo + xx, y + yo + yy, color);
-          } else {
-            writeFillRect(x + (xo16 + xx) * size_x, y + (yo16 + yy) * size_y,
-                          size_x, size_y, color);
-          }
-        }
+        on = bits & 0x80;
         bits <<= 1;
+        if (xx == 0) {
+          span = on;
+        } else if (on != span) {
+          if (span || opaque)
+            writeGlyphSpan(x + (xo + x0) * size_x, y + (yo + yy) * size_y,
+                           xx - x0, size_x, size_y, span ? color : bg);
+          x0 = xx;
+          span = on;
+        }
       }
+      if (w && (span || opaque))
+        writeGlyphSpan(x + (xo + x0) * size_x, y + (yo + yy) * size_y, w - x0,
+                       size_x, size_y, span ? color : bg);
+      x0 = 0;
     }
     endWrite();
 
   } // End classic vs custom font
 }
+/**************************************************************************/
+/*!
+   @brief   Draw a horizontal span of a custom font glyph
+    @param    x   Left x coordinate (scaled)
+    @param    y   Top y coordinate (scaled)
+    @param    w   Length of the span in glyph pixels
+    @param    size_x  Font magnification level in X-axis
+    @param    size_y  Font magnification level in Y-axis
+    @param    color 16-bit 5-6-5 Color of the span
+*/
+/**************************************************************************/
+void Adafruit_GFX::writeGlyphSpan(int16_t x, int16_t y, int16_t w,
+                                  uint8_t size_x, uint8_t size_y,
+                                  uint16_t color) {
+  if (size_x == 1 && size_y == 1)
+    writeFastHLine(x, y, w, color);
+  else
+    writeFillRect(x, y, w * size_x, size_y, color);
+}
+
 /**************************************************************************/
 /*!
     @brief  Print one byte/character of data, used to support print()
@@ -1994,6 +2011,38 @@ void GFXcanvas16::drawPixel(int16_t x, int16_t y, uint16_t color) {
   }
 }
 
+/**************************************************************************/
+/*!
+   @brief    Draw a horizontal line into the framebuffer (unrotated canvases
+   are filled directly, rotated ones go through drawPixel())
+    @param    x   Left-most x coordinate
+    @param    y   Row coordinate
+    @param    w   Width in pixels
+    @param    color 16-bit 5-6-5 Color to fill with
+*/
+/**************************************************************************/
+void GFXcanvas16::drawFastHLine(int16_t x, int16_t y, int16_t w,
+                                uint16_t color) {
+  if (!buffer || rotation) {
+    Adafruit_GFX::drawFastHLine(x, y, w, color);
+    return;
+  }
+  if ((y < 0) || (y >= _height))
+    return;
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if ((x + w) > _width)
+    w = _width - x;
+  if (w <= 0)
+    return;
+
+  uint16_t *ptr = &buffer[x + y * WIDTH];
+  while (w--)
+    *ptr++ = color;
+}
+
 /**************************************************************************/
 /*!
     @brief  Fill the framebuffer completely with one color
@@ -2027,9 +2076,6 @@ void GFXcanvas16::fillScreen(uint16_t color) {
 */
 /**************************************************************************/
 void GFXcanvas16::byteSwap(void) {
-  if (buffer) {
-    uint32_t i, pixels = WIDTH * HEIGHT;
-    for (i = 0; i < pixels; i++)
-      buffer[i] = __builtin_bswap16(buffer[i]);
-  }
+  if (buffer)
+    rgb565Swap(buffer, buffer, (uint32_t)WIDTH * HEIGHT);
 }
@@ -222,6 +222,8 @@ public:
 protected:
   void charBounds(char c, int16_t *x, int16_t *y, int16_t *minx, int16_t *miny,
                   int16_t *maxx, int16_t *maxy);
+  void writeGlyphSpan(int16_t x, int16_t y, int16_t w, uint8_t size_x,
+                      uint8_t size_y, uint16_t color);
   int16_t WIDTH,      ///< This is the 'raw' display width - never changes
       HEIGHT;         ///< This is the 'raw' display height - never changes
   int16_t _width,     ///< Display width as modified by current rotation
@@ -342,6 +344,7 @@ public:
   ~GFXcanvas16(void);
   void drawPixel(int16_t x, int16_t y, uint16_t color),
       fillScreen(uint16_t color), byteSwap(void);
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
   /**********************************************************************/
   /*!
     @brief    Get a pointer to the internal buffer memory
@@ -0,0 +1,132 @@
+/*!
+ * @file Adafruit_GFX_RGB565.cpp
+ *
+ * Pixel kernels for RGB565 buffers.
+ *
+ * BSD license, all text here must be included in any redistribution.
+ */
+
+#include "Adafruit_GFX_RGB565.h"
+
+/// Word access to pixel buffers (allowed to alias uint16_t)
+typedef uint32_t __attribute__((__may_alias__)) rgb565_word_t;
+
+/// Channels of a pixel spread over a word: G in 21..26, R in 11..15 and B
+/// in 0..4, leaving room above each channel for sums and products
+#define RGB565_LANES 0x07E0F81Ful
+
+/*!
+    @brief  Spread the channels of a pixel over a word.
+    @param  c  16-bit pixel color in '565' RGB format.
+    @return Channels as lanes (see RGB565_LANES).
+*/
+static inline uint32_t spread(uint16_t c) {
+  return (c | ((uint32_t)c << 16)) & RGB565_LANES;
+}
+
+/*!
+    @brief  Pack the lanes of a word back into a pixel.
+    @param  x  Channels as lanes (see RGB565_LANES), without carries.
+    @return 16-bit pixel color in '565' RGB format.
+*/
+static inline uint16_t pack(uint32_t x) { return x | (x >> 16); }
+
+/*!
+    @brief  Swap the bytes of the two pixels of a word.
+    @param  w  Two pixels.
+    @return Two pixels, bytes swapped.
+*/
+static inline uint32_t swapWord(uint32_t w) {
+  return ((w & 0x00FF00FFul) << 8) | ((w >> 8) & 0x00FF00FFul);
+}
+
+/*!
+    @brief  Fill a buffer with a color.
+    @param  dst    Buffer.
+    @param  color  16-bit pixel color.
+    @param  len    Number of pixels.
+*/
+void rgb565Fill(uint16_t *dst, uint16_t color, uint32_t len) {
+  uint32_t c2 = color * 0x00010001ul;
+  rgb565_word_t *w;
+
+  if (len && ((uintptr_t)dst & 2)) {
+    *dst++ = color;
+    len--;
+  }
+  for (w = (rgb565_word_t *)dst; len >= 2; len -= 2)
+    *w++ = c2;
+  if (len)
+    *(uint16_t *)w = color;
+}
+
+/*!
+    @brief  Swap the bytes of each pixel (little endian to wire order and
+            back).
+    @param  dst  Output buffer (can be src).
+    @param  src  Pixels.
+    @param  len  Number of pixels.
+*/
+void rgb565Swap(uint16_t *dst, const uint16_t *src, uint32_t len) {
+  const rgb565_word_t *s;
+  rgb565_word_t *d;
+
+  if (((uintptr_t)dst ^ (uintptr_t)src) & 2) {
+    // Buffers not aligned the same way, no word access
+    while (len--)
+      *dst++ = __builtin_bswap16(*src++);
+    return;
+  }
+  if (len && ((uintptr_t)dst & 2)) {
+    *dst++ = __builtin_bswap16(*src++);
+    len--;
+  }
+  s = (const rgb565_word_t *)src;
+  d = (rgb565_word_t *)dst;
+  for (; len >= 2; len -= 2)
+    *d++ = swapWord(*s++);
+  if (len)
+    *(uint16_t *)d = __builtin_bswap16(*(const uint16_t *)s);
+}
+
+/*!
+    @brief  Scale two lines down to one line at half width: each pixel is
+            the average of a 2x2 block, (a + b + c + d + 2) / 4 for each
+            channel.
+    @param  dst    Output line, len pixels (can be line0).
+    @param  line0  First line, 2 * len pixels.
+    @param  line1  Second line, 2 * len pixels.
+    @param  len    Number of output pixels.
+*/
+void rgb565Half(uint16_t *dst, const uint16_t *line0, const uint16_t *line1,
+                uint32_t len) {
+  // Rounding: 2 in each lane
+  const uint32_t round = (2ul << 21) | (2ul << 11) | 2ul;
+  uint32_t i, sum;
+
+  for (i = 0; i < len; i++) {
+    sum = spread(line0[2 * i]) + spread(line0[2 * i + 1]) +
+          spread(line1[2 * i]) + spread(line1[2 * i + 1]) + round;
+    dst[i] = pack((sum >> 2) & RGB565_LANES);
+  }
+}
+
+/*!
+    @brief  Blend pixels over a background color: for each channel,
+            (src * a + bg * (32 - a)) / 32, with a = (alpha + 4) / 8.
+    @param  dst    Output buffer (can be src).
+    @param  src    Pixels.
+    @param  alpha  Opacity of each pixel (0: background, 255: pixel).
+    @param  bg     Background color.
+    @param  len    Number of pixels.
+*/
+void rgb565Blend(uint16_t *dst, const uint16_t *src, const uint8_t *alpha,
+                 uint16_t bg, uint32_t len) {
+  uint32_t b = spread(bg), i, a;
+
+  // Products stay below the next lane: 63 * 32 < 2^11
+  for (i = 0; i < len; i++) {
+    a = (alpha[i] + 4) >> 3;
+    dst[i] = pack(((spread(src[i]) * a + b * (32 - a)) >> 5) & RGB565_LANES);
+  }
+}
@@ -0,0 +1,25 @@
+/*!
+ * @file Adafruit_GFX_RGB565.h
+ *
+ * Pixel kernels for RGB565 buffers: fill, byte swap, 2x2 box downscale and
+ * alpha blend against a background color. Pixels are processed as 32-bit
+ * words (two pixels per word for fills and swaps, the three channels of a
+ * pixel as lanes of a word for the arithmetic), giving the same results as
+ * the per-channel formulas in the comments.
+ *
+ * BSD license, all text here must be included in any redistribution.
+ */
+
+#ifndef _ADAFRUIT_GFX_RGB565_H_
+#define _ADAFRUIT_GFX_RGB565_H_
+
+#include <stdint.h>
+
+void rgb565Fill(uint16_t *dst, uint16_t color, uint32_t len);
+void rgb565Swap(uint16_t *dst, const uint16_t *src, uint32_t len);
+void rgb565Half(uint16_t *dst, const uint16_t *line0, const uint16_t *line1,
+                uint32_t len);
+void rgb565Blend(uint16_t *dst, const uint16_t *src, const uint8_t *alpha,
+                 uint16_t bg, uint32_t len);
+
+#endif // _ADAFRUIT_GFX_RGB565_H_
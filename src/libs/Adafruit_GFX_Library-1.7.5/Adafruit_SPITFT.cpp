@@ -34,6 +34,7 @@
 #if !defined(__AVR_ATtiny85__) // Not for ATtiny, at all
 
 #include "Adafruit_SPITFT.h"
+#include "Adafruit_GFX_RGB565.h"
 
 #if defined(__AVR__)
 #if defined(__AVR_XMEGA__) // only tested with __AVR_ATmega4809__
@@ -921,6 +922,16 @@ void Adafruit_SPITFT::startWrite(void) {
             for all display types; not an SPI-specific function.
 */
 void Adafruit_SPITFT::endWrite(void) {
+#if defined(ESP32)
+  if (dmaQueue && dmaQueue->busy()) {
+    // Don't wait for the bus to drain: the chip is deselected by the
+    // next dmaWait(), which any later display access goes through.
+    dmaQueue->flush();
+    dmaCSPending = true;
+    SPI_END_TRANSACTION();
+    return;
+  }
+#endif
   if (_cs >= 0)
     SPI_CS_HIGH();
   SPI_END_TRANSACTION();
@@ -943,7 +954,12 @@ void Adafruit_SPITFT::endWrite(void) {
 */
 void Adafruit_SPITFT::writePixel(int16_t x, int16_t y, uint16_t color) {
   if ((x >= 0) && (x < _width) && (y >= 0) && (y < _height)) {
+    if (shadow && shadow->skipFill(x, y, 1, 1, color))
+      return;
     setAddrWindow(x, y, 1, 1);
+    if (shadow)
+      shadow->writeColor(color, 1);
+    SPITFT_COUNT(pixels, 1);
     SPI_WRITE16(color);
   }
 }
@@ -982,8 +998,22 @@ void Adafruit_SPITFT::writePixels(uint16_t *colors, uint32_t len, bool block,
   if (!len)
     return; // Avoid 0-byte transfers
 
+  if (shadow)
+    shadow->writePixels(colors, len, bigEndian);
+  SPITFT_COUNT(pixels, len);
+
 #if defined(ESP32) // ESP32 has a special SPI pixel-writing function...
   if (connection == TFT_HARD_SPI) {
+    if (dmaQueue) {
+      // Pixels are copied to the DMA buffers, 'colors' can be reused as
+      // soon as this returns. Blocking only waits for the bus.
+      SPITFT_COUNT(bytes, len * 2);
+      dmaQueue->writePixels(colors, len, bigEndian);
+      if (block)
+        dmaWait();
+      return;
+    }
+    SPITFT_COUNT(bytes, len * 2);
     hwspi._spi->writePixels(colors, len * 2);
     return;
   }
@@ -997,6 +1027,7 @@ void Adafruit_SPITFT::writePixels(uint16_t *colors, uint32_t len, bool block,
   }
 
   // use the separate tx, rx buf variant to prevent overwrite the buffer
+  SPITFT_COUNT(bytes, 2 * len);
   hwspi._spi->transfer(colors, NULL, 2 * len);
 
   // swap back color buffer
@@ -1113,6 +1144,16 @@ void Adafruit_SPITFT::writePixels(uint16_t *colors, uint32_t len, bool block,
             was used (as is the default case).
 */
 void Adafruit_SPITFT::dmaWait(void) {
+#if defined(ESP32)
+  if (dmaQueue) {
+    dmaQueue->fence();
+    if (dmaCSPending) {
+      dmaCSPending = false;
+      if (_cs >= 0)
+        SPI_CS_HIGH();
+    }
+  }
+#endif
 #if defined(USE_SPI_DMA) && (defined(__SAMD51__) || defined(ARDUINO_SAMD_ZERO))
   while (dma_busy)
     ;
@@ -1127,6 +1168,53 @@ void Adafruit_SPITFT::dmaWait(void) {
 #endif
 }
 
+#if defined(ESP32)
+/*!
+    @brief  Send pixels (writePixels(), writeColor()) through a DMA queue.
+            Only used with hardware SPI. Pixel transfers then run in the
+            background: writePixels() with block=false and writeColor()
+            return once the pixels are queued, commands and any other bus
+            access wait for them, and endWrite() leaves the chip selected
+            until they are done. Use dmaWait() as completion fence.
+    @param  queue  Initialized queue (see SPITFT_DMAQueue::begin()) or NULL
+                   to go back to blocking transfers.
+*/
+void Adafruit_SPITFT::setDMAQueue(SPITFT_DMAQueue *queue) {
+  dmaWait();
+  dmaQueue = (connection == TFT_HARD_SPI) ? queue : NULL;
+}
+
+/*!
+    @brief  Wait for queued DMA transfers before a CPU driven write.
+*/
+inline void Adafruit_SPITFT::DMA_FENCE(void) {
+  if (dmaQueue && dmaQueue->busy())
+    dmaQueue->fence();
+}
+#endif
+
+/*!
+    @brief  Keep a copy of the display memory. writePixels(), writeColor()
+            and the pixel functions update it; fills and bitmaps that would
+            not change any pixel are not sent and bitmaps are cropped to
+            the pixels they change. The display must only be written
+            through this class while a shadow is set.
+    @param  s  Shadow (it is reset: the whole screen is unknown) or NULL.
+*/
+void Adafruit_SPITFT::setShadow(SPITFT_Shadow *s) {
+  shadow = s;
+  if (shadow)
+    shadow->reset(_width, _height);
+}
+
+/*!
+    @brief  Record the address windows written from now on (in the
+            coordinates of the current rotation). The caller takes the
+            areas and clears the list when it wants.
+    @param  d  List of areas or NULL.
+*/
+void Adafruit_SPITFT::setDamage(SPITFT_Damage *d) { damage = d; }
+
 /*!
     @brief  Issue a series of pixels, all the same color. Not self-
             contained; should follow startWrite() and setAddrWindow() calls.
@@ -1138,26 +1226,32 @@ void Adafruit_SPITFT::writeColor(uint16_t color, uint32_t len) {
   if (!len)
     return; // Avoid 0-byte transfers
 
+  if (shadow)
+    shadow->writeColor(color, len);
+  SPITFT_COUNT(pixels, len);
+
   uint8_t hi = color >> 8, lo = color;
 
 #if defined(ESP32) // ESP32 has a special SPI pixel-writing function...
   if (connection == TFT_HARD_SPI) {
+    if (dmaQueue) {
+      SPITFT_COUNT(bytes, len * 2);
+      dmaQueue->writeColor(color, len);
+      return;
+    }
 #define SPI_MAX_PIXELS_AT_ONCE 32
 #define TMPBUF_LONGWORDS (SPI_MAX_PIXELS_AT_ONCE + 1) / 2
 #define TMPBUF_PIXELS (TMPBUF_LONGWORDS * 2)
     static uint32_t temp[TMPBUF_LONGWORDS];
-    uint32_t c32 = color * 0x00010001;
-    uint16_t bufLen = (len < TMPBUF_PIXELS) ? len : TMPBUF_PIXELS, xferLen,
-             fillLen;
+    uint16_t bufLen = (len < TMPBUF_PIXELS) ? len : TMPBUF_PIXELS, xferLen;
     // Fill temp buffer 32 bits at a time
-    fillLen = (bufLen + 1) / 2; // Round up to next 32-bit boundary
-    for (uint32_t t = 0; t < fillLen; t++) {
-      temp[t] = c32;
-    }
+    rgb565Fill((uint16_t *)temp, color, bufLen);
     // Issue pixels in blocks from temp buffer
     while (len) {                              // While pixels remain
       xferLen = (bufLen < len) ? bufLen : len; // How many this pass?
-      writePixels((uint16_t *)temp, xferLen);
+      // Straight to the bus, the shadow already has these pixels
+      SPITFT_COUNT(bytes, xferLen * 2);
+      hwspi._spi->writePixels((uint16_t *)temp, xferLen * 2);
       len -= xferLen;
     }
     return;
@@ -1178,11 +1272,14 @@ void Adafruit_SPITFT::writeColor(uint16_t color, uint32_t len) {
       pixbuf[i] = swap_color;
     }
 
+    SPITFT_Shadow *s = shadow; // Already has these pixels
+    shadow = NULL;
     while (len) {
       uint32_t const count = min(len, pixbufcount);
       writePixels(pixbuf, count, true, true);
       len -= count;
     }
+    shadow = s;
 
     rtos_free(pixbuf);
     return;
@@ -1285,6 +1382,7 @@ void Adafruit_SPITFT::writeColor(uint16_t color, uint32_t len) {
   // All other cases (non-DMA hard SPI, bitbang SPI, parallel)...
 
   if (connection == TFT_HARD_SPI) {
+    SPITFT_COUNT(bytes, len * 2);
 #if defined(ESP8266)
     do {
       uint32_t pixelsThisPass = len;
@@ -1558,6 +1656,8 @@ void inline Adafruit_SPITFT::writeFastVLine(int16_t x, int16_t y, int16_t h,
 inline void Adafruit_SPITFT::writeFillRectPreclipped(int16_t x, int16_t y,
                                                      int16_t w, int16_t h,
                                                      uint16_t color) {
+  if (shadow && shadow->skipFill(x, y, w, h, color))
+    return; // Already there
   setAddrWindow(x, y, w, h);
   writeColor(color, (uint32_t)w * h);
 }
@@ -1583,8 +1683,13 @@ void Adafruit_SPITFT::drawPixel(int16_t x, int16_t y, uint16_t color) {
   // Clip first...
   if ((x >= 0) && (x < _width) && (y >= 0) && (y < _height)) {
     // THEN set up transaction (if needed) and draw...
+    if (shadow && shadow->skipFill(x, y, 1, 1, color))
+      return;
     startWrite();
     setAddrWindow(x, y, 1, 1);
+    if (shadow)
+      shadow->writeColor(color, 1);
+    SPITFT_COUNT(pixels, 1);
     SPI_WRITE16(color);
     endWrite();
   }
@@ -1742,6 +1847,9 @@ void Adafruit_SPITFT::drawFastVLine(int16_t x, int16_t y, int16_t h,
     @param  color  16-bit pixel color in '565' RGB format.
 */
 void Adafruit_SPITFT::pushColor(uint16_t color) {
+  if (shadow)
+    shadow->writeColor(color, 1);
+  SPITFT_COUNT(pixels, 1);
   startWrite();
   SPI_WRITE16(color);
   endWrite();
@@ -1791,11 +1899,29 @@ void Adafruit_SPITFT::drawRGBBitmap(int16_t x, int16_t y, uint16_t *pcolors,
     h = _height - y; // Clip bottom
 
   pcolors += by1 * saveW + bx1; // Offset bitmap ptr to clipped top-left
+  if (shadow) { // Only send the pixels that change
+    uint32_t offset;
+    if (!shadow->cropBitmap(&x, &y, &w, &h, pcolors, saveW, &offset))
+      return;
+    pcolors += offset;
+  }
   startWrite();
   setAddrWindow(x, y, w, h); // Clipped area
-  while (h--) {              // For each (clipped) scanline...
+  if (w == saveW) { // Contiguous rows, one burst
+#if defined(ESP32)
+    writePixels(pcolors, (uint32_t)w * h, false);
+#else
+    writePixels(pcolors, (uint32_t)w * h);
+#endif
+    h = 0;
+  }
+  while (h--) { // For each (clipped) scanline...
+#if defined(ESP32)
+    writePixels(pcolors, w, false); // Rows are copied when DMA is enabled
+#else
     writePixels(pcolors, w); // Push one (clipped) row
-    pcolors += saveW;        // Advance pointer by one full (unclipped) line
+#endif
+    pcolors += saveW; // Advance pointer by one full (unclipped) line
   }
   endWrite();
 }
@@ -2001,6 +2127,11 @@ uint16_t Adafruit_SPITFT::readcommand16(uint16_t addr) {
             encapsulated both actions.
 */
 inline void Adafruit_SPITFT::SPI_BEGIN_TRANSACTION(void) {
+  SPITFT_COUNT(transactions, 1);
+#if defined(ESP32)
+  if (dmaQueue)
+    dmaWait(); // Bus settings can't change under a DMA transfer
+#endif
   if (connection == TFT_HARD_SPI) {
 #if defined(SPI_HAS_TRANSACTION)
     hwspi._spi->beginTransaction(hwspi.settings);
@@ -2046,7 +2177,11 @@ inline void Adafruit_SPITFT::SPI_END_TRANSACTION(void) {
     @param  b  8-bit value to write.
 */
 void Adafruit_SPITFT::spiWrite(uint8_t b) {
+  SPITFT_COUNT(bytes, 1);
   if (connection == TFT_HARD_SPI) {
+#if defined(ESP32)
+    DMA_FENCE();
+#endif
 #if defined(__AVR__)
     AVR_WRITESPI(b);
 #elif defined(ESP8266) || defined(ESP32)
@@ -2086,6 +2221,9 @@ void Adafruit_SPITFT::spiWrite(uint8_t b) {
     @param  cmd  8-bit command to write.
 */
 void Adafruit_SPITFT::writeCommand(uint8_t cmd) {
+#if defined(ESP32)
+  DMA_FENCE(); // Queued pixels must go out as data
+#endif
   SPI_DC_LOW();
   spiWrite(cmd);
   SPI_DC_HIGH();
@@ -2104,6 +2242,7 @@ void Adafruit_SPITFT::writeCommand(uint8_t cmd) {
 uint8_t Adafruit_SPITFT::spiRead(void) {
   uint8_t b = 0;
   uint16_t w = 0;
+  SPITFT_COUNT(bytes, 1);
   if (connection == TFT_HARD_SPI) {
     return hwspi._spi->transfer((uint8_t)0);
   } else if (connection == TFT_SOFT_SPI) {
@@ -2349,7 +2488,11 @@ inline bool Adafruit_SPITFT::SPI_MISO_READ(void) {
     @param  w  16-bit value to write.
 */
 void Adafruit_SPITFT::SPI_WRITE16(uint16_t w) {
+  SPITFT_COUNT(bytes, 2);
   if (connection == TFT_HARD_SPI) {
+#if defined(ESP32)
+    DMA_FENCE();
+#endif
 #if defined(__AVR__)
     AVR_WRITESPI(w >> 8);
     AVR_WRITESPI(w);
@@ -2398,7 +2541,11 @@ void Adafruit_SPITFT::SPI_WRITE16(uint16_t w) {
     @param  l  32-bit value to write.
 */
 void Adafruit_SPITFT::SPI_WRITE32(uint32_t l) {
+  SPITFT_COUNT(bytes, 4);
   if (connection == TFT_HARD_SPI) {
+#if defined(ESP32)
+    DMA_FENCE();
+#endif
 #if defined(__AVR__)
     AVR_WRITESPI(l >> 24);
     AVR_WRITESPI(l >> 16);
@@ -23,7 +23,12 @@
 #if !defined(__AVR_ATtiny85__) // Not for ATtiny, at all
 
 #include "Adafruit_GFX.h"
+#include "Adafruit_SPITFT_Damage.h"
+#include "Adafruit_SPITFT_Shadow.h"
 #include <SPI.h>
+#if defined(ESP32)
+#include "Adafruit_SPITFT_DMA.h"
+#endif
 
 // HARDWARE CONFIG ---------------------------------------------------------
 
@@ -101,6 +106,22 @@ typedef volatile ADAGFX_PORT_t *PORTreg_t; ///< PORT register type
 /*! For first arg to parallel constructor */
 enum tftBusWidth { tft8bitbus, tft16bitbus };
 
+/*!
+  @brief  Bus counters, kept when the library is built with SPITFT_STATS
+*/
+typedef struct {
+  uint32_t transactions; ///< SPI transactions begun
+  uint32_t addrWindows;  ///< setAddrWindow() calls
+  uint32_t bytes;        ///< Bytes written or read
+  uint32_t pixels;       ///< Pixels written
+} SPITFT_Stats;
+
+#if defined(SPITFT_STATS)
+#define SPITFT_COUNT(field, n) (_stats.field += (n)) ///< Add to a counter
+#else
+#define SPITFT_COUNT(field, n) ///< Bus counters disabled
+#endif
+
 // CLASS DEFINITION --------------------------------------------------------
 
 /*!
@@ -227,6 +248,40 @@ public:
   // Another new function, companion to the new non-blocking
   // writePixels() variant.
   void dmaWait(void);
+#if defined(ESP32)
+  // Send pixels through a DMA queue (hardware SPI only), NULL to disable
+  void setDMAQueue(SPITFT_DMAQueue *queue);
+  /*!
+    @brief   Get the DMA queue.
+    @return  Queue set by setDMAQueue() or NULL.
+  */
+  SPITFT_DMAQueue *getDMAQueue(void) { return dmaQueue; }
+#endif
+  // Keep a copy of the display memory, NULL to disable
+  void setShadow(SPITFT_Shadow *shadow);
+  /*!
+    @brief   Get the shadow of the display memory.
+    @return  Shadow set by setShadow() or NULL.
+  */
+  SPITFT_Shadow *getShadow(void) { return shadow; }
+  // Record the written areas, NULL to disable
+  void setDamage(SPITFT_Damage *damage);
+  /*!
+    @brief   Get the list of written areas.
+    @return  List set by setDamage() or NULL.
+  */
+  SPITFT_Damage *getDamage(void) { return damage; }
+#if defined(SPITFT_STATS)
+  /*!
+    @brief   Get the bus counters.
+    @return  Counters since the last resetStats().
+  */
+  const SPITFT_Stats &getStats(void) { return _stats; }
+  /*!
+    @brief   Reset the bus counters.
+  */
+  void resetStats(void) { memset(&_stats, 0, sizeof(_stats)); }
+#endif
 
   // These functions are similar to the 'write' functions above, but with
   // a chip-select and/or SPI transaction built-in. They're typically used
@@ -515,6 +570,17 @@ protected:
   uint8_t invertOffCommand = 0; ///< Command to disable invert mode
 
   uint32_t _freq = 0; ///< Dummy var to keep subclasses happy
+
+#if defined(ESP32)
+  void DMA_FENCE(void);
+  SPITFT_DMAQueue *dmaQueue = NULL; ///< Asynchronous pixel transfers
+  bool dmaCSPending = false;        ///< Chip deselect waits for the DMA
+#endif
+  SPITFT_Shadow *shadow = NULL; ///< Copy of the display memory
+  SPITFT_Damage *damage = NULL; ///< Areas written
+#if defined(SPITFT_STATS)
+  SPITFT_Stats _stats = {0, 0, 0, 0}; ///< Bus counters
+#endif
 };
 
 #endif // end __AVR_ATtiny85__
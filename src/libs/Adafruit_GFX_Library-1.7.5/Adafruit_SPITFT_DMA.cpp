@@ -0,0 +1,209 @@
+/*!
+ * @file Adafruit_SPITFT_DMA.cpp
+ *
+ * Asynchronous, double-buffered pixel transfers for Adafruit_SPITFT.
+ *
+ * BSD license, all text here must be included in any redistribution.
+ */
+
+#include "Adafruit_SPITFT_DMA.h"
+#include "Adafruit_GFX_RGB565.h"
+#include <string.h>
+
+/*!
+    @brief  Constructor
+    @param  bus     Bus backend.
+    @param  pixels  Size of each of the two buffers, in pixels.
+*/
+SPITFT_DMAQueue::SPITFT_DMAQueue(SPITFT_DMABus *bus, uint32_t pixels)
+    : bus(bus), capacity(pixels) {
+  memset(&st, 0, sizeof(st));
+}
+
+/*!
+    @brief  Destructor. Waits for transfers in flight.
+*/
+SPITFT_DMAQueue::~SPITFT_DMAQueue() {
+  if (buf[0] || buf[1])
+    fence();
+  for (uint8_t i = 0; i < 2; i++) {
+    if (buf[i])
+      bus->freeBuffer(buf[i]);
+  }
+}
+
+/*!
+    @brief   Allocate the buffers and prepare the bus.
+    @return  true on success. On failure the queue must not be used.
+*/
+bool SPITFT_DMAQueue::begin(void) {
+  if (buf[0] && buf[1])
+    return true;
+  if (!bus || !capacity || !bus->begin(capacity * 2))
+    return false;
+  buf[0] = (uint16_t *)bus->allocBuffer(capacity * 2);
+  buf[1] = (uint16_t *)bus->allocBuffer(capacity * 2);
+  if (!buf[0] || !buf[1]) {
+    for (uint8_t i = 0; i < 2; i++) {
+      if (buf[i])
+        bus->freeBuffer(buf[i]);
+      buf[i] = NULL;
+    }
+    return false;
+  }
+  return true;
+}
+
+/*!
+    @brief  Queue pixels. Returns once all of them have been copied, the
+            last ones may still be waiting in the active buffer: call
+            flush() or fence() to send them.
+    @param  colors     Pixels (RGB565).
+    @param  len        Number of pixels.
+    @param  bigEndian  Pixels are already in wire order.
+*/
+void SPITFT_DMAQueue::writePixels(const uint16_t *colors, uint32_t len,
+                                  bool bigEndian) {
+  while (len) {
+    if (fill == 0) {
+      acquire(active);
+      fillLen[active] = 0; // Buffer no longer holds a fill
+    }
+    uint32_t n = capacity - fill;
+    if (n > len)
+      n = len;
+    uint16_t *dst = buf[active] + fill;
+    if (bigEndian)
+      memcpy(dst, colors, n * 2);
+    else
+      rgb565Swap(dst, colors, n);
+    colors += n;
+    len -= n;
+    fill += n;
+    if (fill == capacity)
+      flush();
+  }
+}
+
+/*!
+    @brief  Queue a run of pixels of the same color. Long runs are sent
+            from a buffer filled once with that color, in transfers as
+            large as the buffer; short ones are merged with pixel data.
+    @param  color  16-bit pixel color in '565' RGB format.
+    @param  len    Number of pixels.
+*/
+void SPITFT_DMAQueue::writeColor(uint16_t color, uint32_t len) {
+  uint16_t swapped = __builtin_bswap16(color);
+  uint32_t n;
+  uint8_t idx;
+
+  if (len < SPITFT_DMA_MIN_FILL) {
+    while (len) {
+      if (fill == 0) {
+        acquire(active);
+        fillLen[active] = 0;
+      }
+      n = capacity - fill;
+      if (n > len)
+        n = len;
+      rgb565Fill(buf[active] + fill, swapped, n);
+      len -= n;
+      fill += n;
+      if (fill == capacity)
+        flush();
+    }
+    return;
+  }
+
+  flush();
+  // Reuse a buffer that already holds this color (even if in flight, DMA
+  // only reads it), otherwise refill the active one
+  n = (len < capacity) ? len : capacity;
+  if (fillColor[active ^ 1] == swapped && fillLen[active ^ 1] >= n) {
+    idx = active ^ 1;
+  } else {
+    idx = active;
+    if (fillColor[idx] != swapped || fillLen[idx] < n) {
+      acquire(idx);
+      rgb565Fill(buf[idx], swapped, n);
+      fillColor[idx] = swapped;
+      fillLen[idx] = n;
+    }
+    active ^= 1; // Next pixels go to the other buffer
+  }
+  while (len) {
+    n = (len < fillLen[idx]) ? len : fillLen[idx];
+    submit(idx, n);
+    len -= n;
+  }
+  st.fills++;
+}
+
+/*!
+    @brief  Start the transfer of the pixels waiting in the active buffer
+            and switch to the other buffer. Does not wait.
+*/
+void SPITFT_DMAQueue::flush(void) {
+  if (!fill)
+    return;
+  submit(active, fill);
+  fill = 0;
+  active ^= 1;
+}
+
+/*!
+    @brief  Send everything queued and wait until the bus is idle.
+*/
+void SPITFT_DMAQueue::fence(void) {
+  if (!busy())
+    return;
+  flush();
+  while (inFlight)
+    waitOne();
+  bus->release();
+  st.fences++;
+}
+
+/*!
+    @brief  Reset counters.
+*/
+void SPITFT_DMAQueue::resetStats(void) { memset(&st, 0, sizeof(st)); }
+
+/*!
+    @brief  Start a transfer from a buffer
+    @param  idx     Buffer.
+    @param  pixels  Number of pixels, from the start of the buffer.
+*/
+void SPITFT_DMAQueue::submit(uint8_t idx, uint32_t pixels) {
+  if (inFlight == SPITFT_DMA_QUEUE_DEPTH) {
+    st.stalls++;
+    waitOne();
+  }
+  bus->startTransfer((const uint8_t *)buf[idx], pixels * 2);
+  ring[(head + inFlight) % SPITFT_DMA_QUEUE_DEPTH] = idx;
+  inFlight++;
+  pending[idx]++;
+  st.transfers++;
+  st.bytes += pixels * 2;
+}
+
+/*!
+    @brief  Wait for the oldest transfer in flight.
+*/
+void SPITFT_DMAQueue::waitOne(void) {
+  bus->waitTransfer();
+  pending[ring[head]]--;
+  head = (head + 1) % SPITFT_DMA_QUEUE_DEPTH;
+  inFlight--;
+}
+
+/*!
+    @brief  Wait until a buffer can be written (no transfer in flight).
+    @param  idx  Buffer.
+*/
+void SPITFT_DMAQueue::acquire(uint8_t idx) {
+  if (pending[idx])
+    st.stalls++;
+  while (pending[idx])
+    waitOne();
+}
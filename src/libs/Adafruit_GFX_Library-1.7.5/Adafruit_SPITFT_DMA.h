@@ -0,0 +1,124 @@
+/*!
+ * @file Adafruit_SPITFT_DMA.h
+ *
+ * Asynchronous, double-buffered pixel transfers for Adafruit_SPITFT.
+ * The queue logic (buffer ownership, ordering and fences) does not depend
+ * on the MCU: the actual transfers are started by an SPITFT_DMABus, which
+ * can be a DMA capable SPI driver or an emulated bus.
+ *
+ * BSD license, all text here must be included in any redistribution.
+ */
+
+#ifndef _ADAFRUIT_SPITFT_DMA_H_
+#define _ADAFRUIT_SPITFT_DMA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef SPITFT_DMA_BUFFER_PIXELS
+#define SPITFT_DMA_BUFFER_PIXELS 2048 ///< Pixels per buffer (two buffers)
+#endif
+#ifndef SPITFT_DMA_MIN_FILL
+#define SPITFT_DMA_MIN_FILL 64 ///< Shorter fills are merged with pixel data
+#endif
+#define SPITFT_DMA_QUEUE_DEPTH 8 ///< Maximum number of transfers in flight
+
+/*!
+  @brief  Bus backend: starts transfers and waits for their completion.
+          Transfers must complete in the order they were started.
+*/
+class SPITFT_DMABus {
+public:
+  virtual ~SPITFT_DMABus() {}
+  /*!
+    @brief   Prepare the bus for transfers
+    @param   maxBytes  Largest transfer that will be started.
+    @return  true on success, false if DMA can't be used.
+  */
+  virtual bool begin(uint32_t maxBytes) = 0;
+  /*!
+    @brief   Allocate a buffer that can be used as DMA source.
+    @param   bytes  Size.
+    @return  Buffer or NULL.
+  */
+  virtual void *allocBuffer(uint32_t bytes) = 0;
+  /*!
+    @brief  Free a buffer returned by allocBuffer().
+    @param  buf  Buffer.
+  */
+  virtual void freeBuffer(void *buf) = 0;
+  /*!
+    @brief  Start a transfer. Returns as soon as the transfer is queued;
+            data must not change until waitTransfer() reports it done.
+    @param  data  Bytes, in wire order.
+    @param  len   Number of bytes.
+  */
+  virtual void startTransfer(const uint8_t *data, uint32_t len) = 0;
+  /*!
+    @brief  Wait for the oldest transfer in flight to complete.
+  */
+  virtual void waitTransfer(void) = 0;
+  /*!
+    @brief  All transfers are done: give the bus back to the regular
+            (CPU driven) SPI functions.
+  */
+  virtual void release(void) {}
+};
+
+/*!
+  @brief  Transfer counters
+*/
+typedef struct {
+  uint32_t transfers; ///< Transfers started
+  uint32_t bytes;     ///< Bytes transferred
+  uint32_t fills;     ///< writeColor() calls sent from a filled buffer
+  uint32_t stalls;    ///< Waits for a buffer or a queue slot
+  uint32_t fences;    ///< fence() calls that had to wait
+} SPITFT_DMAStats;
+
+/*!
+  @brief  Double-buffered queue of pixel transfers. Pixels are copied
+          (byte swapped) into the buffer being filled while the other one
+          is on the bus, so callers never wait for the transfer of their
+          own data, only for a free buffer.
+*/
+class SPITFT_DMAQueue {
+public:
+  SPITFT_DMAQueue(SPITFT_DMABus *bus,
+                  uint32_t pixels = SPITFT_DMA_BUFFER_PIXELS);
+  ~SPITFT_DMAQueue();
+
+  bool begin(void);
+  void writePixels(const uint16_t *colors, uint32_t len,
+                   bool bigEndian = false);
+  void writeColor(uint16_t color, uint32_t len);
+  void flush(void);
+  void fence(void);
+  /*!
+    @brief   Check for queued pixels or transfers in flight.
+    @return  true if fence() would have to wait.
+  */
+  bool busy(void) const { return (inFlight > 0) || (fill > 0); }
+  const SPITFT_DMAStats &stats(void) const { return st; }
+  void resetStats(void);
+
+private:
+  void submit(uint8_t idx, uint32_t pixels);
+  void waitOne(void);
+  void acquire(uint8_t idx);
+
+  SPITFT_DMABus *bus;                     ///< Bus backend
+  uint16_t *buf[2] = {NULL, NULL};        ///< Pixel buffers (wire order)
+  uint32_t capacity;                      ///< Pixels per buffer
+  uint32_t fill = 0;                      ///< Pixels queued in buf[active]
+  uint8_t active = 0;                     ///< Buffer being filled
+  uint8_t ring[SPITFT_DMA_QUEUE_DEPTH];   ///< Buffer of each transfer
+  uint8_t head = 0;                       ///< Oldest transfer in ring
+  uint8_t inFlight = 0;                   ///< Transfers in flight
+  uint8_t pending[2] = {0, 0};            ///< Transfers in flight per buffer
+  uint16_t fillColor[2] = {0, 0};         ///< Color held by a filled buffer
+  uint32_t fillLen[2] = {0, 0};           ///< Pixels of fillColor held
+  SPITFT_DMAStats st;                     ///< Counters
+};
+
+#endif // _ADAFRUIT_SPITFT_DMA_H_
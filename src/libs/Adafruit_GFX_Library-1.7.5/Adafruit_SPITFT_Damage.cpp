@@ -0,0 +1,157 @@
+/*!
+ * @file Adafruit_SPITFT_Damage.cpp
+ *
+ * Screen areas written since they were last taken.
+ *
+ * BSD license, all text here must be included in any redistribution.
+ */
+
+#include "Adafruit_SPITFT_Damage.h"
+
+/*!
+    @brief  Area of a rectangle.
+    @param  r  Rectangle.
+    @return Pixels.
+*/
+static inline int32_t rectArea(const SPITFT_Rect &r) {
+  return (int32_t)r.w * r.h;
+}
+
+/*!
+    @brief  Smallest rectangle holding two rectangles.
+    @param  a  Rectangle.
+    @param  b  Rectangle.
+    @return Bounding rectangle.
+*/
+static SPITFT_Rect rectUnion(const SPITFT_Rect &a, const SPITFT_Rect &b) {
+  SPITFT_Rect r;
+  int16_t x2 = (a.x + a.w > b.x + b.w) ? a.x + a.w : b.x + b.w;
+  int16_t y2 = (a.y + a.h > b.y + b.h) ? a.y + a.h : b.y + b.h;
+
+  r.x = (a.x < b.x) ? a.x : b.x;
+  r.y = (a.y < b.y) ? a.y : b.y;
+  r.w = x2 - r.x;
+  r.h = y2 - r.y;
+  return r;
+}
+
+/*!
+    @brief  Pixels a merge would add to two rectangles (negative when they
+            overlap).
+    @param  a  Rectangle.
+    @param  b  Rectangle.
+    @return Pixels of the bounding rectangle not in a nor in b.
+*/
+static int32_t mergeCost(const SPITFT_Rect &a, const SPITFT_Rect &b) {
+  return rectArea(rectUnion(a, b)) - rectArea(a) - rectArea(b);
+}
+
+/*!
+    @brief  Constructor. No area.
+*/
+SPITFT_Damage::SPITFT_Damage(void) {}
+
+/*!
+    @brief  Add a written area.
+    @param  x  Left.
+    @param  y  Top.
+    @param  w  Width.
+    @param  h  Height.
+*/
+void SPITFT_Damage::add(int16_t x, int16_t y, int16_t w, int16_t h) {
+  SPITFT_Rect r = {x, y, w, h};
+  int32_t cost, best;
+  uint8_t i, j;
+
+  if ((w <= 0) || (h <= 0))
+    return;
+
+  for (;;) {
+    // Take in the areas the bounding rectangle would not grow
+    for (i = 0; i < n;) {
+      if (mergeCost(rects[i], r) <= 0) {
+        r = rectUnion(rects[i], r);
+        remove(i);
+        i = 0; // r grew: check the others again
+      } else {
+        i++;
+      }
+    }
+    if (n < SPITFT_DAMAGE_RECTS)
+      break;
+
+    // Full: merge with the area that adds the fewest pixels
+    best = mergeCost(rects[0], r);
+    for (i = 1, j = 0; i < n; i++) {
+      cost = mergeCost(rects[i], r);
+      if (cost < best) {
+        best = cost;
+        j = i;
+      }
+    }
+    r = rectUnion(rects[j], r);
+    remove(j);
+    forced++;
+  }
+  rects[n++] = r;
+}
+
+/*!
+    @brief  Add all the areas of another list.
+    @param  other  Areas.
+*/
+void SPITFT_Damage::add(const SPITFT_Damage &other) {
+  for (uint8_t i = 0; i < other.n; i++)
+    add(other.rects[i].x, other.rects[i].y, other.rects[i].w,
+        other.rects[i].h);
+}
+
+/*!
+    @brief  Remove an area.
+    @param  i  Index, below count().
+*/
+void SPITFT_Damage::remove(uint8_t i) {
+  if (i >= n)
+    return;
+  for (n--; i < n; i++)
+    rects[i] = rects[i + 1];
+}
+
+/*!
+    @brief  Crop the areas to the screen, dropping those outside.
+    @param  w  Screen width.
+    @param  h  Screen height.
+*/
+void SPITFT_Damage::clip(int16_t w, int16_t h) {
+  for (uint8_t i = 0; i < n;) {
+    SPITFT_Rect &r = rects[i];
+    if (r.x < 0) {
+      r.w += r.x;
+      r.x = 0;
+    }
+    if (r.y < 0) {
+      r.h += r.y;
+      r.y = 0;
+    }
+    if (r.x + r.w > w)
+      r.w = w - r.x;
+    if (r.y + r.h > h)
+      r.h = h - r.y;
+    if ((r.w <= 0) || (r.h <= 0))
+      remove(i);
+    else
+      i++;
+  }
+}
+
+/*!
+    @brief  Pixels covered by the areas (overlaps counted twice).
+    @return Pixels.
+*/
+uint32_t SPITFT_Damage::area(void) const {
+  uint32_t a = 0;
+
+  for (uint8_t i = 0; i < n; i++)
+    a += rectArea(rects[i]);
+  return a;
+}
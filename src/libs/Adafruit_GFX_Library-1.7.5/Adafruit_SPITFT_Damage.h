@@ -0,0 +1,69 @@
+/*!
+ * @file Adafruit_SPITFT_Damage.h
+ *
+ * Screen areas written since they were last taken, kept as a short list of
+ * rectangles. Adjacent or overlapping areas are merged when that does not
+ * grow them; when the list is full the two closest areas are merged, so the
+ * list never grows but may cover pixels that were not written.
+ *
+ * BSD license, all text here must be included in any redistribution.
+ */
+
+#ifndef _ADAFRUIT_SPITFT_DAMAGE_H_
+#define _ADAFRUIT_SPITFT_DAMAGE_H_
+
+#include <stdint.h>
+
+#define SPITFT_DAMAGE_RECTS 8 ///< Rectangles kept before merging
+
+/*!
+  @brief  Screen area
+*/
+typedef struct {
+  int16_t x; ///< Left
+  int16_t y; ///< Top
+  int16_t w; ///< Width
+  int16_t h; ///< Height
+} SPITFT_Rect;
+
+/*!
+  @brief  Bounded list of written screen areas.
+*/
+class SPITFT_Damage {
+public:
+  SPITFT_Damage(void);
+
+  void add(int16_t x, int16_t y, int16_t w, int16_t h);
+  void add(const SPITFT_Damage &other);
+  void remove(uint8_t i);
+  void clip(int16_t w, int16_t h);
+  uint32_t area(void) const;
+
+  /*!
+    @brief   Forget all areas.
+  */
+  void clear(void) { n = 0; }
+  /*!
+    @brief   Number of areas.
+    @return  Areas in the list.
+  */
+  uint8_t count(void) const { return n; }
+  /*!
+    @brief   Get an area.
+    @param   i  Index, below count(). Oldest areas first.
+    @return  Area.
+  */
+  const SPITFT_Rect &rect(uint8_t i) const { return rects[i]; }
+  /*!
+    @brief   Number of merges forced by a full list.
+    @return  Merges since the list was created.
+  */
+  uint32_t merges(void) const { return forced; }
+
+private:
+  SPITFT_Rect rects[SPITFT_DAMAGE_RECTS]; ///< Areas
+  uint8_t n = 0;                          ///< Number of areas
+  uint32_t forced = 0;                    ///< Forced merges
+};
+
+#endif // _ADAFRUIT_SPITFT_DAMAGE_H_
@@ -0,0 +1,526 @@
+/*!
+ * @file Adafruit_SPITFT_Shadow.cpp
+ *
+ * Copy of the display memory for Adafruit_SPITFT.
+ *
+ * BSD license, all text here must be included in any redistribution.
+ */
+
+#include "Adafruit_SPITFT_Shadow.h"
+#include <string.h>
+
+#define SHADOW_SOLID -1   ///< Tile state: single color (solid[])
+#define SHADOW_UNKNOWN -2 ///< Tile state: content unknown
+
+#define TILE_MASK (SPITFT_SHADOW_TILE - 1) ///< Position inside a tile
+
+/*!
+    @brief  Byte swap a pixel.
+    @param  c  Pixel.
+    @return Swapped pixel.
+*/
+static inline uint16_t swap16(uint16_t c) { return (c >> 8) | (c << 8); }
+
+/*!
+    @brief  Constructor. The whole screen is unknown.
+    @param  w      Screen width (current rotation).
+    @param  h      Screen height (current rotation).
+    @param  pool   Tile buffers, slots * SPITFT_SHADOW_TILE_PIXELS pixels.
+                   Not owned, must outlive the shadow.
+    @param  slots  Number of tile buffers. With fewer buffers than tiles,
+                   the least recently written tiles are dropped (unknown)
+                   when more are needed.
+*/
+SPITFT_Shadow::SPITFT_Shadow(uint16_t w, uint16_t h, uint16_t *pool,
+                             uint16_t slots)
+    : pool(pool) {
+  ntiles = tileCount(w, h); // Same count once rotated
+  nslots = (slots < ntiles) ? slots : ntiles;
+  slot = new int16_t[ntiles];
+  solid = new uint16_t[ntiles];
+  lastWrite = new uint32_t[nslots ? nslots : 1];
+  owner = new uint16_t[nslots ? nslots : 1];
+  freeSlots = new uint16_t[nslots ? nslots : 1];
+  resetStats();
+  reset(w, h);
+}
+
+/*!
+    @brief  Destructor.
+*/
+SPITFT_Shadow::~SPITFT_Shadow() {
+  delete[] slot;
+  delete[] solid;
+  delete[] lastWrite;
+  delete[] owner;
+  delete[] freeSlots;
+}
+
+/*!
+    @brief  Forget the screen content, e.g. after a rotation.
+    @param  w  Screen width.
+    @param  h  Screen height.
+*/
+void SPITFT_Shadow::reset(uint16_t w, uint16_t h) {
+  _width = w;
+  _height = h;
+  tilesX = (w + SPITFT_SHADOW_TILE - 1) >> SPITFT_SHADOW_TILE_SHIFT;
+  for (uint16_t t = 0; t < ntiles; t++)
+    slot[t] = SHADOW_UNKNOWN;
+  for (nfree = 0; nfree < nslots; nfree++)
+    freeSlots[nfree] = nslots - 1 - nfree;
+  winW = winH = 0;
+}
+
+/*!
+    @brief  Follow setAddrWindow(): next pixels go to this window.
+    @param  x  Left.
+    @param  y  Top.
+    @param  w  Width.
+    @param  h  Height.
+*/
+void SPITFT_Shadow::window(int16_t x, int16_t y, int16_t w, int16_t h) {
+  winX = curX = x;
+  winY = curY = y;
+  winW = w;
+  winH = h;
+}
+
+/*!
+    @brief  Follow writePixels().
+    @param  colors     Pixels.
+    @param  len        Number of pixels.
+    @param  bigEndian  Pixels are byte swapped in memory.
+*/
+void SPITFT_Shadow::writePixels(const uint16_t *colors, uint32_t len,
+                                bool bigEndian) {
+  while (len && (winW > 0) && (winH > 0)) {
+    uint32_t n = winX + winW - curX;
+    if (n > len)
+      n = len;
+    writeSpan(curX, curY, n, colors, 0, bigEndian);
+    colors += n;
+    len -= n;
+    if ((curX += n) >= winX + winW) { // Same wrapping as the display
+      curX = winX;
+      if (++curY >= winY + winH)
+        curY = winY;
+    }
+  }
+}
+
+/*!
+    @brief  Follow writeColor().
+    @param  color  Color.
+    @param  len    Number of pixels.
+*/
+void SPITFT_Shadow::writeColor(uint16_t color, uint32_t len) {
+  if ((winW <= 0) || (winH <= 0))
+    return;
+  if ((curX == winX) && (curY == winY) && (len == (uint32_t)winW * winH)) {
+    fillRect(winX, winY, winW, winH, color); // Whole window
+    return;
+  }
+  while (len) {
+    uint32_t n = winX + winW - curX;
+    if (n > len)
+      n = len;
+    writeSpan(curX, curY, n, NULL, color, false);
+    len -= n;
+    if ((curX += n) >= winX + winW) {
+      curX = winX;
+      if (++curY >= winY + winH)
+        curY = winY;
+    }
+  }
+}
+
+/*!
+    @brief   Check if a fill can be skipped. Counted as skipped if so.
+    @param   x      Left.
+    @param   y      Top.
+    @param   w      Width.
+    @param   h      Height.
+    @param   color  Fill color.
+    @return  true if all the pixels are known to have this color already.
+*/
+bool SPITFT_Shadow::skipFill(int16_t x, int16_t y, int16_t w, int16_t h,
+                             uint16_t color) {
+  if (!inside(x, y, w, h))
+    return false;
+  for (int16_t j = 0; j < h; j++) {
+    if (compareSpan(x, y + j, w, NULL, color, NULL, NULL))
+      return false;
+  }
+  st.fillsSkipped++;
+  st.pixelsSkipped += (uint32_t)w * h;
+  return true;
+}
+
+/*!
+    @brief   Crop a bitmap to the bounding box of the pixels it changes.
+    @param   x       Left, updated.
+    @param   y       Top, updated.
+    @param   w       Width, updated.
+    @param   h       Height, updated.
+    @param   colors  Pixels.
+    @param   stride  Pixels per bitmap row.
+    @param   offset  Set to the first pixel to send, from colors.
+    @return  false if nothing changes (don't send anything).
+*/
+bool SPITFT_Shadow::cropBitmap(int16_t *x, int16_t *y, int16_t *w,
+                               int16_t *h, const uint16_t *colors,
+                               int16_t stride, uint32_t *offset) {
+  int16_t x0 = *w, x1 = -1, y0 = -1, y1 = -1, first, last;
+
+  *offset = 0;
+  if (!inside(*x, *y, *w, *h))
+    return true;
+  for (int16_t j = 0; j < *h; j++) {
+    if (!compareSpan(*x, *y + j, *w, colors + (uint32_t)j * stride, 0,
+                     &first, &last))
+      continue;
+    if (y0 < 0)
+      y0 = j;
+    y1 = j;
+    if (first < x0)
+      x0 = first;
+    if (last > x1)
+      x1 = last;
+  }
+
+  uint32_t pixels = (uint32_t)*w * *h;
+  if (y0 < 0) {
+    st.bitmapsSkipped++;
+    st.pixelsSkipped += pixels;
+    return false;
+  }
+  *offset = (uint32_t)y0 * stride + x0;
+  *x += x0;
+  *y += y0;
+  *w = x1 - x0 + 1;
+  *h = y1 - y0 + 1;
+  if ((uint32_t)*w * *h < pixels) {
+    st.bitmapsCropped++;
+    st.pixelsSkipped += pixels - (uint32_t)*w * *h;
+  }
+  return true;
+}
+
+/*!
+    @brief   Read a pixel.
+    @param   x      Column.
+    @param   y      Row.
+    @param   color  Set to the pixel color, if known.
+    @return  false if the pixel is unknown (or off screen).
+*/
+bool SPITFT_Shadow::getPixel(int16_t x, int16_t y, uint16_t *color) const {
+  if ((x < 0) || (y < 0) || (x >= _width) || (y >= _height))
+    return false;
+  uint16_t t = (y >> SPITFT_SHADOW_TILE_SHIFT) * tilesX +
+               (x >> SPITFT_SHADOW_TILE_SHIFT);
+  if (slot[t] == SHADOW_UNKNOWN)
+    return false;
+  if (slot[t] == SHADOW_SOLID)
+    *color = solid[t];
+  else
+    *color = tilePixels(t)[((y & TILE_MASK) << SPITFT_SHADOW_TILE_SHIFT) +
+                           (x & TILE_MASK)];
+  return true;
+}
+
+/*!
+    @brief   Read a rectangle, like readPixels16() of the display.
+    @param   x    Left.
+    @param   y    Top.
+    @param   w    Width.
+    @param   h    Height.
+    @param   buf  w * h pixels, unknown pixels are set to 0.
+    @return  true if all the pixels are known.
+*/
+bool SPITFT_Shadow::readPixels(int16_t x, int16_t y, int16_t w, int16_t h,
+                               uint16_t *buf) const {
+  bool known = true;
+
+  for (int16_t j = 0; j < h; j++) {
+    for (int16_t i = 0; i < w; i++, buf++) {
+      if (!getPixel(x + i, y + j, buf)) {
+        *buf = 0;
+        known = false;
+      }
+    }
+  }
+  return known;
+}
+
+/*!
+    @brief   Count the known pixels.
+    @return  Pixels of the screen held by the shadow.
+*/
+uint32_t SPITFT_Shadow::knownPixels(void) const {
+  uint32_t n = 0;
+
+  for (uint16_t t = 0; t < tileCount(_width, _height); t++) {
+    if (slot[t] == SHADOW_UNKNOWN)
+      continue;
+    int16_t tx = (t % tilesX) << SPITFT_SHADOW_TILE_SHIFT;
+    int16_t ty = (t / tilesX) << SPITFT_SHADOW_TILE_SHIFT;
+    n += (uint32_t)((_width - tx < SPITFT_SHADOW_TILE) ? _width - tx
+                                                       : SPITFT_SHADOW_TILE) *
+         ((_height - ty < SPITFT_SHADOW_TILE) ? _height - ty
+                                              : SPITFT_SHADOW_TILE);
+  }
+  return n;
+}
+
+/*!
+    @brief  Reset the counters.
+*/
+void SPITFT_Shadow::resetStats(void) { memset(&st, 0, sizeof(st)); }
+
+/*!
+    @brief  Fill a rectangle: tiles entirely covered become single color.
+    @param  x      Left.
+    @param  y      Top.
+    @param  w      Width.
+    @param  h      Height.
+    @param  color  Color.
+*/
+void SPITFT_Shadow::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                             uint16_t color) {
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    y = 0;
+  }
+  if (x + w > _width)
+    w = _width - x;
+  if (y + h > _height)
+    h = _height - y;
+  if ((w <= 0) || (h <= 0))
+    return;
+
+  for (int16_t ty = y & ~TILE_MASK; ty < y + h; ty += SPITFT_SHADOW_TILE) {
+    int16_t iy = (ty > y) ? ty : y;
+    int16_t ih = ((ty + SPITFT_SHADOW_TILE < y + h) ? ty + SPITFT_SHADOW_TILE
+                                                    : y + h) - iy;
+    int16_t th = (_height - ty < SPITFT_SHADOW_TILE) ? _height - ty
+                                                     : SPITFT_SHADOW_TILE;
+    for (int16_t tx = x & ~TILE_MASK; tx < x + w; tx += SPITFT_SHADOW_TILE) {
+      int16_t ix = (tx > x) ? tx : x;
+      int16_t iw = ((tx + SPITFT_SHADOW_TILE < x + w) ? tx + SPITFT_SHADOW_TILE
+                                                      : x + w) - ix;
+      int16_t tw = (_width - tx < SPITFT_SHADOW_TILE) ? _width - tx
+                                                      : SPITFT_SHADOW_TILE;
+      if ((iw == tw) && (ih == th)) {
+        uint16_t t = (ty >> SPITFT_SHADOW_TILE_SHIFT) * tilesX +
+                     (tx >> SPITFT_SHADOW_TILE_SHIFT);
+        freeSlot(t);
+        slot[t] = SHADOW_SOLID;
+        solid[t] = color;
+      } else {
+        for (int16_t j = 0; j < ih; j++)
+          writeSpan(ix, iy + j, iw, NULL, color, false);
+      }
+    }
+  }
+}
+
+/*!
+    @brief  Write a row of pixels.
+    @param  x       Left.
+    @param  y       Row.
+    @param  n       Number of pixels.
+    @param  colors  Pixels, or NULL to write n times color.
+    @param  color   Color if colors is NULL.
+    @param  swap    Pixels are byte swapped.
+*/
+void SPITFT_Shadow::writeSpan(int16_t x, int16_t y, int16_t n,
+                              const uint16_t *colors, uint16_t color,
+                              bool swap) {
+  if ((y < 0) || (y >= _height))
+    return;
+  if (x < 0) {
+    if (colors)
+      colors -= x;
+    n += x;
+    x = 0;
+  }
+  if (x + n > _width)
+    n = _width - x;
+  if (n <= 0)
+    return;
+
+  uint16_t t = (y >> SPITFT_SHADOW_TILE_SHIFT) * tilesX +
+               (x >> SPITFT_SHADOW_TILE_SHIFT);
+  uint16_t row = (y & TILE_MASK) << SPITFT_SHADOW_TILE_SHIFT;
+  int16_t i, m, s;
+
+  seq++;
+  for (; n > 0; n -= m, t++) {
+    int16_t col = x & TILE_MASK;
+    m = SPITFT_SHADOW_TILE - col;
+    if (m > n)
+      m = n;
+    s = slot[t];
+    if (s == SHADOW_UNKNOWN) {
+      // A window covering the whole tile rewrites all of its pixels
+      if (!row && !col && covers(t))
+        s = allocSlot(t);
+    } else if (s == SHADOW_SOLID) {
+      for (i = 0; i < m; i++) {
+        uint16_t c = colors ? (swap ? swap16(colors[i]) : colors[i]) : color;
+        if (c != solid[t])
+          break;
+      }
+      if (i < m) {
+        uint16_t c = solid[t];
+        if ((s = allocSlot(t)) >= 0) {
+          uint16_t *p = tilePixels(t);
+          for (i = 0; i < SPITFT_SHADOW_TILE_PIXELS; i++)
+            p[i] = c;
+        }
+      }
+    }
+    if (s >= 0) {
+      uint16_t *p = tilePixels(t) + row + col;
+      if (!colors) {
+        for (i = 0; i < m; i++)
+          p[i] = color;
+      } else if (swap) {
+        for (i = 0; i < m; i++)
+          p[i] = swap16(colors[i]);
+      } else {
+        memcpy(p, colors, m * sizeof(uint16_t));
+      }
+      lastWrite[s] = seq;
+    }
+    x += m;
+    if (colors)
+      colors += m;
+  }
+}
+
+/*!
+    @brief   Compare a row of pixels with the shadow.
+    @param   x       Left.
+    @param   y       Row.
+    @param   n       Number of pixels (on screen).
+    @param   colors  Pixels, or NULL to compare with color.
+    @param   color   Color if colors is NULL.
+    @param   first   Set to the first differing pixel (can be NULL).
+    @param   last    Set to the last differing pixel (can be NULL).
+    @return  true if a pixel differs or is unknown.
+*/
+bool SPITFT_Shadow::compareSpan(int16_t x, int16_t y, int16_t n,
+                                const uint16_t *colors, uint16_t color,
+                                int16_t *first, int16_t *last) const {
+  uint16_t t = (y >> SPITFT_SHADOW_TILE_SHIFT) * tilesX +
+               (x >> SPITFT_SHADOW_TILE_SHIFT);
+  uint16_t row = (y & TILE_MASK) << SPITFT_SHADOW_TILE_SHIFT;
+  int16_t i, j, m, lo = -1, hi = -1;
+
+  for (i = 0; i < n; i += m, t++) {
+    int16_t col = (x + i) & TILE_MASK;
+    m = SPITFT_SHADOW_TILE - col;
+    if (m > n - i)
+      m = n - i;
+    if (slot[t] == SHADOW_UNKNOWN) {
+      if (lo < 0)
+        lo = i;
+      hi = i + m - 1;
+    } else {
+      const uint16_t *p =
+          (slot[t] == SHADOW_SOLID) ? NULL : tilePixels(t) + row + col;
+      for (j = 0; j < m; j++) {
+        uint16_t c = colors ? colors[i + j] : color;
+        if (c == (p ? p[j] : solid[t]))
+          continue;
+        if (lo < 0)
+          lo = i + j;
+        hi = i + j;
+      }
+    }
+    if ((lo >= 0) && !first)
+      return true; // Any difference will do
+  }
+  if (first)
+    *first = lo;
+  if (last)
+    *last = hi;
+  return lo >= 0;
+}
+
+/*!
+    @brief   Check a rectangle is on screen.
+    @param   x  Left.
+    @param   y  Top.
+    @param   w  Width.
+    @param   h  Height.
+    @return  true if all of it is on screen.
+*/
+bool SPITFT_Shadow::inside(int16_t x, int16_t y, int16_t w, int16_t h) const {
+  return (x >= 0) && (y >= 0) && (w > 0) && (h > 0) && (x + w <= _width) &&
+         (y + h <= _height);
+}
+
+/*!
+    @brief   Check if the address window covers a whole tile.
+    @param   t  Tile.
+    @return  true if covered.
+*/
+bool SPITFT_Shadow::covers(uint16_t t) const {
+  int16_t tx = (t % tilesX) << SPITFT_SHADOW_TILE_SHIFT;
+  int16_t ty = (t / tilesX) << SPITFT_SHADOW_TILE_SHIFT;
+  int16_t tw = (_width - tx < SPITFT_SHADOW_TILE) ? _width - tx
+                                                  : SPITFT_SHADOW_TILE;
+  int16_t th = (_height - ty < SPITFT_SHADOW_TILE) ? _height - ty
+                                                   : SPITFT_SHADOW_TILE;
+  return (winX <= tx) && (winY <= ty) && (winX + winW >= tx + tw) &&
+         (winY + winH >= ty + th);
+}
+
+/*!
+    @brief   Give a tile buffer to a tile. When none is free, the least
+             recently written tile is dropped.
+    @param   t  Tile (without a buffer).
+    @return  Tile buffer, or -1 (the tile is then unknown).
+*/
+int16_t SPITFT_Shadow::allocSlot(uint16_t t) {
+  int16_t s = -1;
+
+  if (nfree) {
+    s = freeSlots[--nfree];
+  } else if (nslots) {
+    s = 0;
+    for (int16_t i = 1; i < nslots; i++) {
+      if ((int32_t)(lastWrite[i] - lastWrite[s]) < 0)
+        s = i;
+    }
+    slot[owner[s]] = SHADOW_UNKNOWN;
+    st.evictions++;
+  }
+  if (s < 0) {
+    slot[t] = SHADOW_UNKNOWN;
+    return -1;
+  }
+  slot[t] = s;
+  owner[s] = t;
+  lastWrite[s] = seq;
+  return s;
+}
+
+/*!
+    @brief  Take back the tile buffer of a tile, if any. The tile state
+            must be set by the caller.
+    @param  t  Tile.
+*/
+void SPITFT_Shadow::freeSlot(uint16_t t) {
+  if (slot[t] >= 0) {
+    freeSlots[nfree++] = slot[t];
+    slot[t] = SHADOW_UNKNOWN;
+  }
+}
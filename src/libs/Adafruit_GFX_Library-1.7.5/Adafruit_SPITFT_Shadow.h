@@ -0,0 +1,124 @@
+/*!
+ * @file Adafruit_SPITFT_Shadow.h
+ *
+ * Copy of the display memory for Adafruit_SPITFT, kept up to date by the
+ * pixel write functions. The screen is split in square tiles: a tile holds
+ * a single color, its own pixels (from a pool of tile buffers, that can be
+ * smaller than the screen) or is unknown. Writes that would not change the
+ * display can be skipped and the screen can be read back without the bus.
+ *
+ * BSD license, all text here must be included in any redistribution.
+ */
+
+#ifndef _ADAFRUIT_SPITFT_SHADOW_H_
+#define _ADAFRUIT_SPITFT_SHADOW_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SPITFT_SHADOW_TILE_SHIFT 4 ///< Tile side: 16 pixels
+#define SPITFT_SHADOW_TILE (1 << SPITFT_SHADOW_TILE_SHIFT) ///< Tile side
+#define SPITFT_SHADOW_TILE_PIXELS                                              \
+  (SPITFT_SHADOW_TILE * SPITFT_SHADOW_TILE) ///< Pixels per tile buffer
+
+/*!
+  @brief  Shadow counters
+*/
+typedef struct {
+  uint32_t fillsSkipped;   ///< Fills not sent, the pixels already matched
+  uint32_t bitmapsSkipped; ///< Bitmaps not sent, the pixels already matched
+  uint32_t bitmapsCropped; ///< Bitmaps sent cropped to their changes
+  uint32_t pixelsSkipped;  ///< Pixels not sent
+  uint32_t evictions;      ///< Tile buffers taken back (tile unknown)
+} SPITFT_ShadowStats;
+
+/*!
+  @brief  Tiled copy of the display memory, in the coordinates of the
+          current rotation.
+*/
+class SPITFT_Shadow {
+public:
+  SPITFT_Shadow(uint16_t w, uint16_t h, uint16_t *pool, uint16_t slots);
+  ~SPITFT_Shadow();
+
+  /*!
+    @brief   Number of tiles covering a screen.
+    @param   w  Width.
+    @param   h  Height.
+    @return  Tiles (tile buffers needed to mirror the whole screen).
+  */
+  static uint16_t tileCount(uint16_t w, uint16_t h) {
+    return ((w + SPITFT_SHADOW_TILE - 1) >> SPITFT_SHADOW_TILE_SHIFT) *
+           ((h + SPITFT_SHADOW_TILE - 1) >> SPITFT_SHADOW_TILE_SHIFT);
+  }
+
+  void reset(uint16_t w, uint16_t h);
+  void window(int16_t x, int16_t y, int16_t w, int16_t h);
+  void writePixels(const uint16_t *colors, uint32_t len,
+                   bool bigEndian = false);
+  void writeColor(uint16_t color, uint32_t len);
+
+  bool skipFill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  bool cropBitmap(int16_t *x, int16_t *y, int16_t *w, int16_t *h,
+                  const uint16_t *colors, int16_t stride, uint32_t *offset);
+
+  bool getPixel(int16_t x, int16_t y, uint16_t *color) const;
+  bool readPixels(int16_t x, int16_t y, int16_t w, int16_t h,
+                  uint16_t *buf) const;
+  uint32_t knownPixels(void) const;
+
+  /*!
+    @brief   Width of the mirrored screen.
+    @return  Pixels.
+  */
+  uint16_t width(void) const { return _width; }
+  /*!
+    @brief   Height of the mirrored screen.
+    @return  Pixels.
+  */
+  uint16_t height(void) const { return _height; }
+  /*!
+    @brief   Number of tile buffers.
+    @return  Tile buffers in the pool.
+  */
+  uint16_t slots(void) const { return nslots; }
+  const SPITFT_ShadowStats &stats(void) const { return st; }
+  void resetStats(void);
+
+private:
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void writeSpan(int16_t x, int16_t y, int16_t n, const uint16_t *colors,
+                 uint16_t color, bool swap);
+  bool compareSpan(int16_t x, int16_t y, int16_t n, const uint16_t *colors,
+                   uint16_t color, int16_t *first, int16_t *last) const;
+  bool inside(int16_t x, int16_t y, int16_t w, int16_t h) const;
+  bool covers(uint16_t t) const;
+  int16_t allocSlot(uint16_t t);
+  void freeSlot(uint16_t t);
+  uint16_t *tilePixels(uint16_t t) const {
+    return pool + (uint32_t)slot[t] * SPITFT_SHADOW_TILE_PIXELS;
+  }
+
+  uint16_t *pool;            ///< Tile buffers (not owned)
+  uint16_t nslots;           ///< Tile buffers in the pool
+  uint16_t ntiles;           ///< Tiles allocated (any rotation)
+  int16_t *slot;             ///< Tile buffer of each tile, or a state
+  uint16_t *solid;           ///< Color of single color tiles
+  uint32_t *lastWrite;       ///< Write sequence of each tile buffer
+  uint16_t *owner;           ///< Tile of each tile buffer
+  uint16_t *freeSlots;       ///< Unused tile buffers
+  uint16_t nfree = 0;        ///< Number of unused tile buffers
+  uint32_t seq = 0;          ///< Write sequence
+  uint16_t _width = 0;       ///< Screen width
+  uint16_t _height = 0;      ///< Screen height
+  uint16_t tilesX = 0;       ///< Tiles per row
+  int16_t winX = 0;          ///< Address window
+  int16_t winY = 0;          ///< Address window
+  int16_t winW = 0;          ///< Address window
+  int16_t winH = 0;          ///< Address window
+  int16_t curX = 0;          ///< Next pixel written
+  int16_t curY = 0;          ///< Next pixel written
+  SPITFT_ShadowStats st;     ///< Counters
+};
+
+#endif // _ADAFRUIT_SPITFT_SHADOW_H_
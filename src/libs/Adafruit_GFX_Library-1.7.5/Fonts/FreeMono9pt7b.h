@@ -71,7 +71,7 @@ const uint8_t FreeMono9pt7bBitmaps[] PROGMEM = {
     0xBF, 0x29, 0x24, 0xA2, 0x49, 0x26, 0xFF, 0xF8, 0x89, 0x24, 0x8A, 0x49,
     0x2C, 0x61, 0x24, 0x30};
 
-const GFXglyph FreeMono9pt7bGlyphs[] PROGMEM = {
+constexpr GFXglyph FreeMono9pt7bGlyphs[] PROGMEM = {
     {0, 0, 0, 11, 0, 1},      // 0x20 ' '
     {0, 2, 11, 11, 4, -10},   // 0x21 '!'
     {3, 6, 5, 11, 2, -10},    // 0x22 '"'
@@ -168,8 +168,8 @@ const GFXglyph FreeMono9pt7bGlyphs[] PROGMEM = {
     {836, 3, 13, 11, 4, -10}, // 0x7D '}'
     {841, 7, 3, 11, 2, -6}};  // 0x7E '~'
 
-const GFXfont FreeMono9pt7b PROGMEM = {(uint8_t *)FreeMono9pt7bBitmaps,
-                                       (GFXglyph *)FreeMono9pt7bGlyphs, 0x20,
-                                       0x7E, 18};
+constexpr GFXfont FreeMono9pt7b PROGMEM = {(uint8_t *)FreeMono9pt7bBitmaps,
+                                           (GFXglyph *)FreeMono9pt7bGlyphs, 0x20,
+                                           0x7E, 18};
 
 // Approx. 1516 bytes
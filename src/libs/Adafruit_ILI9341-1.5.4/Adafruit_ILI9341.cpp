@@ -242,6 +242,8 @@ void Adafruit_ILI9341::setRotation(uint8_t m) {
   }
 
   sendCommand(ILI9341_MADCTL, &m, 1);
+  if (shadow)
+    shadow->reset(_width, _height); // Same memory, new coordinates
 }
 
 /**************************************************************************/
@@ -303,6 +305,7 @@ void Adafruit_ILI9341::setScrollMargins(uint16_t top, uint16_t bottom) {
 void Adafruit_ILI9341::setAddrWindow(uint16_t x1, uint16_t y1, uint16_t w,
                                      uint16_t h) {
   uint16_t x2 = (x1 + w - 1), y2 = (y1 + h - 1);
+  SPITFT_COUNT(addrWindows, 1);
   writeCommand(ILI9341_CASET); // Column address set
   SPI_WRITE16(x1);
   SPI_WRITE16(x2);
@@ -310,6 +313,10 @@ void Adafruit_ILI9341::setAddrWindow(uint16_t x1, uint16_t y1, uint16_t w,
   SPI_WRITE16(y1);
   SPI_WRITE16(y2);
   writeCommand(ILI9341_RAMWR); // Write to RAM
+  if (shadow)
+    shadow->window(x1, y1, w, h);
+  if (damage)
+    damage->add(x1, y1, w, h);
 }
 
 /**************************************************************************/
@@ -877,17 +877,20 @@ void AsyncWebSocket::_handleEvent(AsyncWebSocketClient * client, AwsEventType ty
 }
 
 void AsyncWebSocket::_addClient(AsyncWebSocketClient * client){
+  AsyncWebLockGuard l(_lock);
   _clients.add(client);
 }
 
 void AsyncWebSocket::_handleDisconnect(AsyncWebSocketClient * client){
-  
+  // The list deletes the client: not while an id based call uses it
+  AsyncWebLockGuard l(_lock);
   _clients.remove_first([=](AsyncWebSocketClient * c){
     return c->id() == client->id();
   });
 }
 
 bool AsyncWebSocket::availableForWriteAll(){
+  AsyncWebLockGuard l(_lock);
   for(const auto& c: _clients){
     if(c->queueIsFull()) return false;
   }
@@ -895,6 +898,7 @@ bool AsyncWebSocket::availableForWriteAll(){
 }
 
 bool AsyncWebSocket::availableForWrite(uint32_t id){
+  AsyncWebLockGuard l(_lock);
   for(const auto& c: _clients){
     if(c->queueIsFull() && (c->id() == id )) return false;
   }
@@ -902,6 +906,7 @@ bool AsyncWebSocket::availableForWrite(uint32_t id){
 }
 
 size_t AsyncWebSocket::count() const {
+  AsyncWebLockGuard l(_lock);
   return _clients.count_if([](AsyncWebSocketClient * c){
     return c->status() == WS_CONNECTED;
   });
@@ -916,8 +921,13 @@ AsyncWebSocketClient * AsyncWebSocket::client(uint32_t id){
   return nullptr;
 }
 
+bool AsyncWebSocket::hasClient(uint32_t id){
+  AsyncWebLockGuard l(_lock);
+  return client(id) != NULL;
+}
 
 void AsyncWebSocket::close(uint32_t id, uint16_t code, const char * message){
+  AsyncWebLockGuard l(_lock);
   AsyncWebSocketClient * c = client(id);
   if(c)
     c->close(code, message);
@@ -938,6 +948,7 @@ void AsyncWebSocket::cleanupClients(uint16_t maxClients)
 }
 
 void AsyncWebSocket::ping(uint32_t id, uint8_t *data, size_t len){
+  AsyncWebLockGuard l(_lock);
   AsyncWebSocketClient * c = client(id);
   if(c)
     c->ping(data, len);
@@ -951,6 +962,7 @@ void AsyncWebSocket::pingAll(uint8_t *data, size_t len){
 }
 
 void AsyncWebSocket::text(uint32_t id, const char * message, size_t len){
+  AsyncWebLockGuard l(_lock);
   AsyncWebSocketClient * c = client(id);
   if(c)
     c->text(message, len);
@@ -975,6 +987,7 @@ void AsyncWebSocket::textAll(const char * message, size_t len){
 }
 
 void AsyncWebSocket::binary(uint32_t id, const char * message, size_t len){
+  AsyncWebLockGuard l(_lock);
   AsyncWebSocketClient * c = client(id);
   if(c)
     c->binary(message, len);
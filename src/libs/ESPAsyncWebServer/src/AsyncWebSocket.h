@@ -24,11 +24,15 @@
 #include <Arduino.h>
 #ifdef ESP32
 #include <AsyncTCP.h>
+#ifndef WS_MAX_QUEUED_MESSAGES
 #define WS_MAX_QUEUED_MESSAGES 32
+#endif
 #else
 #include <ESPAsyncTCP.h>
+#ifndef WS_MAX_QUEUED_MESSAGES
 #define WS_MAX_QUEUED_MESSAGES 8
 #endif
+#endif
 #include <ESPAsyncWebServer.h>
 
 #include "AsyncWebSynchronization.h"
@@ -261,8 +265,10 @@ class AsyncWebSocket: public AsyncWebHandler {
     bool availableForWrite(uint32_t id);
 
     size_t count() const;
+    // Not locked: the client may be deleted by the async_tcp task, other
+    // tasks use the id based calls below
     AsyncWebSocketClient * client(uint32_t id);
-    bool hasClient(uint32_t id){ return client(id) != NULL; }
+    bool hasClient(uint32_t id);
 
     void close(uint32_t id, uint16_t code=0, const char * message=NULL);
     void closeAll(uint16_t code=0, const char * message=NULL);
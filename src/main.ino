@@ -46,18 +46,32 @@
 #include "nexus.h"
 #include "ETheme.h"
 #include "EInterface.h"
+#include "ERenderQueue.h"
+#include "ETftDMA.h"
+#include "ENetwork.h"
 #include "OpenWeather.h"
+#include "EWeatherScheduler.h"
 #include "UserConf.h"
 #include "webservices.cpp"
 
 /** User configuration data */
 UserConf confData;
-/** Embedded GUI */
+/** Embedded GUI (drawn by the render task once it is running) */
 EInterface *gui = NULL;
+/** Screen updates, posted by the tasks and drawn by the render task */
+ERenderQueue screen;
+/** Render task */
+TaskHandle_t renderTask = NULL;
+/** DMA transfers to the TFT module */
+ETftDMA tftDMA(TFT_SPI_FREQ);
 /** Color theme */
 ETheme colorTheme;
+/** Outbound requests: kept-alive connections and DNS cache */
+ENetwork network;
 /** OpenWeather */
 OpenWeather weatherWS;
+/** Weather refresh scheduler */
+EWeatherScheduler weatherSched(&weatherWS);
 /** Wall clock */
 tmElements_t wallClock;
 /** Web server */
@@ -74,7 +88,7 @@ HTU2XSensor tempHSensor;
 #error You should enable at least one Temperature/Humidity sensor
 #endif
 
-/** Mutex for screen update */
+/** Mutex for screen access (render task and screenshots) */
 volatile SemaphoreHandle_t t_mutex;
 
 /** Mutex for wall clock update */
@@ -89,14 +103,11 @@ volatile SemaphoreHandle_t setup_sem;
 /** WiFi reset */
 volatile SemaphoreHandle_t wifi_mutex;
 
-/** Last weather information update */
-unsigned long lastUpdate;
-
 /** Last NTP date/time update */
 unsigned long lastNTPUpdate;
 
 /** Update the date on main screen */
-bool updateStrDate;
+volatile bool updateStrDate;
 
 
 /**
@@ -197,19 +208,15 @@ void updateFromConf(void)
 	writeClock(&wallClock);
 	xSemaphoreGive(clk_mutex);
 
-	xSemaphoreTake(t_mutex, portMAX_DELAY);
 	// LCD backlight
-	gui->setBacklight(confData.getLCDBrightness());
+	screen.setBacklight(confData.getLCDBrightness());
 	// Temperature scale
-	gui->setTempScale(confData.getTempScale());
+	screen.setTempScale(confData.getTempScale());
 	// Time format
-	gui->setTimeFormat(confData.getTimeFormat());
-	xSemaphoreGive(t_mutex);
+	screen.setTimeFormat(confData.getTimeFormat());
 
 	// Set to update date string
-	xSemaphoreTake(t_mutex, portMAX_DELAY);
 	updateStrDate = true;
-	xSemaphoreGive(t_mutex);
 }
 
 /**
@@ -226,26 +233,61 @@ void factoryReset(void)
 	// Should never reach here: do not release the mutex for safety reasons
 }
 
-#ifdef DEBUG_SCREENSHOT
 /**
- * Take a screenshot of the screen (for debug purposes)
+ * Wake up the render task
+ * @param arg Render task handle
  */
-void takeScreenshot(void)
+void wakeRender(void *arg)
 {
-	digitalWrite(LED_PIN, HIGH);
-	xSemaphoreTake(t_mutex, portMAX_DELAY);
-	gui->takeScreenshot("/screenshot.px");
-	delay(100);
-	xSemaphoreGive(t_mutex);
-	digitalWrite(LED_PIN, LOW);
+	xTaskNotifyGive((TaskHandle_t)arg);
 }
+
+/**
+ * Draw the screen updates posted by the other tasks
+ *
+ * This is the only task that draws on the screen. Frames are drawn when
+ * updates are posted (or an icon is blinking), at most one every
+ * RENDER_FRAME_MS: updates posted meanwhile are coalesced.
+ *
+ * @param parameter Task parameters (not used)
+ */
+void taskRender(void *parameter)
+{
+	unsigned long wait = 0, last = 0, elapsed;
+#if GUI_PROFILE
+	unsigned long logged = millis();
 #endif
 
+	while (1) {
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+
+		elapsed = millis() - last;
+		if (elapsed < RENDER_FRAME_MS)
+			delay(RENDER_FRAME_MS - elapsed);
+		last = millis();
+
+		xSemaphoreTake(t_mutex, portMAX_DELAY);
+		wait = screen.render(gui);
+#ifdef SCREEN_STREAM
+		// Come back soon for the viewers that could not take everything
+		if (updateScreenStream() && wait > RENDER_FRAME_MS)
+			wait = RENDER_FRAME_MS;
+#endif
+#if GUI_PROFILE
+		if (millis() - logged >= GUI_PROFILE_LOG_MS) {
+			gui->getProfiler()->log();
+			logged = millis();
+		}
+#endif
+		xSemaphoreGive(t_mutex);
+	}
+}
+
 /**
- * Update graphical elements on the screen
+ * Update the clock on the screen
  * @param parameter Task parameters (not used)
  */
-void taskUpdateScreen(void *parameter)
+void taskUpdateClock(void *parameter)
 {
 	int ret;
 	updateStrDate = true;
@@ -272,17 +314,13 @@ void taskUpdateScreen(void *parameter)
 				updateStrDate = true;
 			}
 
-			xSemaphoreTake(t_mutex, portMAX_DELAY);
-			if (gui) {
-				gui->setHours(wallClock.Hour);
-				gui->setMinutes(wallClock.Minute);
-				gui->setSeconds(wallClock.Second);
-				if (updateStrDate) {
-					gui->setDate(formatDate(wallClock));
-					updateStrDate = false;
-				}
+			screen.setHours(wallClock.Hour);
+			screen.setMinutes(wallClock.Minute);
+			screen.setSeconds(wallClock.Second);
+			if (updateStrDate) {
+				screen.setDate(formatDate(wallClock));
+				updateStrDate = false;
 			}
-			xSemaphoreGive(t_mutex);
 		}
 		delay(1000);
 	}
@@ -297,34 +335,36 @@ void taskUpdateWeatherInfo(void *parameter)
 	int i;
 	float t1, tf1, tf2;
 	weather_info_t wfc;
+	unsigned int changed;
 
 	while (1) {
-		if (WiFi.status() == WL_CONNECTED) {
-			if ((now() - lastUpdate) >= WEATHER_UPDATE_INTERVAL) {
-				lastUpdate = now();
+		if (WiFi.status() == WL_CONNECTED &&
+				weatherSched.nextPoll(millis()) == 0) {
+			if (weatherSched.poll(millis(), &changed) != 0)
+				log_e("Error to retrieve forecast!");
 
-				if (weatherWS.updateForecast() != 0) {
-					log_e("Error to retrieve forecast!");
-				} else {
-					weather_info_t w = weatherWS.getDailyForecast();
-					t1 = OpenWeather::convKelvinTemp(w.temp, CELSIUS);
-
-					xSemaphoreTake(t_mutex, portMAX_DELAY);
-					gui->showWeather(w.weather, 0);
-
-					for (i = 0; i < 3; i++) {
-						wfc = weatherWS.getWeeklyForecast(i);
-						tf1 = OpenWeather::convKelvinTemp(wfc.feels, CELSIUS);
-						tf2 = OpenWeather::convKelvinTemp(wfc.temp, CELSIUS);
-
-						gui->showForecastLabel(i, dayShortStr(weekday(wfc.date)));
-						gui->showForecastTemp1(i, tf1);
-						gui->showForecastTemp2(i, tf2);
-						gui->showForecastWeather(i, wfc.weather);
-					}
-					xSemaphoreGive(t_mutex);
+			// Only what changed is drawn again
+			if (changed & WEATHER_CHANGED_CURRENT) {
+				weather_info_t w = weatherWS.getDailyForecast();
+				t1 = OpenWeather::convKelvinTemp(w.temp, CELSIUS);
+
+				screen.showWeather(w.weather, 0);
+			}
+
+			if (changed & WEATHER_CHANGED_FORECAST) {
+				for (i = 0; i < 3; i++) {
+					wfc = weatherWS.getWeeklyForecast(i);
+					tf1 = OpenWeather::convKelvinTemp(wfc.feels, CELSIUS);
+					tf2 = OpenWeather::convKelvinTemp(wfc.temp, CELSIUS);
+
+					screen.showForecastLabel(i, dayShortStr(weekday(wfc.date)));
+					screen.showForecastTemp1(i, tf1);
+					screen.showForecastTemp2(i, tf2);
+					screen.showForecastWeather(i, wfc.weather);
 				}
 			}
+			log_d("UpdateWeatherInfo stack: %u bytes free",
+					uxTaskGetStackHighWaterMark(NULL));
 		}
 		delay(1000);
 	}
@@ -336,6 +376,8 @@ void taskUpdateWeatherInfo(void *parameter)
  */
 void taskUpdateNTP(void *parameter)
 {
+	static char ntpServer[NET_HOST_MAX];
+	IPAddress ntpIP;
 	int i;
 	float t1, tf1, tf2;
 	weather_info_t wfc;
@@ -345,19 +387,24 @@ void taskUpdateNTP(void *parameter)
 			if ((now() - lastNTPUpdate) >= NTP_UPDATE_INTERVAL) {
 				lastNTPUpdate = now();
 
-				// NTP update
+				// NTP update (SNTP keeps the server string: static, the
+				// address from the DNS cache, else the name)
+				if (network.resolve(confData.getNTPServer().c_str(), ntpIP))
+					strncpy(ntpServer, ntpIP.toString().c_str(),
+							sizeof(ntpServer) - 1);
+				else
+					strncpy(ntpServer, confData.getNTPServer().c_str(),
+							sizeof(ntpServer) - 1);
 				xSemaphoreTake(clk_mutex, portMAX_DELAY);
 				configTime(confData.getTimezone(), confData.getDaylight(),
-					confData.getNTPServer().c_str());
+					ntpServer);
 				// Update wall clock
 				getSysClock(&wallClock);
 				xSemaphoreGive(clk_mutex);
 
 				// Update date on screen (time will be updated on the next
 				// second)
-				xSemaphoreTake(t_mutex, portMAX_DELAY);
 				updateStrDate = true;
-				xSemaphoreGive(t_mutex);
 			}
 		}
 		delay(1000);
@@ -378,10 +425,8 @@ void taskReadTHSensor(void *parameter)
 					tempHSensor.getStatusString());
 		} else {
 			// Display data
-			xSemaphoreTake(t_mutex, portMAX_DELAY);
-			gui->showTemp1(tempHSensor.getTemperature());
-			gui->showHumidity1(tempHSensor.getHumidity());
-			xSemaphoreGive(t_mutex);
+			screen.showTemp1(tempHSensor.getTemperature());
+			screen.showHumidity1(tempHSensor.getHumidity());
 		}
 
 		delay(10000);
@@ -438,11 +483,7 @@ void taskReceiveSensorData(void *parameter)
 			portEXIT_CRITICAL(&nexusMutex);
 
 			// Indicate on screen that data has been received
-			xSemaphoreTake(t_mutex, portMAX_DELAY);
-			gui->showRadio(true);
-			delay(300);
-			gui->showRadio(false);
-			xSemaphoreGive(t_mutex);
+			screen.blinkRadio(1, RADIO_BLINK_TIME);
 		}
 
 		// Show data on the screen
@@ -452,19 +493,15 @@ void taskReceiveSensorData(void *parameter)
 				lastShow = now();
 				if ((lastShow - lastData[disp]) <= SENSOR_DATA_EXPIRATION) {
 					t = (float)sensors[disp].temperature / 10;
-					xSemaphoreTake(t_mutex, portMAX_DELAY);
-					gui->showChannel(sensors[disp].flags.fields.channel + 1);
-					gui->showTemp2(t);
-					gui->showHumidity2(sensors[disp].humidity);
-					xSemaphoreGive(t_mutex);
+					screen.showChannel(sensors[disp].flags.fields.channel + 1);
+					screen.showTemp2(t);
+					screen.showHumidity2(sensors[disp].humidity);
 				} else {
 					// Sensor data is expired, let's invalidate it
 					sensors[disp].flags.fields.channel = NEXUS_INVALID_CHANNEL;
-					xSemaphoreTake(t_mutex, portMAX_DELAY);
-					gui->showChannel(GUI_INV_CHANNEL);
-					gui->showTemp2(GUI_INV_TEMP);
-					gui->showHumidity2(GUI_INV_HUMIDITY);
-					xSemaphoreGive(t_mutex);
+					screen.showChannel(GUI_INV_CHANNEL);
+					screen.showTemp2(GUI_INV_TEMP);
+					screen.showHumidity2(GUI_INV_HUMIDITY);
 				}
 			}
 
@@ -518,7 +555,7 @@ void setup() {
 			TFT_BACKLIGHT, BACKLIGHT_DEFAULT, colorTheme,
 			&SPIFFS);
 
-	gui->initialize();
+	gui->initialize(&tftDMA);
 	gui->showLogo();
 	gui->showVersion(50, 200);
 	delay(700);
@@ -566,24 +603,29 @@ void setup() {
 	}
 
 	// Device is configured, proceed with initialization
-	lastUpdate    = now() - WEATHER_UPDATE_INTERVAL;
 	lastNTPUpdate = now() - NTP_UPDATE_INTERVAL + 5;
 
 	WiFi.mode(WIFI_STA);
 	WiFi.begin(confData.getWiFiSSID().c_str(),
 				confData.getWiFiPassword().c_str());
+	weatherWS.setNetwork(&network);
 	weatherWS.setAPIKey(confData.getAPIKey());
 	weatherWS.setCity(confData.getCity());
+	weatherSched.setIntervals(WEATHER_CURRENT_INTERVAL,
+			WEATHER_FORECAST_INTERVAL);
 
 	gui->clearAll();
 	gui->showAll();
 	gui->setCity(formatCity(weatherWS.getCity()));
+	gui->flush();
 
 	updateFromConf();
 
-	xTaskCreate(taskUpdateScreen,      "UpdateScreen",      16384, NULL, 2, NULL);
+	xTaskCreate(taskRender,            "Render",            16384, NULL, 2, &renderTask);
+	screen.setNotify(wakeRender, renderTask);
+	xTaskCreate(taskUpdateClock,       "UpdateClock",        4096, NULL, 2, NULL);
 	xTaskCreate(taskReceiveSensorData, "ReceiveSensorData", 16384, NULL, 0, NULL);
-	xTaskCreate(taskUpdateWeatherInfo, "UpdateWeatherInfo", 36864, NULL, 0, NULL);
+	xTaskCreate(taskUpdateWeatherInfo, "UpdateWeatherInfo",  8192, NULL, 0, NULL);
 	xTaskCreate(taskUpdateNTP,         "UpdateNTP",          8192, NULL, 0, NULL);
 	xTaskCreate(taskReadTHSensor,      "ReadTHSensor",       4096, NULL, 0, NULL);
 }
@@ -598,7 +640,6 @@ void loop()
 	bool icon      = false;
 	int nocontimer = 0;
 	int resettimer = 0;
-	int i;
 
 	while (1) {
 		// User reset button
@@ -639,20 +680,16 @@ void loop()
 					else
 						icon = false;
 
-					xSemaphoreTake(t_mutex, portMAX_DELAY);
-					gui->showWiFi(icon);
-					gui->setIP("");
-					xSemaphoreGive(t_mutex);
+					screen.showWiFi(icon);
+					screen.setIP("");
 					delay(1000);
 				} while (status == WL_IDLE_STATUS ||
 						 status == WL_NO_SSID_AVAIL);
 				break;
 
 			case WL_CONNECTED:
-				xSemaphoreTake(t_mutex, portMAX_DELAY);
-				gui->showWiFi(true);
-				gui->setIP(formatIP(WiFi.localIP()));
-				xSemaphoreGive(t_mutex);
+				screen.showWiFi(true);
+				screen.setIP(formatIP(WiFi.localIP()));
 
 				if (!wsinit) {
 					wsinit = true;
@@ -667,10 +704,8 @@ void loop()
 			case WL_CONNECTION_LOST:
 			case WL_DISCONNECTED:
 			default:
-				xSemaphoreTake(t_mutex, portMAX_DELAY);
-				gui->showWiFi(false);
-				gui->setIP("");
-				xSemaphoreGive(t_mutex);
+				screen.showWiFi(false);
+				screen.setIP("");
 				nocontimer++;
 				break;
 		}
@@ -681,15 +716,7 @@ void loop()
 			WiFiReconnect();
 
 			// Quick blink WiFi icon
-			xSemaphoreTake(t_mutex, portMAX_DELAY);
-			for (i = 0; i < 4; i++) {
-				if ((i % 2) == 0)
-					gui->showWiFi(true);
-				else
-					gui->showWiFi(false);
-				delay(400);
-			}
-			xSemaphoreGive(t_mutex);
+			screen.blinkWiFi(WIFI_BLINK_PHASES, WIFI_BLINK_TIME);
 
 			// Reset timer counter
 			nocontimer = 0;
@@ -43,6 +43,8 @@
 #include "wstation.h"
 #include "webservices.h"
 #include "EInterface.h"
+#include "EScreenEncoder.h"
+#include "EScreenStream.h"
 
 #define CHECK_HTTP_AUTH(req, conf) do { \
 	if(!req->authenticate(conf.getUsername().c_str(), \
@@ -149,6 +151,207 @@ String processData(const String& var)
 	return String();
 }
 
+#ifdef DEBUG_SCREENSHOT
+/**
+ * Read lines of the screen for a screenshot
+ *
+ * Runs in the web server task: the screen mutex is only held for one strip,
+ * so the render task is not held back for the whole transfer. It is not
+ * waited for longer than WS_SCREEN_TIMEOUT, which would hold every other
+ * client of the web server: the strip is then counted as a read error.
+ *
+ * @param [in] y First line
+ * @param [in] lines Number of lines
+ * @param [out] buf Pixels
+ * @param [in] arg Not used
+ * @return bool false on error
+ */
+static bool readScreenshot(int16_t y, int16_t lines, uint16_t *buf, void *arg)
+{
+	bool res;
+
+	if (xSemaphoreTake(t_mutex, WS_SCREEN_TIMEOUT) != pdTRUE)
+		return false;
+	res = gui->readScreen(0, y, gui->getWidth(), lines, buf);
+	xSemaphoreGive(t_mutex);
+	return res;
+}
+
+/**
+ * Send a screenshot, encoded while it is sent (chunked transfer)
+ * @param [in] request HTTP request
+ * @param [in] format File format
+ */
+static void sendScreenshot(AsyncWebServerRequest *request,
+		EScreenEncoder::screen_format_t format)
+{
+	EScreenEncoder *encoder;
+	AsyncWebServerResponse *response;
+	unsigned long start = millis();
+	uint32_t heap = ESP.getFreeHeap();
+
+	if (xSemaphoreTake(t_mutex, WS_SCREEN_TIMEOUT) != pdTRUE) {
+		request->send(503);
+		return;
+	}
+	encoder = new EScreenEncoder(format, gui->getWidth(), gui->getHeight(),
+			readScreenshot, NULL);
+	xSemaphoreGive(t_mutex);
+	if (!encoder->isValid()) {
+		delete encoder;
+		request->send(503);
+		return;
+	}
+
+	response = request->beginChunkedResponse(encoder->getContentType(),
+		[encoder, start, heap](uint8_t *buffer, size_t maxLen,
+				size_t index) -> size_t {
+			size_t n = encoder->read(buffer, maxLen);
+			if (!n) {
+				log_i("Screenshot: %u bytes in %lu ms, %u bytes used, "
+						"%u bytes of heap left (min %u), %u read errors",
+						index, millis() - start, heap - ESP.getFreeHeap(),
+						ESP.getFreeHeap(), ESP.getMinFreeHeap(),
+						encoder->getErrors());
+			}
+			return n;
+		});
+	response->addHeader("Cache-Control", "no-store");
+	// The response may be dropped before the end of the file
+	request->onDisconnect([encoder]() {
+		delete encoder;
+	});
+	request->send(response);
+}
+#endif
+
+#ifdef SCREEN_STREAM
+/** Live screen (/ws/screen) */
+static AsyncWebSocket *screenSocket = NULL;
+/** Messages of the live screen, created with the first viewer */
+static EScreenStream *screenStream = NULL;
+/** Message being sent (copied by the web socket) */
+static uint8_t screenMessage[SCREEN_STREAM_MSG_SIZE];
+/** A viewer disconnected: removed by the render task */
+static volatile bool screenLeft = false;
+
+/**
+ * Read an area of the screen for the live screen
+ *
+ * Runs in the render task, which holds the screen mutex.
+ *
+ * @param [in] x Left
+ * @param [in] y Top
+ * @param [in] w Width
+ * @param [in] h Height
+ * @param [out] buf Pixels
+ * @param [in] arg Not used
+ * @return bool false on error
+ */
+static bool readScreenStream(int16_t x, int16_t y, int16_t w, int16_t h,
+		uint16_t *buf, void *arg)
+{
+	return gui->readScreen(x, y, w, h, buf);
+}
+
+/**
+ * Live screen viewer connected or disconnected
+ * @param [in] server Web socket
+ * @param [in] client Viewer
+ * @param [in] type Event
+ * @param [in] arg Event data (not used)
+ * @param [in] data Received data (not used)
+ * @param [in] len Received data length (not used)
+ */
+static void onScreenSocket(AsyncWebSocket *server,
+		AsyncWebSocketClient *client, AwsEventType type, void *arg,
+		uint8_t *data, size_t len)
+{
+	bool added = false;
+
+	if (type == WS_EVT_CONNECT) {
+		// Do not hold the web server while a frame is drawn
+		if (xSemaphoreTake(t_mutex, WS_SCREEN_TIMEOUT) != pdTRUE) {
+			log_i("Screen busy, live screen viewer refused");
+			client->close();
+			return;
+		}
+		if (!screenStream) {
+			screenStream = new EScreenStream(gui->getWidth(),
+					gui->getHeight(), readScreenStream, NULL);
+			gui->setDamage(screenStream->getDamage());
+		}
+		added = screenStream->addClient(client->id());
+		xSemaphoreGive(t_mutex);
+		if (!added) {
+			log_i("Too many live screen viewers");
+			client->close();
+		} else if (renderTask) {
+			// Start sending the screen
+			xTaskNotifyGive(renderTask);
+		}
+	} else if (type == WS_EVT_DISCONNECT && screenStream) {
+		// Removed by the render task (updateScreenStream())
+		screenLeft = true;
+		if (renderTask)
+			xTaskNotifyGive(renderTask);
+	}
+}
+
+/**
+ * Send the areas of the screen drawn to the live screen viewers
+ *
+ * Called by the render task after each frame, with the screen mutex held.
+ * A viewer that cannot take more messages is skipped: its areas merge until
+ * it catches up. The async_tcp task deletes the viewers that leave, so they
+ * are only reached by id, under the lock of the web socket.
+ *
+ * @return bool true if a viewer still has messages to take
+ */
+bool updateScreenStream()
+{
+	bool pending = false;
+	uint32_t id;
+	size_t len;
+	int i;
+
+	if (!screenStream)
+		return false;
+
+	// Viewers gone: the web socket no longer knows them
+	if (screenLeft) {
+		screenLeft = false;
+		for (i = 0; i < SCREEN_STREAM_CLIENTS; i++) {
+			id = screenStream->getClient(i);
+			if (id && !screenSocket->hasClient(id))
+				screenStream->removeClient(id);
+		}
+	}
+
+	screenStream->setSize(gui->getWidth(), gui->getHeight());
+	screenStream->update();
+	for (i = 0; i < SCREEN_STREAM_CLIENTS; i++) {
+		id = screenStream->getClient(i);
+		if (!id || !screenSocket->hasClient(id))
+			continue;
+		while (screenStream->isPending(id)) {
+			if (!screenSocket->availableForWrite(id)) {
+				screenStream->setBusy(id);
+				pending = true;
+				break;
+			}
+			len = screenStream->nextMessage(id, screenMessage,
+					sizeof(screenMessage));
+			if (!len)
+				break;
+			// Dropped if the viewer left meanwhile
+			screenSocket->binary(id, screenMessage, len);
+		}
+	}
+	return pending;
+}
+#endif
+
 /**
  * Setup all web services
  * @param [in] webserver AsyncWebServer object
@@ -165,13 +368,60 @@ void SetupWebServices(AsyncWebServer *webServer)
 	});
 
 #ifdef DEBUG_SCREENSHOT
-	// Take screenshot
-	webServer->on("/takescreenshot", HTTP_GET, [](AsyncWebServerRequest *request){
-		takeScreenshot();
-		request->send(200, "text/plain", "OK");
+	// Screenshot, encoded from the screen while it is sent
+	webServer->on("/screenshot.png", HTTP_GET, [](AsyncWebServerRequest *request){
+		CHECK_HTTP_AUTH(request, confData);
+		sendScreenshot(request, EScreenEncoder::SCREEN_PNG);
+	});
+	webServer->on("/screenshot.bmp", HTTP_GET, [](AsyncWebServerRequest *request){
+		CHECK_HTTP_AUTH(request, confData);
+		sendScreenshot(request, EScreenEncoder::SCREEN_BMP);
+	});
+#endif
+
+	// Counters of the outbound requests (JSON), /network?reset starts over
+	webServer->on("/network", HTTP_GET, [](AsyncWebServerRequest *request){
+		CHECK_HTTP_AUTH(request, confData);
+		AsyncResponseStream *response =
+			request->beginResponseStream("application/json");
+		network.printJSON(*response);
+		if (request->hasParam("reset"))
+			network.resetStats();
+		request->send(response);
+	});
+
+#if GUI_PROFILE
+	// Render profile (JSON), /profile?reset starts a new one
+	webServer->on("/profile", HTTP_GET, [](AsyncWebServerRequest *request){
+		CHECK_HTTP_AUTH(request, confData);
+		// Do not hold the web server while a frame is drawn
+		if (xSemaphoreTake(t_mutex, WS_SCREEN_TIMEOUT) != pdTRUE) {
+			request->send(503);
+			return;
+		}
+		AsyncResponseStream *response =
+			request->beginResponseStream("application/json");
+		gui->getProfiler()->printJSON(*response);
+		if (request->hasParam("reset"))
+			gui->getProfiler()->reset();
+		xSemaphoreGive(t_mutex);
+		request->send(response);
+	});
+#endif
+
+#ifdef SCREEN_STREAM
+	// Live screen: viewer page and the areas of the screen drawn
+	webServer->on("/screen", HTTP_GET, [](AsyncWebServerRequest *request){
+		CHECK_HTTP_AUTH(request, confData);
+		request->send(SPIFFS, "/screen.html", "text/html");
+	});
+	screenSocket = new AsyncWebSocket("/ws/screen");
+	screenSocket->setFilter([](AsyncWebServerRequest *request) {
+		return request->authenticate(confData.getUsername().c_str(),
+				confData.getUserPass().c_str());
 	});
-	// Screenshot image
-	webServer->serveStatic("/screenshot.px", SPIFFS, "/screenshot.px");
+	screenSocket->onEvent(onScreenSocket);
+	webServer->addHandler(screenSocket);
 #endif
 
 	// Logo image file